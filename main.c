@@ -8,10 +8,17 @@
 #include "ptts.h"
 #include "ptts_flowlm.h"
 #include "ptts_mimi.h"
+#include "ptts_prefork.h"
+#include "ptts_batch.h"
+#include "ptts_serve.h"
+#include "ptts_longform.h"
+#include "ptts_trace.h"
 #include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <time.h>
 
 typedef enum {
     OUTPUT_QUIET = 0,
@@ -24,21 +31,26 @@ static output_level_t output_level = OUTPUT_NORMAL;
 static void print_usage(const char *prog) {
     printf("Pocket-TTS Pure C (WIP)\n");
     printf("Usage: %s -d model_dir -p \"text\" -o out.wav [options]\n", prog);
+    printf("       %s serve -d model_dir [--listen ADDR] [--workers N] [options]\n", prog);
     printf("\nPrimary:\n");
     printf("  -d, --dir PATH        Model directory or .safetensors file\n");
     printf("  -p, --prompt TEXT     Text to synthesize\n");
     printf("  -o, --output PATH     Output WAV path\n");
     printf("      --voice NAME      Voice embedding name or .safetensors path (default: alba)\n");
     printf("\nIntrospection:\n");
-    printf("      --info            Print model info\n");
+    printf("      --info            Print model info (with -v, also load and time FlowLM/Mimi)\n");
     printf("      --list            List tensors in weights file\n");
     printf("      --find TEXT       List tensors whose names contain TEXT\n");
     printf("      --verify          Verify weights against expected shapes\n");
     printf("      --tokens          Print token IDs for the prompt\n");
+    printf("      --pack PATH       Write a packed .ptts model (mmap-and-run) and time cold/warm loads\n");
     printf("\nDebug/analysis:\n");
     printf("      --flow-test       Run a single FlowLM step and print latent stats\n");
     printf("      --mimi-test       Run FlowLM + Mimi decoder transformer stats\n");
     printf("      --mimi-wave PATH  Write Mimi decode WAV to PATH (frames * 80ms)\n");
+    printf("      --mimi-bench      Time Mimi decode per layout, conv layer and precision (--frames, default 25)\n");
+    printf("      --flow-bench      Time the flow net, generic GEMV vs pinned thread teams (--frames calls, default 200)\n");
+    printf("      --tokenizer-bench Tokenizer throughput in MB/s on ~1 MB of the prompt (or built-in text)\n");
     printf("      --frames N        Number of FlowLM/Mimi frames (default: auto)\n");
     printf("      --latent-out PATH Write raw FlowLM latents (32 floats per frame)\n");
     printf("      --cond-out PATH   Write first FlowLM condition vector (1024 floats)\n");
@@ -46,20 +58,218 @@ static void print_usage(const char *prog) {
     printf("      --dummy           Generate placeholder audio (no model)\n");
     printf("\nGeneration:\n");
     printf("  -S, --seed N          Random seed (-1 for random)\n");
+    printf("      --request-id N    Noise stream id (independent noise for the same seed)\n");
     printf("  -t, --temp F          Noise temperature for FlowLM (default: 1.0)\n");
     printf("      --noise-clamp F   Clamp noise to [-F, F] (default: 0, off)\n");
     printf("      --eos-threshold F Stop early if eos_logit >= F (default: -4.0)\n");
     printf("      --eos-min-frames N Minimum frames before EOS stop (default: 1)\n");
     printf("      --eos-after N     Frames to keep after EOS (default: auto)\n");
     printf("  -r, --rate N          Sample rate for dummy generator (default: 24000)\n");
-    printf("  -s, --steps N         Flow matching steps (placeholder)\n");
+    printf("  -s, --steps N         Flow matching steps (1-64, default 1)\n");
+    printf("\nLong-form:\n");
+    printf("      --long            Split the text into sentence chunks and synthesize them in parallel\n");
+    printf("      --text-file PATH  Read the text from PATH instead of --prompt\n");
+    printf("      --chunk-words N   Words per chunk for --long (default: 40)\n");
+    printf("      --silence MS      Silence between chunks for --long (default: 120)\n");
+    printf("      --crossfade MS    Crossfade between chunks for --long (default: 0)\n");
+    printf("\nServer:\n");
+    printf("      serve             HTTP daemon: POST /synthesize (JSON, chunked audio), GET /metrics\n");
+    printf("      --listen ADDR     HOST:PORT, PORT or Unix socket path for serve (default: 127.0.0.1:8080)\n");
+    printf("      --workers N       Concurrent syntheses for serve (default: 1), --batch and --long (default: CPUs/2)\n");
+    printf("      --queue N         Connections waiting for a serve worker before 503 (default: 16)\n");
+    printf("      --max-batch N     serve: step up to N requests per frame on one scheduler thread (default: off)\n");
+    printf("      --batch FILE      Synthesize every JSONL request in FILE with one model load\n");
+    printf("      --out-dir DIR     Output directory for --batch (default: .)\n");
+    printf("      --prefork N       Load once, fork N copy-on-write workers serving --socket\n");
+    printf("      --socket PATH     Unix socket for --prefork (default: ptts.sock)\n");
     printf("\nOutput:\n");
+    printf("      --stats json      Print generation stats (stage times, TTFA, RTF, memory) to stdout\n");
+    printf("      --trace FILE      Write a Chrome trace (chrome://tracing, Perfetto) of the run\n");
     printf("  -q, --quiet           Less output\n");
     printf("  -v, --verbose         More output\n");
     printf("  -h, --help            Show help\n");
     printf("\nExamples:\n");
     printf("  %s -d pocket-tts-model -p \"Hello world\" -o out.wav --voice alba\n", prog);
     printf("  %s --list -d pocket-tts-model\n", prog);
+    printf("  %s -d pocket-tts-model --long --text-file chapter.txt -o chapter.wav\n", prog);
+    printf("  %s serve -d pocket-tts-model --listen 8080 --workers 2\n", prog);
+}
+
+static double bench_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+/* Decode the same random latents channels-first and channels-last, report
+ * wall time per layout and the SNR of one against the other. */
+static int run_mimi_bench(ptts_ctx *ctx, int frames) {
+    static const struct { ptts_mimi_layout layout; const char *name; } layouts[2] = {
+        {PTTS_MIMI_LAYOUT_CHANNELS_FIRST, "channels-first"},
+        {PTTS_MIMI_LAYOUT_CHANNELS_LAST, "channels-last"},
+    };
+    ptts_mimi *mm = ptts_mimi_load(ctx);
+    if (!mm) {
+        fprintf(stderr, "Error: failed to load Mimi weights\n");
+        return 1;
+    }
+    size_t n = (size_t)frames * PTTS_MIMI_FRAME_SAMPLES;
+    float *latents = (float *)malloc(sizeof(float) * 32 * (size_t)frames);
+    float *out[2];
+    out[0] = (float *)malloc(sizeof(float) * n);
+    out[1] = (float *)malloc(sizeof(float) * n);
+    if (!latents || !out[0] || !out[1]) {
+        fprintf(stderr, "Error: out of memory\n");
+        free(latents); free(out[0]); free(out[1]);
+        ptts_mimi_free(mm);
+        return 1;
+    }
+    srand(1234);
+    for (int i = 0; i < 32 * frames; i++) latents[i] = 2.0f * rand() / (float)RAND_MAX - 1.0f;
+
+    double audio_ms = frames * 80.0;
+    for (int i = 0; i < 2; i++) {
+        int len = 0;
+        double t0 = bench_now_ms();
+        if (ptts_mimi_set_layout(mm, layouts[i].layout) != 0 ||
+            ptts_mimi_decode(mm, latents, frames, out[i], &len) != 0) {
+            fprintf(stderr, "Error: Mimi decode failed (%s)\n", layouts[i].name);
+            free(latents); free(out[0]); free(out[1]);
+            ptts_mimi_free(mm);
+            return 1;
+        }
+        double ms = bench_now_ms() - t0;
+        printf("Mimi decode %-14s %d frames: %9.2f ms (%.2fx realtime)\n",
+               layouts[i].name, frames, ms, audio_ms / ms);
+    }
+    double sig = 0.0, err = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double d = (double)out[1][i] - out[0][i];
+        sig += (double)out[0][i] * out[0][i];
+        err += d * d;
+    }
+    printf("Layout parity: SNR %.1f dB\n", err > 0.0 ? 10.0 * log10(sig / err) : INFINITY);
+    printf("\nConv1d kernels (channels-last):\n");
+    if (ptts_mimi_conv_report(mm, frames) != 0) fprintf(stderr, "Error: conv report failed\n");
+    printf("\nReduced precision (channels-last, stage ms):\n");
+    if (ptts_mimi_precision_report(mm, frames) != 0) {
+        fprintf(stderr, "Error: precision report failed\n");
+    }
+    free(latents); free(out[0]); free(out[1]);
+    ptts_mimi_free(mm);
+    return 0;
+}
+
+/* Time the flow net with the generic GEMVs and with pinned weight-stationary
+ * teams, and report the speedup of each. */
+static int run_flow_bench(ptts_ctx *ctx, int calls) {
+    ptts_flowlm *fm = ptts_flowlm_load(ctx);
+    if (!fm) {
+        fprintf(stderr, "Error: failed to load FlowLM weights\n");
+        return 1;
+    }
+    int rc = ptts_flowlm_flow_report(fm, calls);
+    if (rc != 0) fprintf(stderr, "Error: flow report failed\n");
+    ptts_flowlm_free(fm);
+    return rc != 0;
+}
+
+/* Tokenize about 1 MB made of copies of text and report throughput (best
+ * of three runs). */
+static int run_tokenizer_bench(ptts_ctx *ctx, const char *text) {
+    static const char *fallback =
+        "The quick brown fox jumps over the lazy dog. Pocket TTS turns text into speech "
+        "on a CPU, one frame at a time; numbers like 3.14 and 1,024 are spelled out first. ";
+    if (!text || !text[0]) text = fallback;
+    size_t unit = strlen(text);
+    size_t copies = (1u << 20) / (unit + 1) + 1;
+    size_t len = copies * (unit + 1);
+    char *doc = (char *)malloc(len + 1);
+    if (!doc) {
+        fprintf(stderr, "Error: out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i < copies; i++) {
+        memcpy(doc + i * (unit + 1), text, unit);
+        doc[i * (unit + 1) + unit] = ' ';
+    }
+    doc[len] = '\0';
+
+    double best = 0.0;
+    int n = 0;
+    for (int rep = 0; rep < 3; rep++) {
+        int *ids = NULL;
+        double t0 = bench_now_ms();
+        if (ptts_tokenize(ctx, doc, &ids, &n) != 0) {
+            fprintf(stderr, "Error: %s\n", ptts_get_error());
+            free(doc);
+            return 1;
+        }
+        double ms = bench_now_ms() - t0;
+        free(ids);
+        if (rep == 0 || ms < best) best = ms;
+    }
+    printf("Tokenizer: %.2f MB -> %d tokens in %.2f ms: %.2f MB/s, %.0f tokens/s\n",
+           len / 1e6, n, best, len / 1e6 / (best / 1000.0), n / (best / 1000.0));
+    free(doc);
+    return 0;
+}
+
+/* Pack the model, then time cold and warm loads of the source weights and
+ * of the packed file. */
+static int run_pack(const char *model_dir, const char *out_path) {
+    ptts_ctx *ctx = ptts_load_dir(model_dir);
+    if (!ctx) {
+        fprintf(stderr, "Error: %s\n", ptts_get_error());
+        return 1;
+    }
+    double t0 = bench_now_ms();
+    int rc = ptts_pack_model(ctx, out_path);
+    double pack_ms = bench_now_ms() - t0;
+    ptts_free(ctx);
+    if (rc != 0) {
+        fprintf(stderr, "Error: %s\n", ptts_get_error());
+        return 1;
+    }
+    printf("Packed %s -> %s in %.1f ms\n", model_dir, out_path, pack_ms);
+
+    const char *paths[2] = {model_dir, out_path};
+    const char *names[2] = {"source", "packed"};
+    for (int i = 0; i < 2; i++) {
+        double cold = 0.0, warm = 0.0;
+        if (ptts_load_time_ms(paths[i], 1, &cold) != 0 ||
+            ptts_load_time_ms(paths[i], 0, &warm) != 0) {
+            fprintf(stderr, "Error: %s\n", ptts_get_error());
+            return 1;
+        }
+        printf("Load %-7s cold %9.2f ms  warm %9.2f ms\n", names[i], cold, warm);
+    }
+    printf("(packed weights are paged in on first use rather than at load)\n");
+    return 0;
+}
+
+/* Whole file as a NUL-terminated string, or NULL. */
+static char *read_text_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    size_t cap = 4096, len = 0;
+    char *buf = (char *)malloc(cap);
+    while (buf) {
+        len += fread(buf + len, 1, cap - len - 1, f);
+        if (len < cap - 1) break;
+        cap *= 2;
+        char *nb = (char *)realloc(buf, cap);
+        if (!nb) free(buf);
+        buf = nb;
+    }
+    int err = ferror(f);
+    fclose(f);
+    if (!buf || err) {
+        free(buf);
+        return NULL;
+    }
+    buf[len] = '\0';
+    return buf;
 }
 
 #define LOG_NORMAL(...) do { if (output_level >= OUTPUT_NORMAL) fprintf(stderr, __VA_ARGS__); } while(0)
@@ -77,11 +287,26 @@ int main(int argc, char **argv) {
     int verify_weights = 0;
     int flow_test = 0;
     int mimi_test = 0;
+    int mimi_bench = 0;
+    int flow_bench = 0;
+    int tokenizer_bench = 0;
     const char *mimi_wave = NULL;
+    const char *pack_out = NULL;
+    const char *socket_path = "ptts.sock";
+    int prefork = 0;
+    int serve = 0;
+    ptts_serve_opts serve_opts = {"127.0.0.1:8080", 0, 16, 0, NULL, PTTS_PARAMS_DEFAULT};
+    const char *batch_file = NULL;
+    const char *out_dir = ".";
+    int long_form = 0;
+    const char *text_file = NULL;
+    ptts_longform_opts long_opts_cfg = PTTS_LONGFORM_OPTS_DEFAULT;
     const char *find_pat = NULL;
     const char *latent_out = NULL;
     const char *cond_out = NULL;
     const char *flow_out = NULL;
+    const char *stats_fmt = NULL;
+    const char *trace_path = NULL;
     ptts_params params = PTTS_PARAMS_DEFAULT;
 
     static struct option long_opts[] = {
@@ -94,9 +319,26 @@ int main(int argc, char **argv) {
         {"find", required_argument, 0, 0},
         {"verify", no_argument, 0, 0},
         {"tokens", no_argument, 0, 0},
+        {"pack", required_argument, 0, 0},
+        {"prefork", required_argument, 0, 0},
+        {"socket", required_argument, 0, 0},
+        {"listen", required_argument, 0, 0},
+        {"batch", required_argument, 0, 0},
+        {"out-dir", required_argument, 0, 0},
+        {"workers", required_argument, 0, 0},
+        {"queue", required_argument, 0, 0},
+        {"max-batch", required_argument, 0, 0},
+        {"long", no_argument, 0, 0},
+        {"text-file", required_argument, 0, 0},
+        {"chunk-words", required_argument, 0, 0},
+        {"silence", required_argument, 0, 0},
+        {"crossfade", required_argument, 0, 0},
         {"flow-test", no_argument, 0, 0},
         {"mimi-test", no_argument, 0, 0},
         {"mimi-wave", required_argument, 0, 0},
+        {"mimi-bench", no_argument, 0, 0},
+        {"flow-bench", no_argument, 0, 0},
+        {"tokenizer-bench", no_argument, 0, 0},
         {"frames", required_argument, 0, 0},
         {"latent-out", required_argument, 0, 0},
         {"cond-out", required_argument, 0, 0},
@@ -110,12 +352,22 @@ int main(int argc, char **argv) {
         {"rate", required_argument, 0, 'r'},
         {"steps", required_argument, 0, 's'},
         {"seed", required_argument, 0, 'S'},
+        {"request-id", required_argument, 0, 0},
+        {"stats", required_argument, 0, 0},
+        {"trace", required_argument, 0, 0},
         {"quiet", no_argument, 0, 'q'},
         {"verbose", no_argument, 0, 'v'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
 
+    if (argc > 1 && strcmp(argv[1], "serve") == 0) {
+        serve = 1;
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
+
     int opt;
     int long_idx = 0;
     while ((opt = getopt_long(argc, argv, "d:p:o:r:s:S:t:qvh", long_opts, &long_idx)) != -1) {
@@ -127,9 +379,26 @@ int main(int argc, char **argv) {
                 else if (strcmp(long_opts[long_idx].name, "find") == 0) find_pat = optarg;
                 else if (strcmp(long_opts[long_idx].name, "verify") == 0) verify_weights = 1;
                 else if (strcmp(long_opts[long_idx].name, "tokens") == 0) show_tokens = 1;
+                else if (strcmp(long_opts[long_idx].name, "pack") == 0) pack_out = optarg;
+                else if (strcmp(long_opts[long_idx].name, "prefork") == 0) prefork = atoi(optarg);
+                else if (strcmp(long_opts[long_idx].name, "socket") == 0) socket_path = optarg;
+                else if (strcmp(long_opts[long_idx].name, "listen") == 0) serve_opts.listen = optarg;
+                else if (strcmp(long_opts[long_idx].name, "batch") == 0) batch_file = optarg;
+                else if (strcmp(long_opts[long_idx].name, "out-dir") == 0) out_dir = optarg;
+                else if (strcmp(long_opts[long_idx].name, "workers") == 0) serve_opts.workers = atoi(optarg);
+                else if (strcmp(long_opts[long_idx].name, "queue") == 0) serve_opts.queue = atoi(optarg);
+                else if (strcmp(long_opts[long_idx].name, "max-batch") == 0) serve_opts.max_batch = atoi(optarg);
+                else if (strcmp(long_opts[long_idx].name, "long") == 0) long_form = 1;
+                else if (strcmp(long_opts[long_idx].name, "text-file") == 0) text_file = optarg;
+                else if (strcmp(long_opts[long_idx].name, "chunk-words") == 0) long_opts_cfg.max_words = atoi(optarg);
+                else if (strcmp(long_opts[long_idx].name, "silence") == 0) long_opts_cfg.silence_ms = atoi(optarg);
+                else if (strcmp(long_opts[long_idx].name, "crossfade") == 0) long_opts_cfg.crossfade_ms = atoi(optarg);
                 else if (strcmp(long_opts[long_idx].name, "flow-test") == 0) flow_test = 1;
                 else if (strcmp(long_opts[long_idx].name, "mimi-test") == 0) mimi_test = 1;
                 else if (strcmp(long_opts[long_idx].name, "mimi-wave") == 0) mimi_wave = optarg;
+                else if (strcmp(long_opts[long_idx].name, "mimi-bench") == 0) mimi_bench = 1;
+                else if (strcmp(long_opts[long_idx].name, "flow-bench") == 0) flow_bench = 1;
+                else if (strcmp(long_opts[long_idx].name, "tokenizer-bench") == 0) tokenizer_bench = 1;
                 else if (strcmp(long_opts[long_idx].name, "frames") == 0) params.num_frames = atoi(optarg);
                 else if (strcmp(long_opts[long_idx].name, "latent-out") == 0) latent_out = optarg;
                 else if (strcmp(long_opts[long_idx].name, "cond-out") == 0) cond_out = optarg;
@@ -143,6 +412,11 @@ int main(int argc, char **argv) {
                 } else if (strcmp(long_opts[long_idx].name, "eos-after") == 0) {
                     params.eos_after = atoi(optarg);
                 }
+                else if (strcmp(long_opts[long_idx].name, "request-id") == 0) {
+                    params.request_id = strtoull(optarg, NULL, 10);
+                }
+                else if (strcmp(long_opts[long_idx].name, "stats") == 0) stats_fmt = optarg;
+                else if (strcmp(long_opts[long_idx].name, "trace") == 0) trace_path = optarg;
                 else if (strcmp(long_opts[long_idx].name, "dummy") == 0) use_dummy = 1;
                 break;
             case 'd': model_dir = optarg; break;
@@ -161,13 +435,94 @@ int main(int argc, char **argv) {
         }
     }
 
+    if (stats_fmt && strcmp(stats_fmt, "json") != 0) {
+        fprintf(stderr, "Error: --stats supports only json\n");
+        return 1;
+    }
+    if (stats_fmt && long_form) {
+        fprintf(stderr, "Error: --stats is not supported with --long\n");
+        return 1;
+    }
+
+    if (params.num_steps < 1 || params.num_steps > PTTS_MAX_STEPS) {
+        fprintf(stderr, "Error: --steps must be between 1 and %d\n", PTTS_MAX_STEPS);
+        return 1;
+    }
     if (params.num_frames < 0) params.num_frames = 0;
     if (params.eos_min_frames < 1) params.eos_min_frames = 1;
     if (params.eos_after < 0) params.eos_after = 0;
 
-    if (info_only || list_tensors || show_tokens || find_pat || verify_weights || flow_test || mimi_test || mimi_wave) {
+    char *file_text = NULL;
+    if (text_file) {
+        file_text = read_text_file(text_file);
+        if (!file_text) {
+            fprintf(stderr, "Error: cannot read %s\n", text_file);
+            return 1;
+        }
+        prompt = file_text;
+    }
+
+    if (pack_out) {
+        if (!model_dir) {
+            fprintf(stderr, "Error: --dir is required for --pack\n");
+            return 1;
+        }
+        return run_pack(model_dir, pack_out);
+    }
+
+    if (serve) {
+        if (!model_dir) {
+            fprintf(stderr, "Error: --dir is required for serve\n");
+            return 1;
+        }
+        ptts_ctx *ctx = ptts_load_dir(model_dir);
+        if (!ctx) {
+            fprintf(stderr, "Error: %s\n", ptts_get_error());
+            return 1;
+        }
+        serve_opts.voice = voice;
+        serve_opts.params = params;
+        int rc = ptts_serve(ctx, &serve_opts);
+        if (rc != 0 && ptts_get_error()[0]) fprintf(stderr, "Error: %s\n", ptts_get_error());
+        ptts_free(ctx);
+        return rc == 0 ? 0 : 1;
+    }
+
+    if (batch_file) {
+        if (!model_dir) {
+            fprintf(stderr, "Error: --dir is required for --batch\n");
+            return 1;
+        }
+        ptts_ctx *ctx = ptts_load_dir(model_dir);
+        if (!ctx) {
+            fprintf(stderr, "Error: %s\n", ptts_get_error());
+            return 1;
+        }
+        int rc = ptts_batch_run(ctx, batch_file, out_dir, serve_opts.workers, voice, &params);
+        ptts_free(ctx);
+        return rc == 0 ? 0 : 1;
+    }
+
+    if (prefork > 0) {
+        if (!model_dir) {
+            fprintf(stderr, "Error: --dir is required for --prefork\n");
+            return 1;
+        }
+        ptts_ctx *ctx = ptts_load_dir(model_dir);
+        if (!ctx) {
+            fprintf(stderr, "Error: %s\n", ptts_get_error());
+            return 1;
+        }
+        int rc = ptts_prefork_serve(ctx, socket_path, prefork, voice, &params);
+        if (rc != 0 && ptts_get_error()[0]) fprintf(stderr, "Error: %s\n", ptts_get_error());
+        ptts_free(ctx);
+        return rc == 0 ? 0 : 1;
+    }
+
+    if (info_only || list_tensors || show_tokens || find_pat || verify_weights || flow_test || mimi_test || mimi_wave ||
+        mimi_bench || flow_bench || tokenizer_bench) {
         if (!model_dir) {
-            fprintf(stderr, "Error: --dir is required for --info/--list/--find/--tokens/--verify/--flow-test/--mimi-test/--mimi-wave\n");
+            fprintf(stderr, "Error: --dir is required for --info/--list/--find/--tokens/--verify/--flow-test/--mimi-test/--mimi-wave/--mimi-bench/--flow-bench/--tokenizer-bench\n");
             return 1;
         }
         ptts_ctx *ctx = ptts_load_dir(model_dir);
@@ -175,9 +530,31 @@ int main(int argc, char **argv) {
             fprintf(stderr, "Error: %s\n", ptts_get_error());
             return 1;
         }
-        if (info_only) ptts_print_info(ctx);
+        if (info_only) {
+            if (output_level >= OUTPUT_VERBOSE) {
+                /* Load both subsystems so the per-subsystem load times show */
+                ptts_flowlm *fm = ptts_flowlm_load(ctx);
+                ptts_mimi *mm = fm ? ptts_mimi_load(ctx) : NULL;
+                if (!fm || !mm) fprintf(stderr, "Error: failed to load model weights\n");
+                ptts_mimi_free(mm);
+                ptts_flowlm_free(fm);
+            }
+            ptts_print_info(ctx);
+        }
         if (list_tensors) ptts_list_tensors(ctx);
         if (find_pat) ptts_list_tensors_matching(ctx, find_pat);
+        if (mimi_bench && run_mimi_bench(ctx, params.num_frames > 0 ? params.num_frames : 25) != 0) {
+            ptts_free(ctx);
+            return 1;
+        }
+        if (flow_bench && run_flow_bench(ctx, params.num_frames > 0 ? params.num_frames : 200) != 0) {
+            ptts_free(ctx);
+            return 1;
+        }
+        if (tokenizer_bench && run_tokenizer_bench(ctx, prompt) != 0) {
+            ptts_free(ctx);
+            return 1;
+        }
         if (verify_weights) {
             int rc = ptts_verify_weights(ctx, output_level >= OUTPUT_VERBOSE);
             if (rc != 0) {
@@ -328,7 +705,7 @@ int main(int argc, char **argv) {
             if (ptts_flowlm_generate_latents(fm, ids, n, voice_cond, voice_len,
                                              gen_frames, params.num_steps,
                                              params.temp, params.noise_clamp, params.seed,
-                                             params.eos_enabled, params.eos_threshold,
+                                             params.request_id, params.eos_enabled, params.eos_threshold,
                                              params.eos_min_frames, params.eos_after,
                                              latents, &used_frames, &eos_first, cond_vec,
                                              flow_vec) != 0) {
@@ -579,6 +956,8 @@ int main(int argc, char **argv) {
     }
 
     ptts_audio *audio = NULL;
+    ptts_stats stats;
+    int have_stats = 0;
 
     if (use_dummy) {
         LOG_NORMAL("Generating dummy audio...\n");
@@ -594,14 +973,35 @@ int main(int argc, char **argv) {
             return 1;
         }
         LOG_VERBOSE("Loaded model, starting inference...\n");
-        audio = ptts_generate(ctx, prompt, voice, &params);
+        if (trace_path) {
+            ptts_trace_thread_name("main", 0);
+            ptts_trace_start();
+        }
+        PTTS_TRACE_BEGIN(t_trace);
+        if (long_form) {
+            long_opts_cfg.workers = serve_opts.workers;
+            audio = ptts_generate_long(ctx, prompt, voice, &params, &long_opts_cfg);
+        } else if (stats_fmt) {
+            audio = ptts_generate_stats(ctx, prompt, voice, &params, NULL, NULL, &stats);
+            have_stats = audio != NULL;
+        } else {
+            audio = ptts_generate(ctx, prompt, voice, &params);
+        }
+        PTTS_TRACE_END(t_trace, "generate", -1);
         if (!audio) {
             fprintf(stderr, "Error: %s\n", ptts_get_error());
             ptts_free(ctx);
             return 1;
         }
+        if (trace_path && ptts_trace_write(trace_path) != 0) {
+            fprintf(stderr, "Error: failed to write trace %s\n", trace_path);
+            ptts_audio_free(audio);
+            ptts_free(ctx);
+            return 1;
+        }
         ptts_free(ctx);
     }
+    free(file_text);
 
     if (!audio) {
         fprintf(stderr, "Error: %s\n", ptts_get_error());
@@ -616,5 +1016,10 @@ int main(int argc, char **argv) {
 
     ptts_audio_free(audio);
     LOG_NORMAL("Saved %s\n", output);
+    if (have_stats) {
+        char line[1024];
+        ptts_stats_json(&stats, line, sizeof(line));
+        printf("%s\n", line);
+    }
     return 0;
 }
@@ -2,14 +2,19 @@
 #include "ptts_flowlm.h"
 #include "ptts_internal.h"
 #include "ptts_mimi.h"
+#include "ptts_spsc.h"
+#include "ptts_trace.h"
 #include <ctype.h>
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 #include <sys/stat.h>
 
 #ifndef M_PI
@@ -20,7 +25,8 @@
  * Error handling
  * ======================================================================== */
 
-static char g_error_msg[256] = {0};
+/* Per thread, so concurrent ptts_generate calls report their own errors. */
+static __thread char g_error_msg[256] = {0};
 static int g_timing_inited = 0;
 static int g_timing_enabled = 0;
 
@@ -48,6 +54,10 @@ static void set_error(const char *msg) {
     g_error_msg[sizeof(g_error_msg) - 1] = '\0';
 }
 
+void ptts_set_error(const char *msg) {
+    set_error(msg);
+}
+
 /* ========================================================================
  * Helpers
  * ======================================================================== */
@@ -69,6 +79,11 @@ static int has_suffix(const char *s, const char *suffix) {
     return strcmp(s + len - slen, suffix) == 0;
 }
 
+/* A weights file given directly instead of a model directory. */
+static int is_weights_file(const char *path) {
+    return has_suffix(path, ".safetensors") || has_suffix(path, ".ptts");
+}
+
 static char *join_path(const char *a, const char *b) {
     size_t alen = strlen(a);
     size_t blen = strlen(b);
@@ -82,13 +97,18 @@ static char *join_path(const char *a, const char *b) {
 static char *find_weights_file(const char *model_dir) {
     if (!model_dir) return NULL;
 
-    /* Direct .safetensors path */
-    if (has_suffix(model_dir, ".safetensors") && file_exists(model_dir)) {
+    /* Direct .safetensors or packed .ptts path */
+    if (is_weights_file(model_dir) && file_exists(model_dir)) {
         return strdup(model_dir);
     }
 
     if (!dir_exists(model_dir)) return NULL;
 
+    /* A packed model written by ptts --pack into the directory wins */
+    char *packed = join_path(model_dir, "model.ptts");
+    if (packed && file_exists(packed)) return packed;
+    free(packed);
+
     /* Preferred filename */
     char *preferred = join_path(model_dir, "tts_b6369a24.safetensors");
     if (preferred && file_exists(preferred)) return preferred;
@@ -130,7 +150,7 @@ static char *find_tokenizer_file(const char *model_dir) {
     if (!model_dir) return NULL;
 
     char *base_dir = NULL;
-    if (has_suffix(model_dir, ".safetensors")) {
+    if (is_weights_file(model_dir)) {
         base_dir = dirname_from_path(model_dir);
     } else {
         base_dir = strdup(model_dir);
@@ -160,7 +180,7 @@ static char *resolve_voice_path(const ptts_ctx *ctx, const char *voice_path) {
     if (!ctx || !ctx->model_dir) return NULL;
 
     char *base_dir = NULL;
-    if (has_suffix(ctx->model_dir, ".safetensors")) {
+    if (is_weights_file(ctx->model_dir)) {
         base_dir = dirname_from_path(ctx->model_dir);
     } else {
         base_dir = strdup(ctx->model_dir);
@@ -290,17 +310,7 @@ int ptts_estimate_frames(int word_count) {
     return frames;
 }
 
-int ptts_load_voice_conditioning(ptts_ctx *ctx, const char *voice_path,
-                                 float **out_cond, int *out_len) {
-    if (!out_cond || !out_len) return -1;
-    *out_cond = NULL;
-    *out_len = 0;
-
-    const char *name = (voice_path && voice_path[0]) ? voice_path : "alba";
-    if (voice_is_disabled(name)) {
-        return 0;
-    }
-
+static int load_voice_file(ptts_ctx *ctx, const char *name, float **out_cond, int *out_len) {
     char *resolved = resolve_voice_path(ctx, name);
     if (!resolved) {
         set_error("Voice prompt not found (run ./download_model.sh --voice alba or pass --voice PATH)");
@@ -363,10 +373,96 @@ int ptts_load_voice_conditioning(ptts_ctx *ctx, const char *voice_path,
     return 0;
 }
 
+static float *copy_floats(const float *src, size_t n) {
+    float *dst = (float *)malloc(n * sizeof(float));
+    if (dst) memcpy(dst, src, n * sizeof(float));
+    return dst;
+}
+
+int ptts_load_voice_conditioning(ptts_ctx *ctx, const char *voice_path,
+                                 float **out_cond, int *out_len) {
+    if (!out_cond || !out_len) return -1;
+    *out_cond = NULL;
+    *out_len = 0;
+
+    const char *name = (voice_path && voice_path[0]) ? voice_path : "alba";
+    if (voice_is_disabled(name)) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&ctx->voice_lock);
+    for (int i = 0; i < ctx->num_voices; i++) {
+        const ptts_voice_slot *v = &ctx->voices[i];
+        if (strcmp(v->name, name) != 0) continue;
+        float *cond = copy_floats(v->cond, (size_t)v->len * PTTS_FLOWLM_DIM);
+        int len = v->len;
+        pthread_mutex_unlock(&ctx->voice_lock);
+        if (!cond) {
+            set_error("Out of memory");
+            return -1;
+        }
+        *out_cond = cond;
+        *out_len = len;
+        return 0;
+    }
+    pthread_mutex_unlock(&ctx->voice_lock);
+
+    if (load_voice_file(ctx, name, out_cond, out_len) != 0) return -1;
+
+    /* Keep a copy; past PTTS_VOICE_CACHE_SLOTS voices, load from disk. */
+    pthread_mutex_lock(&ctx->voice_lock);
+    int cached = 0;
+    for (int i = 0; i < ctx->num_voices; i++) {
+        if (strcmp(ctx->voices[i].name, name) == 0) cached = 1;
+    }
+    if (!cached && ctx->num_voices < PTTS_VOICE_CACHE_SLOTS) {
+        ptts_voice_slot *v = &ctx->voices[ctx->num_voices];
+        v->name = strdup(name);
+        v->cond = copy_floats(*out_cond, (size_t)*out_len * PTTS_FLOWLM_DIM);
+        v->len = *out_len;
+        if (v->name && v->cond) {
+            ctx->num_voices++;
+        } else {
+            free(v->name);
+            free(v->cond);
+        }
+    }
+    pthread_mutex_unlock(&ctx->voice_lock);
+    return 0;
+}
+
 /* ========================================================================
  * Core API
  * ======================================================================== */
 
+#define PTTS_FLOWLM_LAYERS 6
+#define PTTS_PREFIX_CACHE_DEFAULT_MB 256
+
+/* PTTS_PREFIX_CACHE_MB bounds the FlowLM KV prefix cache (0 disables). */
+static ptts_prefix_cache *create_prefix_cache(void) {
+    long mb = PTTS_PREFIX_CACHE_DEFAULT_MB;
+    const char *v = getenv("PTTS_PREFIX_CACHE_MB");
+    if (v && v[0]) mb = strtol(v, NULL, 10);
+    if (mb <= 0) return NULL;
+    return ptts_prefix_cache_create(PTTS_FLOWLM_LAYERS, PTTS_FLOWLM_DIM,
+                                    (size_t)mb << 20);
+}
+
+/* PTTS_KV_POOL_MB caps the shared FlowLM KV page pool (unset/0 = unbounded).
+ * PTTS_KV_WAIT_MS is how long a session blocks for pages another one is
+ * about to release before failing (0 = fail at once). */
+static ptts_kv_pool *create_kv_pool(void) {
+    long mb = 0;
+    const char *v = getenv("PTTS_KV_POOL_MB");
+    if (v && v[0]) mb = strtol(v, NULL, 10);
+    if (mb < 0) mb = 0;
+    ptts_kv_pool *pool = ptts_kv_pool_create(PTTS_FLOWLM_LAYERS, PTTS_FLOWLM_DIM,
+                                             (size_t)mb << 20);
+    v = getenv("PTTS_KV_WAIT_MS");
+    if (pool && v && v[0]) ptts_kv_pool_set_wait_ms(pool, strtod(v, NULL));
+    return pool;
+}
+
 ptts_ctx *ptts_load_dir(const char *model_dir) {
     if (!model_dir) {
         set_error("Model directory required");
@@ -379,12 +475,18 @@ ptts_ctx *ptts_load_dir(const char *model_dir) {
         return NULL;
     }
 
+    double t_open = ptts_time_ms();
     safetensors_file_t *sf = safetensors_open(weights_path);
     if (!sf) {
         free(weights_path);
         set_error("Failed to open safetensors file");
         return NULL;
     }
+    double open_ms = ptts_time_ms() - t_open;
+    if (ptts_timing_enabled()) {
+        fprintf(stderr, "[ptts] safetensors open: %.3f ms (%d tensors, %.1f KB header)\n",
+                open_ms, sf->num_tensors, sf->header_size / 1024.0);
+    }
 
     ptts_ctx *ctx = (ptts_ctx *)calloc(1, sizeof(ptts_ctx));
     if (!ctx) {
@@ -397,6 +499,7 @@ ptts_ctx *ptts_load_dir(const char *model_dir) {
     ctx->model_dir = strdup(model_dir);
     ctx->weights_path = weights_path;
     ctx->weights = sf;
+    ctx->load_times.open_ms = open_ms;
     ctx->sample_rate = PTTS_DEFAULT_SAMPLE_RATE;
 
     ctx->tokenizer_path = find_tokenizer_file(model_dir);
@@ -408,11 +511,24 @@ ptts_ctx *ptts_load_dir(const char *model_dir) {
         }
     }
 
+    ctx->prefix_cache = create_prefix_cache();
+    ctx->kv_pool = create_kv_pool();
+    pthread_mutex_init(&ctx->voice_lock, NULL);
+
     return ctx;
 }
 
 void ptts_free(ptts_ctx *ctx) {
     if (!ctx) return;
+    ptts_mimi_free(ctx->mimi);
+    ptts_flowlm_free(ctx->flowlm);
+    ptts_prefix_cache_free(ctx->prefix_cache);
+    ptts_kv_pool_free(ctx->kv_pool);
+    for (int i = 0; i < ctx->num_voices; i++) {
+        free(ctx->voices[i].name);
+        free(ctx->voices[i].cond);
+    }
+    pthread_mutex_destroy(&ctx->voice_lock);
     safetensors_close(ctx->weights);
     free(ctx->weights_path);
     free(ctx->tokenizer_path);
@@ -424,13 +540,18 @@ void ptts_free(ptts_ctx *ctx) {
 int ptts_print_info(const ptts_ctx *ctx) {
     if (!ctx || !ctx->weights) return -1;
     printf("Pocket-TTS model info\n");
-    printf("  Weights: %s\n", ctx->weights_path ? ctx->weights_path : "(none)");
+    printf("  Weights: %s%s\n", ctx->weights_path ? ctx->weights_path : "(none)",
+           ctx->weights->packed ? " (packed)" : "");
     printf("  Tokenizer: %s\n", ctx->tokenizer_path ? ctx->tokenizer_path : "(not found)");
     if (ctx->tokenizer) {
         printf("  Vocab size: %d\n", ptts_spm_vocab_size(ctx->tokenizer));
     }
     printf("  Tensors: %d\n", ctx->weights->num_tensors);
     printf("  Sample rate (default): %d\n", ctx->sample_rate);
+    printf("  Load: open %.2f ms", ctx->load_times.open_ms);
+    if (ctx->load_times.flowlm_ms > 0.0) printf(", FlowLM %.2f ms", ctx->load_times.flowlm_ms);
+    if (ctx->load_times.mimi_ms > 0.0) printf(", Mimi %.2f ms", ctx->load_times.mimi_ms);
+    printf("\n");
     return 0;
 }
 
@@ -457,13 +578,6 @@ int ptts_list_tensors_matching(const ptts_ctx *ctx, const char *substr) {
  * Weight verification (FlowLM + Mimi)
  * ======================================================================== */
 
-static int ends_with(const char *s, const char *suffix) {
-    size_t slen = strlen(s);
-    size_t tlen = strlen(suffix);
-    if (slen < tlen) return 0;
-    return strcmp(s + slen - tlen, suffix) == 0;
-}
-
 static const safetensor_t *find_tensor_exact(const ptts_ctx *ctx, const char *name) {
     return safetensors_find(ctx->weights, name);
 }
@@ -479,16 +593,11 @@ static const safetensor_t *find_tensor_with_prefix(const ptts_ctx *ctx, const ch
 
 static const safetensor_t *find_tensor_suffix(const ptts_ctx *ctx, const char *suffix,
                                               const char **found_name, int *ambiguous) {
-    const safetensor_t *match = NULL;
-    for (int i = 0; i < ctx->weights->num_tensors; i++) {
-        const safetensor_t *t = &ctx->weights->tensors[i];
-        if (ends_with(t->name, suffix)) {
-            if (match) {
-                if (ambiguous) *ambiguous = 1;
-                return NULL;
-            }
-            match = t;
-        }
+    int count = 0;
+    const safetensor_t *match = safetensors_find_suffix(ctx->weights, suffix, &count);
+    if (count > 1) {
+        if (ambiguous) *ambiguous = 1;
+        return NULL;
     }
     if (match && found_name) *found_name = match->name;
     return match;
@@ -1003,22 +1112,457 @@ int ptts_tokenize(ptts_ctx *ctx, const char *text, int **out_ids, int *out_len)
     return 0;
 }
 
+/* ========================================================================
+ * Packed model writer
+ *
+ * Every tensor goes in as the runtime reads it: F16/BF16 are widened to
+ * F32 once here, and the Mimi convs add their channels-last packings, so
+ * loading a .ptts file is an mmap plus pointer assignments.
+ * ======================================================================== */
+
+typedef struct {
+    safetensors_pack_entry *entries;
+    void **owned; /* per entry: buffer to free after writing, or NULL */
+    int n;
+    int cap;
+} pack_list;
+
+static int pack_push(pack_list *pl, const safetensors_pack_entry *e, void *owned) {
+    if (pl->n == pl->cap) {
+        int cap = pl->cap ? pl->cap * 2 : 256;
+        safetensors_pack_entry *ne = (safetensors_pack_entry *)realloc(
+            pl->entries, (size_t)cap * sizeof(*ne));
+        if (!ne) return -1;
+        pl->entries = ne;
+        void **no = (void **)realloc(pl->owned, (size_t)cap * sizeof(*no));
+        if (!no) return -1;
+        pl->owned = no;
+        pl->cap = cap;
+    }
+    pl->entries[pl->n] = *e;
+    pl->owned[pl->n] = owned;
+    pl->n++;
+    return 0;
+}
+
+static int pack_emit_mimi(void *user, const char *name, const float *data, size_t n) {
+    char *copy = strdup(name);
+    if (!copy) return -1;
+    safetensors_pack_entry e = {0};
+    e.name = copy;
+    e.dtype = DTYPE_F32;
+    e.ndim = 1;
+    e.shape[0] = (int64_t)n;
+    e.data = data;
+    e.data_size = n * sizeof(float);
+    if (pack_push((pack_list *)user, &e, copy) != 0) {
+        free(copy);
+        return -1;
+    }
+    return 0;
+}
+
+int ptts_pack_model(ptts_ctx *ctx, const char *out_path) {
+    if (!ctx || !ctx->weights || !out_path) {
+        set_error("Invalid arguments");
+        return -1;
+    }
+    const safetensors_file_t *sf = ctx->weights;
+    if (sf->packed) {
+        set_error("Weights are already packed");
+        return -1;
+    }
+
+    pack_list pl = {0};
+    int rc = 0;
+    for (int i = 0; i < sf->num_tensors && rc == 0; i++) {
+        const safetensor_t *t = &sf->tensors[i];
+        safetensors_pack_entry e = {0};
+        e.name = t->name;
+        e.ndim = t->ndim;
+        memcpy(e.shape, t->shape, sizeof(e.shape));
+        float *wide = NULL;
+        if (t->dtype == DTYPE_F16 || t->dtype == DTYPE_BF16) {
+            wide = safetensors_get_f32(sf, t);
+            if (!wide && safetensor_numel(t) > 0) {
+                rc = -1;
+                break;
+            }
+            e.dtype = DTYPE_F32;
+            e.data = wide;
+            e.data_size = (size_t)safetensor_numel(t) * sizeof(float);
+        } else {
+            e.dtype = t->dtype;
+            e.data = safetensors_data(sf, t);
+            e.data_size = t->data_size;
+        }
+        rc = pack_push(&pl, &e, wide);
+        if (rc != 0) free(wide);
+    }
+    if (rc != 0) set_error("Out of memory");
+
+    ptts_mimi *mm = NULL;
+    if (rc == 0) {
+        mm = ptts_mimi_load(ctx);
+        if (!mm) {
+            set_error("Failed to load Mimi weights");
+            rc = -1;
+        } else if (ptts_mimi_export_packed(mm, pack_emit_mimi, &pl) != 0) {
+            set_error("Out of memory");
+            rc = -1;
+        }
+    }
+    if (rc == 0 && safetensors_write_pack(out_path, pl.entries, pl.n) != 0) {
+        set_error("Failed to write packed model");
+        rc = -1;
+    }
+
+    ptts_mimi_free(mm);
+    for (int i = 0; i < pl.n; i++) free(pl.owned[i]);
+    free(pl.entries);
+    free(pl.owned);
+    return rc;
+}
+
+/* Evict a file from the page cache (best effort: pages still mapped
+ * elsewhere stay resident). */
+static void drop_page_cache(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+int ptts_load_time_ms(const char *model_dir, int cold, double *out_ms) {
+    if (!model_dir || !out_ms) return -1;
+    if (cold) {
+        char *path = find_weights_file(model_dir);
+        if (path) drop_page_cache(path);
+        free(path);
+    }
+    double t0 = ptts_time_ms();
+    ptts_ctx *ctx = ptts_load_dir(model_dir);
+    if (!ctx) return -1;
+    ptts_flowlm *fm = ptts_flowlm_load(ctx);
+    ptts_mimi *mm = fm ? ptts_mimi_load(ctx) : NULL;
+    *out_ms = ptts_time_ms() - t0;
+    int rc = (fm && mm) ? 0 : -1;
+    if (rc != 0) set_error("Failed to load model weights");
+    ptts_mimi_free(mm);
+    ptts_flowlm_free(fm);
+    ptts_free(ctx);
+    return rc;
+}
+
 const char *ptts_token_piece(ptts_ctx *ctx, int id, int *out_len) {
     if (!ctx || !ctx->tokenizer) return NULL;
     return ptts_spm_piece(ctx->tokenizer, id, out_len);
 }
 
+/* ========================================================================
+ * FlowLM -> Mimi pipeline
+ *
+ * A producer thread runs FlowLM and pushes each scaled latent into an SPSC
+ * ring as soon as it is sampled; the calling thread drains the ring and feeds
+ * whatever is queued to the incremental Mimi decoder. Wall time approaches
+ * max(FlowLM, Mimi) instead of their sum.
+ * ======================================================================== */
+
+#define PTTS_PIPELINE_QUEUE 64
+#define PTTS_PIPELINE_MAX_CHUNK 8
+
+/* PTTS_PIPELINE=0 decodes after FlowLM finishes (the only path that can use
+ * the CUDA conv stack, so CUDA builds default to it). */
+static int pipeline_enabled(void) {
+    static int inited = 0;
+    static int enabled = 1;
+    if (!inited) {
+        const char *v = getenv("PTTS_PIPELINE");
+#ifdef PTTS_USE_CUDA
+        enabled = (v && v[0] && strcmp(v, "0") != 0);
+#else
+        enabled = !(v && v[0] && strcmp(v, "0") == 0);
+#endif
+        inited = 1;
+    }
+    return enabled;
+}
+
+typedef struct {
+    ptts_flowlm *fm;
+    const int *ids;
+    int n;
+    const float *voice_cond;
+    int voice_len;
+    const ptts_params *p;
+    float *latents;
+    ptts_spsc *queue;
+    int used_frames;
+    int status;
+    double busy_ms;
+    double push_wait_ms;
+    ptts_flowlm_run_stats run;
+} pipeline_producer;
+
+static int pipeline_on_frame(void *user, int frame, const float *latent) {
+    pipeline_producer *pr = (pipeline_producer *)user;
+    (void)frame;
+    float scaled[PTTS_FLOWLM_LATENT_DIM];
+    ptts_flowlm_scale_latents(pr->fm, latent, 1, scaled);
+    double t0 = ptts_time_ms();
+    int rc = ptts_spsc_push_wait(pr->queue, scaled);
+    pr->push_wait_ms += ptts_time_ms() - t0;
+    return rc;
+}
+
+static void *pipeline_producer_main(void *arg) {
+    pipeline_producer *pr = (pipeline_producer *)arg;
+    const ptts_params *p = pr->p;
+    ptts_trace_thread_name("flowlm producer", 0);
+    double t0 = ptts_time_ms();
+    pr->status = ptts_flowlm_generate_latents_cb(pr->fm, pr->ids, pr->n, pr->voice_cond,
+                                                 pr->voice_len, p->num_frames, p->num_steps,
+                                                 p->temp, p->noise_clamp, p->seed, p->request_id,
+                                                 p->eos_enabled, p->eos_threshold,
+                                                 p->eos_min_frames, p->eos_after, pr->latents,
+                                                 &pr->used_frames, NULL, NULL, NULL,
+                                                 pipeline_on_frame, pr, &pr->run);
+    pr->busy_ms = ptts_time_ms() - t0 - pr->push_wait_ms;
+    ptts_spsc_close(pr->queue);
+    return NULL;
+}
+
+/* The FlowLM and Mimi parts of a ptts_stats. */
+static void stats_fill(ptts_stats *st, const ptts_flowlm_run_stats *f,
+                       const ptts_mimi_run_stats *m) {
+    st->prefill_ms = f->prefill_ms;
+    st->frame_ms_min = f->frame_ms_min;
+    st->frame_ms_mean = f->frame_ms_mean;
+    st->frame_ms_p95 = f->frame_ms_p95;
+    st->flow_ms = f->flow_ms;
+    st->frames = f->frames;
+    st->eos_frame = f->eos_frame;
+    st->mimi_transformer_ms = m->transformer_ms;
+    st->mimi_conv_ms = m->conv_ms;
+    st->peak_scratch_bytes = f->kv_bytes + m->scratch_bytes;
+}
+
+/* Returns decoded frames, or -1 (error already set). stats, if given, gets
+ * the FlowLM and Mimi parts and ttfa_ms from t_call. */
+static int generate_pipelined(ptts_flowlm *fm, ptts_mimi *mm, const int *ids, int n,
+                              const float *voice_cond, int voice_len, const ptts_params *p,
+                              float *latents, float *out_audio, ptts_audio_fn on_audio,
+                              void *user, ptts_stats *stats, double t_call) {
+    ptts_spsc *queue = ptts_spsc_create(PTTS_PIPELINE_QUEUE, PTTS_FLOWLM_LATENT_DIM);
+    ptts_mimi_stream *st = ptts_mimi_stream_create(mm);
+    if (!queue || !st) {
+        ptts_spsc_free(queue);
+        ptts_mimi_stream_free(st);
+        set_error("Out of memory");
+        return -1;
+    }
+
+    pipeline_producer pr = {fm, ids, n, voice_cond, voice_len, p, latents, queue,
+                            0, -1, 0.0, 0.0, {0.0, 0.0, 0.0, 0.0, 0.0, 0, -1, 0}};
+    double t_start = ptts_time_ms();
+    pthread_t th;
+    if (pthread_create(&th, NULL, pipeline_producer_main, &pr) != 0) {
+        ptts_spsc_free(queue);
+        ptts_mimi_stream_free(st);
+        set_error("Failed to start FlowLM thread");
+        return -1;
+    }
+
+    float chunk[PTTS_PIPELINE_MAX_CHUNK * PTTS_FLOWLM_LATENT_DIM];
+    int decoded = 0;
+    int chunks = 0;
+    int max_depth = 0;
+    long depth_sum = 0;
+    double mimi_ms = 0.0;
+    double wait_ms = 0.0;
+    double first_audio_ms = -1.0;
+    int failed = 0;
+    int stopped = 0;
+    for (;;) {
+        double t0 = ptts_time_ms();
+        if (ptts_spsc_pop_wait(queue, chunk) != 0) break;
+        double t1 = ptts_time_ms();
+        wait_ms += t1 - t0;
+
+        int depth = ptts_spsc_size(queue) + 1;
+        if (depth > max_depth) max_depth = depth;
+        depth_sum += depth;
+        int m = 1;
+        while (m < PTTS_PIPELINE_MAX_CHUNK && decoded + m < p->num_frames &&
+               ptts_spsc_pop(queue, chunk + (size_t)m * PTTS_FLOWLM_LATENT_DIM) == 0) {
+            m++;
+        }
+        if (decoded + m > p->num_frames) {
+            failed = 1;
+            break;
+        }
+
+        int len = 0;
+        if (ptts_mimi_stream_decode(st, chunk, m, out_audio + (size_t)decoded * PTTS_MIMI_FRAME_SAMPLES,
+                                    &len) != 0 ||
+            len != m * PTTS_MIMI_FRAME_SAMPLES) {
+            failed = 1;
+            break;
+        }
+        double t2 = ptts_time_ms();
+        mimi_ms += t2 - t1;
+        if (first_audio_ms < 0.0) first_audio_ms = t2 - t_start;
+        if (on_audio && on_audio(user, out_audio + (size_t)decoded * PTTS_MIMI_FRAME_SAMPLES, len) != 0) {
+            stopped = 1;
+            break;
+        }
+        decoded += m;
+        chunks++;
+    }
+    /* stop the producer early if decoding failed */
+    ptts_spsc_close(queue);
+    pthread_join(th, NULL);
+    ptts_spsc_free(queue);
+    ptts_mimi_run_stats mrs;
+    ptts_mimi_stream_get_stats(st, &mrs);
+    ptts_mimi_stream_free(st);
+
+    if (stopped) {
+        set_error("Stopped by audio callback");
+        return -1;
+    }
+    if (pr.status != 0) {
+        set_error("FlowLM forward failed");
+        return -1;
+    }
+    if (failed || decoded != pr.used_frames) {
+        set_error("Mimi decode failed");
+        return -1;
+    }
+    if (ptts_timing_enabled()) {
+        double wall = ptts_time_ms() - t_start;
+        fprintf(stderr, "[ptts] Pipeline: %.2f ms wall, FlowLM %.2f ms (+%.2f ms blocked), "
+                "Mimi %.2f ms (+%.2f ms waiting), first audio %.2f ms\n",
+                wall, pr.busy_ms, pr.push_wait_ms, mimi_ms, wait_ms, first_audio_ms);
+        fprintf(stderr, "[ptts] Pipeline: %d frames in %d chunks, queue depth max %d avg %.2f\n",
+                decoded, chunks, max_depth, chunks ? (double)depth_sum / chunks : 0.0);
+    }
+    if (stats) {
+        stats_fill(stats, &pr.run, &mrs);
+        /* no frame decoded: no first audio to time */
+        stats->ttfa_ms = first_audio_ms >= 0.0 ? t_start + first_audio_ms - t_call : 0.0;
+        stats->queue_depth_max = max_depth;
+        stats->queue_depth_mean = chunks ? (double)depth_sum / chunks : 0.0;
+        stats->producer_busy_ms = pr.busy_ms;
+        stats->producer_blocked_ms = pr.push_wait_ms;
+        stats->consumer_busy_ms = mimi_ms;
+        stats->consumer_wait_ms = wait_ms;
+    }
+    return decoded;
+}
+
+/* The context's preloaded models, or a private pair for this call. */
+static int acquire_models(ptts_ctx *ctx, ptts_flowlm **fm, ptts_mimi **mm) {
+    *fm = ctx->flowlm ? ctx->flowlm : ptts_flowlm_load(ctx);
+    if (!*fm) {
+        set_error("Failed to load FlowLM weights");
+        return -1;
+    }
+    *mm = ctx->mimi ? ctx->mimi : ptts_mimi_load(ctx);
+    if (!*mm) {
+        if (*fm != ctx->flowlm) ptts_flowlm_free(*fm);
+        set_error("Failed to load Mimi weights");
+        return -1;
+    }
+    return 0;
+}
+
+static void release_models(const ptts_ctx *ctx, ptts_flowlm *fm, ptts_mimi *mm) {
+    if (mm != ctx->mimi) ptts_mimi_free(mm);
+    if (fm != ctx->flowlm) ptts_flowlm_free(fm);
+}
+
+int ptts_preload(ptts_ctx *ctx, int readonly) {
+    if (!ctx) return -1;
+    /* resolve lazily read toggles before callers go multi-threaded */
+    (void)pipeline_enabled();
+    (void)ptts_timing_enabled();
+    if (!ctx->flowlm) ctx->flowlm = ptts_flowlm_load(ctx);
+    if (!ctx->flowlm) {
+        set_error("Failed to load FlowLM weights");
+        return -1;
+    }
+    if (!ctx->mimi) ctx->mimi = ptts_mimi_load(ctx);
+    if (!ctx->mimi) {
+        set_error("Failed to load Mimi weights");
+        return -1;
+    }
+    if (readonly && (ptts_flowlm_protect_weights(ctx->flowlm) != 0 ||
+                     ptts_mimi_protect_weights(ctx->mimi) != 0)) {
+        set_error("Failed to map weights read-only");
+        return -1;
+    }
+    return 0;
+}
+
+void ptts_governor_get_stats(const ptts_ctx *ctx, ptts_governor_stats *out) {
+    ptts_flowlm_governor_stats(ctx ? ctx->flowlm : NULL, out);
+}
+
+int ptts_session_limit(const ptts_ctx *ctx) {
+    (void)ctx;
+    return ptts_flowlm_session_limit();
+}
+
 ptts_audio *ptts_generate(ptts_ctx *ctx, const char *text,
                           const char *voice_path, const ptts_params *params) {
+    return ptts_generate_stats(ctx, text, voice_path, params, NULL, NULL, NULL);
+}
+
+ptts_audio *ptts_generate_stream(ptts_ctx *ctx, const char *text, const char *voice_path,
+                                 const ptts_params *params, ptts_audio_fn on_audio, void *user) {
+    return ptts_generate_stats(ctx, text, voice_path, params, on_audio, user, NULL);
+}
+
+/* total_ms and rtf, once the call is done. */
+static void stats_finish(ptts_stats *st, double t_call) {
+    if (!st) return;
+    st->total_ms = ptts_time_ms() - t_call;
+    st->rtf = st->frames > 0 ? st->total_ms / (st->frames * 80.0) : 0.0;
+}
+
+int ptts_stats_json(const ptts_stats *st, char *buf, size_t size) {
+    if (!st) return -1;
+    return snprintf(buf, size,
+                    "{\"tokenize_ms\":%.3f,\"voice_ms\":%.3f,\"prefill_ms\":%.3f,"
+                    "\"frame_ms\":{\"min\":%.3f,\"mean\":%.3f,\"p95\":%.3f},"
+                    "\"flow_ms\":%.3f,\"mimi_transformer_ms\":%.3f,\"mimi_conv_ms\":%.3f,"
+                    "\"ttfa_ms\":%.3f,\"total_ms\":%.3f,\"rtf\":%.4f,\"frames\":%d,"
+                    "\"eos_frame\":%d,\"peak_scratch_bytes\":%zu,"
+                    "\"pipeline\":{\"queue_depth_max\":%d,\"queue_depth_mean\":%.2f,"
+                    "\"producer_busy_ms\":%.3f,\"producer_blocked_ms\":%.3f,"
+                    "\"consumer_busy_ms\":%.3f,\"consumer_wait_ms\":%.3f}}",
+                    st->tokenize_ms, st->voice_ms, st->prefill_ms, st->frame_ms_min,
+                    st->frame_ms_mean, st->frame_ms_p95, st->flow_ms, st->mimi_transformer_ms,
+                    st->mimi_conv_ms, st->ttfa_ms, st->total_ms, st->rtf, st->frames,
+                    st->eos_frame, st->peak_scratch_bytes, st->queue_depth_max,
+                    st->queue_depth_mean, st->producer_busy_ms, st->producer_blocked_ms,
+                    st->consumer_busy_ms, st->consumer_wait_ms);
+}
+
+int ptts_prepare_request(ptts_ctx *ctx, const char *text, const ptts_params *params,
+                         ptts_params *out_p, int **out_ids, int *out_n) {
     if (!ctx || !text) {
         set_error("Text required");
-        return NULL;
+        return -1;
     }
 
     ptts_params p = PTTS_PARAMS_DEFAULT;
     if (params) p = *params;
     if (p.num_frames < 0) p.num_frames = 0;
     if (p.num_steps < 1) p.num_steps = 1;
+    if (p.num_steps > PTTS_MAX_STEPS) p.num_steps = PTTS_MAX_STEPS;
     if (p.eos_min_frames < 1) p.eos_min_frames = 1;
     if (p.eos_after < 0) p.eos_after = 0;
     if (p.sample_rate <= 0) p.sample_rate = PTTS_DEFAULT_SAMPLE_RATE;
@@ -1028,14 +1572,12 @@ ptts_audio *ptts_generate(ptts_ctx *ctx, const char *text,
     int eos_after_guess = 0;
     char *prepared = ptts_prepare_text(text, &word_count, &eos_after_guess);
     if (!prepared) {
-        return NULL;
+        return -1;
     }
 
-    int *ids = NULL;
-    int n = 0;
-    if (ptts_tokenize(ctx, prepared, &ids, &n) != 0) {
+    if (ptts_tokenize(ctx, prepared, out_ids, out_n) != 0) {
         free(prepared);
-        return NULL;
+        return -1;
     }
     free(prepared);
 
@@ -1043,52 +1585,82 @@ ptts_audio *ptts_generate(ptts_ctx *ctx, const char *text,
         p.num_frames = ptts_estimate_frames(word_count);
     }
     if (p.eos_after <= 0) p.eos_after = eos_after_guess;
+    *out_p = p;
+    return 0;
+}
 
-    ptts_flowlm *fm = ptts_flowlm_load(ctx);
-    if (!fm) {
-        free(ids);
-        set_error("Failed to load FlowLM weights");
-        return NULL;
-    }
-    ptts_mimi *mm = ptts_mimi_load(ctx);
-    if (!mm) {
-        ptts_flowlm_free(fm);
-        free(ids);
-        set_error("Failed to load Mimi weights");
+/* Body of ptts_generate_stats after tokenization; t_call is when the caller
+ * started, so tokenize_ms covers whatever ran before this. */
+static ptts_audio *generate_ids(ptts_ctx *ctx, const int *ids, int n, const ptts_params *params,
+                                const char *voice_path, ptts_audio_fn on_audio, void *user,
+                                ptts_stats *stats, double t_call) {
+    ptts_stats local;
+    memset(&local, 0, sizeof(local));
+    local.eos_frame = -1;
+    const ptts_params p = *params;
+    double t_voice = ptts_time_ms();
+    local.tokenize_ms = t_voice - t_call;
+
+    ptts_flowlm *fm = NULL;
+    ptts_mimi *mm = NULL;
+    if (acquire_models(ctx, &fm, &mm) != 0) {
         return NULL;
     }
 
     float *voice_cond = NULL;
     int voice_len = 0;
     if (ptts_load_voice_conditioning(ctx, voice_path, &voice_cond, &voice_len) != 0) {
-        ptts_mimi_free(mm);
-        ptts_flowlm_free(fm);
-        free(ids);
+        release_models(ctx, fm, mm);
         return NULL;
     }
+    local.voice_ms = ptts_time_ms() - t_voice;
 
     float *latents = (float *)malloc(sizeof(float) * 32 * (size_t)p.num_frames);
     if (!latents) {
         free(voice_cond);
-        ptts_mimi_free(mm);
-        ptts_flowlm_free(fm);
-        free(ids);
+        release_models(ctx, fm, mm);
         set_error("Out of memory");
         return NULL;
     }
 
+    if (pipeline_enabled()) {
+        ptts_audio *audio = ptts_audio_create(p.sample_rate, 1,
+                                              PTTS_MIMI_FRAME_SAMPLES * p.num_frames);
+        int frames = -1;
+        if (!audio) {
+            set_error("Out of memory");
+        } else {
+            frames = generate_pipelined(fm, mm, ids, n, voice_cond, voice_len, &p,
+                                        latents, audio->samples, on_audio, user,
+                                        stats ? &local : NULL, t_call);
+        }
+        free(latents);
+        free(voice_cond);
+        release_models(ctx, fm, mm);
+        if (frames < 0) {
+            ptts_audio_free(audio);
+            return NULL;
+        }
+        audio->num_samples = PTTS_MIMI_FRAME_SAMPLES * frames;
+        if (stats) {
+            stats_finish(&local, t_call);
+            *stats = local;
+        }
+        return audio;
+    }
+
     int used_frames = 0;
     double t_start = 0.0;
     if (ptts_timing_enabled()) t_start = ptts_time_ms();
-    if (ptts_flowlm_generate_latents(fm, ids, n, voice_cond, voice_len,
-                                     p.num_frames, p.num_steps, p.temp, p.noise_clamp,
-                                     p.seed, p.eos_enabled, p.eos_threshold, p.eos_min_frames,
-                                     p.eos_after, latents, &used_frames, NULL, NULL, NULL) != 0) {
+    ptts_flowlm_run_stats frs;
+    if (ptts_flowlm_generate_latents_cb(fm, ids, n, voice_cond, voice_len,
+                                        p.num_frames, p.num_steps, p.temp, p.noise_clamp,
+                                        p.seed, p.request_id, p.eos_enabled, p.eos_threshold,
+                                        p.eos_min_frames, p.eos_after, latents, &used_frames,
+                                        NULL, NULL, NULL, NULL, NULL, &frs) != 0) {
         free(latents);
         free(voice_cond);
-        ptts_mimi_free(mm);
-        ptts_flowlm_free(fm);
-        free(ids);
+        release_models(ctx, fm, mm);
         set_error("FlowLM forward failed");
         return NULL;
     }
@@ -1102,37 +1674,31 @@ ptts_audio *ptts_generate(ptts_ctx *ctx, const char *text,
     if (!scaled) {
         free(latents);
         free(voice_cond);
-        ptts_mimi_free(mm);
-        ptts_flowlm_free(fm);
-        free(ids);
+        release_models(ctx, fm, mm);
         set_error("Out of memory");
         return NULL;
     }
     ptts_flowlm_scale_latents(fm, latents, used_frames, scaled);
 
-    const int frame_samples = 16 * 6 * 5 * 4;
-    int total_samples = frame_samples * used_frames;
+    int total_samples = PTTS_MIMI_FRAME_SAMPLES * used_frames;
     ptts_audio *audio = ptts_audio_create(p.sample_rate, 1, total_samples);
     if (!audio) {
         free(latents);
         free(voice_cond);
-        ptts_mimi_free(mm);
-        ptts_flowlm_free(fm);
-        free(ids);
+        release_models(ctx, fm, mm);
         set_error("Out of memory");
         return NULL;
     }
 
     int wav_len = 0;
     if (ptts_timing_enabled()) t_start = ptts_time_ms();
-    if (ptts_mimi_decode(mm, scaled, used_frames, audio->samples, &wav_len) != 0) {
+    ptts_mimi_run_stats mrs;
+    if (ptts_mimi_decode_stats(mm, scaled, used_frames, audio->samples, &wav_len, &mrs) != 0) {
         ptts_audio_free(audio);
         free(scaled);
         free(latents);
         free(voice_cond);
-        ptts_mimi_free(mm);
-        ptts_flowlm_free(fm);
-        free(ids);
+        release_models(ctx, fm, mm);
         set_error("Mimi decode failed");
         return NULL;
     }
@@ -1145,21 +1711,52 @@ ptts_audio *ptts_generate(ptts_ctx *ctx, const char *text,
         free(scaled);
         free(latents);
         free(voice_cond);
-        ptts_mimi_free(mm);
-        ptts_flowlm_free(fm);
-        free(ids);
+        release_models(ctx, fm, mm);
         set_error("Unexpected Mimi output length");
         return NULL;
     }
     free(scaled);
     free(latents);
     free(voice_cond);
-    ptts_mimi_free(mm);
-    ptts_flowlm_free(fm);
+    release_models(ctx, fm, mm);
+    if (stats) {
+        stats_fill(&local, &frs, &mrs);
+        local.ttfa_ms = ptts_time_ms() - t_call;
+    }
+    if (on_audio && on_audio(user, audio->samples, wav_len) != 0) {
+        ptts_audio_free(audio);
+        set_error("Stopped by audio callback");
+        return NULL;
+    }
+    if (stats) {
+        stats_finish(&local, t_call);
+        *stats = local;
+    }
+    return audio;
+}
+
+ptts_audio *ptts_generate_stats(ptts_ctx *ctx, const char *text, const char *voice_path,
+                                const ptts_params *params, ptts_audio_fn on_audio, void *user,
+                                ptts_stats *stats) {
+    double t_call = ptts_time_ms();
+    ptts_params p;
+    int *ids = NULL;
+    int n = 0;
+    if (ptts_prepare_request(ctx, text, params, &p, &ids, &n) != 0) return NULL;
+    ptts_audio *audio = generate_ids(ctx, ids, n, &p, voice_path, on_audio, user, stats, t_call);
     free(ids);
     return audio;
 }
 
+ptts_audio *ptts_generate_ids(ptts_ctx *ctx, const int *ids, int n, const ptts_params *params,
+                              const char *voice_path) {
+    if (!ctx || !ids || n <= 0 || !params) {
+        set_error("Token ids required");
+        return NULL;
+    }
+    return generate_ids(ctx, ids, n, params, voice_path, NULL, NULL, NULL, ptts_time_ms());
+}
+
 /* ========================================================================
  * Dummy generator (placeholder audio)
  * ======================================================================== */
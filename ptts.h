@@ -1,6 +1,7 @@
 #ifndef PTTS_H
 #define PTTS_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include "ptts_audio.h"
 
@@ -13,6 +14,7 @@ extern "C" {
  * ======================================================================== */
 
 #define PTTS_DEFAULT_SAMPLE_RATE 24000
+#define PTTS_MAX_STEPS 64 /* LSD steps per frame; the default is 1 */
 
 /* ========================================================================
  * Opaque Types
@@ -29,6 +31,7 @@ typedef struct {
     int num_steps;    /* Flow matching steps (placeholder) */
     int num_frames;   /* Number of frames to generate (80ms each) */
     int64_t seed;     /* Random seed (-1 for random) */
+    uint64_t request_id; /* Noise stream id; same seed + id reproduces the same noise */
     float temp;       /* FlowLM noise temperature */
     float noise_clamp;/* Clamp noise to [-F, F] (0 disables) */
     int eos_enabled;  /* Enable EOS early stopping */
@@ -37,7 +40,7 @@ typedef struct {
     int eos_after;    /* Frames to keep after EOS (0 = auto) */
 } ptts_params;
 
-#define PTTS_PARAMS_DEFAULT { PTTS_DEFAULT_SAMPLE_RATE, 1, 0, -1, 0.7f, 0.0f, 1, -4.0f, 1, 0 }
+#define PTTS_PARAMS_DEFAULT { PTTS_DEFAULT_SAMPLE_RATE, 1, 0, -1, 0, 0.7f, 0.0f, 1, -4.0f, 1, 0 }
 
 /* ========================================================================
  * Core API
@@ -56,6 +59,14 @@ int ptts_list_tensors_matching(const ptts_ctx *ctx, const char *substr);
 /* Verify weights shapes against expected config (returns 0 on success). */
 int ptts_verify_weights(const ptts_ctx *ctx, int verbose);
 
+/* Write the loaded weights as a packed model (.ptts): runtime dtype and
+ * layout, 64-byte aligned, mmap'd and used in place by ptts_load_dir. */
+int ptts_pack_model(ptts_ctx *ctx, const char *out_path);
+
+/* Wall time of ptts_load_dir plus the FlowLM and Mimi weight loads. With
+ * cold set, the weights file is first dropped from the page cache. */
+int ptts_load_time_ms(const char *model_dir, int cold, double *out_ms);
+
 /* Tokenization (SentencePiece) */
 int ptts_tokenize(ptts_ctx *ctx, const char *text, int **out_ids, int *out_len);
 const char *ptts_token_piece(ptts_ctx *ctx, int id, int *out_len);
@@ -71,10 +82,80 @@ int ptts_estimate_frames(int word_count);
 int ptts_load_voice_conditioning(ptts_ctx *ctx, const char *voice_path,
                                  float **out_cond, int *out_len);
 
+/* Load FlowLM and Mimi once onto the context so ptts_generate reuses them
+ * instead of loading per call. Calls may then run concurrently from several
+ * threads (with PTTS_FLOW_THREADS they take turns on the flow-net team).
+ * readonly maps the converted weights read-only, for forked workers that
+ * share them copy-on-write. Returns 0 on success. */
+int ptts_preload(ptts_ctx *ctx, int readonly);
+
+/* How many generate calls may run FlowLM at once: 1 when PTTS_CUDA_ATTENTION
+ * keeps the KV cache resident on the GPU (one device cache per process),
+ * 0 for no limit. Callers that run requests concurrently cap to it. */
+int ptts_session_limit(const ptts_ctx *ctx);
+
 /* Generate audio (WIP) */
 ptts_audio *ptts_generate(ptts_ctx *ctx, const char *text,
                           const char *voice_path, const ptts_params *params);
 
+/* Streaming variant: on_audio gets each block of samples as soon as it is
+ * decoded (mono, in order, at most 8 frames of 1920 samples each; a single
+ * block when PTTS_PIPELINE=0). A non-zero return stops generation and the
+ * call fails. Returns the complete audio like ptts_generate. */
+typedef int (*ptts_audio_fn)(void *user, const float *samples, int num_samples);
+ptts_audio *ptts_generate_stream(ptts_ctx *ctx, const char *text, const char *voice_path,
+                                 const ptts_params *params, ptts_audio_fn on_audio, void *user);
+
+/* Where the time of one generate call went. Times are wall milliseconds
+ * from the start of the call; a FlowLM frame runs from sampling its latent
+ * through the transformer step that feeds it back. */
+typedef struct {
+    double tokenize_ms;          /* text preparation + SentencePiece */
+    double voice_ms;             /* voice conditioning load */
+    double prefill_ms;           /* FlowLM voice/text prefix */
+    double frame_ms_min;         /* FlowLM per frame */
+    double frame_ms_mean;
+    double frame_ms_p95;
+    double flow_ms;              /* flow net (LSD steps), all frames */
+    double mimi_transformer_ms;
+    double mimi_conv_ms;         /* upsampling + decoder conv stack */
+    double ttfa_ms;              /* until the first audio was decoded (0 if none was) */
+    double total_ms;
+    double rtf;                  /* total_ms / audio duration (< 1: faster than real time) */
+    int frames;
+    int eos_frame;               /* frame where EOS fired, -1 if it did not */
+    size_t peak_scratch_bytes;   /* FlowLM KV cache + Mimi activation working set */
+    /* FlowLM -> Mimi pipeline; all zero when PTTS_PIPELINE=0 */
+    int queue_depth_max;         /* latents queued when Mimi picked up a chunk */
+    double queue_depth_mean;
+    double producer_busy_ms;     /* FlowLM thread, excluding time blocked on a full ring */
+    double producer_blocked_ms;
+    double consumer_busy_ms;     /* Mimi decode on the calling thread */
+    double consumer_wait_ms;     /* calling thread waiting on an empty ring */
+} ptts_stats;
+
+/* ptts_generate_stream, filling *stats (may be NULL) on success. */
+ptts_audio *ptts_generate_stats(ptts_ctx *ctx, const char *text, const char *voice_path,
+                                const ptts_params *params, ptts_audio_fn on_audio, void *user,
+                                ptts_stats *stats);
+
+/* Writes stats as one line of JSON; returns the length snprintf would. */
+int ptts_stats_json(const ptts_stats *stats, char *buf, size_t size);
+
+/* Real-time governor totals since the preloaded FlowLM was loaded. With
+ * PTTS_GOVERNOR=1 every stream's frames are timed against an 80 ms-per-frame
+ * playback clock; a stream that falls behind runs fewer LSD steps (never
+ * more than it asked for) until it has headroom again. */
+typedef struct {
+    int enabled;
+    unsigned long frames;
+    unsigned long underruns; /* frames ready after their playback deadline */
+    unsigned long lowered;   /* step decreases */
+    unsigned long raised;    /* step increases */
+} ptts_governor_stats;
+
+void ptts_governor_get_stats(const ptts_ctx *ctx, ptts_governor_stats *out);
+
 /* Placeholder generator for pipeline testing */
 ptts_audio *ptts_generate_dummy(const char *text, const ptts_params *params);
 
@@ -4,20 +4,53 @@
 #include <stdlib.h>
 #include <string.h>
 
-static void write_u16_le(FILE *f, uint16_t v) {
-    uint8_t b[2];
+static void put_u16_le(uint8_t *b, uint16_t v) {
     b[0] = (uint8_t)(v & 0xff);
     b[1] = (uint8_t)((v >> 8) & 0xff);
-    fwrite(b, 1, 2, f);
 }
 
-static void write_u32_le(FILE *f, uint32_t v) {
-    uint8_t b[4];
+static void put_u32_le(uint8_t *b, uint32_t v) {
     b[0] = (uint8_t)(v & 0xff);
     b[1] = (uint8_t)((v >> 8) & 0xff);
     b[2] = (uint8_t)((v >> 16) & 0xff);
     b[3] = (uint8_t)((v >> 24) & 0xff);
-    fwrite(b, 1, 4, f);
+}
+
+void ptts_audio_wav_header(uint8_t hdr[PTTS_WAV_HEADER_SIZE], int sample_rate, int channels,
+                           uint32_t data_bytes) {
+    const uint16_t bits_per_sample = 16;
+    const uint16_t bytes_per_sample = bits_per_sample / 8;
+    const uint32_t byte_rate = (uint32_t)sample_rate * (uint32_t)channels * bytes_per_sample;
+    const uint16_t block_align = (uint16_t)(channels * bytes_per_sample);
+
+    /* RIFF header */
+    memcpy(hdr, "RIFF", 4);
+    put_u32_le(hdr + 4, data_bytes == PTTS_WAV_SIZE_UNKNOWN ? data_bytes : 36 + data_bytes);
+    memcpy(hdr + 8, "WAVE", 4);
+
+    /* fmt chunk */
+    memcpy(hdr + 12, "fmt ", 4);
+    put_u32_le(hdr + 16, 16);
+    put_u16_le(hdr + 20, 1); /* PCM */
+    put_u16_le(hdr + 22, (uint16_t)channels);
+    put_u32_le(hdr + 24, (uint32_t)sample_rate);
+    put_u32_le(hdr + 28, byte_rate);
+    put_u16_le(hdr + 32, block_align);
+    put_u16_le(hdr + 34, bits_per_sample);
+
+    /* data chunk */
+    memcpy(hdr + 36, "data", 4);
+    put_u32_le(hdr + 40, data_bytes);
+}
+
+void ptts_audio_to_s16le(const float *samples, size_t n, uint8_t *out) {
+    for (size_t i = 0; i < n; i++) {
+        float s = samples[i];
+        if (s > 1.0f) s = 1.0f;
+        if (s < -1.0f) s = -1.0f;
+        int16_t v = (int16_t)(s * 32767.0f);
+        put_u16_le(out + 2 * i, (uint16_t)v);
+    }
 }
 
 ptts_audio *ptts_audio_create(int sample_rate, int channels, int num_samples) {
@@ -51,40 +84,16 @@ int ptts_audio_save_wav(const ptts_audio *audio, const char *path) {
     FILE *f = fopen(path, "wb");
     if (!f) return -1;
 
-    const uint16_t bits_per_sample = 16;
-    const uint16_t bytes_per_sample = bits_per_sample / 8;
-    const uint32_t num_channels = (uint32_t)audio->channels;
-    const uint32_t sample_rate = (uint32_t)audio->sample_rate;
-    const uint32_t total_samples = (uint32_t)audio->num_samples * num_channels;
-    const uint32_t data_bytes = total_samples * bytes_per_sample;
-    const uint32_t byte_rate = sample_rate * num_channels * bytes_per_sample;
-    const uint16_t block_align = (uint16_t)(num_channels * bytes_per_sample);
+    const uint32_t total_samples = (uint32_t)audio->num_samples * (uint32_t)audio->channels;
+    uint8_t hdr[PTTS_WAV_HEADER_SIZE];
+    ptts_audio_wav_header(hdr, audio->sample_rate, audio->channels, total_samples * 2);
+    fwrite(hdr, 1, sizeof(hdr), f);
 
-    /* RIFF header */
-    fwrite("RIFF", 1, 4, f);
-    write_u32_le(f, 36 + data_bytes);
-    fwrite("WAVE", 1, 4, f);
-
-    /* fmt chunk */
-    fwrite("fmt ", 1, 4, f);
-    write_u32_le(f, 16);
-    write_u16_le(f, 1); /* PCM */
-    write_u16_le(f, (uint16_t)num_channels);
-    write_u32_le(f, sample_rate);
-    write_u32_le(f, byte_rate);
-    write_u16_le(f, block_align);
-    write_u16_le(f, bits_per_sample);
-
-    /* data chunk */
-    fwrite("data", 1, 4, f);
-    write_u32_le(f, data_bytes);
-
-    for (uint32_t i = 0; i < total_samples; i++) {
-        float s = audio->samples[i];
-        if (s > 1.0f) s = 1.0f;
-        if (s < -1.0f) s = -1.0f;
-        int16_t v = (int16_t)(s * 32767.0f);
-        write_u16_le(f, (uint16_t)v);
+    uint8_t buf[4096];
+    for (uint32_t i = 0; i < total_samples; i += sizeof(buf) / 2) {
+        uint32_t n = total_samples - i < sizeof(buf) / 2 ? total_samples - i : (uint32_t)(sizeof(buf) / 2);
+        ptts_audio_to_s16le(audio->samples + i, n, buf);
+        fwrite(buf, 2, n, f);
     }
 
     fclose(f);
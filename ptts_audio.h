@@ -2,6 +2,7 @@
 #define PTTS_AUDIO_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,6 +21,16 @@ void ptts_audio_free(ptts_audio *audio);
 /* Save audio as 16-bit PCM WAV. Returns 0 on success, -1 on error. */
 int ptts_audio_save_wav(const ptts_audio *audio, const char *path);
 
+/* 44-byte header of a 16-bit PCM WAV. For streams of unknown length pass
+ * PTTS_WAV_SIZE_UNKNOWN; most players then read data until EOF. */
+#define PTTS_WAV_HEADER_SIZE 44
+#define PTTS_WAV_SIZE_UNKNOWN 0xFFFFFFFFu
+void ptts_audio_wav_header(uint8_t hdr[PTTS_WAV_HEADER_SIZE], int sample_rate, int channels,
+                           uint32_t data_bytes);
+
+/* Clamp to [-1, 1] and write n samples as 16-bit little-endian (2n bytes). */
+void ptts_audio_to_s16le(const float *samples, size_t n, uint8_t *out);
+
 #ifdef __cplusplus
 }
 #endif
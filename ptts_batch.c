@@ -0,0 +1,334 @@
+/*
+ * ptts_batch.c - JSONL batch synthesis with one resident model
+ */
+
+#define _GNU_SOURCE
+#include "ptts_batch.h"
+#include "ptts_internal.h"
+#include "ptts_request.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+typedef struct {
+    int line;
+    ptts_request req;
+    const char *voice; /* req.voice or the batch default */
+    char *path;
+    ptts_params p; /* normalized by ptts_prepare_request */
+    int *ids;
+    int tokens;
+    double latency_ms;
+    double audio_s;
+    int failed;
+} batch_job;
+
+typedef struct {
+    batch_job *job;
+    ptts_audio *audio;
+} batch_write;
+
+typedef struct {
+    ptts_ctx *ctx;
+    batch_job **order;
+    int num_jobs;
+    int next; /* claimed with __atomic_fetch_add */
+    /* writer queue */
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    batch_write *ring;
+    int cap;
+    int head;
+    int count;
+    int producers_done;
+} batch_state;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+/* Same voice together so its conditioning and KV prefix stay cached, and
+ * long prompts first so the last worker does not finish alone on one. */
+static int job_order(const void *a, const void *b) {
+    const batch_job *x = *(const batch_job *const *)a;
+    const batch_job *y = *(const batch_job *const *)b;
+    int c = strcmp(x->voice, y->voice);
+    if (c != 0) return c;
+    if (x->tokens != y->tokens) return y->tokens - x->tokens;
+    return x->line - y->line;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of a sorted array. */
+static double percentile(const double *v, int n, double pct) {
+    if (n <= 0) return 0.0;
+    int k = (int)(pct / 100.0 * n + 0.999999);
+    if (k < 1) k = 1;
+    if (k > n) k = n;
+    return v[k - 1];
+}
+
+static void *writer_main(void *arg) {
+    batch_state *st = (batch_state *)arg;
+    for (;;) {
+        pthread_mutex_lock(&st->lock);
+        while (st->count == 0 && !st->producers_done) pthread_cond_wait(&st->not_empty, &st->lock);
+        if (st->count == 0) {
+            pthread_mutex_unlock(&st->lock);
+            return NULL;
+        }
+        batch_write w = st->ring[st->head];
+        st->head = (st->head + 1) % st->cap;
+        st->count--;
+        pthread_cond_signal(&st->not_full);
+        pthread_mutex_unlock(&st->lock);
+
+        if (ptts_audio_save_wav(w.audio, w.job->path) != 0) {
+            fprintf(stderr, "[ptts] batch: line %d: cannot write %s\n", w.job->line, w.job->path);
+            w.job->failed = 1;
+        }
+        ptts_audio_free(w.audio);
+    }
+}
+
+static void *worker_main(void *arg) {
+    batch_state *st = (batch_state *)arg;
+    for (;;) {
+        int i = __atomic_fetch_add(&st->next, 1, __ATOMIC_RELAXED);
+        if (i >= st->num_jobs) return NULL;
+        batch_job *job = st->order[i];
+        double t0 = now_ms();
+        ptts_audio *audio = ptts_generate_ids(st->ctx, job->ids, job->tokens, &job->p, job->voice);
+        job->latency_ms = now_ms() - t0;
+        if (!audio) {
+            fprintf(stderr, "[ptts] batch: line %d: %s\n", job->line, ptts_get_error());
+            job->failed = 1;
+            continue;
+        }
+        job->audio_s = (double)audio->num_samples / audio->sample_rate;
+
+        pthread_mutex_lock(&st->lock);
+        while (st->count == st->cap) pthread_cond_wait(&st->not_full, &st->lock);
+        st->ring[(st->head + st->count) % st->cap] = (batch_write){job, audio};
+        st->count++;
+        pthread_cond_signal(&st->not_empty);
+        pthread_mutex_unlock(&st->lock);
+    }
+}
+
+/* Parses and tokenizes one line; returns NULL or an error message. */
+static const char *prepare_job(ptts_ctx *ctx, batch_job *job, const char *line, size_t len,
+                               const char *out_dir, const char *voice, const ptts_params *params) {
+    const char *err = ptts_request_parse(line, len, params, &job->req);
+    if (err) return err;
+    job->voice = job->req.voice ? job->req.voice : (voice ? voice : "alba");
+
+    char name[32];
+    const char *out = job->req.out;
+    if (!out) {
+        snprintf(name, sizeof(name), "%06d.wav", job->line);
+        out = name;
+    }
+    if (strchr(out, '/') || out[0] == '.') return "\"out\" must be a plain file name";
+    size_t plen = strlen(out_dir) + strlen(out) + 2;
+    job->path = (char *)malloc(plen);
+    if (!job->path) return "out of memory";
+    snprintf(job->path, plen, "%s/%s", out_dir, out);
+
+    if (ptts_prepare_request(ctx, job->req.text, &job->req.params, &job->p, &job->ids,
+                             &job->tokens) != 0) {
+        return ptts_get_error();
+    }
+    return NULL;
+}
+
+int ptts_batch_run(ptts_ctx *ctx, const char *jsonl_path, const char *out_dir, int num_workers,
+                   const char *voice, const ptts_params *params) {
+    if (!ctx || !jsonl_path || !out_dir) return -1;
+    FILE *f = strcmp(jsonl_path, "-") == 0 ? stdin : fopen(jsonl_path, "r");
+    if (!f) {
+        fprintf(stderr, "[ptts] batch: cannot open %s: %s\n", jsonl_path, strerror(errno));
+        return -1;
+    }
+    if (mkdir(out_dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "[ptts] batch: cannot create %s: %s\n", out_dir, strerror(errno));
+        if (f != stdin) fclose(f);
+        return -1;
+    }
+
+    double t_start = now_ms();
+    batch_job *jobs = NULL;
+    int num_lines = 0;
+    int cap = 0;
+    int bad = 0;
+    char *line = NULL;
+    size_t line_cap = 0;
+    ssize_t len;
+    int line_no = 0;
+    while ((len = getline(&line, &line_cap, f)) >= 0) {
+        line_no++;
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = '\0';
+        size_t lead = strspn(line, " \t");
+        if (line[lead] == '\0') continue;
+        if (num_lines == cap) {
+            int ncap = cap ? cap * 2 : 64;
+            batch_job *nj = (batch_job *)realloc(jobs, sizeof(batch_job) * (size_t)ncap);
+            if (!nj) {
+                fprintf(stderr, "[ptts] batch: out of memory at line %d\n", line_no);
+                break;
+            }
+            jobs = nj;
+            cap = ncap;
+        }
+        batch_job *job = &jobs[num_lines++];
+        memset(job, 0, sizeof(*job));
+        job->line = line_no;
+        const char *err = prepare_job(ctx, job, line, (size_t)len, out_dir, voice, params);
+        if (err) {
+            fprintf(stderr, "[ptts] batch: line %d: %s\n", line_no, err);
+            job->failed = 1;
+            bad++;
+        }
+    }
+    free(line);
+    if (f != stdin) fclose(f);
+    double prep_ms = now_ms() - t_start;
+
+    int runnable = num_lines - bad;
+    batch_job **order = (batch_job **)malloc(sizeof(batch_job *) * (size_t)(runnable > 0 ? runnable : 1));
+    int rc = -1;
+    if (!order) goto done;
+    int n = 0;
+    for (int i = 0; i < num_lines; i++) {
+        if (!jobs[i].failed) order[n++] = &jobs[i];
+    }
+    qsort(order, (size_t)n, sizeof(batch_job *), job_order);
+    /* Load each voice once up front: the context keeps its conditioning, and
+     * a missing voice fails its lines before any synthesis. */
+    int groups = 0;
+    int kept = 0;
+    for (int i = 0, voice_ok = 0; i < n; i++) {
+        if (i == 0 || strcmp(order[i]->voice, order[i - 1]->voice) != 0) {
+            float *cond = NULL;
+            int cond_len = 0;
+            voice_ok = ptts_load_voice_conditioning(ctx, order[i]->voice, &cond, &cond_len) == 0;
+            free(cond);
+            if (!voice_ok) {
+                fprintf(stderr, "[ptts] batch: voice %s: %s\n", order[i]->voice, ptts_get_error());
+            }
+            groups++;
+        }
+        if (voice_ok) {
+            order[kept++] = order[i];
+        } else {
+            fprintf(stderr, "[ptts] batch: line %d: voice %s unavailable\n", order[i]->line,
+                    order[i]->voice);
+            order[i]->failed = 1;
+        }
+    }
+    n = kept;
+
+    if (num_workers <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = cpus > 1 ? (int)(cpus / 2) : 1;
+    }
+    if (num_workers > n) num_workers = n > 0 ? n : 1;
+    /* the resident CUDA KV cache holds one session */
+    if (num_workers > 1 && ptts_session_limit(ctx) == 1) num_workers = 1;
+    /* concurrent requests would queue for the model's one flow-net team */
+    if (num_workers > 1) unsetenv("PTTS_FLOW_THREADS");
+    if (n > 0 && ptts_preload(ctx, 0) != 0) {
+        fprintf(stderr, "[ptts] batch: %s\n", ptts_get_error());
+        goto done;
+    }
+
+    batch_state st;
+    memset(&st, 0, sizeof(st));
+    st.ctx = ctx;
+    st.order = order;
+    st.num_jobs = n;
+    st.cap = 2 * num_workers;
+    st.ring = (batch_write *)malloc(sizeof(batch_write) * (size_t)st.cap);
+    pthread_t *threads = (pthread_t *)malloc(sizeof(pthread_t) * (size_t)num_workers);
+    if (!st.ring || !threads) {
+        free(st.ring);
+        free(threads);
+        goto done;
+    }
+    pthread_mutex_init(&st.lock, NULL);
+    pthread_cond_init(&st.not_empty, NULL);
+    pthread_cond_init(&st.not_full, NULL);
+
+    double t_run = now_ms();
+    pthread_t writer;
+    int have_writer = pthread_create(&writer, NULL, writer_main, &st) == 0;
+    int started = 0;
+    for (; have_writer && started < num_workers; started++) {
+        if (pthread_create(&threads[started], NULL, worker_main, &st) != 0) break;
+    }
+    if (have_writer && started == 0) {
+        /* no worker thread: run the queue here */
+        worker_main(&st);
+    }
+    for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    if (have_writer) {
+        pthread_mutex_lock(&st.lock);
+        st.producers_done = 1;
+        pthread_cond_signal(&st.not_empty);
+        pthread_mutex_unlock(&st.lock);
+        pthread_join(writer, NULL);
+    }
+    double wall_s = (now_ms() - t_run) / 1000.0;
+    pthread_cond_destroy(&st.not_full);
+    pthread_cond_destroy(&st.not_empty);
+    pthread_mutex_destroy(&st.lock);
+    free(st.ring);
+    free(threads);
+    if (!have_writer) goto done;
+
+    double *lat = (double *)malloc(sizeof(double) * (size_t)(n > 0 ? n : 1));
+    int ok = 0;
+    double audio_s = 0.0;
+    for (int i = 0; i < n; i++) {
+        if (order[i]->failed) continue;
+        if (lat) lat[ok] = order[i]->latency_ms;
+        ok++;
+        audio_s += order[i]->audio_s;
+    }
+    int failed = num_lines - ok;
+    printf("Batch: %d ok, %d failed of %d requests (%d voices, %d workers)\n", ok, failed,
+           num_lines, groups, num_workers);
+    printf("Prepare: %.1f ms (parse + tokenize)\n", prep_ms);
+    printf("Audio: %.2f s in %.2f s wall = %.2f audio s per wall s\n", audio_s, wall_s,
+           wall_s > 0.0 ? audio_s / wall_s : 0.0);
+    if (lat && ok > 0) {
+        qsort(lat, (size_t)ok, sizeof(double), cmp_double);
+        printf("Latency: p50 %.1f ms, p95 %.1f ms, max %.1f ms\n", percentile(lat, ok, 50.0),
+               percentile(lat, ok, 95.0), lat[ok - 1]);
+    }
+    free(lat);
+    rc = failed > 0 ? 1 : 0;
+
+done:
+    for (int i = 0; i < num_lines; i++) {
+        ptts_request_clear(&jobs[i].req);
+        free(jobs[i].path);
+        free(jobs[i].ids);
+    }
+    free(jobs);
+    free(order);
+    return rc;
+}
@@ -0,0 +1,29 @@
+#ifndef PTTS_BATCH_H
+#define PTTS_BATCH_H
+
+#include "ptts.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Offline batch synthesis from a JSONL file ("-" for stdin): one request
+ * object per line (ptts_request.h), "out" naming the WAV inside out_dir
+ * (default: the line number, e.g. 000042.wav). The model is loaded once; all
+ * lines are parsed and tokenized before any synthesis, then run grouped by
+ * voice (longest first within a group) on num_workers threads, while a
+ * writer thread saves finished WAVs. A throughput and latency summary goes to stdout.
+ *
+ * num_workers <= 0 picks half the online CPUs (each synthesis already keeps
+ * a FlowLM and a Mimi thread busy). Returns 0 if every line succeeded, 1 if
+ * some failed, -1 if the batch could not run at all.
+ */
+int ptts_batch_run(ptts_ctx *ctx, const char *jsonl_path, const char *out_dir, int num_workers,
+                   const char *voice, const ptts_params *params);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTTS_BATCH_H */
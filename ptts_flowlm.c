@@ -1,6 +1,8 @@
 #include "ptts_flowlm.h"
 #include "ptts_internal.h"
 #include "ptts_kernels.h"
+#include "ptts_team.h"
+#include "ptts_trace.h"
 #ifdef PTTS_USE_CUDA
 #include "ptts_cuda.h"
 static int attn_cuda_enabled(void);
@@ -12,6 +14,7 @@ static int attn_cuda_cached_enabled(int T);
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -79,6 +82,7 @@ typedef struct {
 
 struct ptts_flowlm {
     ptts_ctx *ctx;
+    safetensors_arena arena; /* converted weights (load_f32) */
     float *embed_weight; /* [vocab+1, text_dim] */
     float *speaker_proj; /* [text_dim, 512] */
     float *emb_std;      /* [latent_dim] */
@@ -91,19 +95,16 @@ struct ptts_flowlm {
     float *out_eos_b;      /* [1] */
     ptts_flowlm_layer layers[FLOWLM_NUM_LAYERS];
     ptts_flow_net flow;
+    struct flow_team *flow_team; /* PTTS_FLOW_THREADS, NULL otherwise */
+    int governor;                /* PTTS_GOVERNOR */
+    ptts_governor_stats gov;     /* totals, updated atomically */
+    unsigned long gov_streams;   /* sessions created with the governor on */
 };
 
 /* ========================================================================
  * Helpers
  * ======================================================================== */
 
-static int ends_with(const char *s, const char *suffix) {
-    size_t slen = strlen(s);
-    size_t tlen = strlen(suffix);
-    if (slen < tlen) return 0;
-    return strcmp(s + slen - tlen, suffix) == 0;
-}
-
 static const safetensor_t *find_tensor_flowlm(const ptts_ctx *ctx, const char *name) {
     const safetensor_t *t = safetensors_find(ctx->weights, name);
     if (t) return t;
@@ -114,24 +115,26 @@ static const safetensor_t *find_tensor_flowlm(const ptts_ctx *ctx, const char *n
     if (t) return t;
 
     /* fallback by suffix */
-    for (int i = 0; i < ctx->weights->num_tensors; i++) {
-        const safetensor_t *cand = &ctx->weights->tensors[i];
-        if (ends_with(cand->name, name)) return cand;
-    }
-    return NULL;
+    return safetensors_find_suffix(ctx->weights, name, NULL);
 }
 
-static float *load_f32(const ptts_ctx *ctx, const char *name) {
+/* Queued on the batch loader: F32 tensors (every tensor of a packed model)
+ * are used in place, the rest are widened in safetensors_loader_run. */
+static float *load_f32(const ptts_ctx *ctx, safetensors_loader *ld, const char *name) {
     const safetensor_t *t = find_tensor_flowlm(ctx, name);
     if (!t) {
         fprintf(stderr, "Missing tensor: %s\n", name);
         return NULL;
     }
-    return safetensors_get_f32(ctx->weights, t);
+    return safetensors_loader_f32(ld, t);
 }
 
-static void free_ptr(float **p) {
-    if (*p) free(*p);
+/* Weights from load_f32 belong to the file mapping or fm->arena. */
+static void free_weight(const ptts_flowlm *fm, float **p) {
+    if (*p && !safetensors_contains(fm->ctx->weights, *p) &&
+        !safetensors_arena_contains(&fm->arena, *p)) {
+        free(*p);
+    }
     *p = NULL;
 }
 
@@ -337,12 +340,14 @@ static void rope_apply_one(float *q, float *k, int H, int D, float max_period, i
     int half = D / 2;
     static int init = 0;
     static float freqs[FLOWLM_HEAD_DIM / 2];
-    if (!init) {
+    /* Concurrent first calls all write the same values; the release store
+     * keeps a reader from seeing init before the table. */
+    if (!__atomic_load_n(&init, __ATOMIC_ACQUIRE)) {
         float log_mp = logf(max_period);
         for (int i = 0; i < half; i++) {
             freqs[i] = expf(-log_mp * (2.0f * i / D));
         }
-        init = 1;
+        __atomic_store_n(&init, 1, __ATOMIC_RELEASE);
     }
 
     float ts = (float)pos;
@@ -367,32 +372,54 @@ static void rope_apply_one(float *q, float *k, int H, int D, float max_period, i
     }
 }
 
+/* KV rows live in pages from a shared ptts_kv_pool; pages[i] covers positions
+ * [i * PTTS_KV_PAGE_POS, (i + 1) * PTTS_KV_PAGE_POS). Pages are taken as the
+ * sequence grows and returned when the cache is freed. */
 typedef struct {
     int max_len;
     int seq_len;
-    float *k_cache[FLOWLM_NUM_LAYERS];
-    float *v_cache[FLOWLM_NUM_LAYERS];
+    ptts_kv_pool *pool;
+    int own_pool;
+    float **pages;
+    int num_pages;
     float *scores;
+#ifdef PTTS_USE_CUDA
+    float *flat_k; /* contiguous copies for the non-resident CUDA attention path */
+    float *flat_v;
+#endif
 } ptts_flowlm_kv_cache;
 
+#define KV_PAGE_ROWS ((size_t)PTTS_KV_PAGE_POS * FLOWLM_D_MODEL)
+
+static inline float *kv_page_rows(const ptts_flowlm_kv_cache *cache, int page, int l, int is_v) {
+    return cache->pages[page] + (size_t)(l * 2 + is_v) * KV_PAGE_ROWS;
+}
+
+static inline float *kv_row(const ptts_flowlm_kv_cache *cache, int l, int is_v, int pos) {
+    return kv_page_rows(cache, pos / PTTS_KV_PAGE_POS, l, is_v) +
+           (size_t)(pos % PTTS_KV_PAGE_POS) * FLOWLM_D_MODEL;
+}
+
+static float *kv_row_fn(void *user, int layer, int is_v, int pos) {
+    return kv_row((const ptts_flowlm_kv_cache *)user, layer, is_v, pos);
+}
+
 static void kv_cache_free(ptts_flowlm_kv_cache *cache);
 
-static ptts_flowlm_kv_cache *kv_cache_create(int max_len) {
+static ptts_flowlm_kv_cache *kv_cache_create(ptts_kv_pool *pool, int max_len) {
     ptts_flowlm_kv_cache *cache = (ptts_flowlm_kv_cache *)calloc(1, sizeof(*cache));
     if (!cache) return NULL;
     cache->max_len = max_len;
     cache->seq_len = 0;
-    size_t kv_elems = (size_t)max_len * FLOWLM_NUM_HEADS * FLOWLM_HEAD_DIM;
-    for (int i = 0; i < FLOWLM_NUM_LAYERS; i++) {
-        cache->k_cache[i] = (float *)malloc(kv_elems * sizeof(float));
-        cache->v_cache[i] = (float *)malloc(kv_elems * sizeof(float));
-        if (!cache->k_cache[i] || !cache->v_cache[i]) {
-            kv_cache_free(cache);
-            return NULL;
-        }
+    cache->pool = pool;
+    if (!cache->pool) {
+        cache->pool = ptts_kv_pool_create(FLOWLM_NUM_LAYERS, FLOWLM_D_MODEL, 0);
+        cache->own_pool = 1;
     }
+    int max_pages = (max_len + PTTS_KV_PAGE_POS - 1) / PTTS_KV_PAGE_POS;
+    cache->pages = (float **)calloc((size_t)max_pages, sizeof(float *));
     cache->scores = (float *)malloc((size_t)max_len * sizeof(float));
-    if (!cache->scores) {
+    if (!cache->pool || !cache->pages || !cache->scores) {
         kv_cache_free(cache);
         return NULL;
     }
@@ -407,20 +434,103 @@ static ptts_flowlm_kv_cache *kv_cache_create(int max_len) {
     return cache;
 }
 
+/* Make sure positions [0, len) are backed by pages. Returns 0, 1 when the
+ * pool budget is spent (pages taken so far stay with the cache, so a retry
+ * continues from there), or -1 past max_len. */
+static int kv_cache_try_reserve(ptts_flowlm_kv_cache *cache, int len) {
+    if (len > cache->max_len) return -1;
+    int need = (len + PTTS_KV_PAGE_POS - 1) / PTTS_KV_PAGE_POS;
+    while (cache->num_pages < need) {
+        float *page = ptts_kv_pool_alloc(cache->pool);
+        if (!page) return 1;
+        cache->pages[cache->num_pages++] = page;
+    }
+    return 0;
+}
+
+/* As kv_cache_try_reserve, but a spent budget waits for other sessions to
+ * release pages (ptts_kv_pool_wait) and fails only when none will. */
+static int kv_cache_reserve(ptts_flowlm_kv_cache *cache, int len) {
+    int rc;
+    while ((rc = kv_cache_try_reserve(cache, len)) == 1) {
+        if (ptts_kv_pool_wait(cache->pool, cache->num_pages) != 0) return -1;
+    }
+    return rc;
+}
+
 static void kv_cache_free(ptts_flowlm_kv_cache *cache) {
     if (!cache) return;
-    for (int i = 0; i < FLOWLM_NUM_LAYERS; i++) {
-        free(cache->k_cache[i]);
-        free(cache->v_cache[i]);
-    }
+    for (int i = 0; i < cache->num_pages; i++) ptts_kv_pool_release(cache->pool, cache->pages[i]);
+    if (cache->own_pool) ptts_kv_pool_free(cache->pool);
+    free(cache->pages);
     free(cache->scores);
+#ifdef PTTS_USE_CUDA
+    free(cache->flat_k);
+    free(cache->flat_v);
+#endif
     free(cache);
 }
 
+#ifdef PTTS_USE_CUDA
+/* Gather one layer's first n rows into contiguous buffers. */
+static int kv_cache_flatten(ptts_flowlm_kv_cache *cache, int l, int n) {
+    size_t elems = (size_t)cache->max_len * FLOWLM_D_MODEL;
+    if (!cache->flat_k) cache->flat_k = (float *)malloc(elems * sizeof(float));
+    if (!cache->flat_v) cache->flat_v = (float *)malloc(elems * sizeof(float));
+    if (!cache->flat_k || !cache->flat_v) return -1;
+    for (int p = 0; p * PTTS_KV_PAGE_POS < n; p++) {
+        int rows = n - p * PTTS_KV_PAGE_POS;
+        if (rows > PTTS_KV_PAGE_POS) rows = PTTS_KV_PAGE_POS;
+        size_t off = (size_t)p * KV_PAGE_ROWS;
+        memcpy(cache->flat_k + off, kv_page_rows(cache, p, l, 0),
+               (size_t)rows * FLOWLM_D_MODEL * sizeof(float));
+        memcpy(cache->flat_v + off, kv_page_rows(cache, p, l, 1),
+               (size_t)rows * FLOWLM_D_MODEL * sizeof(float));
+    }
+    return 0;
+}
+#endif
+
+/* Attention of one query row at pos over the cached keys/values [0, pos]. */
+static void attention_step_cpu(ptts_flowlm_kv_cache *cache, int l, int pos, const float *q,
+                               float *attn_out) {
+    int d = FLOWLM_D_MODEL;
+    int h = FLOWLM_NUM_HEADS;
+    int hd = FLOWLM_HEAD_DIM;
+    float *scores = cache->scores;
+    for (int hh = 0; hh < h; hh++) {
+        float *out = attn_out + hh * hd;
+        int n_keys = pos + 1;
+        const float *qvec = q + hh * hd;
+        for (int tk0 = 0, p = 0; tk0 < n_keys; tk0 += PTTS_KV_PAGE_POS, p++) {
+            const float *kpage = kv_page_rows(cache, p, l, 0) + (size_t)hh * hd;
+            int rows = n_keys - tk0 < PTTS_KV_PAGE_POS ? n_keys - tk0 : PTTS_KV_PAGE_POS;
+            for (int j = 0; j < rows; j++) {
+                const float *kvec = kpage + (size_t)j * d;
+                float dot = 0.0f;
+                for (int d0 = 0; d0 < hd; d0++) dot += qvec[d0] * kvec[d0];
+                scores[tk0 + j] = dot / sqrtf((float)hd);
+            }
+        }
+        softmax_inplace(scores, n_keys);
+        for (int d0 = 0; d0 < hd; d0++) out[d0] = 0.0f;
+        for (int tk0 = 0, p = 0; tk0 < n_keys; tk0 += PTTS_KV_PAGE_POS, p++) {
+            const float *vpage = kv_page_rows(cache, p, l, 1) + (size_t)hh * hd;
+            int rows = n_keys - tk0 < PTTS_KV_PAGE_POS ? n_keys - tk0 : PTTS_KV_PAGE_POS;
+            for (int j = 0; j < rows; j++) {
+                const float *vvec = vpage + (size_t)j * d;
+                float w = scores[tk0 + j];
+                for (int d0 = 0; d0 < hd; d0++) out[d0] += w * vvec[d0];
+            }
+        }
+    }
+}
+
 static int transformer_forward_step_cached(const ptts_flowlm *fm, ptts_flowlm_kv_cache *cache,
                                            float *x) {
     if (!fm || !cache || !x) return -1;
     if (cache->seq_len >= cache->max_len) return -1;
+    if (kv_cache_reserve(cache, cache->seq_len + 1) != 0) return -1;
 
     int d = FLOWLM_D_MODEL;
     int h = FLOWLM_NUM_HEADS;
@@ -438,6 +548,7 @@ static int transformer_forward_step_cached(const ptts_flowlm *fm, ptts_flowlm_kv
 
     for (int l = 0; l < FLOWLM_NUM_LAYERS; l++) {
         const ptts_flowlm_layer *layer = &fm->layers[l];
+        PTTS_TRACE_BEGIN(t_trace);
 
         layernorm_forward(x, 1, d, layer->norm1_w, layer->norm1_b, 1e-5f, x_norm);
         linear_forward(layer->in_proj_w, NULL, 3 * d, d, x_norm, 1, qkv);
@@ -448,9 +559,8 @@ static int transformer_forward_step_cached(const ptts_flowlm *fm, ptts_flowlm_kv
 
         rope_apply_one(q, k, h, hd, FLOWLM_MAX_PERIOD, pos);
 
-        size_t base = (size_t)pos * h * hd;
-        memcpy(cache->k_cache[l] + base, k, (size_t)d * sizeof(float));
-        memcpy(cache->v_cache[l] + base, v, (size_t)d * sizeof(float));
+        memcpy(kv_row(cache, l, 0, pos), k, (size_t)d * sizeof(float));
+        memcpy(kv_row(cache, l, 1, pos), v, (size_t)d * sizeof(float));
 
         int use_gpu = 0;
 #ifdef PTTS_USE_CUDA
@@ -471,7 +581,8 @@ static int transformer_forward_step_cached(const ptts_flowlm *fm, ptts_flowlm_kv
                     use_gpu = 1;
                 }
             } else {
-                if (ptts_cuda_attention_step(q, cache->k_cache[l], cache->v_cache[l],
+                if (kv_cache_flatten(cache, l, pos + 1) == 0 &&
+                    ptts_cuda_attention_step(q, cache->flat_k, cache->flat_v,
                                              pos + 1, h, hd, attn_out) == 0) {
                     use_gpu = 1;
                 }
@@ -479,27 +590,7 @@ static int transformer_forward_step_cached(const ptts_flowlm *fm, ptts_flowlm_kv
         }
 #endif
 
-        if (!use_gpu) {
-            float *scores = cache->scores;
-            for (int hh = 0; hh < h; hh++) {
-                float *out = attn_out + hh * hd;
-                int n_keys = pos + 1;
-                const float *qvec = q + hh * hd;
-                for (int tk = 0; tk < n_keys; tk++) {
-                    const float *kvec = cache->k_cache[l] + ((size_t)tk * h + hh) * hd;
-                    float dot = 0.0f;
-                    for (int d0 = 0; d0 < hd; d0++) dot += qvec[d0] * kvec[d0];
-                    scores[tk] = dot / sqrtf((float)hd);
-                }
-                softmax_inplace(scores, n_keys);
-                for (int d0 = 0; d0 < hd; d0++) out[d0] = 0.0f;
-                for (int tk = 0; tk < n_keys; tk++) {
-                    const float *vvec = cache->v_cache[l] + ((size_t)tk * h + hh) * hd;
-                    float w = scores[tk];
-                    for (int d0 = 0; d0 < hd; d0++) out[d0] += w * vvec[d0];
-                }
-            }
-        }
+        if (!use_gpu) attention_step_cpu(cache, l, pos, q, attn_out);
 
 #ifdef PTTS_USE_CUDA
         if (validate && attn_cuda_cached_enabled(pos + 1)) {
@@ -511,7 +602,8 @@ static int transformer_forward_step_cached(const ptts_flowlm *fm, ptts_flowlm_kv
                     ok = 1;
                 }
             } else {
-                if (ptts_cuda_attention_step(q, cache->k_cache[l], cache->v_cache[l],
+                if (kv_cache_flatten(cache, l, pos + 1) == 0 &&
+                    ptts_cuda_attention_step(q, cache->flat_k, cache->flat_v,
                                              pos + 1, h, hd, attn_gpu) == 0) {
                     ok = 1;
                 }
@@ -536,12 +628,68 @@ static int transformer_forward_step_cached(const ptts_flowlm *fm, ptts_flowlm_kv
         gelu_inplace(ff1, FLOWLM_HIDDEN);
         linear_forward(layer->linear2_w, NULL, d, FLOWLM_HIDDEN, ff1, 1, ff2);
         for (int i = 0; i < d; i++) x[i] += ff2[i];
+        PTTS_TRACE_END(t_trace, "flowlm.layer", l);
     }
 
     cache->seq_len++;
     return 0;
 }
 
+/* One new position for each of n sessions. The rows are stacked so every
+ * projection is a single n-row linear_forward that reads the weights once;
+ * RoPE, the KV append and attention stay per session. CPU attention only. */
+static int transformer_forward_step_batch(const ptts_flowlm *fm, ptts_flowlm_kv_cache **caches,
+                                          int n, float *x) {
+    if (!fm || !caches || n <= 0 || !x) return -1;
+    /* pages are reserved by the caller, one session at a time */
+    for (int b = 0; b < n; b++) {
+        if (caches[b]->num_pages * PTTS_KV_PAGE_POS <= caches[b]->seq_len) return -1;
+    }
+
+    int d = FLOWLM_D_MODEL;
+    float *x_norm = (float *)malloc((size_t)n * d * sizeof(float));
+    float *qkv = (float *)malloc((size_t)n * d * 3 * sizeof(float));
+    float *attn_out = (float *)malloc((size_t)n * d * sizeof(float));
+    float *ff1 = (float *)malloc((size_t)n * FLOWLM_HIDDEN * sizeof(float));
+    if (!x_norm || !qkv || !attn_out || !ff1) {
+        free(x_norm); free(qkv); free(attn_out); free(ff1);
+        return -1;
+    }
+
+    for (int l = 0; l < FLOWLM_NUM_LAYERS; l++) {
+        const ptts_flowlm_layer *layer = &fm->layers[l];
+        PTTS_TRACE_BEGIN(t_trace);
+
+        layernorm_forward(x, n, d, layer->norm1_w, layer->norm1_b, 1e-5f, x_norm);
+        linear_forward(layer->in_proj_w, NULL, 3 * d, d, x_norm, n, qkv);
+
+        for (int b = 0; b < n; b++) {
+            ptts_flowlm_kv_cache *cache = caches[b];
+            int pos = cache->seq_len;
+            float *q = qkv + (size_t)b * 3 * d;
+            float *k = q + d;
+            rope_apply_one(q, k, FLOWLM_NUM_HEADS, FLOWLM_HEAD_DIM, FLOWLM_MAX_PERIOD, pos);
+            memcpy(kv_row(cache, l, 0, pos), k, (size_t)d * sizeof(float));
+            memcpy(kv_row(cache, l, 1, pos), k + d, (size_t)d * sizeof(float));
+            attention_step_cpu(cache, l, pos, q, attn_out + (size_t)b * d);
+        }
+
+        linear_forward(layer->out_proj_w, NULL, d, d, attn_out, n, x_norm);
+        for (size_t i = 0; i < (size_t)n * d; i++) x[i] += x_norm[i];
+
+        layernorm_forward(x, n, d, layer->norm2_w, layer->norm2_b, 1e-5f, x_norm);
+        linear_forward(layer->linear1_w, NULL, FLOWLM_HIDDEN, d, x_norm, n, ff1);
+        gelu_inplace(ff1, n * FLOWLM_HIDDEN);
+        linear_forward(layer->linear2_w, NULL, d, FLOWLM_HIDDEN, ff1, n, x_norm);
+        for (size_t i = 0; i < (size_t)n * d; i++) x[i] += x_norm[i];
+        PTTS_TRACE_END(t_trace, "flowlm.layer_batch", l);
+    }
+
+    for (int b = 0; b < n; b++) caches[b]->seq_len++;
+    free(x_norm); free(qkv); free(attn_out); free(ff1);
+    return 0;
+}
+
 /* ========================================================================
  * Flow net
  * ======================================================================== */
@@ -611,8 +759,260 @@ static int attn_cuda_cached_enabled(int T) {
 }
 #endif
 
+/* ========================================================================
+ * Weight-stationary flow net
+ *
+ * With PTTS_FLOW_THREADS=N (N >= 2) a pinned team of N workers each keeps a
+ * fixed row slice of every flow-net matrix, copied by the worker itself so
+ * the pages are local and the slice (about 30 MB / N in f32) can stay in that
+ * core's L2 across LSD steps and frames. Every GEMV is a parallel partial
+ * over resident rows into a shared vector followed by a team barrier; the
+ * small vector ops are repeated per worker on private copies.
+ * ======================================================================== */
+
+typedef struct {
+    float *w;       /* rows [r0, r1) of the full matrix, worker-local */
+    const float *b; /* full bias (shared, read-only) */
+    int r0;
+    int r1;
+    int in;
+} shard_mat;
+
+typedef struct {
+    shard_mat input;
+    shard_mat cond;
+    shard_mat t_lin0[2];
+    shard_mat t_lin2[2];
+    shard_mat ada[FLOWLM_FLOW_DEPTH];
+    shard_mat mlp0[FLOWLM_FLOW_DEPTH];
+    shard_mat mlp2[FLOWLM_FLOW_DEPTH];
+    shard_mat final_ada;
+    shard_mat final_linear;
+} flow_shard;
+
+struct flow_team {
+    ptts_team *team;
+    pthread_mutex_t lock; /* one job at a time when callers share the model */
+    const ptts_flowlm *fm;
+    flow_shard *shards;
+    int failed;
+    /* current job */
+    const float *cond;
+    const float *x_in;
+    float s;
+    float t;
+    /* shared activations, each written by row owners between barriers */
+    float x[FLOWLM_FLOW_DIM];
+    float c[FLOWLM_FLOW_DIM];
+    float e0[2][FLOWLM_FLOW_DIM];
+    float e2[2][FLOWLM_FLOW_DIM];
+    float ada[FLOWLM_FLOW_DEPTH][FLOWLM_FLOW_DIM * 3];
+    float ada2[FLOWLM_FLOW_DIM * 2];
+    float mlp[FLOWLM_FLOW_DIM];
+    float out[FLOWLM_LATENT_DIM];
+};
+
+static int shard_init(shard_mat *m, const float *w, const float *b, int rows, int in,
+                      int worker, int num_workers) {
+    int chunk = (rows + num_workers - 1) / num_workers;
+    chunk = (chunk + 7) & ~7;
+    m->r0 = worker * chunk < rows ? worker * chunk : rows;
+    m->r1 = m->r0 + chunk < rows ? m->r0 + chunk : rows;
+    m->in = in;
+    m->b = b;
+    m->w = NULL;
+    if (m->r1 == m->r0) return 0;
+    m->w = (float *)malloc((size_t)(m->r1 - m->r0) * in * sizeof(float));
+    if (!m->w) return -1;
+    memcpy(m->w, w + (size_t)m->r0 * in, (size_t)(m->r1 - m->r0) * in * sizeof(float));
+    return 0;
+}
+
+/* y[r] = b[r] + W[r] . x for the owned rows (same summation as ptts_linear_forward). */
+static void shard_gemv(const shard_mat *m, const float *x, float *y) {
+    int in = m->in;
+    for (int r = m->r0; r < m->r1; r++) {
+        const float *wrow = m->w + (size_t)(r - m->r0) * in;
+        float sum = m->b ? m->b[r] : 0.0f;
+        int i = 0;
+        for (; i <= in - 4; i += 4) {
+            sum += wrow[i] * x[i] +
+                   wrow[i+1] * x[i+1] +
+                   wrow[i+2] * x[i+2] +
+                   wrow[i+3] * x[i+3];
+        }
+        for (; i < in; i++) sum += wrow[i] * x[i];
+        y[r] = sum;
+    }
+}
+
+static void flow_team_init(void *arg, int worker, int num_workers) {
+    struct flow_team *ft = (struct flow_team *)arg;
+    const ptts_flow_net *fn = &ft->fm->flow;
+    flow_shard *sh = &ft->shards[worker];
+    const int D = FLOWLM_FLOW_DIM;
+    int rc = 0;
+    rc |= shard_init(&sh->input, fn->input_w, fn->input_b, D, FLOWLM_LATENT_DIM, worker, num_workers);
+    rc |= shard_init(&sh->cond, fn->cond_w, fn->cond_b, D, FLOWLM_D_MODEL, worker, num_workers);
+    for (int i = 0; i < 2; i++) {
+        rc |= shard_init(&sh->t_lin0[i], fn->time[i].lin0_w, fn->time[i].lin0_b, D, 256,
+                         worker, num_workers);
+        rc |= shard_init(&sh->t_lin2[i], fn->time[i].lin2_w, fn->time[i].lin2_b, D, D,
+                         worker, num_workers);
+    }
+    for (int b = 0; b < FLOWLM_FLOW_DEPTH; b++) {
+        const ptts_resblock *rb = &fn->res[b];
+        rc |= shard_init(&sh->ada[b], rb->ada_w, rb->ada_b, 3 * D, D, worker, num_workers);
+        rc |= shard_init(&sh->mlp0[b], rb->mlp0_w, rb->mlp0_b, D, D, worker, num_workers);
+        rc |= shard_init(&sh->mlp2[b], rb->mlp2_w, rb->mlp2_b, D, D, worker, num_workers);
+    }
+    rc |= shard_init(&sh->final_ada, fn->final.ada_w, fn->final.ada_b, 2 * D, D,
+                     worker, num_workers);
+    rc |= shard_init(&sh->final_linear, fn->final.linear_w, fn->final.linear_b,
+                     FLOWLM_LATENT_DIM, D, worker, num_workers);
+    if (rc) ft->failed = 1;
+}
+
+static void flow_shard_free(flow_shard *sh) {
+    free(sh->input.w);
+    free(sh->cond.w);
+    for (int i = 0; i < 2; i++) {
+        free(sh->t_lin0[i].w);
+        free(sh->t_lin2[i].w);
+    }
+    for (int b = 0; b < FLOWLM_FLOW_DEPTH; b++) {
+        free(sh->ada[b].w);
+        free(sh->mlp0[b].w);
+        free(sh->mlp2[b].w);
+    }
+    free(sh->final_ada.w);
+    free(sh->final_linear.w);
+}
+
+static void flow_team_free(struct flow_team *ft) {
+    if (!ft) return;
+    if (ft->shards) {
+        for (int i = 0; i < ptts_team_size(ft->team); i++) flow_shard_free(&ft->shards[i]);
+    }
+    ptts_team_free(ft->team);
+    pthread_mutex_destroy(&ft->lock);
+    free(ft->shards);
+    free(ft);
+}
+
+static int flow_threads_env(void) {
+    const char *v = getenv("PTTS_FLOW_THREADS");
+    return (v && v[0]) ? atoi(v) : 0;
+}
+
+static struct flow_team *flow_team_create(const ptts_flowlm *fm, int n) {
+    if (n < 2) return NULL;
+    struct flow_team *ft = (struct flow_team *)calloc(1, sizeof(struct flow_team));
+    if (!ft) return NULL;
+    pthread_mutex_init(&ft->lock, NULL);
+    ft->fm = fm;
+    ft->team = ptts_team_create(n, 1);
+    if (ft->team) {
+        ft->shards = (flow_shard *)calloc((size_t)ptts_team_size(ft->team), sizeof(flow_shard));
+    }
+    if (!ft->team || !ft->shards) {
+        flow_team_free(ft);
+        return NULL;
+    }
+    ptts_team_run(ft->team, flow_team_init, ft);
+    if (ft->failed) {
+        flow_team_free(ft);
+        return NULL;
+    }
+    return ft;
+}
+
+static void timestep_freqs_embed(const ptts_time_embed *te, float t, float *emb) {
+    for (int i = 0; i < 128; i++) {
+        float freq = te->freqs ? te->freqs[i] : expf(-logf(FLOWLM_MAX_PERIOD) * ((float)i / 128.0f));
+        float angle = freq * t;
+        emb[i] = cosf(angle);
+        emb[i + 128] = sinf(angle);
+    }
+}
+
+static void modulate(float *h, const float *shift, const float *scale, int n) {
+    for (int i = 0; i < n; i++) h[i] = h[i] * (1.0f + scale[i]) + shift[i];
+}
+
+static void flow_team_forward(void *arg, int worker, int num_workers) {
+    struct flow_team *ft = (struct flow_team *)arg;
+    const ptts_flow_net *fn = &ft->fm->flow;
+    const flow_shard *sh = &ft->shards[worker];
+    const int D = FLOWLM_FLOW_DIM;
+    float emb[2][256];
+    float h[FLOWLM_FLOW_DIM];
+    float y[FLOWLM_FLOW_DIM];
+    float tt[FLOWLM_FLOW_DIM];
+    (void)num_workers;
+
+    timestep_freqs_embed(&fn->time[0], ft->s, emb[0]);
+    timestep_freqs_embed(&fn->time[1], ft->t, emb[1]);
+    shard_gemv(&sh->input, ft->x_in, ft->x);
+    shard_gemv(&sh->cond, ft->cond, ft->c);
+    shard_gemv(&sh->t_lin0[0], emb[0], ft->e0[0]);
+    shard_gemv(&sh->t_lin0[1], emb[1], ft->e0[1]);
+    ptts_team_barrier(ft->team);
+
+    for (int i = 0; i < 2; i++) {
+        memcpy(h, ft->e0[i], sizeof(h));
+        silu_inplace(h, D);
+        shard_gemv(&sh->t_lin2[i], h, ft->e2[i]);
+    }
+    ptts_team_barrier(ft->team);
+
+    /* conditioning is the same for every block: issue all adaLN GEMVs at once */
+    rmsnorm_forward(ft->e2[0], D, fn->time[0].rms_alpha, 1e-5f, h);
+    rmsnorm_forward(ft->e2[1], D, fn->time[1].rms_alpha, 1e-5f, tt);
+    for (int i = 0; i < D; i++) y[i] = (h[i] + tt[i]) * 0.5f + ft->c[i];
+    silu_inplace(y, D);
+    for (int b = 0; b < FLOWLM_FLOW_DEPTH; b++) shard_gemv(&sh->ada[b], y, ft->ada[b]);
+    shard_gemv(&sh->final_ada, y, ft->ada2);
+    ptts_team_barrier(ft->team);
+
+    for (int b = 0; b < FLOWLM_FLOW_DEPTH; b++) {
+        const ptts_resblock *rb = &fn->res[b];
+        const float *ada = ft->ada[b];
+        layernorm_forward(ft->x, 1, D, rb->in_ln_w, rb->in_ln_b, 1e-6f, h);
+        modulate(h, ada, ada + D, D);
+        shard_gemv(&sh->mlp0[b], h, ft->mlp);
+        ptts_team_barrier(ft->team);
+
+        memcpy(h, ft->mlp, sizeof(h));
+        silu_inplace(h, D);
+        shard_gemv(&sh->mlp2[b], h, y);
+        const float *gate = ada + 2 * D;
+        for (int r = sh->mlp2[b].r0; r < sh->mlp2[b].r1; r++) {
+            ft->x[r] = ft->x[r] + gate[r] * y[r];
+        }
+        ptts_team_barrier(ft->team);
+    }
+
+    layernorm_forward(ft->x, 1, D, NULL, NULL, 1e-6f, h);
+    modulate(h, ft->ada2, ft->ada2 + D, D);
+    shard_gemv(&sh->final_linear, h, ft->out);
+}
+
 static void flow_net_forward(const ptts_flowlm *fm, const float *cond, float s, float t,
                              const float *x_in, float *out) {
+    if (fm->flow_team) {
+        struct flow_team *ft = fm->flow_team;
+        pthread_mutex_lock(&ft->lock);
+        ft->cond = cond;
+        ft->x_in = x_in;
+        ft->s = s;
+        ft->t = t;
+        ptts_team_run(ft->team, flow_team_forward, ft);
+        memcpy(out, ft->out, sizeof(ft->out));
+        pthread_mutex_unlock(&ft->lock);
+        return;
+    }
+
     float x[FLOWLM_FLOW_DIM];
     float tmp[FLOWLM_FLOW_DIM];
     float tmp2[FLOWLM_FLOW_DIM];
@@ -714,14 +1114,82 @@ static void flow_net_forward(const ptts_flowlm *fm, const float *cond, float s,
     linear_forward(fm->flow.final.linear_w, fm->flow.final.linear_b, FLOWLM_LATENT_DIM, FLOWLM_FLOW_DIM, tmp, 1, out);
 }
 
+/* ms per flow_net_forward over `calls` calls on fixed inputs, best of three. */
+static double flow_report_ms(const ptts_flowlm *fm, const float *cond, const float *x, int calls,
+                             float *out) {
+    double best = 1e30;
+    for (int rep = 0; rep < 3; rep++) {
+        double t0 = ptts_time_ms();
+        for (int i = 0; i < calls; i++) {
+            flow_net_forward(fm, cond, (float)i / calls, (float)(i + 1) / calls, x, out);
+        }
+        double ms = (ptts_time_ms() - t0) / calls;
+        if (ms < best) best = ms;
+    }
+    return best;
+}
+
+int ptts_flowlm_flow_report(ptts_flowlm *fm, int calls) {
+    if (!fm || calls < 1) return -1;
+    int max_n = flow_threads_env();
+    if (max_n < 2) max_n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_n < 2) max_n = 2;
+    float cond[FLOWLM_D_MODEL];
+    float x[FLOWLM_LATENT_DIM];
+    float ref[FLOWLM_LATENT_DIM];
+    float out[FLOWLM_LATENT_DIM];
+    uint32_t r = 12345u;
+    for (int i = 0; i < FLOWLM_D_MODEL; i++) {
+        r = r * 1664525u + 1013904223u;
+        cond[i] = (float)(r >> 8) / 8388608.0f - 1.0f;
+    }
+    for (int i = 0; i < FLOWLM_LATENT_DIM; i++) {
+        r = r * 1664525u + 1013904223u;
+        x[i] = (float)(r >> 8) / 8388608.0f - 1.0f;
+    }
+
+    /* the model's own team (if any) is set aside while the report runs */
+    struct flow_team *own = fm->flow_team;
+    fm->flow_team = NULL;
+    double tg = flow_report_ms(fm, cond, x, calls, ref);
+    printf("%-22s %10s %8s %9s\n", "flow net", "ms/call", "speedup", "max|diff|");
+    printf("%-22s %10.3f %7.2fx %9s\n", "generic GEMV", tg, 1.0, "-");
+    int rc = 0;
+    for (int n = 2;; n = 2 * n < max_n ? 2 * n : max_n) {
+        struct flow_team *ft = flow_team_create(fm, n);
+        if (!ft) {
+            rc = -1;
+            break;
+        }
+        fm->flow_team = ft;
+        double tt = flow_report_ms(fm, cond, x, calls, out);
+        fm->flow_team = NULL;
+        float md = 0.0f;
+        for (int i = 0; i < FLOWLM_LATENT_DIM; i++) {
+            float d = fabsf(out[i] - ref[i]);
+            if (d > md) md = d;
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "%d-thread team", ptts_team_size(ft->team));
+        printf("%-22s %10.3f %7.2fx %9.2g\n", name, tt, tg / tt, md);
+        flow_team_free(ft);
+        if (n == max_n) break;
+    }
+    fm->flow_team = own;
+    return rc;
+}
+
 static void lsd_decode(const ptts_flowlm *fm, const float *cond, int num_steps, float *x,
                        float *out_first_flow) {
     if (num_steps <= 0) return;
+    PTTS_TRACE_BEGIN(t_lsd);
     for (int i = 0; i < num_steps; i++) {
         float s = (float)i / (float)num_steps;
         float t = (float)(i + 1) / (float)num_steps;
         float flow[FLOWLM_LATENT_DIM];
+        PTTS_TRACE_BEGIN(t_flow);
         flow_net_forward(fm, cond, s, t, x, flow);
+        PTTS_TRACE_END(t_flow, "flow_net", i);
         if (i == 0 && out_first_flow) {
             memcpy(out_first_flow, flow, sizeof(flow));
         }
@@ -729,6 +1197,7 @@ static void lsd_decode(const ptts_flowlm *fm, const float *cond, int num_steps,
             x[d] += flow[d] / (float)num_steps;
         }
     }
+    PTTS_TRACE_END(t_lsd, "lsd_decode", num_steps);
 }
 
 /* ========================================================================
@@ -819,162 +1288,264 @@ static int transformer_forward(const ptts_flowlm *fm, float *x, int T) {
 ptts_flowlm *ptts_flowlm_load(ptts_ctx *ctx) {
     if (!ctx || !ctx->weights) return NULL;
 
+    double t0 = ptts_time_ms();
     ptts_flowlm *fm = (ptts_flowlm *)calloc(1, sizeof(ptts_flowlm));
     if (!fm) return NULL;
     fm->ctx = ctx;
+    safetensors_loader *ld = safetensors_loader_create(ctx->weights);
+    if (!ld) {
+        free(fm);
+        return NULL;
+    }
 
-    fm->embed_weight = load_f32(ctx, "conditioner.embed.weight");
-    fm->speaker_proj = load_f32(ctx, "speaker_proj_weight");
-    fm->emb_std = load_f32(ctx, "emb_std");
-    fm->emb_mean = load_f32(ctx, "emb_mean");
-    fm->bos_emb = load_f32(ctx, "bos_emb");
-    fm->input_linear_w = load_f32(ctx, "input_linear.weight");
-    fm->out_norm_w = load_f32(ctx, "out_norm.weight");
-    fm->out_norm_b = load_f32(ctx, "out_norm.bias");
-    fm->out_eos_w = load_f32(ctx, "out_eos.weight");
-    fm->out_eos_b = load_f32(ctx, "out_eos.bias");
+    fm->embed_weight = load_f32(ctx, ld, "conditioner.embed.weight");
+    fm->speaker_proj = load_f32(ctx, ld, "speaker_proj_weight");
+    fm->emb_std = load_f32(ctx, ld, "emb_std");
+    fm->emb_mean = load_f32(ctx, ld, "emb_mean");
+    fm->bos_emb = load_f32(ctx, ld, "bos_emb");
+    fm->input_linear_w = load_f32(ctx, ld, "input_linear.weight");
+    fm->out_norm_w = load_f32(ctx, ld, "out_norm.weight");
+    fm->out_norm_b = load_f32(ctx, ld, "out_norm.bias");
+    fm->out_eos_w = load_f32(ctx, ld, "out_eos.weight");
+    fm->out_eos_b = load_f32(ctx, ld, "out_eos.bias");
 
     for (int i = 0; i < FLOWLM_NUM_LAYERS; i++) {
         char name[128];
         snprintf(name, sizeof(name), "transformer.layers.%d.self_attn.in_proj.weight", i);
-        fm->layers[i].in_proj_w = load_f32(ctx, name);
+        fm->layers[i].in_proj_w = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "transformer.layers.%d.self_attn.out_proj.weight", i);
-        fm->layers[i].out_proj_w = load_f32(ctx, name);
+        fm->layers[i].out_proj_w = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "transformer.layers.%d.norm1.weight", i);
-        fm->layers[i].norm1_w = load_f32(ctx, name);
+        fm->layers[i].norm1_w = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "transformer.layers.%d.norm1.bias", i);
-        fm->layers[i].norm1_b = load_f32(ctx, name);
+        fm->layers[i].norm1_b = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "transformer.layers.%d.norm2.weight", i);
-        fm->layers[i].norm2_w = load_f32(ctx, name);
+        fm->layers[i].norm2_w = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "transformer.layers.%d.norm2.bias", i);
-        fm->layers[i].norm2_b = load_f32(ctx, name);
+        fm->layers[i].norm2_b = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "transformer.layers.%d.linear1.weight", i);
-        fm->layers[i].linear1_w = load_f32(ctx, name);
+        fm->layers[i].linear1_w = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "transformer.layers.%d.linear2.weight", i);
-        fm->layers[i].linear2_w = load_f32(ctx, name);
+        fm->layers[i].linear2_w = load_f32(ctx, ld, name);
     }
 
-    fm->flow.cond_w = load_f32(ctx, "flow_net.cond_embed.weight");
-    fm->flow.cond_b = load_f32(ctx, "flow_net.cond_embed.bias");
-    fm->flow.input_w = load_f32(ctx, "flow_net.input_proj.weight");
-    fm->flow.input_b = load_f32(ctx, "flow_net.input_proj.bias");
+    fm->flow.cond_w = load_f32(ctx, ld, "flow_net.cond_embed.weight");
+    fm->flow.cond_b = load_f32(ctx, ld, "flow_net.cond_embed.bias");
+    fm->flow.input_w = load_f32(ctx, ld, "flow_net.input_proj.weight");
+    fm->flow.input_b = load_f32(ctx, ld, "flow_net.input_proj.bias");
 
     for (int t = 0; t < 2; t++) {
         char name[160];
         snprintf(name, sizeof(name), "flow_net.time_embed.%d.mlp.0.weight", t);
-        fm->flow.time[t].lin0_w = load_f32(ctx, name);
+        fm->flow.time[t].lin0_w = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "flow_net.time_embed.%d.mlp.0.bias", t);
-        fm->flow.time[t].lin0_b = load_f32(ctx, name);
+        fm->flow.time[t].lin0_b = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "flow_net.time_embed.%d.mlp.2.weight", t);
-        fm->flow.time[t].lin2_w = load_f32(ctx, name);
+        fm->flow.time[t].lin2_w = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "flow_net.time_embed.%d.mlp.2.bias", t);
-        fm->flow.time[t].lin2_b = load_f32(ctx, name);
+        fm->flow.time[t].lin2_b = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "flow_net.time_embed.%d.mlp.3.alpha", t);
-        fm->flow.time[t].rms_alpha = load_f32(ctx, name);
+        fm->flow.time[t].rms_alpha = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "flow_net.time_embed.%d.freqs", t);
-        fm->flow.time[t].freqs = load_f32(ctx, name);
+        fm->flow.time[t].freqs = load_f32(ctx, ld, name);
     }
 
     for (int i = 0; i < FLOWLM_FLOW_DEPTH; i++) {
         char name[200];
         snprintf(name, sizeof(name), "flow_net.res_blocks.%d.in_ln.weight", i);
-        fm->flow.res[i].in_ln_w = load_f32(ctx, name);
+        fm->flow.res[i].in_ln_w = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "flow_net.res_blocks.%d.in_ln.bias", i);
-        fm->flow.res[i].in_ln_b = load_f32(ctx, name);
+        fm->flow.res[i].in_ln_b = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "flow_net.res_blocks.%d.mlp.0.weight", i);
-        fm->flow.res[i].mlp0_w = load_f32(ctx, name);
+        fm->flow.res[i].mlp0_w = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "flow_net.res_blocks.%d.mlp.0.bias", i);
-        fm->flow.res[i].mlp0_b = load_f32(ctx, name);
+        fm->flow.res[i].mlp0_b = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "flow_net.res_blocks.%d.mlp.2.weight", i);
-        fm->flow.res[i].mlp2_w = load_f32(ctx, name);
+        fm->flow.res[i].mlp2_w = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "flow_net.res_blocks.%d.mlp.2.bias", i);
-        fm->flow.res[i].mlp2_b = load_f32(ctx, name);
+        fm->flow.res[i].mlp2_b = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "flow_net.res_blocks.%d.adaLN_modulation.1.weight", i);
-        fm->flow.res[i].ada_w = load_f32(ctx, name);
+        fm->flow.res[i].ada_w = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "flow_net.res_blocks.%d.adaLN_modulation.1.bias", i);
-        fm->flow.res[i].ada_b = load_f32(ctx, name);
+        fm->flow.res[i].ada_b = load_f32(ctx, ld, name);
     }
 
-    fm->flow.final.linear_w = load_f32(ctx, "flow_net.final_layer.linear.weight");
-    fm->flow.final.linear_b = load_f32(ctx, "flow_net.final_layer.linear.bias");
-    fm->flow.final.ada_w = load_f32(ctx, "flow_net.final_layer.adaLN_modulation.1.weight");
-    fm->flow.final.ada_b = load_f32(ctx, "flow_net.final_layer.adaLN_modulation.1.bias");
+    fm->flow.final.linear_w = load_f32(ctx, ld, "flow_net.final_layer.linear.weight");
+    fm->flow.final.linear_b = load_f32(ctx, ld, "flow_net.final_layer.linear.bias");
+    fm->flow.final.ada_w = load_f32(ctx, ld, "flow_net.final_layer.adaLN_modulation.1.weight");
+    fm->flow.final.ada_b = load_f32(ctx, ld, "flow_net.final_layer.adaLN_modulation.1.bias");
+
+    safetensors_load_stats stats;
+    int rc = safetensors_loader_run(ld, &stats, &fm->arena);
 
     /* basic validation */
-    if (!fm->embed_weight || !fm->bos_emb || !fm->layers[0].in_proj_w || !fm->flow.cond_w) {
+    if (rc != 0 || !fm->embed_weight || !fm->bos_emb || !fm->layers[0].in_proj_w ||
+        !fm->flow.cond_w) {
         ptts_flowlm_free(fm);
         return NULL;
     }
 
+    fm->flow_team = flow_team_create(fm, flow_threads_env());
+    const char *gov = getenv("PTTS_GOVERNOR");
+    fm->governor = gov && gov[0] && strcmp(gov, "0") != 0;
+    ctx->load_times.flowlm_ms = ptts_time_ms() - t0;
+    if (ptts_timing_enabled()) {
+        fprintf(stderr, "[ptts] FlowLM load: %.2f ms (%d tensors; %d widened, %.1f MB, "
+                "%d threads, %.2f ms)\n", ctx->load_times.flowlm_ms, stats.tensors,
+                stats.converted, stats.bytes / 1e6, stats.threads, stats.ms);
+    }
     return fm;
 }
 
 void ptts_flowlm_free(ptts_flowlm *fm) {
     if (!fm) return;
-    free_ptr(&fm->embed_weight);
-    free_ptr(&fm->speaker_proj);
-    free_ptr(&fm->emb_std);
-    free_ptr(&fm->emb_mean);
-    free_ptr(&fm->bos_emb);
-    free_ptr(&fm->input_linear_w);
-    free_ptr(&fm->out_norm_w);
-    free_ptr(&fm->out_norm_b);
-    free_ptr(&fm->out_eos_w);
-    free_ptr(&fm->out_eos_b);
+    flow_team_free(fm->flow_team);
+    free_weight(fm, &fm->embed_weight);
+    free_weight(fm, &fm->speaker_proj);
+    free_weight(fm, &fm->emb_std);
+    free_weight(fm, &fm->emb_mean);
+    free_weight(fm, &fm->bos_emb);
+    free_weight(fm, &fm->input_linear_w);
+    free_weight(fm, &fm->out_norm_w);
+    free_weight(fm, &fm->out_norm_b);
+    free_weight(fm, &fm->out_eos_w);
+    free_weight(fm, &fm->out_eos_b);
 
     for (int i = 0; i < FLOWLM_NUM_LAYERS; i++) {
-        free_ptr(&fm->layers[i].in_proj_w);
-        free_ptr(&fm->layers[i].out_proj_w);
-        free_ptr(&fm->layers[i].norm1_w);
-        free_ptr(&fm->layers[i].norm1_b);
-        free_ptr(&fm->layers[i].norm2_w);
-        free_ptr(&fm->layers[i].norm2_b);
-        free_ptr(&fm->layers[i].linear1_w);
-        free_ptr(&fm->layers[i].linear2_w);
-    }
-
-    free_ptr(&fm->flow.cond_w);
-    free_ptr(&fm->flow.cond_b);
-    free_ptr(&fm->flow.input_w);
-    free_ptr(&fm->flow.input_b);
+        free_weight(fm, &fm->layers[i].in_proj_w);
+        free_weight(fm, &fm->layers[i].out_proj_w);
+        free_weight(fm, &fm->layers[i].norm1_w);
+        free_weight(fm, &fm->layers[i].norm1_b);
+        free_weight(fm, &fm->layers[i].norm2_w);
+        free_weight(fm, &fm->layers[i].norm2_b);
+        free_weight(fm, &fm->layers[i].linear1_w);
+        free_weight(fm, &fm->layers[i].linear2_w);
+    }
+
+    free_weight(fm, &fm->flow.cond_w);
+    free_weight(fm, &fm->flow.cond_b);
+    free_weight(fm, &fm->flow.input_w);
+    free_weight(fm, &fm->flow.input_b);
     for (int t = 0; t < 2; t++) {
-        free_ptr(&fm->flow.time[t].lin0_w);
-        free_ptr(&fm->flow.time[t].lin0_b);
-        free_ptr(&fm->flow.time[t].lin2_w);
-        free_ptr(&fm->flow.time[t].lin2_b);
-        free_ptr(&fm->flow.time[t].rms_alpha);
-        free_ptr(&fm->flow.time[t].freqs);
+        free_weight(fm, &fm->flow.time[t].lin0_w);
+        free_weight(fm, &fm->flow.time[t].lin0_b);
+        free_weight(fm, &fm->flow.time[t].lin2_w);
+        free_weight(fm, &fm->flow.time[t].lin2_b);
+        free_weight(fm, &fm->flow.time[t].rms_alpha);
+        free_weight(fm, &fm->flow.time[t].freqs);
     }
     for (int i = 0; i < FLOWLM_FLOW_DEPTH; i++) {
-        free_ptr(&fm->flow.res[i].in_ln_w);
-        free_ptr(&fm->flow.res[i].in_ln_b);
-        free_ptr(&fm->flow.res[i].mlp0_w);
-        free_ptr(&fm->flow.res[i].mlp0_b);
-        free_ptr(&fm->flow.res[i].mlp2_w);
-        free_ptr(&fm->flow.res[i].mlp2_b);
-        free_ptr(&fm->flow.res[i].ada_w);
-        free_ptr(&fm->flow.res[i].ada_b);
-    }
-    free_ptr(&fm->flow.final.linear_w);
-    free_ptr(&fm->flow.final.linear_b);
-    free_ptr(&fm->flow.final.ada_w);
-    free_ptr(&fm->flow.final.ada_b);
+        free_weight(fm, &fm->flow.res[i].in_ln_w);
+        free_weight(fm, &fm->flow.res[i].in_ln_b);
+        free_weight(fm, &fm->flow.res[i].mlp0_w);
+        free_weight(fm, &fm->flow.res[i].mlp0_b);
+        free_weight(fm, &fm->flow.res[i].mlp2_w);
+        free_weight(fm, &fm->flow.res[i].mlp2_b);
+        free_weight(fm, &fm->flow.res[i].ada_w);
+        free_weight(fm, &fm->flow.res[i].ada_b);
+    }
+    free_weight(fm, &fm->flow.final.linear_w);
+    free_weight(fm, &fm->flow.final.linear_b);
+    free_weight(fm, &fm->flow.final.ada_w);
+    free_weight(fm, &fm->flow.final.ada_b);
 
+    safetensors_arena_free(&fm->arena);
     free(fm);
 }
 
-static uint32_t rng_next_u32(uint64_t *state) {
-    uint64_t x = *state;
-    x ^= x >> 12;
-    x ^= x << 25;
-    x ^= x >> 27;
-    *state = x;
-    return (uint32_t)((x * 2685821657736338717ULL) >> 32);
+int ptts_flowlm_protect_weights(ptts_flowlm *fm) {
+    return fm ? safetensors_arena_protect(&fm->arena) : -1;
+}
+
+/* ========================================================================
+ * Noise (counter-based)
+ *
+ * Latent noise comes from Philox4x32-10 keyed by the seed, with the
+ * counter built from (block, frame, stream). Any frame's noise can be
+ * produced independently of how many draws came before it, so batched,
+ * sentence-parallel and resumed generation reproduce the same latents.
+ * ======================================================================== */
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define NOISE_BLOCKS (FLOWLM_LATENT_DIM / 4)
+#define NOISE_PAIRS (FLOWLM_LATENT_DIM / 2)
+
+/* Runs NOISE_BLOCKS independent Philox4x32-10 streams lane-wise so the
+ * rounds vectorize; block b yields latent dims [4b, 4b+4). */
+static void philox_frame(uint64_t seed, uint64_t stream, uint32_t frame,
+                         uint32_t out[FLOWLM_LATENT_DIM]) {
+    uint32_t c0[NOISE_BLOCKS], c1[NOISE_BLOCKS], c2[NOISE_BLOCKS], c3[NOISE_BLOCKS];
+    uint32_t k0 = (uint32_t)seed;
+    uint32_t k1 = (uint32_t)(seed >> 32);
+    for (int b = 0; b < NOISE_BLOCKS; b++) {
+        c0[b] = (uint32_t)b;
+        c1[b] = frame;
+        c2[b] = (uint32_t)stream;
+        c3[b] = (uint32_t)(stream >> 32);
+    }
+    for (int r = 0; r < 10; r++) {
+        for (int b = 0; b < NOISE_BLOCKS; b++) {
+            uint64_t p0 = (uint64_t)PHILOX_M0 * c0[b];
+            uint64_t p1 = (uint64_t)PHILOX_M1 * c2[b];
+            uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1[b] ^ k0;
+            uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3[b] ^ k1;
+            c1[b] = (uint32_t)p1;
+            c3[b] = (uint32_t)p0;
+            c0[b] = n0;
+            c2[b] = n2;
+        }
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    for (int b = 0; b < NOISE_BLOCKS; b++) {
+        out[4 * b + 0] = c0[b];
+        out[4 * b + 1] = c1[b];
+        out[4 * b + 2] = c2[b];
+        out[4 * b + 3] = c3[b];
+    }
 }
 
-static float rng_next_f01(uint64_t *state) {
-    uint32_t u = rng_next_u32(state);
-    return (u + 1.0f) / 4294967296.0f;
+void ptts_flowlm_noise(uint64_t seed, uint64_t stream, int frame,
+                       float temp, float noise_clamp, float *out) {
+    float std = (temp > 0.0f) ? sqrtf(temp) : 0.0f;
+    if (std <= 0.0f) {
+        memset(out, 0, (size_t)FLOWLM_LATENT_DIM * sizeof(float));
+        return;
+    }
+
+    uint32_t bits[FLOWLM_LATENT_DIM];
+    philox_frame(seed, stream, (uint32_t)frame, bits);
+
+    /* Box-Muller over all pairs at once: u1 from even words, u2 from odd.
+     * 24-bit uniforms in (0, 1) keep logf finite. */
+    float r[NOISE_PAIRS];
+    float theta[NOISE_PAIRS];
+    for (int i = 0; i < NOISE_PAIRS; i++) {
+        float u1 = ((float)(bits[2 * i] >> 8) + 0.5f) * (1.0f / 16777216.0f);
+        float u2 = ((float)(bits[2 * i + 1] >> 8) + 0.5f) * (1.0f / 16777216.0f);
+        r[i] = sqrtf(-2.0f * logf(u1)) * std;
+        theta[i] = 2.0f * (float)M_PI * u2;
+    }
+    for (int i = 0; i < NOISE_PAIRS; i++) {
+        out[2 * i] = r[i] * cosf(theta[i]);
+        out[2 * i + 1] = r[i] * sinf(theta[i]);
+    }
+    if (noise_clamp > 0.0f) {
+        for (int i = 0; i < FLOWLM_LATENT_DIM; i++) {
+            float z = out[i];
+            if (z < -noise_clamp) z = -noise_clamp;
+            if (z > noise_clamp) z = noise_clamp;
+            out[i] = z;
+        }
+    }
+}
+
+static uint64_t resolve_seed(int64_t seed) {
+    if (seed == -1) seed = (int64_t)time(NULL);
+    return (uint64_t)seed;
 }
 
 int ptts_flowlm_forward_next(ptts_flowlm *fm, const int *tokens, int token_len,
@@ -1043,37 +1614,16 @@ int ptts_flowlm_forward_next(ptts_flowlm *fm, const int *tokens, int token_len,
     eos += fm->out_eos_b ? fm->out_eos_b[0] : 0.0f;
     if (out_eos_logit) *out_eos_logit = eos;
 
-    /* initialize latent with noise and decode */
+    /* initialize latent with noise and decode; frame index = prev_len */
     float latent[FLOWLM_LATENT_DIM];
     int64_t seed = seed_io ? *seed_io : -1;
-    if (seed == -1) seed = (int64_t)time(NULL);
-    uint64_t rng = (uint64_t)seed;
-    float std = (temp > 0.0f) ? sqrtf(temp) : 0.0f;
-    for (int i = 0; i < FLOWLM_LATENT_DIM; i += 2) {
-        float z0 = 0.0f;
-        float z1 = 0.0f;
-        if (std > 0.0f) {
-            float u1 = rng_next_f01(&rng);
-            float u2 = rng_next_f01(&rng);
-            float r = sqrtf(-2.0f * logf(u1));
-            float theta = 2.0f * (float)M_PI * u2;
-            z0 = r * cosf(theta) * std;
-            z1 = r * sinf(theta) * std;
-        }
-        if (noise_clamp > 0.0f) {
-            if (z0 < -noise_clamp) z0 = -noise_clamp;
-            if (z0 > noise_clamp) z0 = noise_clamp;
-            if (z1 < -noise_clamp) z1 = -noise_clamp;
-            if (z1 > noise_clamp) z1 = noise_clamp;
-        }
-        latent[i] = z0;
-        if (i + 1 < FLOWLM_LATENT_DIM) latent[i + 1] = z1;
-    }
+    uint64_t key = resolve_seed(seed);
+    ptts_flowlm_noise(key, 0, prev_len, temp, noise_clamp, latent);
     lsd_decode(fm, normed, lsd_steps, latent, NULL);
 
     memcpy(out_latent, latent, sizeof(latent));
 
-    if (seed_io) *seed_io = (int64_t)rng;
+    if (seed_io) *seed_io = (int64_t)key;
 
     free(x); free(input_lat); free(input_proj);
     return 0;
@@ -1091,115 +1641,490 @@ int ptts_flowlm_forward_one(ptts_flowlm *fm, const int *tokens, int token_len,
 int ptts_flowlm_generate_latents(ptts_flowlm *fm, const int *tokens, int token_len,
                                  const float *cond_prefix, int cond_len,
                                  int max_frames, int lsd_steps, float temp, float noise_clamp,
-                                 int64_t seed, int eos_enabled, float eos_threshold,
+                                 int64_t seed, uint64_t noise_stream,
+                                 int eos_enabled, float eos_threshold,
                                  int eos_min_frames, int eos_after,
                                  float *out_latents, int *out_frames_used,
                                  float *out_first_eos_logit,
                                  float *out_first_cond,
                                  float *out_first_flow) {
-    if (!fm || !tokens || token_len <= 0 || !out_latents || !out_frames_used) return -1;
-    if (max_frames < 1) return -1;
-    if (cond_len < 0) return -1;
-    if (cond_len > 0 && !cond_prefix) return -1;
-    if (eos_min_frames < 1) eos_min_frames = 1;
-    if (eos_after < 0) eos_after = 0;
+    return ptts_flowlm_generate_latents_cb(fm, tokens, token_len, cond_prefix, cond_len,
+                                           max_frames, lsd_steps, temp, noise_clamp,
+                                           seed, noise_stream, eos_enabled, eos_threshold,
+                                           eos_min_frames, eos_after, out_latents,
+                                           out_frames_used, out_first_eos_logit,
+                                           out_first_cond, out_first_flow, NULL, NULL, NULL);
+}
 
+/* ========================================================================
+ * Sessions (KV-cached generation one frame at a time)
+ * ======================================================================== */
+
+struct ptts_flowlm_session {
+    ptts_flowlm *fm;
+    ptts_flowlm_kv_cache *cache;
+    const int *tokens; /* borrowed until prefill completes */
+    int token_len;
+    const float *cond_prefix;
+    int cond_len;
+    int max_frames;
+    int lsd_steps;
+    float temp;
+    float noise_clamp;
+    uint64_t key;
+    uint64_t noise_stream;
+    int eos_enabled;
+    float eos_threshold;
+    int eos_min_frames;
+    int eos_after;
+    int prefix_len; /* voice + text + BOS positions */
+    int prefilled;
+    int looked_up;
+    int reused;
+    uint64_t voice_key;
+    int frame;    /* frames emitted */
+    int eos_step; /* first frame whose EOS logit crossed the threshold, or -1 */
+    int state;    /* 1 running, 0 finished, -1 failed */
+    double flow_ms;
+    int steps_run;    /* LSD steps over all frames */
+    int max_steps;    /* requested LSD steps; the governor stays at or below */
+    double gov_start; /* frame 0 ready: playback starts */
+    double gov_last;
+    double gov_ema;   /* frame interval, ms */
+    int gov_hold;     /* frames since the last step change */
+    unsigned long gov_id; /* stream number in governor log lines */
+    double prefill_ms;
+    float *frame_ms;  /* [max_frames] sample + flow net + feedback step */
+    float x[FLOWLM_D_MODEL]; /* hidden state for the next frame */
+};
+
+ptts_flowlm_session *ptts_flowlm_session_create(ptts_flowlm *fm, const int *tokens, int token_len,
+                                                const float *cond_prefix, int cond_len,
+                                                int max_frames, int lsd_steps, float temp,
+                                                float noise_clamp, int64_t seed,
+                                                uint64_t noise_stream, int eos_enabled,
+                                                float eos_threshold, int eos_min_frames,
+                                                int eos_after) {
+    if (!fm || !tokens || token_len <= 0) return NULL;
+    if (max_frames < 1) return NULL;
+    if (cond_len < 0) return NULL;
+    if (cond_len > 0 && !cond_prefix) return NULL;
+
+    ptts_flowlm_session *s = (ptts_flowlm_session *)calloc(1, sizeof(*s));
+    if (!s) return NULL;
     int max_len = token_len + cond_len + 1 + max_frames;
-    ptts_flowlm_kv_cache *cache = kv_cache_create(max_len);
-    if (!cache) return -1;
+    s->cache = kv_cache_create(fm->ctx ? fm->ctx->kv_pool : NULL, max_len);
+    s->frame_ms = (float *)malloc(sizeof(float) * (size_t)max_frames);
+    /* prefix pages up front while the pool has them; prefill or
+     * ptts_flowlm_session_reserve takes the rest */
+    if (!s->frame_ms || !s->cache || kv_cache_try_reserve(s->cache, cond_len + token_len) < 0) {
+        kv_cache_free(s->cache);
+        free(s->frame_ms);
+        free(s);
+        return NULL;
+    }
+    s->fm = fm;
+    s->tokens = tokens;
+    s->token_len = token_len;
+    s->cond_prefix = cond_prefix;
+    s->cond_len = cond_len;
+    s->max_frames = max_frames;
+    s->lsd_steps = lsd_steps;
+    s->max_steps = lsd_steps;
+    if (fm->governor) s->gov_id = __atomic_add_fetch(&fm->gov_streams, 1, __ATOMIC_RELAXED);
+    s->temp = temp;
+    s->noise_clamp = noise_clamp;
+    s->key = resolve_seed(seed);
+    s->noise_stream = noise_stream;
+    s->eos_enabled = eos_enabled;
+    s->eos_threshold = eos_threshold;
+    s->eos_min_frames = eos_min_frames < 1 ? 1 : eos_min_frames;
+    s->eos_after = eos_after < 0 ? 0 : eos_after;
+    s->prefix_len = cond_len + token_len + 1;
+    s->eos_step = -1;
+    s->state = 1;
+    return s;
+}
 
-    float x[FLOWLM_D_MODEL];
-    for (int t = 0; t < cond_len; t++) {
-        const float *src = cond_prefix + (size_t)t * FLOWLM_D_MODEL;
-        memcpy(x, src, (size_t)FLOWLM_D_MODEL * sizeof(float));
-        if (transformer_forward_step_cached(fm, cache, x) != 0) {
-            kv_cache_free(cache);
-            return -1;
+void ptts_flowlm_session_free(ptts_flowlm_session *s) {
+    if (!s) return;
+    kv_cache_free(s->cache);
+    free(s->frame_ms);
+    free(s);
+}
+
+/* Voice + text prefix rows are identical across requests that share them;
+ * restore what the prefix cache has and only run the remaining steps. */
+static int session_lookup_prefix(ptts_flowlm_session *s) {
+    ptts_prefix_cache *pc = s->fm->ctx ? s->fm->ctx->prefix_cache : NULL;
+    s->looked_up = 1;
+    if (!pc) return 0;
+    s->voice_key = ptts_prefix_cache_voice_key(s->cond_prefix,
+                                               (size_t)s->cond_len * FLOWLM_D_MODEL);
+    s->reused = ptts_prefix_cache_lookup(pc, s->voice_key, s->cond_len, s->tokens, s->token_len,
+                                         kv_row_fn, s->cache);
+    s->cache->seq_len = s->reused;
+    s->prefilled = s->reused;
+#ifdef PTTS_USE_CUDA
+    if (attn_cuda_enabled() && attn_kv_cuda_enabled()) {
+        for (int pos = 0; pos < s->reused; pos++) {
+            for (int l = 0; l < FLOWLM_NUM_LAYERS; l++) {
+                if (ptts_cuda_kv_push(l, pos, kv_row(s->cache, l, 0, pos),
+                                      kv_row(s->cache, l, 1, pos)) != 0) {
+                    return -1;
+                }
+            }
         }
     }
+#endif
+    return 0;
+}
 
-    for (int t = 0; t < token_len; t++) {
-        int id = tokens[t];
-        if (id < 0 || id >= FLOWLM_VOCAB + 1) id = 0;
-        const float *src = fm->embed_weight + (size_t)id * FLOWLM_TEXT_DIM;
-        memcpy(x, src, (size_t)FLOWLM_D_MODEL * sizeof(float));
-        if (transformer_forward_step_cached(fm, cache, x) != 0) {
-            kv_cache_free(cache);
+static void session_insert_prefix(ptts_flowlm_session *s) {
+    ptts_prefix_cache *pc = s->fm->ctx ? s->fm->ctx->prefix_cache : NULL;
+    if (!pc) return;
+    int total = s->cond_len + s->token_len;
+    int computed = total - s->reused;
+    if (computed > 0) {
+        ptts_prefix_cache_insert(pc, s->voice_key, s->cond_len, s->tokens, s->token_len,
+                                 kv_row_fn, s->cache, computed);
+    }
+    if (ptts_timing_enabled()) {
+        ptts_prefix_cache_stats st;
+        ptts_prefix_cache_get_stats(pc, &st);
+        fprintf(stderr, "[ptts] KV prefix cache: reused %d/%d positions "
+                "(hits %llu/%llu, %.1f/%.1f MB, %d nodes, %llu evictions)\n",
+                s->reused, total,
+                (unsigned long long)st.hits, (unsigned long long)st.lookups,
+                st.bytes / 1048576.0, st.max_bytes / 1048576.0, st.nodes,
+                (unsigned long long)st.evictions);
+    }
+}
+
+int ptts_flowlm_session_prefill(ptts_flowlm_session *s, int max_positions) {
+    if (!s || s->state < 0) return -1;
+    if (!s->looked_up && session_lookup_prefix(s) != 0) {
+        s->state = -1;
+        return -1;
+    }
+    const ptts_flowlm *fm = s->fm;
+    double t0 = ptts_time_ms();
+    PTTS_TRACE_BEGIN(t_trace);
+    int start = s->prefilled;
+    int text_end = s->cond_len + s->token_len;
+    int budget = max_positions > 0 ? max_positions : s->prefix_len;
+    for (; budget > 0 && s->prefilled < s->prefix_len; budget--) {
+        int t = s->prefilled;
+        if (t < s->cond_len) {
+            memcpy(s->x, s->cond_prefix + (size_t)t * FLOWLM_D_MODEL,
+                   (size_t)FLOWLM_D_MODEL * sizeof(float));
+        } else if (t < text_end) {
+            int id = s->tokens[t - s->cond_len];
+            if (id < 0 || id >= FLOWLM_VOCAB + 1) id = 0;
+            memcpy(s->x, fm->embed_weight + (size_t)id * FLOWLM_TEXT_DIM,
+                   (size_t)FLOWLM_D_MODEL * sizeof(float));
+        } else {
+            session_insert_prefix(s);
+            float input_lat[FLOWLM_LATENT_DIM];
+            memcpy(input_lat, fm->bos_emb, sizeof(input_lat));
+            linear_forward(fm->input_linear_w, NULL, FLOWLM_D_MODEL, FLOWLM_LATENT_DIM,
+                           input_lat, 1, s->x);
+        }
+        if (transformer_forward_step_cached(fm, s->cache, s->x) != 0) {
+            s->state = -1;
             return -1;
         }
+        s->prefilled++;
     }
+    s->prefill_ms += ptts_time_ms() - t0;
+    PTTS_TRACE_END(t_trace, "flowlm.prefill", s->prefilled - start);
+    return s->prefix_len - s->prefilled;
+}
 
-    float input_lat[FLOWLM_LATENT_DIM];
-    memcpy(input_lat, fm->bos_emb, (size_t)FLOWLM_LATENT_DIM * sizeof(float));
-    linear_forward(fm->input_linear_w, NULL, FLOWLM_D_MODEL, FLOWLM_LATENT_DIM, input_lat, 1, x);
-    if (transformer_forward_step_cached(fm, cache, x) != 0) {
-        kv_cache_free(cache);
-        return -1;
+#define GOV_FRAME_MS 80.0
+#define GOV_LOWER_HOLD 3 /* frames between decisions, so the EMA sees the change */
+#define GOV_RAISE_HOLD 8
+
+/* Real-time governor (PTTS_GOVERNOR=1). Playback starts when frame 0 is
+ * ready, so frame k is due k * 80 ms later; a frame ready after that is an
+ * underrun. Falling behind (an underrun, or frames slower than real time
+ * with under two frames buffered) drops one LSD step; a buffer of four
+ * frames with room for one more step at under 80% of real time restores
+ * one, up to the requested count. */
+static void governor_update(ptts_flowlm_session *s, int frame) {
+    ptts_flowlm *fm = s->fm;
+    double now = ptts_time_ms();
+    __atomic_fetch_add(&fm->gov.frames, 1, __ATOMIC_RELAXED);
+    if (frame == 0) {
+        s->gov_start = now;
+        s->gov_last = now;
+        return;
     }
+    double interval = now - s->gov_last;
+    s->gov_last = now;
+    s->gov_ema = s->gov_ema > 0.0 ? 0.7 * s->gov_ema + 0.3 * interval : interval;
+    s->gov_hold++;
+    double late = now - (s->gov_start + frame * GOV_FRAME_MS);
+    double buffered = -late + GOV_FRAME_MS; /* audio queued once this frame lands */
+    if (late > 0.0) __atomic_fetch_add(&fm->gov.underruns, 1, __ATOMIC_RELAXED);
+
+    int steps = s->lsd_steps;
+    if (steps > 1 && s->gov_hold >= GOV_LOWER_HOLD &&
+        (late > 0.0 || (s->gov_ema > GOV_FRAME_MS && buffered < 2 * GOV_FRAME_MS))) {
+        steps--;
+        __atomic_fetch_add(&fm->gov.lowered, 1, __ATOMIC_RELAXED);
+    } else if (steps < s->max_steps && s->gov_hold >= GOV_RAISE_HOLD &&
+               buffered > 4 * GOV_FRAME_MS &&
+               s->gov_ema * (steps + 1) / steps < 0.8 * GOV_FRAME_MS) {
+        steps++;
+        __atomic_fetch_add(&fm->gov.raised, 1, __ATOMIC_RELAXED);
+    }
+    if (steps == s->lsd_steps) return;
+    fprintf(stderr, "[ptts] Governor: stream %lu frame %d: %d -> %d LSD steps "
+            "(frame %.1f ms, %s %.1f ms)\n", s->gov_id, frame,
+            s->lsd_steps, steps, s->gov_ema, late > 0.0 ? "late" : "buffer",
+            late > 0.0 ? late : buffered);
+    s->lsd_steps = steps;
+    s->gov_hold = 0;
+}
 
-    int64_t seed_local = seed;
-    if (seed_local == -1) seed_local = (int64_t)time(NULL);
-    uint64_t rng = (uint64_t)seed_local;
-    float std = (temp > 0.0f) ? sqrtf(temp) : 0.0f;
+int ptts_flowlm_session_limit(void) {
+#ifdef PTTS_USE_CUDA
+    if (attn_cuda_enabled() && attn_kv_cuda_enabled()) return 1;
+#endif
+    return 0;
+}
 
-    int eos_step = -1;
-    int used = 0;
+void ptts_flowlm_governor_stats(const ptts_flowlm *fm, ptts_governor_stats *out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!fm) return;
+    out->enabled = fm->governor;
+    out->frames = __atomic_load_n(&fm->gov.frames, __ATOMIC_RELAXED);
+    out->underruns = __atomic_load_n(&fm->gov.underruns, __ATOMIC_RELAXED);
+    out->lowered = __atomic_load_n(&fm->gov.lowered, __ATOMIC_RELAXED);
+    out->raised = __atomic_load_n(&fm->gov.raised, __ATOMIC_RELAXED);
+}
 
-    for (int i = 0; i < max_frames; i++) {
-        float normed[FLOWLM_D_MODEL];
-        layernorm_forward(x, 1, FLOWLM_D_MODEL, fm->out_norm_w, fm->out_norm_b, 1e-5f, normed);
-        if (i == 0 && out_first_cond) {
-            memcpy(out_first_cond, normed, sizeof(normed));
-        }
+/* Samples the next frame from s->x into latent and advances the EOS state. */
+static void session_sample(ptts_flowlm_session *s, float *latent, float *out_first_eos_logit,
+                           float *out_first_cond, float *out_first_flow) {
+    const ptts_flowlm *fm = s->fm;
+    int i = s->frame;
+    float normed[FLOWLM_D_MODEL];
+    layernorm_forward(s->x, 1, FLOWLM_D_MODEL, fm->out_norm_w, fm->out_norm_b, 1e-5f, normed);
+    if (out_first_cond) memcpy(out_first_cond, normed, sizeof(normed));
 
-        float eos = 0.0f;
-        for (int d = 0; d < FLOWLM_D_MODEL; d++) eos += fm->out_eos_w[d] * normed[d];
-        eos += fm->out_eos_b ? fm->out_eos_b[0] : 0.0f;
-        if (i == 0 && out_first_eos_logit) *out_first_eos_logit = eos;
+    float eos = 0.0f;
+    for (int d = 0; d < FLOWLM_D_MODEL; d++) eos += fm->out_eos_w[d] * normed[d];
+    eos += fm->out_eos_b ? fm->out_eos_b[0] : 0.0f;
+    if (out_first_eos_logit) *out_first_eos_logit = eos;
+
+    if (s->eos_enabled && i + 1 >= s->eos_min_frames && eos >= s->eos_threshold) {
+        if (s->eos_step < 0) s->eos_step = i;
+    }
+
+    ptts_flowlm_noise(s->key, s->noise_stream, i, s->temp, s->noise_clamp, latent);
+    double t_flow = ptts_time_ms();
+    lsd_decode(fm, normed, s->lsd_steps, latent, out_first_flow);
+    s->flow_ms += ptts_time_ms() - t_flow;
+    s->steps_run += s->lsd_steps > 0 ? s->lsd_steps : 0;
+    if (fm->governor) governor_update(s, i);
+
+    s->frame = i + 1;
+    if ((s->eos_step >= 0 && i >= s->eos_step + s->eos_after) || s->frame >= s->max_frames) {
+        s->state = 0;
+    }
+}
+
+/* Records the time of the frame just sampled. */
+static void session_frame_done(ptts_flowlm_session *s, double ms) {
+    if (s->frame > 0) s->frame_ms[s->frame - 1] = (float)ms;
+}
 
-        if (eos_enabled && i + 1 >= eos_min_frames && eos >= eos_threshold) {
-            if (eos_step < 0) eos_step = i;
+int ptts_flowlm_session_step(ptts_flowlm_session **sessions, int n, float *out_latents) {
+    if (!sessions || n <= 0 || !out_latents) return -1;
+    ptts_flowlm *fm = sessions[0]->fm;
+    double t0 = ptts_time_ms();
+    PTTS_TRACE_BEGIN(t_trace);
+    for (int i = 0; i < n; i++) {
+        const ptts_flowlm_session *s = sessions[i];
+        if (s->fm != fm || s->state != 1 || s->prefilled < s->prefix_len) return -1;
+    }
+
+    /* Sessions that go on need their latent fed back as the next position,
+     * which needs a page every PTTS_KV_PAGE_POS frames. A session that
+     * cannot get one fails alone; schedulers reserve first
+     * (ptts_flowlm_session_reserve) and defer the sessions that got none. */
+    ptts_flowlm_session **next = (ptts_flowlm_session **)malloc(sizeof(*next) * (size_t)n);
+    ptts_flowlm_kv_cache **caches = (ptts_flowlm_kv_cache **)malloc(sizeof(*caches) * (size_t)n);
+    float *lat = (float *)malloc(sizeof(float) * FLOWLM_LATENT_DIM * (size_t)n);
+    float *x = (float *)malloc(sizeof(float) * FLOWLM_D_MODEL * (size_t)n);
+    if (!next || !caches || !lat || !x) {
+        free(next); free(caches); free(lat); free(x);
+        return -1;
+    }
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+        float *latent = out_latents + (size_t)i * FLOWLM_LATENT_DIM;
+        session_sample(sessions[i], latent, NULL, NULL, NULL);
+        if (sessions[i]->state != 1) continue;
+        ptts_flowlm_kv_cache *cache = sessions[i]->cache;
+        if (kv_cache_reserve(cache, cache->seq_len + 1) != 0) {
+            sessions[i]->state = -1;
+            continue;
         }
+        memcpy(lat + (size_t)m * FLOWLM_LATENT_DIM, latent, sizeof(float) * FLOWLM_LATENT_DIM);
+        caches[m] = sessions[i]->cache;
+        next[m++] = sessions[i];
+    }
 
-        float latent[FLOWLM_LATENT_DIM];
-        for (int d = 0; d < FLOWLM_LATENT_DIM; d += 2) {
-            float z0 = 0.0f;
-            float z1 = 0.0f;
-            if (std > 0.0f) {
-                float u1 = rng_next_f01(&rng);
-                float u2 = rng_next_f01(&rng);
-                float r = sqrtf(-2.0f * logf(u1));
-                float theta = 2.0f * (float)M_PI * u2;
-                z0 = r * cosf(theta) * std;
-                z1 = r * sinf(theta) * std;
-            }
-            if (noise_clamp > 0.0f) {
-                if (z0 < -noise_clamp) z0 = -noise_clamp;
-                if (z0 > noise_clamp) z0 = noise_clamp;
-                if (z1 < -noise_clamp) z1 = -noise_clamp;
-                if (z1 > noise_clamp) z1 = noise_clamp;
+    int rc = 0;
+    if (m > 0) {
+        linear_forward(fm->input_linear_w, NULL, FLOWLM_D_MODEL, FLOWLM_LATENT_DIM, lat, m, x);
+        /* one session keeps the single-row path (and its CUDA attention) */
+        rc = m == 1 ? transformer_forward_step_cached(fm, caches[0], x)
+                    : transformer_forward_step_batch(fm, caches, m, x);
+        for (int j = 0; j < m; j++) {
+            if (rc != 0) {
+                next[j]->state = -1;
+            } else {
+                memcpy(next[j]->x, x + (size_t)j * FLOWLM_D_MODEL, sizeof(next[j]->x));
             }
-            latent[d] = z0;
-            if (d + 1 < FLOWLM_LATENT_DIM) latent[d + 1] = z1;
         }
+    }
+    double ms = ptts_time_ms() - t0;
+    for (int i = 0; i < n; i++) session_frame_done(sessions[i], ms);
+    PTTS_TRACE_END(t_trace, "flowlm.session_step", n);
+    free(next); free(caches); free(lat); free(x);
+    return rc;
+}
+
+int ptts_flowlm_session_state(const ptts_flowlm_session *s) {
+    if (!s) return -1;
+    return s->state;
+}
 
-        float *flow_out = (i == 0) ? out_first_flow : NULL;
-        lsd_decode(fm, normed, lsd_steps, latent, flow_out);
-        memcpy(out_latents + (size_t)i * FLOWLM_LATENT_DIM, latent, sizeof(latent));
+int ptts_flowlm_session_frames(const ptts_flowlm_session *s) {
+    return s ? s->frame : 0;
+}
+
+int ptts_flowlm_session_prefill_left(const ptts_flowlm_session *s) {
+    return s ? s->prefix_len - s->prefilled : 0;
+}
 
-        used = i + 1;
-        if (eos_step >= 0 && i >= eos_step + eos_after) break;
+int ptts_flowlm_session_reserve(ptts_flowlm_session *s, int frames) {
+    if (!s || s->state < 0) return -1;
+    /* frame i is fed back as position prefix_len + i */
+    int len = s->prefix_len + s->frame + (frames > 0 ? frames : 0);
+    if (len > s->cache->max_len) len = s->cache->max_len;
+    return kv_cache_try_reserve(s->cache, len);
+}
 
+static int cmp_float(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+void ptts_flowlm_session_get_stats(const ptts_flowlm_session *s, ptts_flowlm_run_stats *out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    out->eos_frame = -1;
+    if (!s) return;
+    out->prefill_ms = s->prefill_ms;
+    out->flow_ms = s->flow_ms;
+    out->frames = s->frame;
+    out->eos_frame = s->eos_step;
+    out->kv_bytes = (size_t)s->cache->num_pages * FLOWLM_NUM_LAYERS * 2 * KV_PAGE_ROWS *
+                    sizeof(float) + (size_t)s->cache->max_len * sizeof(float);
+    int n = s->frame;
+    float *sorted = n > 0 ? (float *)malloc(sizeof(float) * (size_t)n) : NULL;
+    if (!sorted) return;
+    memcpy(sorted, s->frame_ms, sizeof(float) * (size_t)n);
+    qsort(sorted, (size_t)n, sizeof(float), cmp_float);
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) sum += sorted[i];
+    out->frame_ms_min = sorted[0];
+    out->frame_ms_mean = sum / n;
+    out->frame_ms_p95 = sorted[(n * 95 + 99) / 100 - 1]; /* nearest rank */
+    free(sorted);
+}
+
+int ptts_flowlm_generate_latents_cb(ptts_flowlm *fm, const int *tokens, int token_len,
+                                    const float *cond_prefix, int cond_len,
+                                    int max_frames, int lsd_steps, float temp, float noise_clamp,
+                                    int64_t seed, uint64_t noise_stream,
+                                    int eos_enabled, float eos_threshold,
+                                    int eos_min_frames, int eos_after,
+                                    float *out_latents, int *out_frames_used,
+                                    float *out_first_eos_logit,
+                                    float *out_first_cond,
+                                    float *out_first_flow,
+                                    ptts_flowlm_frame_fn on_frame, void *user,
+                                    ptts_flowlm_run_stats *out_stats) {
+    if (!out_latents || !out_frames_used) return -1;
+    ptts_flowlm_session *s = ptts_flowlm_session_create(fm, tokens, token_len, cond_prefix,
+                                                        cond_len, max_frames, lsd_steps, temp,
+                                                        noise_clamp, seed, noise_stream,
+                                                        eos_enabled, eos_threshold,
+                                                        eos_min_frames, eos_after);
+    if (!s) return -1;
+    if (ptts_flowlm_session_prefill(s, 0) != 0) {
+        ptts_flowlm_session_free(s);
+        return -1;
+    }
+
+    while (s->state == 1) {
+        int i = s->frame;
+        float *latent = out_latents + (size_t)i * FLOWLM_LATENT_DIM;
+        double t0 = ptts_time_ms();
+        session_sample(s, latent, i == 0 ? out_first_eos_logit : NULL,
+                       i == 0 ? out_first_cond : NULL, i == 0 ? out_first_flow : NULL);
+        double sample_ms = ptts_time_ms() - t0;
+        if (on_frame && on_frame(user, i, latent) != 0) {
+            ptts_flowlm_session_free(s);
+            return -1;
+        }
+        if (s->state != 1) {
+            session_frame_done(s, sample_ms);
+            break;
+        }
+
+        /* time blocked in on_frame is not the frame's */
+        double t1 = ptts_time_ms();
         linear_forward(fm->input_linear_w, NULL, FLOWLM_D_MODEL, FLOWLM_LATENT_DIM,
-                       latent, 1, x);
-        if (transformer_forward_step_cached(fm, cache, x) != 0) {
-            kv_cache_free(cache);
+                       latent, 1, s->x);
+        if (transformer_forward_step_cached(fm, s->cache, s->x) != 0) {
+            ptts_flowlm_session_free(s);
             return -1;
         }
+        session_frame_done(s, sample_ms + ptts_time_ms() - t1);
     }
 
+    int used = s->frame;
     *out_frames_used = used;
-    kv_cache_free(cache);
+    if (ptts_timing_enabled() && s->steps_run > 0) {
+        int steps = s->steps_run;
+        if (fm->flow_team) {
+            fprintf(stderr, "[ptts] Flow net: %.3f ms per LSD step (%d steps, %d-thread weight-stationary)\n",
+                    s->flow_ms / steps, steps, ptts_team_size(fm->flow_team->team));
+        } else {
+            fprintf(stderr, "[ptts] Flow net: %.3f ms per LSD step (%d steps, generic)\n",
+                    s->flow_ms / steps, steps);
+        }
+    }
+    if (ptts_timing_enabled()) {
+        ptts_kv_pool_stats st;
+        ptts_kv_pool_get_stats(s->cache->pool, &st);
+        fprintf(stderr, "[ptts] KV pool: session %d pages (%.1f MB, worst case %.1f MB), "
+                "pool %d/%d pages in use, peak %d, %d refused, %d waits (%d timed out)\n",
+                s->cache->num_pages, s->cache->num_pages * st.page_bytes / 1048576.0,
+                (double)s->cache->max_len * FLOWLM_NUM_LAYERS * 2 * FLOWLM_D_MODEL * sizeof(float) / 1048576.0,
+                st.pages_in_use, st.pages_total, st.pages_peak, st.alloc_failures, st.waits,
+                st.wait_timeouts);
+    }
+    ptts_flowlm_session_get_stats(s, out_stats);
+    ptts_flowlm_session_free(s);
     return 0;
 }
 
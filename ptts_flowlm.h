@@ -16,6 +16,9 @@ typedef struct ptts_flowlm ptts_flowlm;
 ptts_flowlm *ptts_flowlm_load(ptts_ctx *ctx);
 void ptts_flowlm_free(ptts_flowlm *fm);
 
+/* Map the converted weights read-only (see safetensors_arena_protect). */
+int ptts_flowlm_protect_weights(ptts_flowlm *fm);
+
 /*
  * Run a single FlowLM step (non-streaming). Returns 0 on success.
  * tokens: input text tokens
@@ -29,24 +32,127 @@ int ptts_flowlm_forward_one(ptts_flowlm *fm, const int *tokens, int token_len,
                             int lsd_steps, float temp, float noise_clamp,
                             int64_t seed, float *out_latent, float *out_eos_logit);
 
-/* Generate next latent given previous latents (naive, non-streaming). */
+/* Generate next latent given previous latents (naive, non-streaming).
+ * Noise is drawn for frame index prev_len, so the result does not depend on
+ * earlier calls; *seed_io is resolved (-1 -> time) and left unchanged otherwise. */
 int ptts_flowlm_forward_next(ptts_flowlm *fm, const int *tokens, int token_len,
                              const float *cond_prefix, int cond_len,
                              const float *prev_latents, int prev_len,
                              int lsd_steps, float temp, float noise_clamp,
                              int64_t *seed_io, float *out_latent, float *out_eos_logit);
 
-/* Generate multiple latents with an internal KV cache (non-streaming). */
+/* Generate multiple latents with an internal KV cache (non-streaming).
+ * noise_stream selects an independent noise sequence for the same seed
+ * (e.g. a request or chunk id). */
 int ptts_flowlm_generate_latents(ptts_flowlm *fm, const int *tokens, int token_len,
                                  const float *cond_prefix, int cond_len,
                                  int max_frames, int lsd_steps, float temp, float noise_clamp,
-                                 int64_t seed, int eos_enabled, float eos_threshold,
+                                 int64_t seed, uint64_t noise_stream,
+                                 int eos_enabled, float eos_threshold,
                                  int eos_min_frames, int eos_after,
                                  float *out_latents, int *out_frames_used,
                                  float *out_first_eos_logit,
                                  float *out_first_cond,
                                  float *out_first_flow);
 
+/* Per-frame hook for ptts_flowlm_generate_latents_cb: called with each
+ * (unscaled) latent as soon as it is sampled. Nonzero return aborts. */
+typedef int (*ptts_flowlm_frame_fn)(void *user, int frame, const float *latent);
+
+/* Per-request counters behind ptts_stats. A frame's time runs from
+ * sampling its latent through the transformer step that feeds it back
+ * (time blocked in on_frame excluded; a batched step counts in full for
+ * every session in it). */
+typedef struct {
+    double prefill_ms;   /* voice/text/BOS prefix, prefix-cache restore included */
+    double flow_ms;      /* flow net over all frames */
+    double frame_ms_min;
+    double frame_ms_mean;
+    double frame_ms_p95;
+    int frames;
+    int eos_frame;       /* -1 if EOS never fired */
+    size_t kv_bytes;     /* KV pages and attention scores held by the session */
+} ptts_flowlm_run_stats;
+
+/* Same as ptts_flowlm_generate_latents, plus on_frame and out_stats (either
+ * may be NULL). */
+int ptts_flowlm_generate_latents_cb(ptts_flowlm *fm, const int *tokens, int token_len,
+                                    const float *cond_prefix, int cond_len,
+                                    int max_frames, int lsd_steps, float temp, float noise_clamp,
+                                    int64_t seed, uint64_t noise_stream,
+                                    int eos_enabled, float eos_threshold,
+                                    int eos_min_frames, int eos_after,
+                                    float *out_latents, int *out_frames_used,
+                                    float *out_first_eos_logit,
+                                    float *out_first_cond,
+                                    float *out_first_flow,
+                                    ptts_flowlm_frame_fn on_frame, void *user,
+                                    ptts_flowlm_run_stats *out_stats);
+
+/*
+ * Sessions run the same generation one step at a time, so a scheduler can
+ * interleave many requests: create with the ptts_flowlm_generate_latents
+ * arguments (tokens and cond_prefix are borrowed until prefill completes),
+ * prefill the voice/text/BOS prefix in slices, then step frames.
+ */
+typedef struct ptts_flowlm_session ptts_flowlm_session;
+
+ptts_flowlm_session *ptts_flowlm_session_create(ptts_flowlm *fm, const int *tokens, int token_len,
+                                                const float *cond_prefix, int cond_len,
+                                                int max_frames, int lsd_steps, float temp,
+                                                float noise_clamp, int64_t seed,
+                                                uint64_t noise_stream, int eos_enabled,
+                                                float eos_threshold, int eos_min_frames,
+                                                int eos_after);
+void ptts_flowlm_session_free(ptts_flowlm_session *s);
+
+/* Runs up to max_positions prefix positions (<= 0: all of them). Returns
+ * the positions still to run, 0 once the session can step, or -1. */
+int ptts_flowlm_session_prefill(ptts_flowlm_session *s, int max_positions);
+int ptts_flowlm_session_prefill_left(const ptts_flowlm_session *s);
+
+/* Takes the KV pages the session needs to finish its prefix and emit the
+ * next `frames` frames, without waiting. Returns 0, 1 when the pool budget
+ * is spent (pages taken so far are kept; retry once other sessions release
+ * theirs), or -1. Prefill and step wait for pages instead (see
+ * PTTS_KV_WAIT_MS), so a scheduler reserves first and defers the sessions
+ * that got none rather than blocking or failing them. */
+int ptts_flowlm_session_reserve(ptts_flowlm_session *s, int frames);
+
+/* Emits one frame from each of n prefilled, running sessions of the same
+ * model into out_latents [n, 32] (unscaled). The transformer step that
+ * follows runs the sessions' rows together, so every weight matrix is read
+ * once per frame rather than once per session. Output matches running each
+ * session alone. A session that cannot get a KV page for its next position
+ * is failed on its own. Returns -1 if the shared step failed (the sessions
+ * are failed). */
+int ptts_flowlm_session_step(ptts_flowlm_session **sessions, int n, float *out_latents);
+
+/* 1 while frames remain, 0 after the last one (EOS tail or max_frames),
+ * -1 after a failure. */
+int ptts_flowlm_session_state(const ptts_flowlm_session *s);
+int ptts_flowlm_session_frames(const ptts_flowlm_session *s);
+void ptts_flowlm_session_get_stats(const ptts_flowlm_session *s, ptts_flowlm_run_stats *out);
+
+/* 1 when sessions share the resident CUDA KV cache, else 0 (see
+ * ptts_session_limit). */
+int ptts_flowlm_session_limit(void);
+
+/* Time `calls` flow-net calls on random inputs with the generic GEMVs and
+ * with weight-stationary teams of 2, 4, ... threads (up to PTTS_FLOW_THREADS
+ * or the CPU count), and print ms per call, the speedup and max abs
+ * difference to stdout. */
+int ptts_flowlm_flow_report(ptts_flowlm *fm, int calls);
+
+/* PTTS_GOVERNOR totals for this model (see ptts_governor_get_stats). */
+void ptts_flowlm_governor_stats(const ptts_flowlm *fm, ptts_governor_stats *out);
+
+/* Initial latent noise for one frame (length 32), from a counter-based
+ * generator keyed by (seed, stream, frame, dim). Scaled by sqrt(temp) and
+ * clamped to [-noise_clamp, noise_clamp] when noise_clamp > 0. */
+void ptts_flowlm_noise(uint64_t seed, uint64_t stream, int frame,
+                       float temp, float noise_clamp, float *out);
+
 /* Scale FlowLM latents to Mimi latent space. */
 void ptts_flowlm_scale_latents(const ptts_flowlm *fm, const float *in_latents,
                                int frames, float *out_latents);
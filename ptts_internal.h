@@ -1,9 +1,29 @@
 #ifndef PTTS_INTERNAL_H
 #define PTTS_INTERNAL_H
 
+#include <pthread.h>
+#include "ptts.h"
+#include "ptts_kv_pool.h"
+#include "ptts_prefix_cache.h"
 #include "ptts_safetensors.h"
 #include "ptts_spm.h"
 
+/* Wall time of the most recent load of each subsystem (0 = not loaded). */
+typedef struct {
+    double open_ms;   /* safetensors_open */
+    double flowlm_ms; /* ptts_flowlm_load */
+    double mimi_ms;   /* ptts_mimi_load, including layout/precision setup */
+} ptts_load_times;
+
+/* Decoded voice conditioning kept on the context, keyed by the voice name or
+ * path as passed in; ptts_load_voice_conditioning hands out copies. */
+#define PTTS_VOICE_CACHE_SLOTS 16
+typedef struct {
+    char *name;
+    float *cond;
+    int len;
+} ptts_voice_slot;
+
 struct ptts_ctx {
     char *model_dir;
     char *weights_path;
@@ -11,8 +31,29 @@ struct ptts_ctx {
     char *tokenizer_path;
     ptts_spm *tokenizer;
     int sample_rate;
+    ptts_prefix_cache *prefix_cache; /* NULL when disabled */
+    ptts_kv_pool *kv_pool;
+    ptts_load_times load_times;
+    struct ptts_flowlm *flowlm; /* ptts_preload, else NULL */
+    struct ptts_mimi *mimi;
+    pthread_mutex_t voice_lock;
+    ptts_voice_slot voices[PTTS_VOICE_CACHE_SLOTS];
+    int num_voices;
 };
 
+/* Normalizes params (defaults, frame estimate, EOS tail) and tokenizes the
+ * prepared text into *out_ids (caller frees). Returns 0, or -1 with the
+ * error set. */
+int ptts_prepare_request(ptts_ctx *ctx, const char *text, const ptts_params *params,
+                         ptts_params *out_p, int **out_ids, int *out_n);
+
+/* ptts_generate for ids and params from ptts_prepare_request, so a caller
+ * that already tokenized (batch ordering) does not do it twice. */
+ptts_audio *ptts_generate_ids(ptts_ctx *ctx, const int *ids, int n, const ptts_params *params,
+                              const char *voice_path);
+
+/* Sets the message returned by ptts_get_error (per thread). */
+void ptts_set_error(const char *msg);
 int ptts_timing_enabled(void);
 double ptts_time_ms(void);
 
@@ -1,4 +1,5 @@
 #include "ptts_kernels.h"
+#include "ptts_trace.h"
 
 #ifdef PTTS_USE_CUDA
 #include "ptts_cuda.h"
@@ -16,6 +17,8 @@
 #include <string.h>
 #include <stdlib.h>
 
+#define PTTS_LINEAR_ROW_BLOCK 8 /* input rows sharing one pass over a weight row */
+
 #ifdef PTTS_USE_CUDA
 static int g_cuda_linear_inited = 0;
 static int g_cuda_linear_enabled = 1;
@@ -59,6 +62,7 @@ void ptts_linear_forward(float *y, const float *x, const float *w, const float *
         return;
     }
 #endif
+    PTTS_TRACE_BEGIN(t_trace);
 #ifdef PTTS_USE_BLAS
     cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans,
                 n, out, in, 1.0f, x, in, w, in, 0.0f, y, out);
@@ -69,24 +73,30 @@ void ptts_linear_forward(float *y, const float *x, const float *w, const float *
         }
     }
 #else
+    /* Blocks of rows innermost: each weight row is loaded once per block and
+     * reused from L1, which is what makes batched decoding pay off. */
     #pragma omp parallel for collapse(2)
-    for (int t = 0; t < n; t++) {
+    for (int t0 = 0; t0 < n; t0 += PTTS_LINEAR_ROW_BLOCK) {
         for (int o = 0; o < out; o++) {
-            const float *xrow = x + t * in;
             const float *wrow = w + o * in;
-            float sum = b ? b[o] : 0.0f;
-            int i = 0;
-            for (; i <= in - 4; i += 4) {
-                sum += wrow[i] * xrow[i] +
-                       wrow[i+1] * xrow[i+1] +
-                       wrow[i+2] * xrow[i+2] +
-                       wrow[i+3] * xrow[i+3];
+            int t1 = t0 + PTTS_LINEAR_ROW_BLOCK < n ? t0 + PTTS_LINEAR_ROW_BLOCK : n;
+            for (int t = t0; t < t1; t++) {
+                const float *xrow = x + t * in;
+                float sum = b ? b[o] : 0.0f;
+                int i = 0;
+                for (; i <= in - 4; i += 4) {
+                    sum += wrow[i] * xrow[i] +
+                           wrow[i+1] * xrow[i+1] +
+                           wrow[i+2] * xrow[i+2] +
+                           wrow[i+3] * xrow[i+3];
+                }
+                for (; i < in; i++) sum += wrow[i] * xrow[i];
+                y[(size_t)t * out + o] = sum;
             }
-            for (; i < in; i++) sum += wrow[i] * xrow[i];
-            y[(size_t)t * out + o] = sum;
         }
     }
 #endif
+    PTTS_TRACE_END(t_trace, "linear", out);
 }
 
 void ptts_conv1d_forward(float *y, const float *x, const float *w, const float *b,
@@ -97,6 +107,7 @@ void ptts_conv1d_forward(float *y, const float *x, const float *w, const float *
         return;
     }
 #endif
+    PTTS_TRACE_BEGIN(t_trace);
     int out_len = T / stride;
     int in_per_group = in_ch / groups;
     int out_per_group = out_ch / groups;
@@ -123,6 +134,7 @@ void ptts_conv1d_forward(float *y, const float *x, const float *w, const float *
             y[(size_t)oc * out_len + t] = sum;
         }
     }
+    PTTS_TRACE_END(t_trace, "conv1d", out_ch);
 }
 
 void ptts_convtr1d_forward(float *y, const float *x, const float *w, const float *b,
@@ -133,6 +145,7 @@ void ptts_convtr1d_forward(float *y, const float *x, const float *w, const float
         return;
     }
 #endif
+    PTTS_TRACE_BEGIN(t_trace);
     int full_len = (T - 1) * stride + k;
     int out_len = full_len - (k - stride);
     int out_per_group = out_ch / groups;
@@ -166,6 +179,689 @@ void ptts_convtr1d_forward(float *y, const float *x, const float *w, const float
             }
         }
     }
+    PTTS_TRACE_END(t_trace, "convtr1d", out_ch);
+}
+
+void ptts_conv1d_stream_forward(float *y, float *hist, const float *x, const float *w,
+                                const float *b, int in_ch, int out_ch, int T, int k, int groups) {
+    PTTS_TRACE_BEGIN(t_trace);
+    int in_per_group = in_ch / groups;
+    int out_per_group = out_ch / groups;
+    int h = k - 1;
+
+    #pragma omp parallel for
+    for (int oc = 0; oc < out_ch; oc++) {
+        int g = oc / out_per_group;
+        int in_base = g * in_per_group;
+        const float *wbase = w + (size_t)oc * in_per_group * k;
+        float bias = b ? b[oc] : 0.0f;
+        for (int t = 0; t < T; t++) {
+            float sum = bias;
+            for (int ic = 0; ic < in_per_group; ic++) {
+                const float *wrow = wbase + ic * k;
+                const float *xch = x + (size_t)(in_base + ic) * T;
+                const float *hch = hist + (size_t)(in_base + ic) * h;
+                for (int kk = 0; kk < k; kk++) {
+                    int idx = t - h + kk;
+                    sum += wrow[kk] * (idx < 0 ? hch[h + idx] : xch[idx]);
+                }
+            }
+            y[(size_t)oc * T + t] = sum;
+        }
+    }
+    PTTS_TRACE_END(t_trace, "conv1d_stream", out_ch);
+
+    if (h == 0) return;
+    for (int ic = 0; ic < in_ch; ic++) {
+        float *hch = hist + (size_t)ic * h;
+        const float *xch = x + (size_t)ic * T;
+        if (T >= h) {
+            memcpy(hch, xch + T - h, (size_t)h * sizeof(float));
+        } else {
+            memmove(hch, hch + T, (size_t)(h - T) * sizeof(float));
+            memcpy(hch + h - T, xch, (size_t)T * sizeof(float));
+        }
+    }
+}
+
+int ptts_convtr1d_stream_forward(float *y, float *tail, const float *x, const float *w,
+                                 const float *b, int in_ch, int out_ch, int T, int k,
+                                 int stride, int groups) {
+    int ov = k - stride;
+    if (ov < 0) return -1;
+    int out_len = T * stride;
+    int full_len = out_len + ov;
+    int out_per_group = out_ch / groups;
+    int in_per_group = in_ch / groups;
+    float *acc = (float *)malloc((size_t)out_ch * full_len * sizeof(float));
+    if (!acc) return -1;
+    PTTS_TRACE_BEGIN(t_trace);
+
+    #pragma omp parallel for
+    for (int oc = 0; oc < out_ch; oc++) {
+        int g = oc / out_per_group;
+        int ocg = oc % out_per_group;
+        int in_base = g * in_per_group;
+        float *a = acc + (size_t)oc * full_len;
+        float *tl = tail + (size_t)oc * ov;
+
+        float bias = b ? b[oc] : 0.0f;
+        for (int t = 0; t < full_len; t++) {
+            a[t] = (t < out_len ? bias : 0.0f) + (t < ov ? tl[t] : 0.0f);
+        }
+
+        for (int ic_offset = 0; ic_offset < in_per_group; ic_offset++) {
+            int ic = in_base + ic_offset;
+            const float *xch = x + (size_t)ic * T;
+            const float *wrow = w + ((size_t)ic * out_per_group + ocg) * k;
+            for (int t = 0; t < T; t++) {
+                float *dst = a + t * stride;
+                float xval = xch[t];
+                for (int kk = 0; kk < k; kk++) dst[kk] += wrow[kk] * xval;
+            }
+        }
+
+        memcpy(y + (size_t)oc * out_len, a, (size_t)out_len * sizeof(float));
+        memcpy(tl, a + out_len, (size_t)ov * sizeof(float));
+    }
+
+    free(acc);
+    PTTS_TRACE_END(t_trace, "convtr1d_stream", out_ch);
+    return 0;
+}
+
+/* ------------------------------------------------------------------------
+ * Channels-last convolutions
+ *
+ * Packed weights are [group][k][in_per_group][out_per_group], so one tap of
+ * one input channel is a contiguous row over output channels. Depthwise
+ * layers (one channel per group) pack as [k][channels] instead.
+ * ------------------------------------------------------------------------ */
+
+#define TC_TB 16 /* time rows per tile */
+#define TC_OB 64 /* output channels per tile */
+
+static int tc_depthwise(int in_ch, int out_ch, int groups) {
+    return groups == in_ch && groups == out_ch;
+}
+
+float *ptts_conv1d_pack_tc(const float *w, int in_ch, int out_ch, int k, int groups) {
+    int ipg = in_ch / groups;
+    int opg = out_ch / groups;
+    float *wt = (float *)malloc((size_t)out_ch * ipg * k * sizeof(float));
+    if (!wt) return NULL;
+    if (tc_depthwise(in_ch, out_ch, groups)) {
+        for (int c = 0; c < out_ch; c++) {
+            for (int kk = 0; kk < k; kk++) wt[(size_t)kk * out_ch + c] = w[(size_t)c * k + kk];
+        }
+        return wt;
+    }
+    for (int oc = 0; oc < out_ch; oc++) {
+        int g = oc / opg;
+        int o = oc % opg;
+        for (int ic = 0; ic < ipg; ic++) {
+            for (int kk = 0; kk < k; kk++) {
+                wt[(((size_t)g * k + kk) * ipg + ic) * opg + o] =
+                    w[((size_t)oc * ipg + ic) * k + kk];
+            }
+        }
+    }
+    return wt;
+}
+
+float *ptts_convtr1d_pack_tc(const float *w, int in_ch, int out_ch, int k, int groups) {
+    int ipg = in_ch / groups;
+    int opg = out_ch / groups;
+    float *wt = (float *)malloc((size_t)in_ch * opg * k * sizeof(float));
+    if (!wt) return NULL;
+    if (tc_depthwise(in_ch, out_ch, groups)) {
+        for (int c = 0; c < in_ch; c++) {
+            for (int kk = 0; kk < k; kk++) wt[(size_t)kk * in_ch + c] = w[(size_t)c * k + kk];
+        }
+        return wt;
+    }
+    for (int ic = 0; ic < in_ch; ic++) {
+        int g = ic / ipg;
+        int i = ic % ipg;
+        for (int o = 0; o < opg; o++) {
+            for (int kk = 0; kk < k; kk++) {
+                wt[(((size_t)g * k + kk) * ipg + i) * opg + o] =
+                    w[((size_t)ic * opg + o) * k + kk];
+            }
+        }
+    }
+    return wt;
+}
+
+static inline float bf16_to_f32(uint16_t h) {
+    union { uint32_t u; float f; } v;
+    v.u = (uint32_t)h << 16;
+    return v.f;
+}
+
+/* Round to nearest even. */
+static inline uint16_t f32_to_bf16(float f) {
+    union { uint32_t u; float f; } v;
+    v.f = f;
+    return (uint16_t)((v.u + 0x7fffu + ((v.u >> 16) & 1u)) >> 16);
+}
+
+/* Element i of a conv input, as f32 (PTTS_CONV_IN_BF16 selects storage). */
+static inline float tc_load(const float *x, ptrdiff_t i, int flags) {
+    float v = (flags & PTTS_CONV_IN_BF16) ? bf16_to_f32(((const uint16_t *)x)[i]) : x[i];
+    return ((flags & PTTS_CONV_IN_ELU) && v < 0.0f) ? expf(v) - 1.0f : v;
+}
+
+/* Write one output row segment at element i of y: overwrite or accumulate,
+ * in f32 or bf16 storage. */
+static inline void tc_store(float *y, size_t i, const float *acc, int n, int flags) {
+    if (flags & PTTS_CONV_OUT_BF16) {
+        uint16_t *yh = (uint16_t *)y + i;
+        if (flags & PTTS_CONV_ACCUM) {
+            for (int o = 0; o < n; o++) yh[o] = f32_to_bf16(bf16_to_f32(yh[o]) + acc[o]);
+        } else {
+            for (int o = 0; o < n; o++) yh[o] = f32_to_bf16(acc[o]);
+        }
+    } else if (flags & PTTS_CONV_ACCUM) {
+        for (int o = 0; o < n; o++) y[i + o] += acc[o];
+    } else {
+        memcpy(y + i, acc, (size_t)n * sizeof(float));
+    }
+}
+
+/* Input rows must be staged when they need converting (bf16) or ELU. Rows
+ * before t = 0 are zeros unless PTTS_CONV_IN_HIST makes them readable. */
+static inline int tc_stage_input(int flags) {
+    return (flags & (PTTS_CONV_IN_ELU | PTTS_CONV_IN_BF16)) != 0;
+}
+
+/* Stage n input channels of one row as f32, applying ELU if requested. */
+static inline void tc_stage_row(float *dst, const float *x, ptrdiff_t i, int n, int flags) {
+    if (flags & PTTS_CONV_IN_BF16) {
+        const uint16_t *src = (const uint16_t *)x + i;
+        for (int c = 0; c < n; c++) dst[c] = bf16_to_f32(src[c]);
+    } else {
+        memcpy(dst, x + i, (size_t)n * sizeof(float));
+    }
+    if (flags & PTTS_CONV_IN_ELU) {
+        for (int c = 0; c < n; c++) {
+            float e = dst[c];
+            dst[c] = e >= 0.0f ? e : (expf(e) - 1.0f);
+        }
+    }
+}
+
+static int tc_num_threads(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+static float *tc_thread_buf(float *bufs, size_t per_thread) {
+#ifdef _OPENMP
+    return bufs + (size_t)omp_get_thread_num() * per_thread;
+#else
+    (void)per_thread;
+    return bufs;
+#endif
+}
+
+/* A tile's view of its input rows: either x itself or rows [base, base + T)
+ * of one group staged (widened from bf16, through ELU) into a per-thread
+ * buffer, so the conversion runs once per loaded row in a vectorizable
+ * loop. */
+typedef struct {
+    const float *x;
+    int stride;
+    int T;
+    int base;
+} tc_rows;
+
+static tc_rows tc_tile_rows(const float *x, int in_ch, int T, int c0, int n,
+                            int r0, int r1, float *buf, int flags) {
+    tc_rows v = {x + c0, in_ch, T, 0};
+    if (!(flags & PTTS_CONV_IN_HIST)) {
+        if (!buf) return v;
+        if (r0 < 0) r0 = 0;
+    }
+    if (r1 > T) r1 = T;
+    if (!buf) {
+        v.x = x + (ptrdiff_t)r0 * in_ch + c0;
+        v.T = r1 - r0;
+        v.base = r0;
+        return v;
+    }
+    for (int r = r0; r < r1; r++) {
+        tc_stage_row(buf + (size_t)(r - r0) * n, x, (ptrdiff_t)r * in_ch + c0, n, flags);
+    }
+    v.x = buf;
+    v.stride = n;
+    v.T = r1 - r0;
+    v.base = r0;
+    return v;
+}
+
+/* acc[tt][0..ob) += x[row0 + tt][0..ipg) . w[0..ipg)[0..ob) for tt < tb,
+ * skipping rows outside the view. w is offset to the group, tap and output
+ * block; its rows are wstride apart. */
+static void tc_tile_accumulate(float *acc, int tb, int ob, const tc_rows *xv, int row0,
+                               const float *w, int ipg, int wstride) {
+    row0 -= xv->base;
+    int lo = row0 < 0 ? -row0 : 0;
+    int hi = row0 + tb > xv->T ? xv->T - row0 : tb;
+    for (int ic = 0; ic < ipg; ic++) {
+        const float *wr = w + (size_t)ic * wstride;
+        for (int tt = lo; tt < hi; tt++) {
+            float x = xv->x[(size_t)(row0 + tt) * xv->stride + ic];
+            float *a = acc + tt * TC_OB;
+            for (int o = 0; o < ob; o++) a[o] += x * wr[o];
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------
+ * Shape-specialized channels-last conv1d (stride 1, k = 3 or 7)
+ *
+ * Each tile's input rows, including k-1 rows of history (zeros before
+ * t = 0), are contiguous, so the taps need no bounds checks. The micro
+ * kernel keeps a TC_MR x TC_NR output block in registers while streaming
+ * one packed weight row per (tap, input channel). Summation order matches
+ * the generic tile kernel, so results are identical.
+ * ------------------------------------------------------------------------ */
+
+#define TC_MR 4  /* output rows per register block (c0..c3) */
+#define TC_NR 16 /* output channels per register block */
+
+#define TC_FB 64  /* time rows per tile: each weight block is reused TC_FB / TC_MR times */
+#define TC_ICB 64 /* input channels per weight block (keeps its rows in L1) */
+
+static inline void conv1d_tc_fixed_tile(float *y, size_t y0, int out_ch, const float *xs,
+                                        int xstride, const float *wt, const float *bias,
+                                        int ipg, int opg, int nt, const int k, int flags) {
+    float acc[TC_FB * TC_NR];
+    for (int o0 = 0; o0 < opg; o0 += TC_NR) {
+        for (int r = 0; r < nt; r++) {
+            for (int o = 0; o < TC_NR; o++) acc[r * TC_NR + o] = bias ? bias[o0 + o] : 0.0f;
+        }
+        for (int kk = 0; kk < k; kk++) {
+            for (int i0 = 0; i0 < ipg; i0 += TC_ICB) {
+                int i1 = i0 + TC_ICB < ipg ? i0 + TC_ICB : ipg;
+                const float *wk = wt + (size_t)kk * ipg * opg + o0;
+                for (int r0 = 0; r0 < nt; r0 += TC_MR) {
+                    const float *xk = xs + (size_t)(r0 + kk) * xstride;
+                    float *a = acc + r0 * TC_NR;
+                    float c0[TC_NR], c1[TC_NR], c2[TC_NR], c3[TC_NR];
+                    for (int o = 0; o < TC_NR; o++) {
+                        c0[o] = a[o];
+                        c1[o] = a[TC_NR + o];
+                        c2[o] = a[2 * TC_NR + o];
+                        c3[o] = a[3 * TC_NR + o];
+                    }
+                    for (int ic = i0; ic < i1; ic++) {
+                        const float *w = wk + (size_t)ic * opg;
+                        float x0 = xk[ic];
+                        float x1 = xk[(size_t)xstride + ic];
+                        float x2 = xk[(size_t)2 * xstride + ic];
+                        float x3 = xk[(size_t)3 * xstride + ic];
+                        for (int o = 0; o < TC_NR; o++) {
+                            c0[o] += x0 * w[o];
+                            c1[o] += x1 * w[o];
+                            c2[o] += x2 * w[o];
+                            c3[o] += x3 * w[o];
+                        }
+                    }
+                    for (int o = 0; o < TC_NR; o++) {
+                        a[o] = c0[o];
+                        a[TC_NR + o] = c1[o];
+                        a[2 * TC_NR + o] = c2[o];
+                        a[3 * TC_NR + o] = c3[o];
+                    }
+                }
+            }
+        }
+        for (int r = 0; r < nt; r++) {
+            tc_store(y, y0 + (size_t)r * out_ch + o0, acc + r * TC_NR, TC_NR, flags);
+        }
+    }
+}
+
+static inline void conv1d_tc_fixed(float *y, const float *x, const float *wt, const float *b,
+                                   int in_ch, int out_ch, int T, const int k, int groups,
+                                   int flags, float *bufs, size_t stage) {
+    int ipg = in_ch / groups;
+    int opg = out_ch / groups;
+    int staged = tc_stage_input(flags);
+    int hist = (flags & PTTS_CONV_IN_HIST) != 0;
+    int n_tb = (T + TC_FB - 1) / TC_FB;
+
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (int g = 0; g < groups; g++) {
+        for (int tb = 0; tb < n_tb; tb++) {
+            int t0 = tb * TC_FB;
+            int nt = T - t0 < TC_FB ? T - t0 : TC_FB;
+            const float *xs;
+            int xstride;
+            if (!staged && (t0 >= k - 1 || hist)) {
+                xs = x + (ptrdiff_t)(t0 - (k - 1)) * in_ch + (ptrdiff_t)g * ipg;
+                xstride = in_ch;
+            } else {
+                float *buf = tc_thread_buf(bufs, stage);
+                for (int r = t0 - (k - 1); r < t0 + nt; r++) {
+                    float *dst = buf + (size_t)(r - (t0 - (k - 1))) * ipg;
+                    if (r < 0 && !hist) {
+                        memset(dst, 0, (size_t)ipg * sizeof(float));
+                    } else {
+                        tc_stage_row(dst, x, (ptrdiff_t)r * in_ch + (ptrdiff_t)g * ipg, ipg,
+                                     flags);
+                    }
+                }
+                xs = buf;
+                xstride = ipg;
+            }
+            conv1d_tc_fixed_tile(y, (size_t)t0 * out_ch + (size_t)g * opg, out_ch, xs, xstride,
+                                 wt + (size_t)g * k * ipg * opg, b ? b + g * opg : NULL, ipg, opg,
+                                 nt, k, flags);
+        }
+    }
+}
+
+static int conv1d_tc_fixed_ok(int in_ch, int out_ch, int T, int k, int groups) {
+    return (k == 3 || k == 7) && !tc_depthwise(in_ch, out_ch, groups) &&
+           (out_ch / groups) % TC_NR == 0 && T % TC_MR == 0;
+}
+
+int ptts_kernel_threads(void) {
+    return tc_num_threads();
+}
+
+size_t ptts_conv1d_tc_scratch(int in_ch, int k, int groups) {
+    int rows = TC_FB > TC_TB ? TC_FB : TC_TB;
+    return (size_t)(rows + k - 1) * (in_ch / groups);
+}
+
+size_t ptts_convtr1d_tc_scratch(int in_ch, int k, int stride, int groups) {
+    int taps = (k + stride - 1) / stride;
+    return (size_t)(TC_TB + taps - 1) * (in_ch / groups);
+}
+
+void ptts_conv1d_tc_forward(float *y, const float *x, const float *wt, const float *b,
+                            int in_ch, int out_ch, int T, int k, int groups, int flags,
+                            float *scratch) {
+    PTTS_TRACE_BEGIN(t_trace);
+    if (conv1d_tc_fixed_ok(in_ch, out_ch, T, k, groups)) {
+        size_t stage = ptts_conv1d_tc_scratch(in_ch, k, groups);
+        if (k == 3) {
+            conv1d_tc_fixed(y, x, wt, b, in_ch, out_ch, T, 3, groups, flags, scratch, stage);
+        } else {
+            conv1d_tc_fixed(y, x, wt, b, in_ch, out_ch, T, 7, groups, flags, scratch, stage);
+        }
+    } else {
+        ptts_conv1d_tc_generic_forward(y, x, wt, b, in_ch, out_ch, T, k, groups, flags,
+                                       scratch);
+    }
+    PTTS_TRACE_END(t_trace, "conv1d_tc", out_ch);
+}
+
+void ptts_conv1d_tc_generic_forward(float *y, const float *x, const float *wt, const float *b,
+                                    int in_ch, int out_ch, int T, int k, int groups,
+                                    int flags, float *scratch) {
+    int ipg = in_ch / groups;
+    int opg = out_ch / groups;
+    int staged = tc_stage_input(flags);
+
+    if (tc_depthwise(in_ch, out_ch, groups)) {
+        #pragma omp parallel for
+        for (int t = 0; t < T; t++) {
+            float acc[TC_OB];
+            for (int c0 = 0; c0 < out_ch; c0 += TC_OB) {
+                int n = out_ch - c0 < TC_OB ? out_ch - c0 : TC_OB;
+                for (int c = 0; c < n; c++) acc[c] = b ? b[c0 + c] : 0.0f;
+                for (int kk = 0; kk < k; kk++) {
+                    int idx = t - (k - 1) + kk;
+                    if (idx < 0 && !(flags & PTTS_CONV_IN_HIST)) continue;
+                    const float *wr = wt + (size_t)kk * out_ch + c0;
+                    for (int c = 0; c < n; c++) {
+                        acc[c] += wr[c] * tc_load(x, (ptrdiff_t)idx * in_ch + c0 + c, flags);
+                    }
+                }
+                tc_store(y, (size_t)t * out_ch + c0, acc, n, flags);
+            }
+        }
+        return;
+    }
+
+    size_t stage = ptts_conv1d_tc_scratch(in_ch, k, groups);
+    float *bufs = staged ? scratch : NULL;
+    int n_tb = (T + TC_TB - 1) / TC_TB;
+
+    if (opg < 8) {
+        /* Few outputs (e.g. the mono output conv): reduce over contiguous
+         * input channels instead. */
+        #pragma omp parallel for collapse(2) schedule(static)
+        for (int g = 0; g < groups; g++) {
+            for (int tb = 0; tb < n_tb; tb++) {
+                int t0 = tb * TC_TB;
+                int nt = T - t0 < TC_TB ? T - t0 : TC_TB;
+                tc_rows xv = tc_tile_rows(x, in_ch, T, g * ipg, ipg, t0 - (k - 1), t0 + nt,
+                                          staged ? tc_thread_buf(bufs, stage) : NULL, flags);
+                for (int t = t0; t < t0 + nt; t++) {
+                    for (int o = 0; o < opg; o++) {
+                        float sum = b ? b[g * opg + o] : 0.0f;
+                        for (int kk = 0; kk < k; kk++) {
+                            int idx = t - (k - 1) + kk - xv.base;
+                            if (idx < 0) continue;
+                            const float *xr = xv.x + (size_t)idx * xv.stride;
+                            const float *wr = wt + ((size_t)g * k + kk) * ipg * opg + o;
+                            for (int ic = 0; ic < ipg; ic++) sum += xr[ic] * wr[(size_t)ic * opg];
+                        }
+                        tc_store(y, (size_t)t * out_ch + g * opg + o, &sum, 1, flags);
+                    }
+                }
+            }
+        }
+        return;
+    }
+
+    int n_ob = (opg + TC_OB - 1) / TC_OB;
+    #pragma omp parallel for collapse(3) schedule(static)
+    for (int g = 0; g < groups; g++) {
+        for (int tb = 0; tb < n_tb; tb++) {
+            for (int obi = 0; obi < n_ob; obi++) {
+                float acc[TC_TB * TC_OB];
+                int t0 = tb * TC_TB;
+                int nt = T - t0 < TC_TB ? T - t0 : TC_TB;
+                int o0 = obi * TC_OB;
+                int ob = opg - o0 < TC_OB ? opg - o0 : TC_OB;
+                tc_rows xv = tc_tile_rows(x, in_ch, T, g * ipg, ipg, t0 - (k - 1), t0 + nt,
+                                          staged ? tc_thread_buf(bufs, stage) : NULL, flags);
+                for (int tt = 0; tt < nt; tt++) {
+                    for (int o = 0; o < ob; o++) {
+                        acc[tt * TC_OB + o] = b ? b[g * opg + o0 + o] : 0.0f;
+                    }
+                }
+                for (int kk = 0; kk < k; kk++) {
+                    tc_tile_accumulate(acc, nt, ob, &xv, t0 - (k - 1) + kk,
+                                       wt + ((size_t)g * k + kk) * ipg * opg + o0, ipg, opg);
+                }
+                for (int tt = 0; tt < nt; tt++) {
+                    tc_store(y, (size_t)(t0 + tt) * out_ch + g * opg + o0, acc + tt * TC_OB, ob,
+                             flags);
+                }
+            }
+        }
+    }
+}
+
+static void convtr1d_tc_forward(float *y, const float *x, const float *wt, const float *b,
+                                int in_ch, int out_ch, int T, int k, int stride, int groups,
+                                int flags, float *scratch) {
+    int ipg = in_ch / groups;
+    int opg = out_ch / groups;
+    int out_len = T * stride;
+    int staged = tc_stage_input(flags);
+
+    if (tc_depthwise(in_ch, out_ch, groups)) {
+        #pragma omp parallel for
+        for (int p = 0; p < out_len; p++) {
+            float acc[TC_OB];
+            for (int c0 = 0; c0 < out_ch; c0 += TC_OB) {
+                int n = out_ch - c0 < TC_OB ? out_ch - c0 : TC_OB;
+                for (int c = 0; c < n; c++) acc[c] = b ? b[c0 + c] : 0.0f;
+                for (int kk = p % stride; kk < k; kk += stride) {
+                    if (p - kk < 0 && !(flags & PTTS_CONV_IN_HIST)) break;
+                    int t = (p - kk) / stride; /* exact: kk = p mod stride */
+                    if (t >= T) continue;
+                    const float *wr = wt + (size_t)kk * in_ch + c0;
+                    for (int c = 0; c < n; c++) {
+                        acc[c] += wr[c] * tc_load(x, (ptrdiff_t)t * in_ch + c0 + c, flags);
+                    }
+                }
+                tc_store(y, (size_t)p * out_ch + c0, acc, n, flags);
+            }
+        }
+        return;
+    }
+
+    /* Output p = u * stride + r takes tap kk = r + j * stride from input
+     * u - j, so each phase r is a sum of row-shifted GEMMs over u. */
+    int taps = (k + stride - 1) / stride;
+    size_t stage = ptts_convtr1d_tc_scratch(in_ch, k, stride, groups);
+    float *bufs = staged ? scratch : NULL;
+    int n_tb = (T + TC_TB - 1) / TC_TB;
+    int n_ob = (opg + TC_OB - 1) / TC_OB;
+    #pragma omp parallel for collapse(3) schedule(static)
+    for (int g = 0; g < groups; g++) {
+        for (int tb = 0; tb < n_tb; tb++) {
+            for (int obi = 0; obi < n_ob; obi++) {
+                float acc[TC_TB * TC_OB];
+                int u0 = tb * TC_TB;
+                int nu = T - u0 < TC_TB ? T - u0 : TC_TB;
+                int o0 = obi * TC_OB;
+                int ob = opg - o0 < TC_OB ? opg - o0 : TC_OB;
+                tc_rows xv = tc_tile_rows(x, in_ch, T, g * ipg, ipg, u0 - (taps - 1), u0 + nu,
+                                          staged ? tc_thread_buf(bufs, stage) : NULL, flags);
+                for (int r = 0; r < stride; r++) {
+                    for (int uu = 0; uu < nu; uu++) {
+                        for (int o = 0; o < ob; o++) {
+                            acc[uu * TC_OB + o] = b ? b[g * opg + o0 + o] : 0.0f;
+                        }
+                    }
+                    for (int kk = r, j = 0; kk < k; kk += stride, j++) {
+                        tc_tile_accumulate(acc, nu, ob, &xv, u0 - j,
+                                           wt + ((size_t)g * k + kk) * ipg * opg + o0, ipg, opg);
+                    }
+                    for (int uu = 0; uu < nu; uu++) {
+                        tc_store(y, ((size_t)(u0 + uu) * stride + r) * out_ch + g * opg + o0,
+                                 acc + uu * TC_OB, ob, flags);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ptts_convtr1d_tc_forward(float *y, const float *x, const float *wt, const float *b,
+                              int in_ch, int out_ch, int T, int k, int stride, int groups,
+                              int flags, float *scratch) {
+    PTTS_TRACE_BEGIN(t_trace);
+    convtr1d_tc_forward(y, x, wt, b, in_ch, out_ch, T, k, stride, groups, flags, scratch);
+    PTTS_TRACE_END(t_trace, "convtr1d_tc", out_ch);
+}
+
+/* ------------------------------------------------------------------------
+ * Reduced-precision storage
+ *
+ * BF16 keeps the top 16 bits of an f32 (rounded to nearest even); INT8 is
+ * symmetric per output row with an f32 scale. Linear layers dequantize a
+ * block of weight rows once per call into a per-thread f32 buffer and then
+ * run f32 dot products over every input row, so the weights cross memory
+ * once at half or a quarter of their f32 size.
+ * ------------------------------------------------------------------------ */
+
+#define QL_OB 8 /* weight rows dequantized per block */
+
+void ptts_f32_to_bf16_row(uint16_t *dst, const float *src, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = f32_to_bf16(src[i]);
+}
+
+void ptts_bf16_to_f32_row(float *dst, const uint16_t *src, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = bf16_to_f32(src[i]);
+}
+
+uint16_t *ptts_quantize_bf16(const float *w, size_t n) {
+    uint16_t *q = (uint16_t *)malloc(n * sizeof(uint16_t));
+    if (q) ptts_f32_to_bf16_row(q, w, n);
+    return q;
+}
+
+int8_t *ptts_quantize_q8_rows(const float *w, int rows, int cols, float *scale) {
+    int8_t *q = (int8_t *)malloc((size_t)rows * cols);
+    if (!q) return NULL;
+    for (int r = 0; r < rows; r++) {
+        const float *src = w + (size_t)r * cols;
+        float amax = 0.0f;
+        for (int c = 0; c < cols; c++) {
+            float a = fabsf(src[c]);
+            if (a > amax) amax = a;
+        }
+        float s = amax > 0.0f ? amax / 127.0f : 1.0f;
+        float inv = 1.0f / s;
+        for (int c = 0; c < cols; c++) {
+            q[(size_t)r * cols + c] = (int8_t)lrintf(src[c] * inv);
+        }
+        scale[r] = s;
+    }
+    return q;
+}
+
+size_t ptts_linear_q_scratch(int in) {
+    return (size_t)QL_OB * in;
+}
+
+static void qlinear_forward(float *y, const float *x, const uint16_t *wh, const int8_t *wq,
+                            const float *scale, const float *b, int n, int in, int out,
+                            float *bufs) {
+    size_t per_thread = ptts_linear_q_scratch(in);
+    PTTS_TRACE_BEGIN(t_trace);
+    int n_ob = (out + QL_OB - 1) / QL_OB;
+    #pragma omp parallel for schedule(static)
+    for (int obi = 0; obi < n_ob; obi++) {
+        float *wb = tc_thread_buf(bufs, per_thread);
+        int o0 = obi * QL_OB;
+        int no = out - o0 < QL_OB ? out - o0 : QL_OB;
+        for (int j = 0; j < no; j++) {
+            float *dst = wb + (size_t)j * in;
+            size_t row = (size_t)(o0 + j) * in;
+            if (wh) {
+                for (int i = 0; i < in; i++) dst[i] = bf16_to_f32(wh[row + i]);
+            } else {
+                float s = scale[o0 + j];
+                for (int i = 0; i < in; i++) dst[i] = (float)wq[row + i] * s;
+            }
+        }
+        for (int t = 0; t < n; t++) {
+            const float *xrow = x + (size_t)t * in;
+            for (int j = 0; j < no; j++) {
+                const float *wrow = wb + (size_t)j * in;
+                float sum = 0.0f;
+                for (int i = 0; i < in; i++) sum += wrow[i] * xrow[i];
+                y[(size_t)t * out + o0 + j] = sum + (b ? b[o0 + j] : 0.0f);
+            }
+        }
+    }
+    PTTS_TRACE_END(t_trace, wh ? "linear_bf16" : "linear_q8", out);
+}
+
+void ptts_linear_bf16_forward(float *y, const float *x, const uint16_t *w, const float *b,
+                              int n, int in, int out, float *scratch) {
+    qlinear_forward(y, x, w, NULL, NULL, b, n, in, out, scratch);
+}
+
+void ptts_linear_q8_forward(float *y, const float *x, const int8_t *w, const float *scale,
+                            const float *b, int n, int in, int out, float *scratch) {
+    qlinear_forward(y, x, NULL, w, scale, b, n, in, out, scratch);
 }
 
 void ptts_elu_inplace(float *x, int n) {
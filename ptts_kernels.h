@@ -1,6 +1,9 @@
 #ifndef PTTS_KERNELS_H
 #define PTTS_KERNELS_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 /* Minimal kernel abstraction for backend acceleration. */
 
 /* Linear layer: y = x @ W^T + b
@@ -17,6 +20,72 @@ void ptts_conv1d_forward(float *y, const float *x, const float *w, const float *
 void ptts_convtr1d_forward(float *y, const float *x, const float *w, const float *b,
                            int in_ch, int out_ch, int T, int k, int stride, int groups);
 
+/* Streaming variants for chunked causal decoding.
+ * conv1d (stride 1): hist [in_ch, k-1] holds the previous chunk's trailing
+ * inputs (zeros at stream start) and is updated; y [out_ch, T].
+ * convtr1d (k >= stride): tail [out_ch, k-stride] carries overlap sums not yet
+ * emitted (zeros at stream start) and is updated; y [out_ch, T*stride]. */
+void ptts_conv1d_stream_forward(float *y, float *hist, const float *x, const float *w,
+                                const float *b, int in_ch, int out_ch, int T, int k, int groups);
+int ptts_convtr1d_stream_forward(float *y, float *tail, const float *x, const float *w,
+                                 const float *b, int in_ch, int out_ch, int T, int k,
+                                 int stride, int groups);
+
+/* Channels-last (time-major) variants: x [T, in_ch], y [out_len, out_ch].
+ * Weights are repacked once with the matching pack function (malloc'd,
+ * caller frees) so the inner loops run over contiguous output channels.
+ * conv1d is causal with stride 1 (left pad k-1); convtr1d trims the right
+ * k-stride tail, giving T*stride outputs. flags fuse the surrounding
+ * elementwise ops: PTTS_CONV_IN_ELU applies ELU to x as it is read and
+ * PTTS_CONV_ACCUM adds the result into y (residual) instead of storing it.
+ * PTTS_CONV_IN_BF16 / PTTS_CONV_OUT_BF16 mean x / y hold bf16 values
+ * (uint16_t storage behind the float pointer); arithmetic stays f32.
+ * PTTS_CONV_IN_HIST reads the rows just before x (k-1 for conv1d,
+ * ceil(k/stride)-1 for convtr1d, same storage, before ELU) as the inputs
+ * preceding t = 0 instead of zeros, so a stream can run chunk by chunk. */
+#define PTTS_CONV_IN_ELU 1
+#define PTTS_CONV_ACCUM 2
+#define PTTS_CONV_IN_BF16 4
+#define PTTS_CONV_OUT_BF16 8
+#define PTTS_CONV_IN_HIST 16
+
+float *ptts_conv1d_pack_tc(const float *w, int in_ch, int out_ch, int k, int groups);
+float *ptts_convtr1d_pack_tc(const float *w, int in_ch, int out_ch, int k, int groups);
+/* scratch holds the per-thread input staging: ptts_kernel_threads() times
+ * the *_tc_scratch floats for the layer. The kernels allocate nothing, so
+ * callers size it once (e.g. in a planned workspace). */
+int ptts_kernel_threads(void);
+size_t ptts_conv1d_tc_scratch(int in_ch, int k, int groups);
+size_t ptts_convtr1d_tc_scratch(int in_ch, int k, int stride, int groups);
+void ptts_conv1d_tc_forward(float *y, const float *x, const float *wt, const float *b,
+                            int in_ch, int out_ch, int T, int k, int groups, int flags,
+                            float *scratch);
+void ptts_convtr1d_tc_forward(float *y, const float *x, const float *wt, const float *b,
+                              int in_ch, int out_ch, int T, int k, int stride, int groups,
+                              int flags, float *scratch);
+/* ptts_conv1d_tc_forward dispatches k = 3 and k = 7 (output channels per
+ * group a multiple of 16, T a multiple of 4) to register-blocked kernels
+ * with no per-tap bounds checks; this is the generic tile kernel they are
+ * checked against. */
+void ptts_conv1d_tc_generic_forward(float *y, const float *x, const float *wt, const float *b,
+                                    int in_ch, int out_ch, int T, int k, int groups,
+                                    int flags, float *scratch);
+
+/* Reduced-precision weights with f32 accumulation. BF16 rounds to nearest
+ * even; INT8 is symmetric per row (scale[r] = max|w[r]| / 127). Quantized
+ * copies are malloc'd, caller frees. The linears match ptts_linear_forward
+ * (w [out, in]) with dequantized weights; scratch holds
+ * ptts_kernel_threads() x ptts_linear_q_scratch(in) floats. */
+void ptts_f32_to_bf16_row(uint16_t *dst, const float *src, size_t n);
+void ptts_bf16_to_f32_row(float *dst, const uint16_t *src, size_t n);
+uint16_t *ptts_quantize_bf16(const float *w, size_t n);
+int8_t *ptts_quantize_q8_rows(const float *w, int rows, int cols, float *scale);
+size_t ptts_linear_q_scratch(int in);
+void ptts_linear_bf16_forward(float *y, const float *x, const uint16_t *w, const float *b,
+                              int n, int in, int out, float *scratch);
+void ptts_linear_q8_forward(float *y, const float *x, const int8_t *w, const float *scale,
+                            const float *b, int n, int in, int out, float *scratch);
+
 void ptts_elu_inplace(float *x, int n);
 void ptts_add_inplace(float *a, const float *b, int n);
 
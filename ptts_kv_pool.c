@@ -0,0 +1,152 @@
+/*
+ * ptts_kv_pool.c - Paged KV-cache pool
+ */
+
+#include "ptts_kv_pool.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define KV_POOL_WAIT_MS 5000.0
+
+struct ptts_kv_pool {
+    pthread_mutex_t lock;
+    pthread_cond_t released; /* signalled by every release */
+    unsigned long releases;
+    double wait_ms;
+    float **free_pages;
+    int num_free;
+    int cap_free;
+    ptts_kv_pool_stats stats;
+};
+
+ptts_kv_pool *ptts_kv_pool_create(int num_layers, int row_dim, size_t max_bytes) {
+    if (num_layers <= 0 || row_dim <= 0) return NULL;
+    ptts_kv_pool *pool = (ptts_kv_pool *)calloc(1, sizeof(ptts_kv_pool));
+    if (!pool) return NULL;
+    if (pthread_mutex_init(&pool->lock, NULL) != 0) {
+        free(pool);
+        return NULL;
+    }
+    if (pthread_cond_init(&pool->released, NULL) != 0) {
+        pthread_mutex_destroy(&pool->lock);
+        free(pool);
+        return NULL;
+    }
+    pool->wait_ms = KV_POOL_WAIT_MS;
+    pool->stats.page_bytes = (size_t)num_layers * 2 * PTTS_KV_PAGE_POS * row_dim * sizeof(float);
+    pool->stats.max_bytes = max_bytes;
+    return pool;
+}
+
+void ptts_kv_pool_free(ptts_kv_pool *pool) {
+    if (!pool) return;
+    /* pages still held by sessions belong to them until released */
+    for (int i = 0; i < pool->num_free; i++) free(pool->free_pages[i]);
+    free(pool->free_pages);
+    pthread_cond_destroy(&pool->released);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+/* Under lock: a page can be had without waiting. */
+static int pool_has_page(const ptts_kv_pool *pool) {
+    return pool->num_free > 0 || pool->stats.max_bytes == 0 ||
+           (size_t)(pool->stats.pages_total + 1) * pool->stats.page_bytes <=
+               pool->stats.max_bytes;
+}
+
+float *ptts_kv_pool_alloc(ptts_kv_pool *pool) {
+    if (!pool) return NULL;
+    float *page = NULL;
+    pthread_mutex_lock(&pool->lock);
+    if (pool->num_free > 0) {
+        page = pool->free_pages[--pool->num_free];
+    } else if (pool_has_page(pool)) {
+        page = (float *)malloc(pool->stats.page_bytes);
+        if (page) pool->stats.pages_total++;
+    }
+    if (page) {
+        pool->stats.pages_in_use++;
+        if (pool->stats.pages_in_use > pool->stats.pages_peak) {
+            pool->stats.pages_peak = pool->stats.pages_in_use;
+        }
+    } else {
+        pool->stats.alloc_failures++;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return page;
+}
+
+void ptts_kv_pool_release(ptts_kv_pool *pool, float *page) {
+    if (!pool || !page) return;
+    pthread_mutex_lock(&pool->lock);
+    if (pool->num_free >= pool->cap_free) {
+        int new_cap = pool->cap_free ? pool->cap_free * 2 : 64;
+        float **nf = (float **)realloc(pool->free_pages, (size_t)new_cap * sizeof(float *));
+        if (!nf) {
+            /* cannot track it; hand it back to the system instead */
+            pool->stats.pages_total--;
+            pool->stats.pages_in_use--;
+            pool->releases++;
+            pthread_cond_broadcast(&pool->released);
+            pthread_mutex_unlock(&pool->lock);
+            free(page);
+            return;
+        }
+        pool->free_pages = nf;
+        pool->cap_free = new_cap;
+    }
+    pool->free_pages[pool->num_free++] = page;
+    pool->stats.pages_in_use--;
+    pool->releases++;
+    pthread_cond_broadcast(&pool->released);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void ptts_kv_pool_set_wait_ms(ptts_kv_pool *pool, double ms) {
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->wait_ms = ms > 0.0 ? ms : 0.0;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int ptts_kv_pool_wait(ptts_kv_pool *pool, int held) {
+    if (!pool) return -1;
+    pthread_mutex_lock(&pool->lock);
+    int rc = -1;
+    if (pool_has_page(pool)) {
+        rc = 0;
+    } else if (pool->wait_ms > 0.0 && pool->stats.pages_in_use > held) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        long long ns = deadline.tv_nsec + (long long)(pool->wait_ms * 1e6);
+        deadline.tv_sec += (time_t)(ns / 1000000000LL);
+        deadline.tv_nsec = (long)(ns % 1000000000LL);
+        unsigned long seen = pool->releases;
+        pool->stats.waits++;
+        while (pool->releases == seen) {
+            if (pthread_cond_timedwait(&pool->released, &pool->lock, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+        if (pool->releases != seen) {
+            rc = 0;
+        } else {
+            pool->stats.wait_timeouts++;
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return rc;
+}
+
+void ptts_kv_pool_get_stats(ptts_kv_pool *pool, ptts_kv_pool_stats *out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    *out = pool->stats;
+    pthread_mutex_unlock(&pool->lock);
+}
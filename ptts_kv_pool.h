@@ -0,0 +1,58 @@
+#ifndef PTTS_KV_POOL_H
+#define PTTS_KV_POOL_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Shared pool of fixed-size transformer KV pages.
+ *
+ * A page holds K and V rows for PTTS_KV_PAGE_POS consecutive positions of
+ * every layer, laid out [layer][k/v][PTTS_KV_PAGE_POS][row_dim]. Sessions
+ * take pages as their sequence grows and give them back when done, so the
+ * memory held tracks actual lengths instead of worst-case estimates.
+ * Released pages are kept for reuse. All calls are thread-safe.
+ */
+
+#define PTTS_KV_PAGE_POS 16
+
+typedef struct ptts_kv_pool ptts_kv_pool;
+
+typedef struct {
+    int pages_total;    /* pages allocated from the system (in use + free) */
+    int pages_in_use;
+    int pages_peak;     /* high-water mark of pages_in_use */
+    int alloc_failures; /* requests refused because of max_bytes */
+    int waits;          /* ptts_kv_pool_wait calls that blocked */
+    int wait_timeouts;  /* ... and gave up without a release */
+    size_t page_bytes;
+    size_t max_bytes;   /* 0 = unbounded */
+} ptts_kv_pool_stats;
+
+/* max_bytes caps pages_total * page_bytes (0 = unbounded). */
+ptts_kv_pool *ptts_kv_pool_create(int num_layers, int row_dim, size_t max_bytes);
+void ptts_kv_pool_free(ptts_kv_pool *pool);
+
+/* Take a page (contents undefined). Returns NULL when the budget is spent. */
+float *ptts_kv_pool_alloc(ptts_kv_pool *pool);
+void ptts_kv_pool_release(ptts_kv_pool *pool, float *page);
+
+/* How long ptts_kv_pool_wait blocks (default 5000 ms, 0 = never). */
+void ptts_kv_pool_set_wait_ms(ptts_kv_pool *pool, double ms);
+
+/* For a caller whose alloc was refused and that holds `held` pages: blocks
+ * until another holder releases a page, up to the wait time. Returns 0 when
+ * an alloc is worth retrying, -1 when none will succeed in time (timeout, or
+ * nobody else holds pages to give back). */
+int ptts_kv_pool_wait(ptts_kv_pool *pool, int held);
+
+void ptts_kv_pool_get_stats(ptts_kv_pool *pool, ptts_kv_pool_stats *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTTS_KV_POOL_H */
@@ -0,0 +1,378 @@
+/*
+ * ptts_longform.c - Sentence-chunked parallel synthesis of long texts
+ */
+
+#include "ptts_longform.h"
+#include "ptts_internal.h"
+#include "ptts_trace.h"
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ========================================================================
+ * Sentence splitting
+ * ======================================================================== */
+
+typedef struct {
+    const char *b;
+    const char *e;
+    int words;
+} text_span;
+
+typedef struct {
+    text_span *v;
+    int n;
+    int cap;
+} span_list;
+
+static int span_push(span_list *l, const char *b, const char *e, int words) {
+    if (l->n == l->cap) {
+        int ncap = l->cap ? l->cap * 2 : 32;
+        text_span *nv = (text_span *)realloc(l->v, sizeof(text_span) * (size_t)ncap);
+        if (!nv) return -1;
+        l->v = nv;
+        l->cap = ncap;
+    }
+    l->v[l->n++] = (text_span){b, e, words};
+    return 0;
+}
+
+static int count_words(const char *b, const char *e) {
+    int words = 0;
+    int in_word = 0;
+    for (const char *p = b; p < e; p++) {
+        if (isspace((unsigned char)*p)) {
+            in_word = 0;
+        } else if (!in_word) {
+            in_word = 1;
+            words++;
+        }
+    }
+    return words;
+}
+
+/* "Dr." and initials ("J. R. R.") do not end a sentence. */
+static int is_abbreviation(const char *start, const char *dot) {
+    static const char *const abbrevs[] = {"mr", "mrs", "ms", "dr", "prof", "st", "sr", "jr",
+                                          "vs", "no", "mt", "fig", "approx"};
+    const char *w = dot;
+    while (w > start && isalpha((unsigned char)w[-1])) w--;
+    size_t len = (size_t)(dot - w);
+    if (len == 1) return 1;
+    for (size_t i = 0; i < sizeof(abbrevs) / sizeof(abbrevs[0]); i++) {
+        if (strlen(abbrevs[i]) == len && strncasecmp(w, abbrevs[i], len) == 0) return 1;
+    }
+    return 0;
+}
+
+/* Closing quotes and brackets that belong to the sentence before them. */
+static size_t closer_len(const char *p) {
+    if (*p == '"' || *p == '\'' || *p == ')' || *p == ']') return 1;
+    /* U+2019 and U+201D */
+    if ((unsigned char)p[0] == 0xE2 && (unsigned char)p[1] == 0x80 &&
+        ((unsigned char)p[2] == 0x99 || (unsigned char)p[2] == 0x9D)) {
+        return 3;
+    }
+    return 0;
+}
+
+/* Adds [b, e) trimmed, cut into pieces of at most max_words words: at the
+ * last , ; or : that keeps a third of the limit, else after max_words. */
+static int push_sentence(span_list *out, const char *b, const char *e, int max_words) {
+    while (b < e && isspace((unsigned char)*b)) b++;
+    while (e > b && isspace((unsigned char)e[-1])) e--;
+    while (b < e) {
+        int words = count_words(b, e);
+        if (words <= max_words) return span_push(out, b, e, words);
+        const char *p = b;
+        const char *clause = NULL;
+        int clause_words = 0;
+        int n = 0;
+        while (n < max_words) {
+            while (isspace((unsigned char)*p)) p++;
+            while (p < e && !isspace((unsigned char)*p)) p++;
+            n++;
+            if (n >= max_words / 3 && strchr(",;:", p[-1])) {
+                clause = p;
+                clause_words = n;
+            }
+        }
+        const char *cut = clause ? clause : p;
+        if (span_push(out, b, cut, clause ? clause_words : n) != 0) return -1;
+        b = cut;
+        while (b < e && isspace((unsigned char)*b)) b++;
+    }
+    return 0;
+}
+
+static int split_spans(const char *text, int max_words, span_list *out) {
+    const char *s = text;
+    const char *p = text;
+    while (*p) {
+        const char *end = NULL;
+        const char *next = NULL;
+        if (*p == '.' || *p == '!' || *p == '?') {
+            const char *q = p + 1;
+            while (*q == '.' || *q == '!' || *q == '?') q++;
+            for (size_t c; (c = closer_len(q)) > 0;) q += c;
+            if ((*q == '\0' || isspace((unsigned char)*q)) &&
+                !(*p == '.' && q == p + 1 && is_abbreviation(s, p))) {
+                end = next = q;
+            }
+        } else if (*p == '\n') {
+            /* a blank line ends a paragraph even without punctuation */
+            const char *q = p + 1;
+            while (*q == ' ' || *q == '\t' || *q == '\r') q++;
+            if (*q == '\n') {
+                end = p;
+                next = q + 1;
+            }
+        }
+        if (end) {
+            if (push_sentence(out, s, end, max_words) != 0) return -1;
+            s = p = next;
+            continue;
+        }
+        p++;
+    }
+    return push_sentence(out, s, p, max_words);
+}
+
+int ptts_split_sentences(const char *text, int max_words, char ***out_chunks, int *out_n) {
+    if (!text || !out_chunks || !out_n) return -1;
+    *out_chunks = NULL;
+    *out_n = 0;
+    if (max_words < 1) max_words = 1;
+
+    span_list spans = {NULL, 0, 0};
+    if (split_spans(text, max_words, &spans) != 0) {
+        free(spans.v);
+        ptts_set_error("Out of memory");
+        return -1;
+    }
+
+    /* Greedily merge sentences up to max_words per chunk. */
+    char **chunks = (char **)calloc((size_t)(spans.n > 0 ? spans.n : 1), sizeof(char *));
+    int n = 0;
+    for (int i = 0; chunks && i < spans.n;) {
+        int j = i + 1;
+        int words = spans.v[i].words;
+        size_t bytes = (size_t)(spans.v[i].e - spans.v[i].b) + 1;
+        while (j < spans.n && words + spans.v[j].words <= max_words) {
+            words += spans.v[j].words;
+            bytes += (size_t)(spans.v[j].e - spans.v[j].b) + 1;
+            j++;
+        }
+        char *c = (char *)malloc(bytes);
+        if (!c) {
+            ptts_chunks_free(chunks, n);
+            chunks = NULL;
+            break;
+        }
+        size_t off = 0;
+        for (int k = i; k < j; k++) {
+            if (k > i) c[off++] = ' ';
+            size_t len = (size_t)(spans.v[k].e - spans.v[k].b);
+            memcpy(c + off, spans.v[k].b, len);
+            off += len;
+        }
+        c[off] = '\0';
+        chunks[n++] = c;
+        i = j;
+    }
+    free(spans.v);
+    if (!chunks) {
+        ptts_set_error("Out of memory");
+        return -1;
+    }
+    *out_chunks = chunks;
+    *out_n = n;
+    return 0;
+}
+
+void ptts_chunks_free(char **chunks, int n) {
+    if (!chunks) return;
+    for (int i = 0; i < n; i++) free(chunks[i]);
+    free(chunks);
+}
+
+/* ========================================================================
+ * Parallel synthesis
+ * ======================================================================== */
+
+typedef struct {
+    ptts_ctx *ctx;
+    char **chunks;
+    int n;
+    const char *voice;
+    ptts_params params;
+    ptts_audio **audio;
+    double *ms;
+    int next;   /* claimed with __atomic_fetch_add */
+    int failed; /* set once; later chunks are skipped */
+    int threads_started; /* names the trace tracks */
+    pthread_mutex_t lock;
+    char error[256];
+} longform_state;
+
+/* Chunk 0 keeps the master seed; the rest get splitmix64 of (master, i). */
+static int64_t chunk_seed(int64_t master, int i) {
+    if (i == 0) return master;
+    uint64_t z = (uint64_t)master + 0x9E3779B97F4A7C15ull * (uint64_t)i;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return (int64_t)(z & 0x7FFFFFFFFFFFFFFFull);
+}
+
+static void *longform_worker(void *arg) {
+    longform_state *st = (longform_state *)arg;
+    for (;;) {
+        int i = __atomic_fetch_add(&st->next, 1, __ATOMIC_RELAXED);
+        if (i >= st->n || __atomic_load_n(&st->failed, __ATOMIC_RELAXED)) return NULL;
+        ptts_params p = st->params;
+        p.seed = chunk_seed(st->params.seed, i);
+        double t0 = ptts_time_ms();
+        PTTS_TRACE_BEGIN(t_trace);
+        st->audio[i] = ptts_generate(st->ctx, st->chunks[i], st->voice, &p);
+        PTTS_TRACE_END(t_trace, "longform.chunk", i);
+        st->ms[i] = ptts_time_ms() - t0;
+        if (!st->audio[i]) {
+            pthread_mutex_lock(&st->lock);
+            if (!st->failed) {
+                snprintf(st->error, sizeof(st->error), "Chunk %d: %s", i + 1, ptts_get_error());
+                __atomic_store_n(&st->failed, 1, __ATOMIC_RELAXED);
+            }
+            pthread_mutex_unlock(&st->lock);
+        }
+    }
+}
+
+static void *longform_thread(void *arg) {
+    longform_state *st = (longform_state *)arg;
+    ptts_trace_thread_name("longform worker %d",
+                           __atomic_add_fetch(&st->threads_started, 1, __ATOMIC_RELAXED));
+    return longform_worker(arg);
+}
+
+/* Concatenates in order with silence_ms of silence, then blends crossfade_ms
+ * of the next chunk's start over the end of what precedes it. */
+static ptts_audio *stitch(ptts_audio **parts, int n, int silence_ms, int crossfade_ms) {
+    int sr = parts[0]->sample_rate;
+    size_t gap = (size_t)(silence_ms > 0 ? silence_ms : 0) * (size_t)sr / 1000;
+    size_t xf = (size_t)(crossfade_ms > 0 ? crossfade_ms : 0) * (size_t)sr / 1000;
+    size_t max_total = 0;
+    for (int i = 0; i < n; i++) max_total += (size_t)parts[i]->num_samples + (i > 0 ? gap : 0);
+    ptts_audio *out = ptts_audio_create(sr, 1, (int)max_total);
+    if (!out) return NULL;
+
+    size_t pos = 0;
+    for (int i = 0; i < n; i++) {
+        const float *src = parts[i]->samples;
+        size_t len = (size_t)parts[i]->num_samples;
+        if (i > 0) pos += gap; /* calloc'd: already silent */
+        size_t ov = xf;
+        if (ov > pos) ov = pos;
+        if (ov > len) ov = len;
+        size_t start = pos - ov;
+        for (size_t k = 0; k < ov; k++) {
+            float w = (float)(k + 1) / (float)(ov + 1);
+            out->samples[start + k] = out->samples[start + k] * (1.0f - w) + src[k] * w;
+        }
+        memcpy(out->samples + pos, src + ov, (len - ov) * sizeof(float));
+        pos = start + len;
+    }
+    out->num_samples = (int)pos;
+    return out;
+}
+
+ptts_audio *ptts_generate_long(ptts_ctx *ctx, const char *text, const char *voice_path,
+                               const ptts_params *params, const ptts_longform_opts *opts) {
+    if (!ctx || !text) {
+        ptts_set_error("Text required");
+        return NULL;
+    }
+    ptts_longform_opts o = PTTS_LONGFORM_OPTS_DEFAULT;
+    if (opts) o = *opts;
+    if (o.max_words < 1) o.max_words = 40;
+
+    longform_state st;
+    memset(&st, 0, sizeof(st));
+    ptts_params defaults = PTTS_PARAMS_DEFAULT;
+    st.params = params ? *params : defaults;
+    if (st.params.seed == -1) st.params.seed = (int64_t)time(NULL);
+    st.ctx = ctx;
+    st.voice = voice_path;
+    if (ptts_split_sentences(text, o.max_words, &st.chunks, &st.n) != 0) return NULL;
+    if (st.n == 0) {
+        ptts_chunks_free(st.chunks, st.n);
+        ptts_set_error("Text prompt cannot be empty");
+        return NULL;
+    }
+
+    int workers = o.workers;
+    if (workers <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = cpus > 1 ? (int)(cpus / 2) : 1;
+    }
+    if (workers > st.n) workers = st.n;
+    /* the resident CUDA KV cache holds one session */
+    if (workers > 1 && ptts_session_limit(ctx) == 1) workers = 1;
+
+    st.audio = (ptts_audio **)calloc((size_t)st.n, sizeof(ptts_audio *));
+    st.ms = (double *)calloc((size_t)st.n, sizeof(double));
+    pthread_t *threads = (pthread_t *)calloc((size_t)workers, sizeof(pthread_t));
+    ptts_audio *out = NULL;
+    if (!st.audio || !st.ms || !threads) {
+        ptts_set_error("Out of memory");
+        goto done;
+    }
+    if (ptts_preload(ctx, 0) != 0) goto done;
+    pthread_mutex_init(&st.lock, NULL);
+
+    double t0 = ptts_time_ms();
+    int started = 0;
+    for (; started < workers; started++) {
+        if (pthread_create(&threads[started], NULL, longform_thread, &st) != 0) break;
+    }
+    if (started == 0) longform_worker(&st);
+    for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    double wall_ms = ptts_time_ms() - t0;
+    pthread_mutex_destroy(&st.lock);
+
+    if (st.failed) {
+        ptts_set_error(st.error);
+        goto done;
+    }
+    out = stitch(st.audio, st.n, o.silence_ms, o.crossfade_ms);
+    if (!out) {
+        ptts_set_error("Out of memory");
+        goto done;
+    }
+    if (ptts_timing_enabled()) {
+        double busy_ms = 0.0;
+        for (int i = 0; i < st.n; i++) {
+            fprintf(stderr, "[ptts] Long-form chunk %d/%d: %.2f s audio in %.2f ms\n", i + 1,
+                    st.n, (double)st.audio[i]->num_samples / st.audio[i]->sample_rate, st.ms[i]);
+            busy_ms += st.ms[i];
+        }
+        fprintf(stderr, "[ptts] Long-form: %d chunks on %d workers, %.2f s audio in %.2f ms "
+                "wall (%.2fx over serial chunks), seed %lld\n", st.n, workers,
+                (double)out->num_samples / out->sample_rate, wall_ms,
+                wall_ms > 0.0 ? busy_ms / wall_ms : 0.0, (long long)st.params.seed);
+    }
+
+done:
+    if (st.audio) {
+        for (int i = 0; i < st.n; i++) ptts_audio_free(st.audio[i]);
+    }
+    free(st.audio);
+    free(st.ms);
+    free(threads);
+    ptts_chunks_free(st.chunks, st.n);
+    return out;
+}
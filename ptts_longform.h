@@ -0,0 +1,41 @@
+#ifndef PTTS_LONGFORM_H
+#define PTTS_LONGFORM_H
+
+#include "ptts.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Long-form synthesis: the text is split at sentence boundaries into chunks
+ * of at most max_words words, the chunks are synthesized concurrently on
+ * one preloaded model, and the audio is joined in order. FlowLM sequence
+ * length and KV cache stay bounded by the chunk instead of the document.
+ *
+ * Chunk 0 uses params->seed (a random one when -1); chunk i > 0 uses a seed
+ * mixed from that master seed and i, so a document is reproducible and a
+ * one-chunk text matches ptts_generate.
+ */
+typedef struct {
+    int max_words;    /* words per chunk; longer sentences split at , ; : */
+    int workers;      /* chunks in flight (<= 0: half the online CPUs) */
+    int silence_ms;   /* silence between chunks */
+    int crossfade_ms; /* linear crossfade from one chunk into the next */
+} ptts_longform_opts;
+
+#define PTTS_LONGFORM_OPTS_DEFAULT { 40, 0, 120, 0 }
+
+ptts_audio *ptts_generate_long(ptts_ctx *ctx, const char *text, const char *voice_path,
+                               const ptts_params *params, const ptts_longform_opts *opts);
+
+/* The chunks ptts_generate_long would synthesize. Returns 0 and fills
+ * *out_chunks (free with ptts_chunks_free) and *out_n. */
+int ptts_split_sentences(const char *text, int max_words, char ***out_chunks, int *out_n);
+void ptts_chunks_free(char **chunks, int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTTS_LONGFORM_H */
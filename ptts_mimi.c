@@ -1,13 +1,21 @@
+#define _GNU_SOURCE
 #include "ptts_mimi.h"
 #include "ptts_internal.h"
 #include "ptts_kernels.h"
+#include "ptts_trace.h"
 #ifdef PTTS_USE_CUDA
 #include "ptts_cuda.h"
 #endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include <math.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #define MIMI_D_MODEL 512
 #define MIMI_NUM_HEADS 8
@@ -16,6 +24,14 @@
 #define MIMI_HIDDEN 2048
 #define MIMI_CONTEXT 250
 
+/* Reduced-precision copy of a transformer weight, built by
+ * ptts_mimi_set_precision. */
+typedef struct {
+    uint16_t *bf16;
+    int8_t *q8;
+    float *scale; /* per output row, INT8 only */
+} mimi_qweight;
+
 typedef struct {
     float *in_proj_w;
     float *out_proj_w;
@@ -27,11 +43,17 @@ typedef struct {
     float *linear2_w;
     float *ls1; /* layer scale 1 */
     float *ls2; /* layer scale 2 */
+    mimi_qweight in_proj_q;
+    mimi_qweight out_proj_q;
+    mimi_qweight linear1_q;
+    mimi_qweight linear2_q;
 } ptts_mimi_layer;
 
 typedef struct {
     float *w;
     float *b;
+    float *wt; /* channels-last packing (NULL until needed) */
+    const char *wname; /* weight tensor name, owned by ctx->weights */
     int out_ch;
     int in_ch;
     int k;
@@ -42,6 +64,8 @@ typedef struct {
 typedef struct {
     float *w;
     float *b;
+    float *wt;
+    const char *wname;
     int in_ch;
     int out_ch;
     int k;
@@ -56,8 +80,12 @@ typedef struct {
     int compress;
 } ptts_resblock;
 
+typedef struct mimi_workspace mimi_workspace;
+static void mimi_ws_drain(ptts_mimi *mm);
+
 struct ptts_mimi {
     ptts_ctx *ctx;
+    safetensors_arena arena; /* converted weights (load_f32) */
     float *quant_w; /* [512, 32, 1] */
     ptts_convtr1d upsample;
     ptts_conv1d dec_in;
@@ -65,15 +93,13 @@ struct ptts_mimi {
     ptts_resblock res[3];
     ptts_conv1d dec_out;
     ptts_mimi_layer layers[MIMI_NUM_LAYERS];
+    ptts_mimi_layout layout;
+    ptts_mimi_precision precision;
+    pthread_mutex_t ws_lock;
+    mimi_workspace *ws_free; /* idle conv-stack workspaces, see mimi_ws_acquire */
+    int active_decodes;      /* chunked ptts_mimi_decode calls in flight */
 };
 
-static int ends_with(const char *s, const char *suffix) {
-    size_t slen = strlen(s);
-    size_t tlen = strlen(suffix);
-    if (slen < tlen) return 0;
-    return strcmp(s + slen - tlen, suffix) == 0;
-}
-
 static const safetensor_t *find_tensor_mimi(const ptts_ctx *ctx, const char *name) {
     const safetensor_t *t = safetensors_find(ctx->weights, name);
     if (t) return t;
@@ -87,30 +113,46 @@ static const safetensor_t *find_tensor_mimi(const ptts_ctx *ctx, const char *nam
     t = safetensors_find(ctx->weights, buf);
     if (t) return t;
 
-    for (int i = 0; i < ctx->weights->num_tensors; i++) {
-        const safetensor_t *cand = &ctx->weights->tensors[i];
-        if (ends_with(cand->name, name)) return cand;
-    }
-    return NULL;
+    return safetensors_find_suffix(ctx->weights, name, NULL);
 }
 
-static float *load_f32(const ptts_ctx *ctx, const char *name) {
+/* Borrows F32 tensors from the mapping; anything else gets a buffer that
+ * safetensors_loader_run fills. */
+static float *load_f32(const ptts_ctx *ctx, safetensors_loader *ld, const char *name) {
     const safetensor_t *t = find_tensor_mimi(ctx, name);
     if (!t) {
         fprintf(stderr, "Missing tensor: %s\n", name);
         return NULL;
     }
-    return safetensors_get_f32(ctx->weights, t);
+    return safetensors_loader_f32(ld, t);
 }
 
-static float *load_f32_optional(const ptts_ctx *ctx, const char *name) {
+/* Conv weight by name. A packed model also stores the channels-last copy
+ * as "<weight>.tc", which then needs no repacking in set_layout. */
+static float *load_conv_weight(const ptts_ctx *ctx, safetensors_loader *ld, const char *name,
+                               const char **wname, float **wt) {
     const safetensor_t *t = find_tensor_mimi(ctx, name);
-    if (!t) return NULL;
-    return safetensors_get_f32(ctx->weights, t);
+    if (!t) {
+        fprintf(stderr, "Missing tensor: %s\n", name);
+        return NULL;
+    }
+    *wname = t->name;
+    char buf[512];
+    snprintf(buf, sizeof(buf), "%s.tc", t->name);
+    const safetensor_t *tc = safetensors_find(ctx->weights, buf);
+    if (tc && safetensor_numel(tc) == safetensor_numel(t)) {
+        *wt = (float *)safetensors_get_f32_direct(ctx->weights, tc);
+    }
+    return safetensors_loader_f32(ld, t);
 }
 
-static void free_ptr(float **p) {
-    if (*p) free(*p);
+/* load_f32 weights live in the file mapping or the arena; only the
+ * set_layout packs are heap buffers. */
+static void free_weight(const ptts_mimi *mm, float **p) {
+    if (*p && !safetensors_contains(mm->ctx->weights, *p) &&
+        !safetensors_arena_contains(&mm->arena, *p)) {
+        free(*p);
+    }
     *p = NULL;
 }
 
@@ -176,11 +218,63 @@ static void resblock_forward(const ptts_resblock *rb, float *x, int T) {
     free(tmp); free(tmp2);
 }
 
+static void conv1d_forward_tc(const ptts_conv1d *c, const float *x, int T, float *y,
+                              int flags, float *scratch) {
+    ptts_conv1d_tc_forward(y, x, c->wt, c->b, c->in_ch, c->out_ch, T, c->k, c->groups, flags,
+                           scratch);
+}
+
+static void convtr1d_forward_tc(const ptts_convtr1d *c, const float *x, int T, float *y,
+                                int flags, float *scratch) {
+    ptts_convtr1d_tc_forward(y, x, c->wt, c->b, c->in_ch, c->out_ch, T, c->k, c->stride,
+                             c->groups, flags, scratch);
+}
+
+static size_t conv1d_tc_scratch(const ptts_conv1d *c) {
+    return ptts_conv1d_tc_scratch(c->in_ch, c->k, c->groups);
+}
+
+static size_t convtr1d_tc_scratch(const ptts_convtr1d *c) {
+    return ptts_convtr1d_tc_scratch(c->in_ch, c->k, c->stride, c->groups);
+}
+
+/* Input staging for any channels-last conv of the decoder, for the current
+ * kernel thread count. */
+static size_t mimi_tc_scratch_floats(const ptts_mimi *mm) {
+    size_t per = convtr1d_tc_scratch(&mm->upsample);
+    size_t s = conv1d_tc_scratch(&mm->dec_in);
+    if (s > per) per = s;
+    for (int i = 0; i < 3; i++) {
+        s = convtr1d_tc_scratch(&mm->up[i]);
+        if (s > per) per = s;
+        s = conv1d_tc_scratch(&mm->res[i].conv1);
+        if (s > per) per = s;
+        s = conv1d_tc_scratch(&mm->res[i].conv2);
+        if (s > per) per = s;
+    }
+    s = conv1d_tc_scratch(&mm->dec_out);
+    if (s > per) per = s;
+    return per * (size_t)ptts_kernel_threads();
+}
+
 static void linear_forward(const float *w, const float *b, int out, int in,
                            const float *x, int n, float *y) {
     ptts_linear_forward(y, x, w, b, n, in, out);
 }
 
+/* Transformer projection at the decoder's weight precision; qscratch is
+ * the dequantization staging (layer_qscratch_floats), NULL at f32. */
+static void layer_linear(const ptts_mimi *mm, const float *w, const mimi_qweight *q,
+                         int out, int in, const float *x, int n, float *y, float *qscratch) {
+    if (mm->precision == PTTS_MIMI_PRECISION_BF16 && q->bf16) {
+        ptts_linear_bf16_forward(y, x, q->bf16, NULL, n, in, out, qscratch);
+    } else if (mm->precision == PTTS_MIMI_PRECISION_INT8 && q->q8) {
+        ptts_linear_q8_forward(y, x, q->q8, q->scale, NULL, n, in, out, qscratch);
+    } else {
+        linear_forward(w, NULL, out, in, x, n, y);
+    }
+}
+
 static void layernorm_forward(const float *x, int n, int d,
                               const float *w, const float *b, float eps, float *y) {
     for (int t = 0; t < n; t++) {
@@ -214,19 +308,6 @@ static void gelu_inplace(float *x, int n) {
     for (int i = 0; i < n; i++) x[i] = gelu(x[i]);
 }
 
-static void softmax_inplace(float *x, int n) {
-    float maxv = x[0];
-    for (int i = 1; i < n; i++) if (x[i] > maxv) maxv = x[i];
-    float sum = 0.0f;
-    for (int i = 0; i < n; i++) {
-        x[i] = expf(x[i] - maxv);
-        sum += x[i];
-    }
-    if (sum == 0.0f) return;
-    float inv = 1.0f / sum;
-    for (int i = 0; i < n; i++) x[i] *= inv;
-}
-
 static void rope_apply(float *q, float *k, int T, int H, int D, float max_period, int offset) {
     int half = D / 2;
     float *freqs = (float *)malloc((size_t)half * sizeof(float));
@@ -261,58 +342,141 @@ static void rope_apply(float *q, float *k, int T, int H, int D, float max_period
     free(freqs);
 }
 
+#define MIMI_ATTN_QBLOCK 16
+
+/* Scratch floats per thread needed by attention_forward_context. */
+static int attn_scores_len(int T, int n_past, int context) {
+    return context > 0 ? context : n_past + T;
+}
+
+static int attn_num_threads(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+/* Causal attention over the last `context` keys (all keys if context <= 0).
+ * k/v hold n_past rows of earlier positions followed by the T query rows.
+ * Work is split across heads and blocks of MIMI_ATTN_QBLOCK queries;
+ * scores provides attn_scores_len() floats per thread. */
 static void attention_forward_context(const float *q, const float *k, const float *v,
-                                      int T, int H, int D, int context, float *out) {
+                                      int T, int n_past, int H, int D, int context,
+                                      float *scores, float *out) {
     float scale = 1.0f / sqrtf((float)D);
-    float *scores = (float *)malloc((size_t)T * sizeof(float));
-    if (!scores) return;
+    int n_blocks = (T + MIMI_ATTN_QBLOCK - 1) / MIMI_ATTN_QBLOCK;
+#ifdef _OPENMP
+    int stride = attn_scores_len(T, n_past, context);
+#endif
 
+    #pragma omp parallel for collapse(2) schedule(static)
     for (int h = 0; h < H; h++) {
-        for (int tq = 0; tq < T; tq++) {
-            int n_keys = tq + 1;
-            const float *qvec = q + (tq * H + h) * D;
-            for (int tk = 0; tk < n_keys; tk++) {
-                if (context > 0 && (tq - tk) >= context) {
-                    scores[tk] = -1e30f;
-                    continue;
+        for (int blk = 0; blk < n_blocks; blk++) {
+#ifdef _OPENMP
+            float *sc = scores + (size_t)omp_get_thread_num() * stride;
+#else
+            float *sc = scores;
+#endif
+            int tq_end = (blk + 1) * MIMI_ATTN_QBLOCK < T ? (blk + 1) * MIMI_ATTN_QBLOCK : T;
+            for (int tq = blk * MIMI_ATTN_QBLOCK; tq < tq_end; tq++) {
+                int qi = n_past + tq;
+                int k0 = (context > 0 && qi - context + 1 > 0) ? qi - context + 1 : 0;
+                int n_keys = qi - k0 + 1;
+                const float *qvec = q + ((size_t)tq * H + h) * D;
+                const float *kbase = k + ((size_t)k0 * H + h) * D;
+                const float *vbase = v + ((size_t)k0 * H + h) * D;
+                size_t row = (size_t)H * D;
+
+                float maxv = -INFINITY;
+                for (int j = 0; j < n_keys; j++) {
+                    const float *kvec = kbase + (size_t)j * row;
+                    float dot = 0.0f;
+                    for (int d = 0; d < D; d++) dot += qvec[d] * kvec[d];
+                    dot *= scale;
+                    sc[j] = dot;
+                    if (dot > maxv) maxv = dot;
+                }
+                float sum = 0.0f;
+                for (int j = 0; j < n_keys; j++) {
+                    sc[j] = expf(sc[j] - maxv);
+                    sum += sc[j];
+                }
+                float inv = 1.0f / sum;
+
+                float *outvec = out + ((size_t)tq * H + h) * D;
+                for (int d = 0; d < D; d++) outvec[d] = 0.0f;
+                for (int j = 0; j < n_keys; j++) {
+                    const float *vvec = vbase + (size_t)j * row;
+                    float w = sc[j] * inv;
+                    for (int d = 0; d < D; d++) outvec[d] += w * vvec[d];
                 }
-                const float *kvec = k + (tk * H + h) * D;
-                float dot = 0.0f;
-                for (int d = 0; d < D; d++) dot += qvec[d] * kvec[d];
-                scores[tk] = dot * scale;
-            }
-            softmax_inplace(scores, n_keys);
-            float *outvec = out + (tq * H + h) * D;
-            for (int d = 0; d < D; d++) outvec[d] = 0.0f;
-            for (int tk = 0; tk < n_keys; tk++) {
-                const float *vvec = v + (tk * H + h) * D;
-                float w = scores[tk];
-                for (int d = 0; d < D; d++) outvec[d] += w * vvec[d];
             }
         }
     }
-    free(scores);
 }
 
-static int transformer_forward(const ptts_mimi *mm, float *x, int T) {
+/* Attention history carried between streaming chunks: the last
+ * MIMI_CONTEXT - 1 post-RoPE K/V rows of each layer. */
+typedef struct {
+    int pos;     /* absolute position of the next input */
+    int n_past;  /* rows held, <= MIMI_CONTEXT - 1 */
+    float *k[MIMI_NUM_LAYERS];
+    float *v[MIMI_NUM_LAYERS];
+} mimi_attn_state;
+
+/* One sequence of a (possibly batched) transformer call. */
+typedef struct {
+    int T;                /* new rows */
+    int pos;              /* absolute position of the first row (kv->pos if kv) */
+    mimi_attn_state *kv;  /* streaming history, NULL for a self-contained sequence */
+} mimi_seq;
+
+/* Run the decoder transformer over nseq sequences stacked row-wise in x.
+ * Norms, projections and the MLP see all rows at once (one GEMM per weight
+ * per layer); RoPE, the attention window and the KV history stay per
+ * sequence. Rows are computed independently, so each sequence's output is
+ * identical to running it alone. */
+static int transformer_forward_seqs(const ptts_mimi *mm, float *x, int nseq, const mimi_seq *seqs) {
     int d = MIMI_D_MODEL;
     int h = MIMI_NUM_HEADS;
     int hd = MIMI_HEAD_DIM;
+    int T = 0;
+    int kv_rows = 0;
+    int max_scores = 0;
+    int any_kv = 0;
+    for (int i = 0; i < nseq; i++) {
+        int n_past = seqs[i].kv ? seqs[i].kv->n_past : 0;
+        int len = attn_scores_len(seqs[i].T, n_past, MIMI_CONTEXT);
+        T += seqs[i].T;
+        kv_rows += n_past + seqs[i].T;
+        if (len > max_scores) max_scores = len;
+        if (seqs[i].kv) any_kv = 1;
+    }
     double t_start = 0.0;
     if (ptts_timing_enabled()) t_start = ptts_time_ms();
 
     float *x_norm = (float *)malloc((size_t)T * d * sizeof(float));
     float *qkv = (float *)malloc((size_t)T * d * 3 * sizeof(float));
     float *q = (float *)malloc((size_t)T * h * hd * sizeof(float));
-    float *k = (float *)malloc((size_t)T * h * hd * sizeof(float));
-    float *v = (float *)malloc((size_t)T * h * hd * sizeof(float));
+    float *k = (float *)malloc((size_t)kv_rows * h * hd * sizeof(float));
+    float *v = (float *)malloc((size_t)kv_rows * h * hd * sizeof(float));
     float *attn = (float *)malloc((size_t)T * h * hd * sizeof(float));
+    float *scores = (float *)malloc((size_t)attn_num_threads() * max_scores * sizeof(float));
     float *attn_out = (float *)malloc((size_t)T * d * sizeof(float));
     float *ff1 = (float *)malloc((size_t)T * MIMI_HIDDEN * sizeof(float));
     float *ff2 = (float *)malloc((size_t)T * d * sizeof(float));
+    /* dequantization staging, sized for the widest input (linear2) */
+    float *qscratch = NULL;
+    if (mm->precision != PTTS_MIMI_PRECISION_F32) {
+        qscratch = (float *)malloc((size_t)ptts_kernel_threads() *
+                                   ptts_linear_q_scratch(MIMI_HIDDEN) * sizeof(float));
+    }
 
-    if (!x_norm || !qkv || !q || !k || !v || !attn || !attn_out || !ff1 || !ff2) {
-        free(x_norm); free(qkv); free(q); free(k); free(v); free(attn); free(attn_out); free(ff1); free(ff2);
+    if (!x_norm || !qkv || !q || !k || !v || !attn || !scores || !attn_out || !ff1 || !ff2 ||
+        (mm->precision != PTTS_MIMI_PRECISION_F32 && !qscratch)) {
+        free(x_norm); free(qkv); free(q); free(k); free(v); free(attn); free(scores);
+        free(attn_out); free(ff1); free(ff2); free(qscratch);
         return -1;
     }
 
@@ -320,31 +484,56 @@ static int transformer_forward(const ptts_mimi *mm, float *x, int T) {
         const ptts_mimi_layer *layer = &mm->layers[l];
 
         layernorm_forward(x, T, d, layer->norm1_w, layer->norm1_b, 1e-5f, x_norm);
-        linear_forward(layer->in_proj_w, NULL, 3 * d, d, x_norm, T, qkv);
+        layer_linear(mm, layer->in_proj_w, &layer->in_proj_q, 3 * d, d, x_norm, T, qkv,
+                     qscratch);
+
+        int row = 0;      /* first row of this sequence in x/q/attn */
+        int kv_base = 0;  /* first row of this sequence in k/v */
+        for (int i = 0; i < nseq; i++) {
+            mimi_attn_state *kv = seqs[i].kv;
+            int Ti = seqs[i].T;
+            int n_past = kv ? kv->n_past : 0;
+            int offset = kv ? kv->pos : seqs[i].pos;
+            float *qs = q + (size_t)row * d;
+            float *ks = k + (size_t)kv_base * d;
+            float *vs = v + (size_t)kv_base * d;
+            float *k_new = ks + (size_t)n_past * d;
+            float *v_new = vs + (size_t)n_past * d;
+            for (int t = 0; t < Ti; t++) {
+                const float *r = qkv + (size_t)(row + t) * 3 * d;
+                for (int hh = 0; hh < h; hh++) {
+                    memcpy(qs + (t * h + hh) * hd, r + (0 * d + hh * hd), (size_t)hd * sizeof(float));
+                    memcpy(k_new + (t * h + hh) * hd, r + (1 * d + hh * hd), (size_t)hd * sizeof(float));
+                    memcpy(v_new + (t * h + hh) * hd, r + (2 * d + hh * hd), (size_t)hd * sizeof(float));
+                }
+            }
 
-        for (int t = 0; t < T; t++) {
-            const float *row = qkv + t * 3 * d;
-            for (int hh = 0; hh < h; hh++) {
-                float *qv = q + (t * h + hh) * hd;
-                float *kv = k + (t * h + hh) * hd;
-                float *vv = v + (t * h + hh) * hd;
-                memcpy(qv, row + (0 * d + hh * hd), (size_t)hd * sizeof(float));
-                memcpy(kv, row + (1 * d + hh * hd), (size_t)hd * sizeof(float));
-                memcpy(vv, row + (2 * d + hh * hd), (size_t)hd * sizeof(float));
+            rope_apply(qs, k_new, Ti, h, hd, 10000.0f, offset);
+            if (kv && n_past > 0) {
+                memcpy(ks, kv->k[l], (size_t)n_past * d * sizeof(float));
+                memcpy(vs, kv->v[l], (size_t)n_past * d * sizeof(float));
+            }
+            attention_forward_context(qs, ks, vs, Ti, n_past, h, hd, MIMI_CONTEXT, scores,
+                                      attn + (size_t)row * d);
+            if (kv) {
+                int total = n_past + Ti;
+                int keep = total < MIMI_CONTEXT - 1 ? total : MIMI_CONTEXT - 1;
+                memcpy(kv->k[l], ks + (size_t)(total - keep) * d, (size_t)keep * d * sizeof(float));
+                memcpy(kv->v[l], vs + (size_t)(total - keep) * d, (size_t)keep * d * sizeof(float));
             }
+            row += Ti;
+            kv_base += n_past + Ti;
         }
 
-        rope_apply(q, k, T, h, hd, 10000.0f, 0);
-        attention_forward_context(q, k, v, T, h, hd, MIMI_CONTEXT, attn);
-
         for (int t = 0; t < T; t++) {
-            float *row = attn_out + t * d;
+            float *r = attn_out + t * d;
             for (int hh = 0; hh < h; hh++) {
-                memcpy(row + hh * hd, attn + (t * h + hh) * hd, (size_t)hd * sizeof(float));
+                memcpy(r + hh * hd, attn + (t * h + hh) * hd, (size_t)hd * sizeof(float));
             }
         }
 
-        linear_forward(layer->out_proj_w, NULL, d, d, attn_out, T, x_norm);
+        layer_linear(mm, layer->out_proj_w, &layer->out_proj_q, d, d, attn_out, T, x_norm,
+                     qscratch);
         for (int i = 0; i < T * d; i++) {
             float add = x_norm[i];
             if (layer->ls1) add *= layer->ls1[i % d];
@@ -352,9 +541,11 @@ static int transformer_forward(const ptts_mimi *mm, float *x, int T) {
         }
 
         layernorm_forward(x, T, d, layer->norm2_w, layer->norm2_b, 1e-5f, x_norm);
-        linear_forward(layer->linear1_w, NULL, MIMI_HIDDEN, d, x_norm, T, ff1);
+        layer_linear(mm, layer->linear1_w, &layer->linear1_q, MIMI_HIDDEN, d, x_norm, T, ff1,
+                     qscratch);
         gelu_inplace(ff1, T * MIMI_HIDDEN);
-        linear_forward(layer->linear2_w, NULL, d, MIMI_HIDDEN, ff1, T, ff2);
+        layer_linear(mm, layer->linear2_w, &layer->linear2_q, d, MIMI_HIDDEN, ff1, T, ff2,
+                     qscratch);
         for (int i = 0; i < T * d; i++) {
             float add = ff2[i];
             if (layer->ls2) add *= layer->ls2[i % d];
@@ -362,26 +553,81 @@ static int transformer_forward(const ptts_mimi *mm, float *x, int T) {
         }
     }
 
-    if (ptts_timing_enabled()) {
+    for (int i = 0; i < nseq; i++) {
+        mimi_attn_state *kv = seqs[i].kv;
+        if (!kv) continue;
+        int total = kv->n_past + seqs[i].T;
+        kv->n_past = total < MIMI_CONTEXT - 1 ? total : MIMI_CONTEXT - 1;
+        kv->pos += seqs[i].T;
+    }
+
+    if (ptts_timing_enabled() && !any_kv) {
         double t_end = ptts_time_ms();
-        fprintf(stderr, "[ptts] Mimi transformer: %.2f ms (T=%d)\n", t_end - t_start, T);
+        if (nseq == 1) {
+            fprintf(stderr, "[ptts] Mimi transformer: %.2f ms (T=%d)\n", t_end - t_start, T);
+        } else {
+            fprintf(stderr, "[ptts] Mimi transformer: %.2f ms (T=%d over %d sequences)\n",
+                    t_end - t_start, T, nseq);
+        }
     }
 
-    free(x_norm); free(qkv); free(q); free(k); free(v); free(attn); free(attn_out); free(ff1); free(ff2);
+    free(x_norm); free(qkv); free(q); free(k); free(v); free(attn); free(scores);
+    free(attn_out); free(ff1); free(ff2); free(qscratch);
     return 0;
 }
 
+/* kv (NULL for a self-contained sequence starting at absolute position pos)
+ * supplies and receives the attention history of a streaming decode. */
+static int transformer_forward_kv(const ptts_mimi *mm, float *x, int T, int pos,
+                                  mimi_attn_state *kv) {
+    mimi_seq seq = {T, pos, kv};
+    return transformer_forward_seqs(mm, x, 1, &seq);
+}
+
+static int transformer_forward(const ptts_mimi *mm, float *x, int T) {
+    return transformer_forward_kv(mm, x, T, 0, NULL);
+}
+
+/* PTTS_MIMI_LAYOUT=chw selects the channel-major decode; the default is
+ * channels-last except where the CUDA conv stack takes the decode. */
+static ptts_mimi_layout default_layout(void) {
+    const char *v = getenv("PTTS_MIMI_LAYOUT");
+    if (v && v[0]) {
+        return strcmp(v, "chw") == 0 ? PTTS_MIMI_LAYOUT_CHANNELS_FIRST
+                                     : PTTS_MIMI_LAYOUT_CHANNELS_LAST;
+    }
+#ifdef PTTS_USE_CUDA
+    if (cuda_conv_enabled()) return PTTS_MIMI_LAYOUT_CHANNELS_FIRST;
+#endif
+    return PTTS_MIMI_LAYOUT_CHANNELS_LAST;
+}
+
+static ptts_mimi_precision default_precision(void) {
+    const char *v = getenv("PTTS_MIMI_PRECISION");
+    if (v && strcmp(v, "bf16") == 0) return PTTS_MIMI_PRECISION_BF16;
+    if (v && strcmp(v, "int8") == 0) return PTTS_MIMI_PRECISION_INT8;
+    return PTTS_MIMI_PRECISION_F32;
+}
+
 ptts_mimi *ptts_mimi_load(ptts_ctx *ctx) {
     if (!ctx || !ctx->weights) return NULL;
+    double t0 = ptts_time_ms();
     ptts_mimi *mm = (ptts_mimi *)calloc(1, sizeof(ptts_mimi));
     if (!mm) return NULL;
-    mm->ctx = ctx;
-
-    mm->quant_w = load_f32(ctx, "quantizer.output_proj.weight");
-    mm->upsample.w = load_f32_optional(ctx, "upsample.convtr.weight");
-    if (!mm->upsample.w) {
-        mm->upsample.w = load_f32(ctx, "upsample.convtr.convtr.weight");
+    safetensors_loader *ld = safetensors_loader_create(ctx->weights);
+    if (!ld) {
+        free(mm);
+        return NULL;
     }
+    mm->ctx = ctx;
+    pthread_mutex_init(&mm->ws_lock, NULL);
+
+    mm->quant_w = load_f32(ctx, ld, "quantizer.output_proj.weight");
+    mm->upsample.w = load_conv_weight(ctx, ld,
+                                      find_tensor_mimi(ctx, "upsample.convtr.weight")
+                                          ? "upsample.convtr.weight"
+                                          : "upsample.convtr.convtr.weight",
+                                      &mm->upsample.wname, &mm->upsample.wt);
     mm->upsample.b = NULL;
     mm->upsample.in_ch = 512;
     mm->upsample.out_ch = 512;
@@ -390,8 +636,9 @@ ptts_mimi *ptts_mimi_load(ptts_ctx *ctx) {
     mm->upsample.groups = 512;
 
     /* Decoder conv stack weights */
-    mm->dec_in.w = load_f32(ctx, "decoder.model.0.conv.weight");
-    mm->dec_in.b = load_f32(ctx, "decoder.model.0.conv.bias");
+    mm->dec_in.w = load_conv_weight(ctx, ld, "decoder.model.0.conv.weight",
+                                    &mm->dec_in.wname, &mm->dec_in.wt);
+    mm->dec_in.b = load_f32(ctx, ld, "decoder.model.0.conv.bias");
     mm->dec_in.in_ch = 512;
     mm->dec_in.out_ch = 512;
     mm->dec_in.k = 7;
@@ -399,8 +646,9 @@ ptts_mimi *ptts_mimi_load(ptts_ctx *ctx) {
     mm->dec_in.groups = 1;
 
     /* Stage 0: ratio 6 */
-    mm->up[0].w = load_f32(ctx, "decoder.model.2.convtr.weight");
-    mm->up[0].b = load_f32(ctx, "decoder.model.2.convtr.bias");
+    mm->up[0].w = load_conv_weight(ctx, ld, "decoder.model.2.convtr.weight",
+                                   &mm->up[0].wname, &mm->up[0].wt);
+    mm->up[0].b = load_f32(ctx, ld, "decoder.model.2.convtr.bias");
     mm->up[0].in_ch = 512;
     mm->up[0].out_ch = 256;
     mm->up[0].k = 12;
@@ -408,15 +656,17 @@ ptts_mimi *ptts_mimi_load(ptts_ctx *ctx) {
     mm->up[0].groups = 1;
     mm->res[0].dim = 256;
     mm->res[0].compress = 2;
-    mm->res[0].conv1.w = load_f32(ctx, "decoder.model.3.block.1.conv.weight");
-    mm->res[0].conv1.b = load_f32(ctx, "decoder.model.3.block.1.conv.bias");
+    mm->res[0].conv1.w = load_conv_weight(ctx, ld, "decoder.model.3.block.1.conv.weight",
+                                          &mm->res[0].conv1.wname, &mm->res[0].conv1.wt);
+    mm->res[0].conv1.b = load_f32(ctx, ld, "decoder.model.3.block.1.conv.bias");
     mm->res[0].conv1.in_ch = 256;
     mm->res[0].conv1.out_ch = 128;
     mm->res[0].conv1.k = 3;
     mm->res[0].conv1.stride = 1;
     mm->res[0].conv1.groups = 1;
-    mm->res[0].conv2.w = load_f32(ctx, "decoder.model.3.block.3.conv.weight");
-    mm->res[0].conv2.b = load_f32(ctx, "decoder.model.3.block.3.conv.bias");
+    mm->res[0].conv2.w = load_conv_weight(ctx, ld, "decoder.model.3.block.3.conv.weight",
+                                          &mm->res[0].conv2.wname, &mm->res[0].conv2.wt);
+    mm->res[0].conv2.b = load_f32(ctx, ld, "decoder.model.3.block.3.conv.bias");
     mm->res[0].conv2.in_ch = 128;
     mm->res[0].conv2.out_ch = 256;
     mm->res[0].conv2.k = 1;
@@ -424,8 +674,9 @@ ptts_mimi *ptts_mimi_load(ptts_ctx *ctx) {
     mm->res[0].conv2.groups = 1;
 
     /* Stage 1: ratio 5 */
-    mm->up[1].w = load_f32(ctx, "decoder.model.5.convtr.weight");
-    mm->up[1].b = load_f32(ctx, "decoder.model.5.convtr.bias");
+    mm->up[1].w = load_conv_weight(ctx, ld, "decoder.model.5.convtr.weight",
+                                   &mm->up[1].wname, &mm->up[1].wt);
+    mm->up[1].b = load_f32(ctx, ld, "decoder.model.5.convtr.bias");
     mm->up[1].in_ch = 256;
     mm->up[1].out_ch = 128;
     mm->up[1].k = 10;
@@ -433,15 +684,17 @@ ptts_mimi *ptts_mimi_load(ptts_ctx *ctx) {
     mm->up[1].groups = 1;
     mm->res[1].dim = 128;
     mm->res[1].compress = 2;
-    mm->res[1].conv1.w = load_f32(ctx, "decoder.model.6.block.1.conv.weight");
-    mm->res[1].conv1.b = load_f32(ctx, "decoder.model.6.block.1.conv.bias");
+    mm->res[1].conv1.w = load_conv_weight(ctx, ld, "decoder.model.6.block.1.conv.weight",
+                                          &mm->res[1].conv1.wname, &mm->res[1].conv1.wt);
+    mm->res[1].conv1.b = load_f32(ctx, ld, "decoder.model.6.block.1.conv.bias");
     mm->res[1].conv1.in_ch = 128;
     mm->res[1].conv1.out_ch = 64;
     mm->res[1].conv1.k = 3;
     mm->res[1].conv1.stride = 1;
     mm->res[1].conv1.groups = 1;
-    mm->res[1].conv2.w = load_f32(ctx, "decoder.model.6.block.3.conv.weight");
-    mm->res[1].conv2.b = load_f32(ctx, "decoder.model.6.block.3.conv.bias");
+    mm->res[1].conv2.w = load_conv_weight(ctx, ld, "decoder.model.6.block.3.conv.weight",
+                                          &mm->res[1].conv2.wname, &mm->res[1].conv2.wt);
+    mm->res[1].conv2.b = load_f32(ctx, ld, "decoder.model.6.block.3.conv.bias");
     mm->res[1].conv2.in_ch = 64;
     mm->res[1].conv2.out_ch = 128;
     mm->res[1].conv2.k = 1;
@@ -449,8 +702,9 @@ ptts_mimi *ptts_mimi_load(ptts_ctx *ctx) {
     mm->res[1].conv2.groups = 1;
 
     /* Stage 2: ratio 4 */
-    mm->up[2].w = load_f32(ctx, "decoder.model.8.convtr.weight");
-    mm->up[2].b = load_f32(ctx, "decoder.model.8.convtr.bias");
+    mm->up[2].w = load_conv_weight(ctx, ld, "decoder.model.8.convtr.weight",
+                                   &mm->up[2].wname, &mm->up[2].wt);
+    mm->up[2].b = load_f32(ctx, ld, "decoder.model.8.convtr.bias");
     mm->up[2].in_ch = 128;
     mm->up[2].out_ch = 64;
     mm->up[2].k = 8;
@@ -458,23 +712,26 @@ ptts_mimi *ptts_mimi_load(ptts_ctx *ctx) {
     mm->up[2].groups = 1;
     mm->res[2].dim = 64;
     mm->res[2].compress = 2;
-    mm->res[2].conv1.w = load_f32(ctx, "decoder.model.9.block.1.conv.weight");
-    mm->res[2].conv1.b = load_f32(ctx, "decoder.model.9.block.1.conv.bias");
+    mm->res[2].conv1.w = load_conv_weight(ctx, ld, "decoder.model.9.block.1.conv.weight",
+                                          &mm->res[2].conv1.wname, &mm->res[2].conv1.wt);
+    mm->res[2].conv1.b = load_f32(ctx, ld, "decoder.model.9.block.1.conv.bias");
     mm->res[2].conv1.in_ch = 64;
     mm->res[2].conv1.out_ch = 32;
     mm->res[2].conv1.k = 3;
     mm->res[2].conv1.stride = 1;
     mm->res[2].conv1.groups = 1;
-    mm->res[2].conv2.w = load_f32(ctx, "decoder.model.9.block.3.conv.weight");
-    mm->res[2].conv2.b = load_f32(ctx, "decoder.model.9.block.3.conv.bias");
+    mm->res[2].conv2.w = load_conv_weight(ctx, ld, "decoder.model.9.block.3.conv.weight",
+                                          &mm->res[2].conv2.wname, &mm->res[2].conv2.wt);
+    mm->res[2].conv2.b = load_f32(ctx, ld, "decoder.model.9.block.3.conv.bias");
     mm->res[2].conv2.in_ch = 32;
     mm->res[2].conv2.out_ch = 64;
     mm->res[2].conv2.k = 1;
     mm->res[2].conv2.stride = 1;
     mm->res[2].conv2.groups = 1;
 
-    mm->dec_out.w = load_f32(ctx, "decoder.model.11.conv.weight");
-    mm->dec_out.b = load_f32(ctx, "decoder.model.11.conv.bias");
+    mm->dec_out.w = load_conv_weight(ctx, ld, "decoder.model.11.conv.weight",
+                                     &mm->dec_out.wname, &mm->dec_out.wt);
+    mm->dec_out.b = load_f32(ctx, ld, "decoder.model.11.conv.bias");
     mm->dec_out.in_ch = 64;
     mm->dec_out.out_ch = 1;
     mm->dec_out.k = 3;
@@ -484,65 +741,204 @@ ptts_mimi *ptts_mimi_load(ptts_ctx *ctx) {
     for (int i = 0; i < MIMI_NUM_LAYERS; i++) {
         char name[160];
         snprintf(name, sizeof(name), "decoder_transformer.transformer.layers.%d.self_attn.in_proj.weight", i);
-        mm->layers[i].in_proj_w = load_f32(ctx, name);
+        mm->layers[i].in_proj_w = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "decoder_transformer.transformer.layers.%d.self_attn.out_proj.weight", i);
-        mm->layers[i].out_proj_w = load_f32(ctx, name);
+        mm->layers[i].out_proj_w = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "decoder_transformer.transformer.layers.%d.norm1.weight", i);
-        mm->layers[i].norm1_w = load_f32(ctx, name);
+        mm->layers[i].norm1_w = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "decoder_transformer.transformer.layers.%d.norm1.bias", i);
-        mm->layers[i].norm1_b = load_f32(ctx, name);
+        mm->layers[i].norm1_b = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "decoder_transformer.transformer.layers.%d.norm2.weight", i);
-        mm->layers[i].norm2_w = load_f32(ctx, name);
+        mm->layers[i].norm2_w = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "decoder_transformer.transformer.layers.%d.norm2.bias", i);
-        mm->layers[i].norm2_b = load_f32(ctx, name);
+        mm->layers[i].norm2_b = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "decoder_transformer.transformer.layers.%d.linear1.weight", i);
-        mm->layers[i].linear1_w = load_f32(ctx, name);
+        mm->layers[i].linear1_w = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "decoder_transformer.transformer.layers.%d.linear2.weight", i);
-        mm->layers[i].linear2_w = load_f32(ctx, name);
+        mm->layers[i].linear2_w = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "decoder_transformer.transformer.layers.%d.layer_scale_1.scale", i);
-        mm->layers[i].ls1 = load_f32(ctx, name);
+        mm->layers[i].ls1 = load_f32(ctx, ld, name);
         snprintf(name, sizeof(name), "decoder_transformer.transformer.layers.%d.layer_scale_2.scale", i);
-        mm->layers[i].ls2 = load_f32(ctx, name);
+        mm->layers[i].ls2 = load_f32(ctx, ld, name);
     }
 
-    if (!mm->quant_w || !mm->layers[0].in_proj_w || !mm->dec_out.w || !mm->upsample.w) {
+    safetensors_load_stats stats;
+    if (safetensors_loader_run(ld, &stats, &mm->arena) != 0 || !mm->quant_w || !mm->layers[0].in_proj_w ||
+        !mm->dec_out.w || !mm->upsample.w) {
+        ptts_mimi_free(mm);
+        return NULL;
+    }
+    if (ptts_mimi_set_layout(mm, default_layout()) != 0 ||
+        ptts_mimi_set_precision(mm, default_precision()) != 0) {
         ptts_mimi_free(mm);
         return NULL;
     }
+    ctx->load_times.mimi_ms = ptts_time_ms() - t0;
+    if (ptts_timing_enabled()) {
+        fprintf(stderr, "[ptts] Mimi load: %.2f ms (%d tensors; %d widened, %.1f MB, "
+                "%d threads, %.2f ms)\n", ctx->load_times.mimi_ms, stats.tensors,
+                stats.converted, stats.bytes / 1e6, stats.threads, stats.ms);
+    }
     return mm;
 }
 
+static int pack_conv1d_tc(ptts_conv1d *c) {
+    if (c->wt || !c->w) return 0;
+    c->wt = ptts_conv1d_pack_tc(c->w, c->in_ch, c->out_ch, c->k, c->groups);
+    return c->wt ? 0 : -1;
+}
+
+static int pack_convtr1d_tc(ptts_convtr1d *c) {
+    if (c->wt || !c->w) return 0;
+    c->wt = ptts_convtr1d_pack_tc(c->w, c->in_ch, c->out_ch, c->k, c->groups);
+    return c->wt ? 0 : -1;
+}
+
+int ptts_mimi_set_layout(ptts_mimi *mm, ptts_mimi_layout layout) {
+    if (!mm) return -1;
+    if (layout == PTTS_MIMI_LAYOUT_CHANNELS_LAST) {
+        int rc = pack_convtr1d_tc(&mm->upsample) | pack_conv1d_tc(&mm->dec_in) |
+                 pack_conv1d_tc(&mm->dec_out);
+        for (int i = 0; i < 3; i++) {
+            rc |= pack_convtr1d_tc(&mm->up[i]) | pack_conv1d_tc(&mm->res[i].conv1) |
+                  pack_conv1d_tc(&mm->res[i].conv2);
+        }
+        if (rc != 0) return -1;
+    }
+    mm->layout = layout;
+    return 0;
+}
+
+ptts_mimi_layout ptts_mimi_get_layout(const ptts_mimi *mm) {
+    return mm ? mm->layout : PTTS_MIMI_LAYOUT_CHANNELS_FIRST;
+}
+
+static int emit_packed(ptts_mimi_emit_fn emit, void *user, const char *wname, const float *wt,
+                       size_t n) {
+    char name[512];
+    snprintf(name, sizeof(name), "%s.tc", wname);
+    return emit(user, name, wt, n);
+}
+
+int ptts_mimi_export_packed(ptts_mimi *mm, ptts_mimi_emit_fn emit, void *user) {
+    if (!mm || !emit) return -1;
+    ptts_mimi_layout layout = mm->layout;
+    if (ptts_mimi_set_layout(mm, PTTS_MIMI_LAYOUT_CHANNELS_LAST) != 0) return -1;
+    mm->layout = layout;
+
+    const ptts_convtr1d *tr[4] = {&mm->upsample, &mm->up[0], &mm->up[1], &mm->up[2]};
+    const ptts_conv1d *cv[8] = {&mm->dec_in, &mm->dec_out,
+                                &mm->res[0].conv1, &mm->res[0].conv2,
+                                &mm->res[1].conv1, &mm->res[1].conv2,
+                                &mm->res[2].conv1, &mm->res[2].conv2};
+    for (int i = 0; i < 4; i++) {
+        size_t n = (size_t)tr[i]->in_ch * (tr[i]->out_ch / tr[i]->groups) * tr[i]->k;
+        int rc = emit_packed(emit, user, tr[i]->wname, tr[i]->wt, n);
+        if (rc != 0) return rc;
+    }
+    for (int i = 0; i < 8; i++) {
+        size_t n = (size_t)cv[i]->out_ch * (cv[i]->in_ch / cv[i]->groups) * cv[i]->k;
+        int rc = emit_packed(emit, user, cv[i]->wname, cv[i]->wt, n);
+        if (rc != 0) return rc;
+    }
+    return 0;
+}
+
+static int quantize_weight(mimi_qweight *q, const float *w, int rows, int cols,
+                           ptts_mimi_precision precision) {
+    if (precision == PTTS_MIMI_PRECISION_BF16 && !q->bf16) {
+        q->bf16 = ptts_quantize_bf16(w, (size_t)rows * cols);
+        if (!q->bf16) return -1;
+    } else if (precision == PTTS_MIMI_PRECISION_INT8 && !q->q8) {
+        q->scale = (float *)malloc((size_t)rows * sizeof(float));
+        if (!q->scale) return -1;
+        q->q8 = ptts_quantize_q8_rows(w, rows, cols, q->scale);
+        if (!q->q8) return -1;
+    }
+    return 0;
+}
+
+static void free_qweight(mimi_qweight *q) {
+    free(q->bf16);
+    free(q->q8);
+    free(q->scale);
+    memset(q, 0, sizeof(*q));
+}
+
+int ptts_mimi_set_precision(ptts_mimi *mm, ptts_mimi_precision precision) {
+    if (!mm) return -1;
+    if (precision != PTTS_MIMI_PRECISION_F32) {
+        for (int l = 0; l < MIMI_NUM_LAYERS; l++) {
+            ptts_mimi_layer *layer = &mm->layers[l];
+            int rc = quantize_weight(&layer->in_proj_q, layer->in_proj_w, 3 * MIMI_D_MODEL,
+                                     MIMI_D_MODEL, precision) |
+                     quantize_weight(&layer->out_proj_q, layer->out_proj_w, MIMI_D_MODEL,
+                                     MIMI_D_MODEL, precision) |
+                     quantize_weight(&layer->linear1_q, layer->linear1_w, MIMI_HIDDEN,
+                                     MIMI_D_MODEL, precision) |
+                     quantize_weight(&layer->linear2_q, layer->linear2_w, MIMI_D_MODEL,
+                                     MIMI_HIDDEN, precision);
+            if (rc != 0) return -1;
+        }
+    }
+    /* Cached workspaces were planned for the previous activation size. */
+    if (precision != mm->precision) mimi_ws_drain(mm);
+    mm->precision = precision;
+    return 0;
+}
+
+ptts_mimi_precision ptts_mimi_get_precision(const ptts_mimi *mm) {
+    return mm ? mm->precision : PTTS_MIMI_PRECISION_F32;
+}
+
 void ptts_mimi_free(ptts_mimi *mm) {
     if (!mm) return;
-    free_ptr(&mm->quant_w);
-    free_ptr(&mm->upsample.w);
-    free_ptr(&mm->dec_in.w);
-    free_ptr(&mm->dec_in.b);
+    free_weight(mm, &mm->quant_w);
+    free_weight(mm, &mm->upsample.w);
+    free_weight(mm, &mm->upsample.wt);
+    free_weight(mm, &mm->dec_in.w);
+    free_weight(mm, &mm->dec_in.b);
+    free_weight(mm, &mm->dec_in.wt);
+    free_weight(mm, &mm->dec_out.wt);
     for (int i = 0; i < 3; i++) {
-        free_ptr(&mm->up[i].w);
-        free_ptr(&mm->up[i].b);
-        free_ptr(&mm->res[i].conv1.w);
-        free_ptr(&mm->res[i].conv1.b);
-        free_ptr(&mm->res[i].conv2.w);
-        free_ptr(&mm->res[i].conv2.b);
-    }
-    free_ptr(&mm->dec_out.w);
-    free_ptr(&mm->dec_out.b);
+        free_weight(mm, &mm->up[i].w);
+        free_weight(mm, &mm->up[i].b);
+        free_weight(mm, &mm->up[i].wt);
+        free_weight(mm, &mm->res[i].conv1.w);
+        free_weight(mm, &mm->res[i].conv1.b);
+        free_weight(mm, &mm->res[i].conv1.wt);
+        free_weight(mm, &mm->res[i].conv2.w);
+        free_weight(mm, &mm->res[i].conv2.b);
+        free_weight(mm, &mm->res[i].conv2.wt);
+    }
+    free_weight(mm, &mm->dec_out.w);
+    free_weight(mm, &mm->dec_out.b);
     for (int i = 0; i < MIMI_NUM_LAYERS; i++) {
-        free_ptr(&mm->layers[i].in_proj_w);
-        free_ptr(&mm->layers[i].out_proj_w);
-        free_ptr(&mm->layers[i].norm1_w);
-        free_ptr(&mm->layers[i].norm1_b);
-        free_ptr(&mm->layers[i].norm2_w);
-        free_ptr(&mm->layers[i].norm2_b);
-        free_ptr(&mm->layers[i].linear1_w);
-        free_ptr(&mm->layers[i].linear2_w);
-        free_ptr(&mm->layers[i].ls1);
-        free_ptr(&mm->layers[i].ls2);
+        free_weight(mm, &mm->layers[i].in_proj_w);
+        free_weight(mm, &mm->layers[i].out_proj_w);
+        free_weight(mm, &mm->layers[i].norm1_w);
+        free_weight(mm, &mm->layers[i].norm1_b);
+        free_weight(mm, &mm->layers[i].norm2_w);
+        free_weight(mm, &mm->layers[i].norm2_b);
+        free_weight(mm, &mm->layers[i].linear1_w);
+        free_weight(mm, &mm->layers[i].linear2_w);
+        free_weight(mm, &mm->layers[i].ls1);
+        free_weight(mm, &mm->layers[i].ls2);
+        free_qweight(&mm->layers[i].in_proj_q);
+        free_qweight(&mm->layers[i].out_proj_q);
+        free_qweight(&mm->layers[i].linear1_q);
+        free_qweight(&mm->layers[i].linear2_q);
     }
+    mimi_ws_drain(mm);
+    pthread_mutex_destroy(&mm->ws_lock);
+    safetensors_arena_free(&mm->arena);
     free(mm);
 }
 
+int ptts_mimi_protect_weights(ptts_mimi *mm) {
+    return mm ? safetensors_arena_protect(&mm->arena) : -1;
+}
+
 int ptts_mimi_forward_one(ptts_mimi *mm, const float *latent, float *out_embed) {
     if (!mm || !latent || !out_embed) return -1;
 
@@ -563,9 +959,432 @@ int ptts_mimi_decode_one(ptts_mimi *mm, const float *latent, float *out_audio, i
     return ptts_mimi_decode(mm, latent, 1, out_audio, out_len);
 }
 
-int ptts_mimi_decode(ptts_mimi *mm, const float *latents, int frames,
-                     float *out_audio, int *out_len) {
-    if (!mm || !latents || !out_audio || !out_len || frames < 1) return -1;
+/* ========================================================================
+ * Conv stack buffer plan
+ *
+ * Every intermediate of the channels-last decode is listed with the step
+ * that produces it and the last step that reads it. Tensors whose lifetimes
+ * do not overlap share an arena, so a decode runs out of MIMI_NUM_ARENAS
+ * buffers sized once per frame-count class and reused across calls. ELU is
+ * fused into the conv that reads it and the resblock residual is accumulated
+ * by conv2, so only the transformer and the residual add work in place.
+ * ======================================================================== */
+
+#define MIMI_NUM_ARENAS 3
+#define MIMI_PLAN_CLASS 16   /* frames are planned in multiples of this */
+#define MIMI_WS_CACHE 8      /* idle workspaces kept per model */
+
+enum {
+    MIMI_BUF_Q,        /* quantizer projection [frames, 512] */
+    MIMI_BUF_UP,       /* upsample out, transformed in place [T0, 512] */
+    MIMI_BUF_DEC_IN,   /* dec_in out [T0, 512] */
+    MIMI_BUF_STAGE,    /* per upsampling stage: */
+    MIMI_BUF_Y = 0,    /*   convtr out, residual accumulated in place */
+    MIMI_BUF_HID,      /*   conv1 out */
+    MIMI_BUF_PER_STAGE,
+    MIMI_NUM_BUFS = MIMI_BUF_STAGE + 3 * MIMI_BUF_PER_STAGE
+};
+
+typedef struct {
+    int frames;                            /* size class */
+    int num_arenas;                        /* arenas actually used */
+    int arena_of[MIMI_NUM_BUFS];
+    size_t lead[MIMI_NUM_BUFS];            /* floats kept free before each buffer */
+    size_t arena_floats[MIMI_NUM_ARENAS];
+} mimi_conv_plan;
+
+struct mimi_workspace {
+    mimi_conv_plan plan;
+    float *arena[MIMI_NUM_ARENAS];
+    float *scratch; /* conv input staging, see mimi_tc_scratch_floats */
+    size_t scratch_floats;
+    mimi_workspace *next;
+};
+
+static int stage_buf(int stage, int which) {
+    return MIMI_BUF_STAGE + stage * MIMI_BUF_PER_STAGE + which;
+}
+
+/* Input rows a conv reads before t = 0 (what a stream carries over). */
+static int conv1d_hist_rows(const ptts_conv1d *c) {
+    return c->k - 1;
+}
+
+static int convtr1d_hist_rows(const ptts_convtr1d *c) {
+    return (c->k + c->stride - 1) / c->stride - 1;
+}
+
+/* Greedy interval colouring in definition order: each tensor takes the free
+ * arena (last reader strictly before its definition) that needs to grow the
+ * least. Returns -1 if the schedule needs more than MIMI_NUM_ARENAS. */
+static int mimi_plan_build(const ptts_mimi *mm, int frames, mimi_conv_plan *plan) {
+    size_t size[MIMI_NUM_BUFS];
+    int def[MIMI_NUM_BUFS], last[MIMI_NUM_BUFS];
+    size_t T = (size_t)frames * mm->upsample.stride;
+    /* Stage activations are bf16 below f32 precision: two per float slot. */
+    int act_bf16 = mm->precision != PTTS_MIMI_PRECISION_F32;
+
+    /* Room for the rows each buffer's reader looks back at, filled by the
+     * streaming decoder (see mimi_hist). */
+    size_t lead[MIMI_NUM_BUFS];
+    lead[MIMI_BUF_Q] = (size_t)convtr1d_hist_rows(&mm->upsample) * MIMI_D_MODEL;
+    lead[MIMI_BUF_UP] = (size_t)conv1d_hist_rows(&mm->dec_in) * MIMI_D_MODEL;
+    lead[MIMI_BUF_DEC_IN] = (size_t)convtr1d_hist_rows(&mm->up[0]) * mm->dec_in.out_ch;
+    for (int i = 0; i < 3; i++) {
+        const ptts_resblock *rb = &mm->res[i];
+        int rows = i < 2 ? convtr1d_hist_rows(&mm->up[i + 1]) : conv1d_hist_rows(&mm->dec_out);
+        if (conv1d_hist_rows(&rb->conv1) > rows) rows = conv1d_hist_rows(&rb->conv1);
+        lead[stage_buf(i, MIMI_BUF_Y)] = (size_t)rows * rb->dim;
+        lead[stage_buf(i, MIMI_BUF_HID)] = (size_t)conv1d_hist_rows(&rb->conv2) *
+                                           rb->conv1.out_ch;
+        if (act_bf16) {
+            lead[stage_buf(i, MIMI_BUF_Y)] = (lead[stage_buf(i, MIMI_BUF_Y)] + 1) / 2;
+            lead[stage_buf(i, MIMI_BUF_HID)] = (lead[stage_buf(i, MIMI_BUF_HID)] + 1) / 2;
+        }
+    }
+
+    size[MIMI_BUF_Q] = (size_t)frames * MIMI_D_MODEL;
+    def[MIMI_BUF_Q] = 0; last[MIMI_BUF_Q] = 1;
+    size[MIMI_BUF_UP] = T * MIMI_D_MODEL;
+    def[MIMI_BUF_UP] = 1; last[MIMI_BUF_UP] = 3;          /* step 2: transformer */
+    size[MIMI_BUF_DEC_IN] = T * mm->dec_in.out_ch;
+    def[MIMI_BUF_DEC_IN] = 3; last[MIMI_BUF_DEC_IN] = 4;
+    for (int i = 0; i < 3; i++) {
+        int s = 4 + 3 * i;  /* convtr, conv1, conv2 (+= y) */
+        T *= mm->up[i].stride;
+        size[stage_buf(i, MIMI_BUF_Y)] = T * mm->res[i].dim;
+        size[stage_buf(i, MIMI_BUF_HID)] = T * mm->res[i].conv1.out_ch;
+        if (act_bf16) {
+            size[stage_buf(i, MIMI_BUF_Y)] = (size[stage_buf(i, MIMI_BUF_Y)] + 1) / 2;
+            size[stage_buf(i, MIMI_BUF_HID)] = (size[stage_buf(i, MIMI_BUF_HID)] + 1) / 2;
+        }
+        def[stage_buf(i, MIMI_BUF_Y)] = s;
+        last[stage_buf(i, MIMI_BUF_Y)] = s + 3;            /* next convtr or dec_out */
+        def[stage_buf(i, MIMI_BUF_HID)] = s + 1; last[stage_buf(i, MIMI_BUF_HID)] = s + 2;
+    }
+
+    int busy_until[MIMI_NUM_ARENAS];
+    memset(plan, 0, sizeof(*plan));
+    plan->frames = frames;
+    for (int a = 0; a < MIMI_NUM_ARENAS; a++) busy_until[a] = -1;
+    for (int b = 0; b < MIMI_NUM_BUFS; b++) {
+        int best = -1;
+        size_t best_growth = 0;
+        for (int a = 0; a < MIMI_NUM_ARENAS; a++) {
+            if (busy_until[a] >= def[b]) continue;
+            size_t growth = size[b] > plan->arena_floats[a] ? size[b] - plan->arena_floats[a] : 0;
+            if (best < 0 || growth < best_growth) {
+                best = a;
+                best_growth = growth;
+            }
+        }
+        if (best < 0) return -1;
+        if (best + 1 > plan->num_arenas) plan->num_arenas = best + 1;
+        plan->arena_of[b] = best;
+        plan->lead[b] = lead[b];
+        busy_until[best] = last[b];
+        size[b] += lead[b];
+        if (size[b] > plan->arena_floats[best]) plan->arena_floats[best] = size[b];
+    }
+    return 0;
+}
+
+static size_t mimi_plan_bytes(const mimi_conv_plan *plan) {
+    size_t n = 0;
+    for (int a = 0; a < MIMI_NUM_ARENAS; a++) n += plan->arena_floats[a];
+    return n * sizeof(float);
+}
+
+static void mimi_ws_free(mimi_workspace *ws) {
+    if (!ws) return;
+    for (int a = 0; a < MIMI_NUM_ARENAS; a++) free(ws->arena[a]);
+    free(ws->scratch);
+    free(ws);
+}
+
+/* Sizes the staging for the calling thread's kernel thread count (chunk
+ * workers run fewer OpenMP threads than the caller). */
+static int mimi_ws_fit_scratch(const ptts_mimi *mm, mimi_workspace *ws) {
+    size_t need = mimi_tc_scratch_floats(mm);
+    if (ws->scratch_floats >= need) return 0;
+    float *s = (float *)realloc(ws->scratch, need * sizeof(float));
+    if (!s) return -1;
+    ws->scratch = s;
+    ws->scratch_floats = need;
+    return 0;
+}
+
+/* Take the smallest idle workspace planned for at least frames, or build
+ * one for frames rounded up to MIMI_PLAN_CLASS. */
+static mimi_workspace *mimi_ws_acquire(ptts_mimi *mm, int frames) {
+    int cls = (frames + MIMI_PLAN_CLASS - 1) / MIMI_PLAN_CLASS * MIMI_PLAN_CLASS;
+    pthread_mutex_lock(&mm->ws_lock);
+    mimi_workspace **best = NULL;
+    for (mimi_workspace **p = &mm->ws_free; *p; p = &(*p)->next) {
+        if ((*p)->plan.frames >= cls && (!best || (*p)->plan.frames < (*best)->plan.frames)) {
+            best = p;
+        }
+    }
+    mimi_workspace *ws = NULL;
+    if (best) {
+        ws = *best;
+        *best = ws->next;
+        ws->next = NULL;
+    }
+    pthread_mutex_unlock(&mm->ws_lock);
+    if (ws) {
+        if (mimi_ws_fit_scratch(mm, ws) == 0) return ws;
+        mimi_ws_free(ws);
+        return NULL;
+    }
+
+    ws = (mimi_workspace *)calloc(1, sizeof(mimi_workspace));
+    if (!ws) return NULL;
+    if (mimi_plan_build(mm, cls, &ws->plan) != 0) {
+        free(ws);
+        return NULL;
+    }
+    for (int a = 0; a < ws->plan.num_arenas; a++) {
+        ws->arena[a] = (float *)malloc(ws->plan.arena_floats[a] * sizeof(float));
+        if (!ws->arena[a]) {
+            mimi_ws_free(ws);
+            return NULL;
+        }
+    }
+    if (mimi_ws_fit_scratch(mm, ws) != 0) {
+        mimi_ws_free(ws);
+        return NULL;
+    }
+    return ws;
+}
+
+static void mimi_ws_release(ptts_mimi *mm, mimi_workspace *ws) {
+    if (!ws) return;
+    int kept = 0;
+    pthread_mutex_lock(&mm->ws_lock);
+    for (mimi_workspace *p = mm->ws_free; p; p = p->next) kept++;
+    if (kept < MIMI_WS_CACHE) {
+        ws->next = mm->ws_free;
+        mm->ws_free = ws;
+        ws = NULL;
+    }
+    pthread_mutex_unlock(&mm->ws_lock);
+    mimi_ws_free(ws);
+}
+
+static void mimi_ws_drain(ptts_mimi *mm) {
+    while (mm->ws_free) {
+        mimi_workspace *ws = mm->ws_free;
+        mm->ws_free = ws->next;
+        mimi_ws_free(ws);
+    }
+}
+
+static float *ws_buf(const mimi_workspace *ws, int buf) {
+    return ws->arena[ws->plan.arena_of[buf]] + ws->plan.lead[buf];
+}
+
+/* Input rows a streaming conv carries into its next call, stored like that
+ * conv's input (bf16 stage activations below f32 precision). */
+typedef struct {
+    unsigned char *rows;
+    size_t row_bytes;
+    int n;
+} mimi_hist;
+
+enum {
+    MIMI_HIST_UPSAMPLE,
+    MIMI_HIST_DEC_IN,
+    MIMI_HIST_UP,                       /* per upsampling stage: convtr, */
+    MIMI_HIST_CONV1 = MIMI_HIST_UP + 3, /*   resblock conv1 and conv2 */
+    MIMI_HIST_CONV2 = MIMI_HIST_CONV1 + 3,
+    MIMI_HIST_DEC_OUT = MIMI_HIST_CONV2 + 3,
+    MIMI_NUM_HIST
+};
+
+/* Streaming only (hist != NULL): copy layer's carried rows in front of its
+ * input x, into the room the plan leaves there, and return the conv flag
+ * that reads them. */
+static int hist_enter(const mimi_hist *hist, int layer, float *x) {
+    if (!hist) return 0;
+    const mimi_hist *h = &hist[layer];
+    size_t n = (size_t)h->n * h->row_bytes;
+    memcpy((unsigned char *)x - n, h->rows, n);
+    return PTTS_CONV_IN_HIST;
+}
+
+/* Keep the last rows of carried + current input (T rows at x) for the next
+ * call. Must run before anything overwrites x. */
+static void hist_leave(mimi_hist *hist, int layer, const float *x, int T) {
+    if (!hist) return;
+    mimi_hist *h = &hist[layer];
+    size_t n = (size_t)h->n * h->row_bytes;
+    memcpy(h->rows, (const unsigned char *)x + (size_t)T * h->row_bytes - n, n);
+}
+
+/* Channels-last front half: quantizer projection and upsampling of one
+ * sequence into x ([frames * stride, 512]), using the workspace's Q buffer.
+ * hist (a stream's carried rows, or NULL) is as for mimi_conv_stack_tc. */
+static void mimi_upsample_tc(ptts_mimi *mm, mimi_workspace *ws, const float *latents,
+                             int frames, float *x, mimi_hist *hist) {
+    float *q = ws_buf(ws, MIMI_BUF_Q);
+    linear_forward(mm->quant_w, NULL, MIMI_D_MODEL, 32, latents, frames, q);
+    int hf = hist_enter(hist, MIMI_HIST_UPSAMPLE, q);
+    convtr1d_forward_tc(&mm->upsample, q, frames, x, hf, ws->scratch);
+    hist_leave(hist, MIMI_HIST_UPSAMPLE, q, frames);
+}
+
+/* Channels-last conv stack: transformer output x ([T, 512]) to T * 120
+ * samples. Intermediates live in the planned workspace (see
+ * mimi_plan_build); x itself is only read. Below f32 precision the
+ * upsampling stages store their activations as bf16. stage_ms, if given,
+ * receives dec_in, the three stages and dec_out times. With hist (a
+ * stream's MIMI_NUM_HIST carried inputs) every conv continues from the
+ * previous call instead of zero padding; x must then be the workspace's UP
+ * buffer, whose lead room takes dec_in's history. */
+static int mimi_conv_stack_tc(ptts_mimi *mm, mimi_workspace *ws, float *x_in, int T,
+                              float *out_audio, double *stage_ms, mimi_hist *hist) {
+    int act = mm->precision != PTTS_MIMI_PRECISION_F32;
+    int in_act = act ? PTTS_CONV_IN_BF16 : 0;
+    int out_act = act ? PTTS_CONV_OUT_BF16 : 0;
+    double t = stage_ms ? ptts_time_ms() : 0.0;
+
+    PTTS_TRACE_BEGIN(t_trace);
+    float *y = ws_buf(ws, MIMI_BUF_DEC_IN);
+    int hf = hist_enter(hist, MIMI_HIST_DEC_IN, x_in);
+    conv1d_forward_tc(&mm->dec_in, x_in, T, y, hf, ws->scratch);
+    hist_leave(hist, MIMI_HIST_DEC_IN, x_in, T);
+    PTTS_TRACE_END(t_trace, "mimi.dec_in", T);
+    float *x = y;
+    int x_flags = 0; /* storage of x: dec_in output is f32 */
+    if (stage_ms) { double now = ptts_time_ms(); stage_ms[0] = now - t; t = now; }
+
+    /* Each stage reads ELU(x); the resblock is x += conv2(ELU(conv1(ELU(x)))). */
+    for (int i = 0; i < 3; i++) {
+        const ptts_resblock *rb = &mm->res[i];
+        PTTS_TRACE_BEGIN(t_stage);
+        y = ws_buf(ws, stage_buf(i, MIMI_BUF_Y));
+        hf = hist_enter(hist, MIMI_HIST_UP + i, x);
+        convtr1d_forward_tc(&mm->up[i], x, T, y, PTTS_CONV_IN_ELU | x_flags | out_act | hf,
+                            ws->scratch);
+        hist_leave(hist, MIMI_HIST_UP + i, x, T);
+        x = y;
+        x_flags = in_act;
+        T *= mm->up[i].stride;
+
+        /* conv1's history is the stage output before the residual lands. */
+        float *h = ws_buf(ws, stage_buf(i, MIMI_BUF_HID));
+        hf = hist_enter(hist, MIMI_HIST_CONV1 + i, x);
+        conv1d_forward_tc(&rb->conv1, x, T, h, PTTS_CONV_IN_ELU | in_act | out_act | hf,
+                          ws->scratch);
+        hist_leave(hist, MIMI_HIST_CONV1 + i, x, T);
+        hf = hist_enter(hist, MIMI_HIST_CONV2 + i, h);
+        conv1d_forward_tc(&rb->conv2, h, T, x,
+                          PTTS_CONV_IN_ELU | PTTS_CONV_ACCUM | in_act | out_act | hf,
+                          ws->scratch);
+        hist_leave(hist, MIMI_HIST_CONV2 + i, h, T);
+        PTTS_TRACE_END(t_stage, "mimi.stage", i);
+        if (stage_ms) { double now = ptts_time_ms(); stage_ms[1 + i] = now - t; t = now; }
+    }
+
+    PTTS_TRACE_BEGIN(t_out);
+    hf = hist_enter(hist, MIMI_HIST_DEC_OUT, x);
+    conv1d_forward_tc(&mm->dec_out, x, T, out_audio, PTTS_CONV_IN_ELU | x_flags | hf,
+                      ws->scratch);
+    hist_leave(hist, MIMI_HIST_DEC_OUT, x, T);
+    PTTS_TRACE_END(t_out, "mimi.dec_out", T);
+    if (stage_ms) stage_ms[4] = ptts_time_ms() - t;
+    return T;
+}
+
+static void mimi_run_stats_add(ptts_mimi_run_stats *rs, double transformer_ms, double conv_ms,
+                               size_t scratch_bytes) {
+    if (!rs) return;
+    rs->transformer_ms += transformer_ms;
+    rs->conv_ms += conv_ms;
+    if (scratch_bytes > rs->scratch_bytes) rs->scratch_bytes = scratch_bytes;
+}
+
+/* Peak bytes of the activations live at once in a channel-major conv stack
+ * pass over T transformer steps: the transformer output, a stage's input
+ * and output, and its resblock temporaries. */
+static size_t mimi_chw_stack_bytes(const ptts_mimi *mm, int T) {
+    size_t base = (size_t)MIMI_D_MODEL * T;
+    size_t cur = (size_t)mm->dec_in.out_ch * T;
+    size_t peak = base + (size_t)MIMI_D_MODEL * T + cur;
+    for (int i = 0; i < 3; i++) {
+        int t_out = T * mm->up[i].stride;
+        size_t y = (size_t)mm->up[i].out_ch * t_out;
+        size_t res = ((size_t)mm->res[i].dim + mm->res[i].conv1.out_ch) * t_out;
+        if (base + cur + y + res > peak) peak = base + cur + y + res;
+        cur = y;
+        T = t_out;
+    }
+    if (base + cur + (size_t)mm->dec_out.out_ch * T > peak) {
+        peak = base + cur + (size_t)mm->dec_out.out_ch * T;
+    }
+    return peak * sizeof(float);
+}
+
+/* Channels-last decode: every activation is [T, channels], so the
+ * transformer consumes the upsampled features in place and the mono output
+ * conv writes the waveform directly. */
+static int mimi_decode_span_tc(ptts_mimi *mm, const float *latents, int frames, int frame0,
+                               float *out_audio, int *out_len, ptts_mimi_run_stats *rs) {
+    int timing = ptts_timing_enabled();
+    double t_span = ptts_time_ms();
+    double t_alloc = t_span;
+    mimi_workspace *ws = mimi_ws_acquire(mm, frames);
+    if (!ws) return -1;
+    if (timing) t_alloc = ptts_time_ms() - t_alloc;
+
+    int T = frames * mm->upsample.stride;
+    float *x = ws_buf(ws, MIMI_BUF_UP);
+    PTTS_TRACE_BEGIN(t_up);
+    mimi_upsample_tc(mm, ws, latents, frames, x, NULL);
+    PTTS_TRACE_END(t_up, "mimi.upsample", frames);
+    double t_tr = ptts_time_ms();
+    PTTS_TRACE_BEGIN(t_trace);
+    if (transformer_forward_kv(mm, x, T, frame0 * mm->upsample.stride, NULL) != 0) {
+        mimi_ws_release(mm, ws);
+        return -1;
+    }
+    PTTS_TRACE_END(t_trace, "mimi.transformer", frames);
+
+    double t_cpu = ptts_time_ms();
+
+    T = mimi_conv_stack_tc(mm, ws, x, T, out_audio, NULL, NULL);
+    mimi_run_stats_add(rs, t_cpu - t_tr, ptts_time_ms() - t_span - (t_cpu - t_tr),
+                       mimi_plan_bytes(&ws->plan));
+
+    if (timing) {
+        double t_end = ptts_time_ms();
+        size_t peak = mimi_plan_bytes(&ws->plan);
+        int cls = ws->plan.frames;
+        int nar = ws->plan.num_arenas;
+        double t_rel = ptts_time_ms();
+        mimi_ws_release(mm, ws);
+        t_alloc += ptts_time_ms() - t_rel;
+        fprintf(stderr,
+                "[ptts] Mimi conv stack (CPU, channels-last): %.2f ms, %d arenas %.1f MB "
+                "(class %d frames), allocator %.3f ms\n",
+                t_end - t_cpu, nar, (double)peak / (1024.0 * 1024.0),
+                cls, t_alloc);
+    } else {
+        mimi_ws_release(mm, ws);
+    }
+    *out_len = T;
+    return 0;
+}
+
+/* Decode frames as a self-contained sequence whose first frame sits at
+ * absolute frame index frame0 (sets the RoPE positions). */
+static int mimi_decode_span(ptts_mimi *mm, const float *latents, int frames, int frame0,
+                            float *out_audio, int *out_len, ptts_mimi_run_stats *rs) {
+    if (mm->layout == PTTS_MIMI_LAYOUT_CHANNELS_LAST) {
+        return mimi_decode_span_tc(mm, latents, frames, frame0, out_audio, out_len, rs);
+    }
+    double t_span = ptts_time_ms();
 
     /* quantizer output proj: [frames,32] -> [512,frames] (channel-major) */
     float *q = (float *)malloc((size_t)MIMI_D_MODEL * frames * sizeof(float));
@@ -593,11 +1412,15 @@ int ptts_mimi_decode(ptts_mimi *mm, const float *latents, int frames,
     if (!up_t) { free(up); return -1; }
     chw_to_thw(up, MIMI_D_MODEL, up_len, up_t);
 
-    if (transformer_forward(mm, up_t, up_len) != 0) {
+    double t_tr = ptts_time_ms();
+    PTTS_TRACE_BEGIN(t_trace);
+    if (transformer_forward_kv(mm, up_t, up_len, frame0 * mm->upsample.stride, NULL) != 0) {
         free(up_t);
         free(up);
         return -1;
     }
+    PTTS_TRACE_END(t_trace, "mimi.transformer", frames);
+    double tr_ms = ptts_time_ms() - t_tr;
 
     /* back to channel-major for conv stack */
     thw_to_chw(up_t, up_len, MIMI_D_MODEL, up);
@@ -659,6 +1482,7 @@ int ptts_mimi_decode(ptts_mimi *mm, const float *latents, int frames,
             }
             *out_len = cuda_len;
             free(up);
+            mimi_run_stats_add(rs, tr_ms, ptts_time_ms() - t_span - tr_ms, 0);
             return 0;
         }
         if (timing) {
@@ -730,5 +1554,882 @@ int ptts_mimi_decode(ptts_mimi *mm, const float *latents, int frames,
     memcpy(out_audio, out, (size_t)T * sizeof(float));
     *out_len = T;
     free(out);
+    mimi_run_stats_add(rs, tr_ms, ptts_time_ms() - t_span - tr_ms,
+                       mimi_chw_stack_bytes(mm, up_len));
+    return 0;
+}
+
+/* ========================================================================
+ * Conv kernel report
+ * ======================================================================== */
+
+static double conv_report_ms(const ptts_conv1d *c, const float *x, int T, float *y, int flags,
+                             int generic, int reps, float *scratch) {
+    double t0 = ptts_time_ms();
+    for (int i = 0; i < reps; i++) {
+        if (generic) {
+            ptts_conv1d_tc_generic_forward(y, x, c->wt, c->b, c->in_ch, c->out_ch, T, c->k,
+                                           c->groups, flags, scratch);
+        } else {
+            conv1d_forward_tc(c, x, T, y, flags, scratch);
+        }
+    }
+    return (ptts_time_ms() - t0) / reps;
+}
+
+typedef struct {
+    const char *name;
+    const ptts_conv1d *c;
+    int T;
+    int flags; /* as used by mimi_decode_span_tc */
+} conv_report_layer;
+
+int ptts_mimi_conv_report(ptts_mimi *mm, int frames) {
+    static const char *res_names[3] = {"res0.conv1", "res1.conv1", "res2.conv1"};
+    if (!mm || frames < 1) return -1;
+    if (ptts_mimi_set_layout(mm, PTTS_MIMI_LAYOUT_CHANNELS_LAST) != 0) return -1;
+    conv_report_layer layers[5];
+    int n = 0;
+    int T = frames * mm->upsample.stride;
+    layers[n++] = (conv_report_layer){"dec_in", &mm->dec_in, T, 0};
+    for (int i = 0; i < 3; i++) {
+        T *= mm->up[i].stride;
+        layers[n++] = (conv_report_layer){res_names[i], &mm->res[i].conv1, T, PTTS_CONV_IN_ELU};
+    }
+    layers[n++] = (conv_report_layer){"dec_out", &mm->dec_out, T, PTTS_CONV_IN_ELU};
+    float *scratch = (float *)malloc(mimi_tc_scratch_floats(mm) * sizeof(float));
+    if (!scratch) return -1;
+
+    printf("%-11s %2s %9s %7s %11s %11s %8s %9s\n", "layer", "k", "in->out", "T",
+           "generic ms", "special ms", "speedup", "max|diff|");
+    for (int l = 0; l < n; l++) {
+        const ptts_conv1d *c = layers[l].c;
+        int Tl = layers[l].T;
+        float *x = (float *)malloc((size_t)Tl * c->in_ch * sizeof(float));
+        float *y0 = (float *)malloc((size_t)Tl * c->out_ch * sizeof(float));
+        float *y1 = (float *)malloc((size_t)Tl * c->out_ch * sizeof(float));
+        if (!x || !y0 || !y1) { free(x); free(y0); free(y1); free(scratch); return -1; }
+        uint32_t r = 12345u;
+        for (size_t i = 0; i < (size_t)Tl * c->in_ch; i++) {
+            r = r * 1664525u + 1013904223u;
+            x[i] = (float)(r >> 8) / 8388608.0f - 1.0f;
+        }
+        int reps = Tl * c->in_ch * c->out_ch * c->k < (1 << 27) ? 5 : 1;
+        double tg = conv_report_ms(c, x, Tl, y0, layers[l].flags, 1, reps, scratch);
+        double ts = conv_report_ms(c, x, Tl, y1, layers[l].flags, 0, reps, scratch);
+        float md = 0.0f;
+        for (size_t i = 0; i < (size_t)Tl * c->out_ch; i++) {
+            float d = fabsf(y0[i] - y1[i]);
+            if (d > md) md = d;
+        }
+        char shape[32];
+        snprintf(shape, sizeof(shape), "%d->%d", c->in_ch, c->out_ch);
+        printf("%-11s %2d %9s %7d %11.2f %11.2f %7.2fx %9.2g\n", layers[l].name, c->k, shape, Tl,
+               tg, ts, tg / ts, md);
+        free(x); free(y0); free(y1);
+    }
+    free(scratch);
+    return 0;
+}
+
+#define PREC_REPORT_STAGES 6 /* transformer, dec_in, stage0-2, dec_out */
+
+/* One channels-last decode with per-stage times (best of two runs). */
+static int precision_report_run(ptts_mimi *mm, const float *latents, int frames, float *x,
+                                float *out, double *ms) {
+    int T = frames * mm->upsample.stride;
+    for (int s = 0; s < PREC_REPORT_STAGES; s++) ms[s] = 1e30;
+    for (int rep = 0; rep < 2; rep++) {
+        double run[PREC_REPORT_STAGES];
+        mimi_workspace *ws = mimi_ws_acquire(mm, frames);
+        if (!ws) return -1;
+        mimi_upsample_tc(mm, ws, latents, frames, x, NULL);
+        double t0 = ptts_time_ms();
+        if (transformer_forward_kv(mm, x, T, 0, NULL) != 0) {
+            mimi_ws_release(mm, ws);
+            return -1;
+        }
+        run[0] = ptts_time_ms() - t0;
+        mimi_conv_stack_tc(mm, ws, x, T, out, run + 1, NULL);
+        mimi_ws_release(mm, ws);
+        for (int s = 0; s < PREC_REPORT_STAGES; s++) {
+            if (run[s] < ms[s]) ms[s] = run[s];
+        }
+    }
     return 0;
 }
+
+int ptts_mimi_precision_report(ptts_mimi *mm, int frames) {
+    static const struct { ptts_mimi_precision p; const char *name; } modes[3] = {
+        {PTTS_MIMI_PRECISION_F32, "f32"},
+        {PTTS_MIMI_PRECISION_BF16, "bf16"},
+        {PTTS_MIMI_PRECISION_INT8, "int8"},
+    };
+    static const char *stage_names[PREC_REPORT_STAGES] = {
+        "transf", "dec_in", "stage0", "stage1", "stage2", "dec_out"};
+    if (!mm || frames < 1) return -1;
+    ptts_mimi_layout layout = mm->layout;
+    ptts_mimi_precision precision = mm->precision;
+    if (ptts_mimi_set_layout(mm, PTTS_MIMI_LAYOUT_CHANNELS_LAST) != 0) return -1;
+
+    size_t n = (size_t)frames * PTTS_MIMI_FRAME_SAMPLES;
+    float *latents = (float *)malloc((size_t)frames * 32 * sizeof(float));
+    float *x = (float *)malloc((size_t)frames * mm->upsample.stride * MIMI_D_MODEL * sizeof(float));
+    float *ref = (float *)malloc(n * sizeof(float));
+    float *out = (float *)malloc(n * sizeof(float));
+    int rc = -1;
+    if (!latents || !x || !ref || !out) goto done;
+    uint32_t r = 4321u;
+    for (int i = 0; i < frames * 32; i++) {
+        r = r * 1664525u + 1013904223u;
+        latents[i] = (float)(r >> 8) / 8388608.0f - 1.0f;
+    }
+
+    printf("%-5s", "prec");
+    for (int s = 0; s < PREC_REPORT_STAGES; s++) printf(" %8s", stage_names[s]);
+    printf(" %9s %8s %9s\n", "total ms", "SNR dB", "max|diff|");
+    double base[PREC_REPORT_STAGES];
+    for (int m = 0; m < 3; m++) {
+        double ms[PREC_REPORT_STAGES];
+        if (ptts_mimi_set_precision(mm, modes[m].p) != 0 ||
+            precision_report_run(mm, latents, frames, x, m == 0 ? ref : out, ms) != 0) {
+            goto done;
+        }
+        double total = 0.0;
+        for (int s = 0; s < PREC_REPORT_STAGES; s++) total += ms[s];
+        printf("%-5s", modes[m].name);
+        for (int s = 0; s < PREC_REPORT_STAGES; s++) printf(" %8.2f", ms[s]);
+        if (m == 0) {
+            memcpy(base, ms, sizeof(base));
+            printf(" %9.2f %8s %9s\n", total, "-", "-");
+            continue;
+        }
+        double sig = 0.0, err = 0.0;
+        float md = 0.0f;
+        for (size_t i = 0; i < n; i++) {
+            float d = out[i] - ref[i];
+            sig += (double)ref[i] * ref[i];
+            err += (double)d * d;
+            if (fabsf(d) > md) md = fabsf(d);
+        }
+        printf(" %9.2f %8.1f %9.2g\n", total, err > 0.0 ? 10.0 * log10(sig / err) : INFINITY, md);
+        printf("%-5s", "  x");
+        double base_total = 0.0;
+        for (int s = 0; s < PREC_REPORT_STAGES; s++) {
+            printf(" %7.2fx", base[s] / ms[s]);
+            base_total += base[s];
+        }
+        printf(" %8.2fx\n", base_total / total);
+    }
+    rc = 0;
+
+done:
+    ptts_mimi_set_precision(mm, precision);
+    ptts_mimi_set_layout(mm, layout);
+    free(latents); free(x); free(ref); free(out);
+    return rc;
+}
+
+/* ========================================================================
+ * Chunked decode
+ * ======================================================================== */
+
+#define MIMI_CHUNK_DEFAULT 64
+
+/* Frames per chunk for ptts_mimi_decode (PTTS_MIMI_CHUNK, 0 = one pass). */
+static int mimi_chunk_frames(void) {
+    static int inited = 0;
+    static int frames = MIMI_CHUNK_DEFAULT;
+    if (!inited) {
+        const char *v = getenv("PTTS_MIMI_CHUNK");
+        if (v && v[0]) {
+            frames = atoi(v);
+            if (frames < 0) frames = 0;
+        }
+#ifdef PTTS_USE_CUDA
+        /* The GPU conv stack wants the whole sequence in one launch. */
+        else if (cuda_conv_enabled()) {
+            frames = 0;
+        }
+#endif
+        inited = 1;
+    }
+    return frames;
+}
+
+/* PTTS_MIMI_THREADS, else the CPUs this process may run on shared out
+ * between the decodes running at once (serve, batch and long-form workers
+ * each decode their own request). */
+static int mimi_chunk_threads(int decodes) {
+    const char *v = getenv("PTTS_MIMI_THREADS");
+    if (v && v[0]) {
+        int n = atoi(v);
+        return n > 0 ? n : 1;
+    }
+    long n = 0;
+#ifdef __linux__
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) n = CPU_COUNT(&allowed);
+#endif
+    if (n <= 0) n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (decodes > 1) n /= decodes;
+    return n > 0 ? (int)n : 1;
+}
+
+/* Look-back samples at a causal conv1d input (stride 1) given the look-back
+ * at its output. */
+static int conv1d_lookback(const ptts_conv1d *c, int out_lb) {
+    return out_lb + c->k - c->stride;
+}
+
+/* Same for a trimmed convtr: output p reads inputs t with
+ * t * stride <= p <= t * stride + k - 1. Outputs start on a frame boundary. */
+static int convtr1d_lookback(const ptts_convtr1d *c, int out_lb) {
+    return (out_lb + c->k - 1) / c->stride;
+}
+
+/* Latent frames before a chunk that its first output sample can depend on:
+ * the decoder is causal, so decoding a chunk together with this many earlier
+ * frames and dropping their samples reproduces the one-pass output. */
+static int mimi_halo_frames(const ptts_mimi *mm) {
+    int lb = 0;
+    lb = conv1d_lookback(&mm->dec_out, lb);
+    for (int i = 2; i >= 0; i--) {
+        lb = conv1d_lookback(&mm->res[i].conv1, lb);
+        lb = conv1d_lookback(&mm->res[i].conv2, lb);
+        lb = convtr1d_lookback(&mm->up[i], lb);
+    }
+    lb = conv1d_lookback(&mm->dec_in, lb);
+    lb += MIMI_NUM_LAYERS * (MIMI_CONTEXT - 1);
+    return convtr1d_lookback(&mm->upsample, lb);
+}
+
+typedef struct {
+    ptts_mimi *mm;
+    const float *latents;
+    int frames;
+    int chunk;
+    int halo;
+    int num_chunks;
+    int inner_threads;
+    float *out_audio;
+    pthread_mutex_t lock;
+    int next;
+    int failed;
+    ptts_mimi_run_stats *rs; /* times summed over threads, scratch too */
+    int threads_started;     /* names the trace tracks */
+} mimi_chunk_job;
+
+static void *mimi_chunk_worker(void *arg) {
+    mimi_chunk_job *job = (mimi_chunk_job *)arg;
+#ifdef _OPENMP
+    omp_set_num_threads(job->inner_threads);
+#endif
+    int fs = PTTS_MIMI_FRAME_SAMPLES;
+    ptts_mimi_run_stats rs = {0.0, 0.0, 0};
+    float *scratch = (float *)malloc((size_t)(job->chunk + job->halo) * fs * sizeof(float));
+    if (!scratch) {
+        pthread_mutex_lock(&job->lock);
+        job->failed = 1;
+        pthread_mutex_unlock(&job->lock);
+        return NULL;
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        int c = job->failed ? job->num_chunks : job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (c >= job->num_chunks) break;
+
+        int f0 = c * job->chunk;
+        int f1 = f0 + job->chunk < job->frames ? f0 + job->chunk : job->frames;
+        int s = f0 - job->halo > 0 ? f0 - job->halo : 0;
+        int len = 0;
+        PTTS_TRACE_BEGIN(t_trace);
+        int rc = mimi_decode_span(job->mm, job->latents + (size_t)s * 32, f1 - s, s,
+                                  scratch, &len, &rs);
+        PTTS_TRACE_END(t_trace, "mimi.chunk", c);
+        if (rc != 0 || len != (f1 - s) * fs) {
+            pthread_mutex_lock(&job->lock);
+            job->failed = 1;
+            pthread_mutex_unlock(&job->lock);
+            break;
+        }
+        memcpy(job->out_audio + (size_t)f0 * fs, scratch + (size_t)(f0 - s) * fs,
+               (size_t)(f1 - f0) * fs * sizeof(float));
+    }
+
+    free(scratch);
+    if (job->rs) {
+        pthread_mutex_lock(&job->lock);
+        job->rs->transformer_ms += rs.transformer_ms;
+        job->rs->conv_ms += rs.conv_ms;
+        job->rs->scratch_bytes += rs.scratch_bytes +
+                                  (size_t)(job->chunk + job->halo) * fs * sizeof(float);
+        pthread_mutex_unlock(&job->lock);
+    }
+    return NULL;
+}
+
+static void *mimi_chunk_thread(void *arg) {
+    mimi_chunk_job *job = (mimi_chunk_job *)arg;
+    ptts_trace_thread_name("mimi chunk %d",
+                           __atomic_add_fetch(&job->threads_started, 1, __ATOMIC_RELAXED));
+    return mimi_chunk_worker(arg);
+}
+
+int ptts_mimi_decode(ptts_mimi *mm, const float *latents, int frames,
+                     float *out_audio, int *out_len) {
+    return ptts_mimi_decode_stats(mm, latents, frames, out_audio, out_len, NULL);
+}
+
+int ptts_mimi_decode_stats(ptts_mimi *mm, const float *latents, int frames,
+                           float *out_audio, int *out_len, ptts_mimi_run_stats *rs) {
+    if (!mm || !latents || !out_audio || !out_len || frames < 1) return -1;
+    if (rs) memset(rs, 0, sizeof(*rs));
+
+    PTTS_TRACE_BEGIN(t_trace);
+    int chunk = mimi_chunk_frames();
+    if (chunk <= 0 || frames <= chunk) {
+        int rc = mimi_decode_span(mm, latents, frames, 0, out_audio, out_len, rs);
+        PTTS_TRACE_END(t_trace, "mimi.decode", frames);
+        return rc;
+    }
+
+    mimi_chunk_job job;
+    memset(&job, 0, sizeof(job));
+    job.mm = mm;
+    job.latents = latents;
+    job.frames = frames;
+    job.chunk = chunk;
+    job.halo = mimi_halo_frames(mm);
+    job.num_chunks = (frames + chunk - 1) / chunk;
+    job.out_audio = out_audio;
+    job.rs = rs;
+    pthread_mutex_init(&job.lock, NULL);
+
+    int decodes = __atomic_add_fetch(&mm->active_decodes, 1, __ATOMIC_RELAXED);
+    int nthreads = mimi_chunk_threads(decodes);
+    if (nthreads > job.num_chunks) nthreads = job.num_chunks;
+    job.inner_threads = 1;
+#ifdef _OPENMP
+    job.inner_threads = omp_get_max_threads() / nthreads;
+    if (job.inner_threads < 1) job.inner_threads = 1;
+#endif
+
+    double t_start = 0.0;
+    int timing = ptts_timing_enabled();
+    if (timing) t_start = ptts_time_ms();
+
+    pthread_t *tids = (pthread_t *)calloc((size_t)nthreads, sizeof(pthread_t));
+    if (!tids) {
+        __atomic_sub_fetch(&mm->active_decodes, 1, __ATOMIC_RELAXED);
+        pthread_mutex_destroy(&job.lock);
+        return -1;
+    }
+    int started = 0;
+    for (int i = 1; i < nthreads; i++) {
+        if (pthread_create(&tids[i], NULL, mimi_chunk_thread, &job) != 0) break;
+        started++;
+    }
+    /* The caller works too; its OpenMP setting is restored afterwards. */
+#ifdef _OPENMP
+    int caller_threads = omp_get_max_threads();
+#endif
+    mimi_chunk_worker(&job);
+#ifdef _OPENMP
+    omp_set_num_threads(caller_threads);
+#endif
+    for (int i = 1; i <= started; i++) pthread_join(tids[i], NULL);
+    free(tids);
+    pthread_mutex_destroy(&job.lock);
+    __atomic_sub_fetch(&mm->active_decodes, 1, __ATOMIC_RELAXED);
+
+    if (job.failed) return -1;
+    if (timing) {
+        double t_end = ptts_time_ms();
+        mimi_conv_plan plan;
+        int span = chunk + job.halo;
+        size_t peak = 0;
+        if (mimi_plan_build(mm, (span + MIMI_PLAN_CLASS - 1) / MIMI_PLAN_CLASS * MIMI_PLAN_CLASS,
+                            &plan) == 0) {
+            peak = mimi_plan_bytes(&plan);
+        }
+        fprintf(stderr,
+                "[ptts] Mimi chunked decode: %d chunks of %d frames (+%d halo) on %d threads: "
+                "%.2f ms (conv workspace %.1f MB per thread)\n",
+                job.num_chunks, chunk, job.halo, started + 1, t_end - t_start,
+                (double)peak / (1024.0 * 1024.0));
+    }
+    *out_len = frames * PTTS_MIMI_FRAME_SAMPLES;
+    PTTS_TRACE_END(t_trace, "mimi.decode", frames);
+    return 0;
+}
+
+int ptts_mimi_decode_batch(ptts_mimi *mm, int n, const float *const *latents,
+                           const int *frames, float *const *out_audio, int *out_len) {
+    if (!mm || n < 1 || !latents || !frames || !out_audio || !out_len) return -1;
+    for (int i = 0; i < n; i++) {
+        if (!latents[i] || !out_audio[i] || frames[i] < 1) return -1;
+    }
+
+    /* Sequences that would be chunked (or a channel-major decoder) take the
+     * single-sequence path; the rest share one transformer pass. */
+    int chunk = mimi_chunk_frames();
+    int batch_ok = mm->layout == PTTS_MIMI_LAYOUT_CHANNELS_LAST;
+    int nb = 0;
+    int total_t = 0;
+    for (int i = 0; i < n; i++) {
+        if (batch_ok && (chunk <= 0 || frames[i] <= chunk)) {
+            nb++;
+            total_t += frames[i] * mm->upsample.stride;
+        } else if (ptts_mimi_decode(mm, latents[i], frames[i], out_audio[i], &out_len[i]) != 0) {
+            return -1;
+        }
+    }
+    if (nb == 0) return 0;
+    if (nb == 1) {
+        for (int i = 0; i < n; i++) {
+            if (chunk <= 0 || frames[i] <= chunk) {
+                return mimi_decode_span_tc(mm, latents[i], frames[i], 0, out_audio[i], &out_len[i],
+                                           NULL);
+            }
+        }
+    }
+
+    int timing = ptts_timing_enabled();
+    double t_start = timing ? ptts_time_ms() : 0.0;
+
+    int *idx = (int *)malloc((size_t)nb * sizeof(int));
+    mimi_seq *seqs = (mimi_seq *)calloc((size_t)nb, sizeof(mimi_seq));
+    mimi_workspace **ws = (mimi_workspace **)calloc((size_t)nb, sizeof(mimi_workspace *));
+    float *x = (float *)malloc((size_t)total_t * MIMI_D_MODEL * sizeof(float));
+    int rc = -1;
+    int b = 0;
+    if (!idx || !seqs || !ws || !x) goto done;
+
+    for (int i = 0; i < n; i++) {
+        if (chunk > 0 && frames[i] > chunk) continue;
+        idx[b] = i;
+        seqs[b].T = frames[i] * mm->upsample.stride;
+        seqs[b].pos = 0;
+        b++;
+    }
+
+    /* Upsample every sequence into its rows of the stacked input. */
+    float *row = x;
+    for (b = 0; b < nb; b++) {
+        int i = idx[b];
+        ws[b] = mimi_ws_acquire(mm, frames[i]);
+        if (!ws[b]) goto done;
+        mimi_upsample_tc(mm, ws[b], latents[i], frames[i], row, NULL);
+        row += (size_t)seqs[b].T * MIMI_D_MODEL;
+    }
+
+    if (transformer_forward_seqs(mm, x, nb, seqs) != 0) goto done;
+
+    double t_conv = timing ? ptts_time_ms() : 0.0;
+    row = x;
+    for (b = 0; b < nb; b++) {
+        int i = idx[b];
+        out_len[i] = mimi_conv_stack_tc(mm, ws[b], row, seqs[b].T, out_audio[i], NULL, NULL);
+        row += (size_t)seqs[b].T * MIMI_D_MODEL;
+    }
+    rc = 0;
+
+    if (timing) {
+        double t_end = ptts_time_ms();
+        fprintf(stderr,
+                "[ptts] Mimi batched decode: %d sequences, %d frames: %.2f ms "
+                "(conv stacks %.2f ms)\n",
+                nb, total_t / mm->upsample.stride, t_end - t_start, t_end - t_conv);
+    }
+
+done:
+    if (ws) {
+        for (b = 0; b < nb; b++) {
+            if (ws[b]) mimi_ws_release(mm, ws[b]);
+        }
+    }
+    free(idx); free(seqs); free(ws); free(x);
+    return rc;
+}
+
+/* ========================================================================
+ * Streaming decode
+ * ======================================================================== */
+
+struct ptts_mimi_stream {
+    ptts_mimi *mm;
+    mimi_attn_state attn;
+    int channels_last;     /* decoder layout at creation picks the state below */
+    int act_bf16;          /* bf16 stage activations (precision at creation) */
+    mimi_hist hist[MIMI_NUM_HIST]; /* channels-last: carried conv inputs */
+    float *upsample_tail;  /* channel-major: [512, k - stride] */
+    float *dec_in_hist;    /* [512, k - 1] */
+    float *up_tail[3];
+    float *res_hist[3];    /* conv1 inputs; conv2 is k=1 */
+    float *dec_out_hist;
+    size_t state_bytes;    /* everything above */
+    ptts_mimi_run_stats stats;
+};
+
+static float *zeros_f32(size_t n) {
+    return (float *)calloc(n > 0 ? n : 1, sizeof(float));
+}
+
+/* n zero rows of ch elements: the causal padding before the first call. */
+static size_t hist_init(mimi_hist *h, int n, int ch, size_t elem) {
+    h->n = n;
+    h->row_bytes = (size_t)ch * elem;
+    h->rows = (unsigned char *)calloc(n > 0 ? (size_t)n * h->row_bytes : 1, 1);
+    return (size_t)n * h->row_bytes;
+}
+
+/* Channels-last state: the inputs of every conv as mimi_conv_stack_tc
+ * stores them (dec_in's output is f32, later stages follow act_bf16). */
+static size_t mimi_stream_init_tc(ptts_mimi_stream *st) {
+    const ptts_mimi *mm = st->mm;
+    size_t act = st->act_bf16 ? sizeof(uint16_t) : sizeof(float);
+    size_t n = hist_init(&st->hist[MIMI_HIST_UPSAMPLE], convtr1d_hist_rows(&mm->upsample),
+                         mm->upsample.in_ch, sizeof(float));
+    n += hist_init(&st->hist[MIMI_HIST_DEC_IN], conv1d_hist_rows(&mm->dec_in),
+                   mm->dec_in.in_ch, sizeof(float));
+    for (int i = 0; i < 3; i++) {
+        const ptts_resblock *rb = &mm->res[i];
+        n += hist_init(&st->hist[MIMI_HIST_UP + i], convtr1d_hist_rows(&mm->up[i]),
+                       mm->up[i].in_ch, i == 0 ? sizeof(float) : act);
+        n += hist_init(&st->hist[MIMI_HIST_CONV1 + i], conv1d_hist_rows(&rb->conv1),
+                       rb->conv1.in_ch, act);
+        n += hist_init(&st->hist[MIMI_HIST_CONV2 + i], conv1d_hist_rows(&rb->conv2),
+                       rb->conv2.in_ch, act);
+    }
+    n += hist_init(&st->hist[MIMI_HIST_DEC_OUT], conv1d_hist_rows(&mm->dec_out),
+                   mm->dec_out.in_ch, act);
+    return n;
+}
+
+/* Channel-major state: conv inputs and convtr overlap tails, [C, rows]. */
+static size_t mimi_stream_init_chw(ptts_mimi_stream *st) {
+    const ptts_mimi *mm = st->mm;
+    size_t len = (size_t)mm->upsample.out_ch * (mm->upsample.k - mm->upsample.stride);
+    size_t n = len;
+    st->upsample_tail = zeros_f32(len);
+    len = (size_t)mm->dec_in.in_ch * (mm->dec_in.k - 1);
+    st->dec_in_hist = zeros_f32(len);
+    n += len;
+    len = (size_t)mm->dec_out.in_ch * (mm->dec_out.k - 1);
+    st->dec_out_hist = zeros_f32(len);
+    n += len;
+    for (int i = 0; i < 3; i++) {
+        len = (size_t)mm->up[i].out_ch * (mm->up[i].k - mm->up[i].stride);
+        st->up_tail[i] = zeros_f32(len);
+        n += len;
+        len = (size_t)mm->res[i].conv1.in_ch * (mm->res[i].conv1.k - 1);
+        st->res_hist[i] = zeros_f32(len);
+        n += len;
+    }
+    return n * sizeof(float);
+}
+
+ptts_mimi_stream *ptts_mimi_stream_create(ptts_mimi *mm) {
+    if (!mm) return NULL;
+    ptts_mimi_stream *st = (ptts_mimi_stream *)calloc(1, sizeof(ptts_mimi_stream));
+    if (!st) return NULL;
+    st->mm = mm;
+    st->channels_last = mm->layout == PTTS_MIMI_LAYOUT_CHANNELS_LAST;
+    st->act_bf16 = mm->precision != PTTS_MIMI_PRECISION_F32;
+    int ok = 1;
+    for (int l = 0; l < MIMI_NUM_LAYERS; l++) {
+        st->attn.k[l] = zeros_f32((size_t)(MIMI_CONTEXT - 1) * MIMI_D_MODEL);
+        st->attn.v[l] = zeros_f32((size_t)(MIMI_CONTEXT - 1) * MIMI_D_MODEL);
+        ok = ok && st->attn.k[l] && st->attn.v[l];
+    }
+    st->state_bytes = (size_t)MIMI_NUM_LAYERS * 2 * (MIMI_CONTEXT - 1) * MIMI_D_MODEL *
+                      sizeof(float);
+    if (st->channels_last) {
+        st->state_bytes += mimi_stream_init_tc(st);
+        for (int l = 0; l < MIMI_NUM_HIST; l++) ok = ok && st->hist[l].rows;
+    } else {
+        st->state_bytes += mimi_stream_init_chw(st);
+        ok = ok && st->upsample_tail && st->dec_in_hist && st->dec_out_hist;
+        for (int i = 0; i < 3; i++) ok = ok && st->up_tail[i] && st->res_hist[i];
+    }
+    if (!ok) {
+        ptts_mimi_stream_free(st);
+        return NULL;
+    }
+    return st;
+}
+
+void ptts_mimi_stream_free(ptts_mimi_stream *st) {
+    if (!st) return;
+    for (int l = 0; l < MIMI_NUM_LAYERS; l++) {
+        free(st->attn.k[l]);
+        free(st->attn.v[l]);
+    }
+    for (int l = 0; l < MIMI_NUM_HIST; l++) free(st->hist[l].rows);
+    free(st->upsample_tail);
+    free(st->dec_in_hist);
+    free(st->dec_out_hist);
+    for (int i = 0; i < 3; i++) {
+        free(st->up_tail[i]);
+        free(st->res_hist[i]);
+    }
+    free(st);
+}
+
+/* Carried state is stored for the decoder's precision at creation. */
+static int mimi_stream_usable(const ptts_mimi_stream *st) {
+    return !st->channels_last ||
+           st->act_bf16 == (st->mm->precision != PTTS_MIMI_PRECISION_F32);
+}
+
+static int resblock_forward_stream(const ptts_resblock *rb, float *hist, float *x, int T) {
+    int dim = rb->dim;
+    int c1_out = rb->conv1.out_ch;
+    float *tmp = (float *)malloc((size_t)dim * T * sizeof(float));
+    float *tmp2 = (float *)malloc((size_t)c1_out * T * sizeof(float));
+    if (!tmp || !tmp2) { free(tmp); free(tmp2); return -1; }
+
+    memcpy(tmp, x, (size_t)dim * T * sizeof(float));
+    elu_inplace(tmp, dim * T);
+    ptts_conv1d_stream_forward(tmp2, hist, tmp, rb->conv1.w, rb->conv1.b, rb->conv1.in_ch,
+                               rb->conv1.out_ch, T, rb->conv1.k, rb->conv1.groups);
+    elu_inplace(tmp2, c1_out * T);
+    conv1d_forward_stream(&rb->conv2, tmp2, T, tmp);
+
+    ptts_add_inplace(x, tmp, dim * T);
+
+    free(tmp); free(tmp2);
+    return 0;
+}
+
+/* Upsampling stage: convtr with carried tail, then the residual block. */
+static float *upstage_forward_stream(const ptts_convtr1d *up, float *tail,
+                                     const ptts_resblock *rb, float *hist,
+                                     const float *x, int T) {
+    int t_out = T * up->stride;
+    float *y = (float *)malloc((size_t)up->out_ch * t_out * sizeof(float));
+    if (!y) return NULL;
+    if (ptts_convtr1d_stream_forward(y, tail, x, up->w, up->b, up->in_ch, up->out_ch, T,
+                                     up->k, up->stride, up->groups) != 0 ||
+        resblock_forward_stream(rb, hist, y, t_out) != 0) {
+        free(y);
+        return NULL;
+    }
+    return y;
+}
+
+/* Channel-major streaming front half: quantizer projection and upsampling
+ * with the carried tail. Returns the transformer input as
+ * [frames * stride, 512]. */
+static float *mimi_stream_upsample(ptts_mimi_stream *st, const float *latents, int frames) {
+    ptts_mimi *mm = st->mm;
+    float *q = (float *)malloc((size_t)MIMI_D_MODEL * frames * sizeof(float));
+    if (!q) return NULL;
+    for (int o = 0; o < MIMI_D_MODEL; o++) {
+        const float *wrow = mm->quant_w + o * 32;
+        float *dst = q + (size_t)o * frames;
+        for (int t = 0; t < frames; t++) {
+            const float *lat = latents + (size_t)t * 32;
+            float sum = 0.0f;
+            for (int i = 0; i < 32; i++) sum += wrow[i] * lat[i];
+            dst[t] = sum;
+        }
+    }
+
+    int T = frames * mm->upsample.stride;
+    float *up = (float *)malloc((size_t)MIMI_D_MODEL * T * sizeof(float));
+    float *up_t = (float *)malloc((size_t)T * MIMI_D_MODEL * sizeof(float));
+    if (!up || !up_t ||
+        ptts_convtr1d_stream_forward(up, st->upsample_tail, q, mm->upsample.w, mm->upsample.b,
+                                     mm->upsample.in_ch, mm->upsample.out_ch, frames,
+                                     mm->upsample.k, mm->upsample.stride,
+                                     mm->upsample.groups) != 0) {
+        free(q); free(up); free(up_t);
+        return NULL;
+    }
+    free(q);
+
+    chw_to_thw(up, MIMI_D_MODEL, T, up_t);
+    free(up);
+    return up_t;
+}
+
+/* Channel-major streaming back half: transformer output ([T, 512]) through
+ * the conv stack with carried history. */
+static int mimi_stream_convs(ptts_mimi_stream *st, const float *up_t, int T,
+                             float *out_audio, int *out_len) {
+    ptts_mimi *mm = st->mm;
+    float *up = (float *)malloc((size_t)MIMI_D_MODEL * T * sizeof(float));
+    if (!up) return -1;
+    thw_to_chw(up_t, T, MIMI_D_MODEL, up);
+
+    float *x = (float *)malloc((size_t)mm->dec_in.out_ch * T * sizeof(float));
+    if (!x) { free(up); return -1; }
+    ptts_conv1d_stream_forward(x, st->dec_in_hist, up, mm->dec_in.w, mm->dec_in.b,
+                               mm->dec_in.in_ch, mm->dec_in.out_ch, T, mm->dec_in.k,
+                               mm->dec_in.groups);
+    free(up);
+
+    int dim = mm->dec_in.out_ch;
+    for (int i = 0; i < 3; i++) {
+        elu_inplace(x, dim * T);
+        float *y = upstage_forward_stream(&mm->up[i], st->up_tail[i], &mm->res[i],
+                                          st->res_hist[i], x, T);
+        free(x);
+        if (!y) return -1;
+        x = y;
+        T *= mm->up[i].stride;
+        dim = mm->res[i].dim;
+    }
+
+    elu_inplace(x, dim * T);
+    ptts_conv1d_stream_forward(out_audio, st->dec_out_hist, x, mm->dec_out.w, mm->dec_out.b,
+                               mm->dec_out.in_ch, mm->dec_out.out_ch, T, mm->dec_out.k,
+                               mm->dec_out.groups);
+    free(x);
+    *out_len = T;
+    return 0;
+}
+
+/* Channel-major streaming step: transposes around the transformer and
+ * per-stage buffers, as in the channel-major one-shot decode. */
+static int mimi_stream_decode_chw(ptts_mimi_stream *st, const float *latents, int frames,
+                                  float *out_audio, int *out_len) {
+    int T = frames * st->mm->upsample.stride;
+    double t0 = ptts_time_ms();
+    PTTS_TRACE_BEGIN(t_up);
+    float *up_t = mimi_stream_upsample(st, latents, frames);
+    if (!up_t) return -1;
+    PTTS_TRACE_END(t_up, "mimi.upsample", frames);
+    double t_tr = ptts_time_ms();
+    PTTS_TRACE_BEGIN(t_trace);
+    if (transformer_forward_kv(st->mm, up_t, T, 0, &st->attn) != 0) {
+        free(up_t);
+        return -1;
+    }
+    PTTS_TRACE_END(t_trace, "mimi.transformer", frames);
+    double tr_ms = ptts_time_ms() - t_tr;
+    PTTS_TRACE_BEGIN(t_conv);
+    int rc = mimi_stream_convs(st, up_t, T, out_audio, out_len);
+    PTTS_TRACE_END(t_conv, "mimi.conv_stack", frames);
+    free(up_t);
+    mimi_run_stats_add(&st->stats, tr_ms, ptts_time_ms() - t0 - tr_ms,
+                       st->state_bytes + mimi_chw_stack_bytes(st->mm, T));
+    return rc;
+}
+
+/* Channels-last streaming step: the one-shot decode's workspace and fused
+ * kernels, with every conv reading its carried rows from the lead room in
+ * front of its input (PTTS_CONV_IN_HIST). */
+static int mimi_stream_decode_tc(ptts_mimi_stream *st, const float *latents, int frames,
+                                 float *out_audio, int *out_len) {
+    ptts_mimi *mm = st->mm;
+    double t0 = ptts_time_ms();
+    mimi_workspace *ws = mimi_ws_acquire(mm, frames);
+    if (!ws) return -1;
+    int T = frames * mm->upsample.stride;
+    float *x = ws_buf(ws, MIMI_BUF_UP);
+    PTTS_TRACE_BEGIN(t_up);
+    mimi_upsample_tc(mm, ws, latents, frames, x, st->hist);
+    PTTS_TRACE_END(t_up, "mimi.upsample", frames);
+    double t_tr = ptts_time_ms();
+    PTTS_TRACE_BEGIN(t_trace);
+    if (transformer_forward_kv(mm, x, T, 0, &st->attn) != 0) {
+        mimi_ws_release(mm, ws);
+        return -1;
+    }
+    PTTS_TRACE_END(t_trace, "mimi.transformer", frames);
+    double tr_ms = ptts_time_ms() - t_tr;
+    PTTS_TRACE_BEGIN(t_conv);
+    *out_len = mimi_conv_stack_tc(mm, ws, x, T, out_audio, NULL, st->hist);
+    PTTS_TRACE_END(t_conv, "mimi.conv_stack", frames);
+    mimi_run_stats_add(&st->stats, tr_ms, ptts_time_ms() - t0 - tr_ms,
+                       st->state_bytes + mimi_plan_bytes(&ws->plan));
+    mimi_ws_release(mm, ws);
+    return 0;
+}
+
+int ptts_mimi_stream_decode(ptts_mimi_stream *st, const float *latents, int frames,
+                            float *out_audio, int *out_len) {
+    if (!st || !latents || !out_audio || !out_len || frames < 1) return -1;
+    if (!mimi_stream_usable(st)) return -1;
+    if (st->channels_last) return mimi_stream_decode_tc(st, latents, frames, out_audio, out_len);
+    return mimi_stream_decode_chw(st, latents, frames, out_audio, out_len);
+}
+
+void ptts_mimi_stream_get_stats(const ptts_mimi_stream *st, ptts_mimi_run_stats *out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (st) *out = st->stats;
+}
+
+int ptts_mimi_stream_decode_batch(ptts_mimi_stream *const *st, int n,
+                                  const float *const *latents, const int *frames,
+                                  float *const *out_audio, int *out_len) {
+    if (!st || n < 1 || !latents || !frames || !out_audio || !out_len) return -1;
+    for (int i = 0; i < n; i++) {
+        if (!st[i] || st[i]->mm != st[0]->mm || st[i]->channels_last != st[0]->channels_last ||
+            !mimi_stream_usable(st[i]) || !latents[i] || !out_audio[i] || frames[i] < 1) {
+            return -1;
+        }
+    }
+    if (n == 1) return ptts_mimi_stream_decode(st[0], latents[0], frames[0], out_audio[0], out_len);
+
+    ptts_mimi *mm = st[0]->mm;
+    int tc = st[0]->channels_last;
+    int stride = mm->upsample.stride;
+    int total_t = 0;
+    for (int i = 0; i < n; i++) total_t += frames[i] * stride;
+
+    mimi_seq *seqs = (mimi_seq *)calloc((size_t)n, sizeof(mimi_seq));
+    mimi_workspace **ws = (mimi_workspace **)calloc((size_t)n, sizeof(mimi_workspace *));
+    float *x = (float *)malloc((size_t)total_t * MIMI_D_MODEL * sizeof(float));
+    int rc = -1;
+    if (!seqs || !ws || !x) goto done;
+
+    /* Channels-last streams upsample straight into their stacked rows and
+     * copy the transformer output back in front of their workspace's lead
+     * room, which dec_in's history needs. */
+    float *row = x;
+    for (int i = 0; i < n; i++) {
+        seqs[i].T = frames[i] * stride;
+        seqs[i].kv = &st[i]->attn;
+        if (tc) {
+            ws[i] = mimi_ws_acquire(mm, frames[i]);
+            if (!ws[i]) goto done;
+            mimi_upsample_tc(mm, ws[i], latents[i], frames[i], row, st[i]->hist);
+        } else {
+            float *up_t = mimi_stream_upsample(st[i], latents[i], frames[i]);
+            if (!up_t) goto done;
+            memcpy(row, up_t, (size_t)seqs[i].T * MIMI_D_MODEL * sizeof(float));
+            free(up_t);
+        }
+        row += (size_t)seqs[i].T * MIMI_D_MODEL;
+    }
+
+    rc = transformer_forward_seqs(mm, x, n, seqs);
+    row = x;
+    for (int i = 0; i < n && rc == 0; i++) {
+        if (tc) {
+            float *up = ws_buf(ws[i], MIMI_BUF_UP);
+            memcpy(up, row, (size_t)seqs[i].T * MIMI_D_MODEL * sizeof(float));
+            out_len[i] = mimi_conv_stack_tc(mm, ws[i], up, seqs[i].T, out_audio[i], NULL,
+                                            st[i]->hist);
+        } else {
+            rc = mimi_stream_convs(st[i], row, seqs[i].T, out_audio[i], &out_len[i]);
+        }
+        row += (size_t)seqs[i].T * MIMI_D_MODEL;
+    }
+
+done:
+    if (ws) {
+        for (int i = 0; i < n; i++) {
+            if (ws[i]) mimi_ws_release(mm, ws[i]);
+        }
+    }
+    free(seqs); free(ws); free(x);
+    return rc;
+}
@@ -1,6 +1,7 @@
 #ifndef PTTS_MIMI_H
 #define PTTS_MIMI_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include "ptts.h"
 
@@ -8,11 +9,61 @@
 extern "C" {
 #endif
 
+/* Output samples per latent frame (80 ms @ 24kHz). */
+#define PTTS_MIMI_FRAME_SAMPLES 1920
+
 typedef struct ptts_mimi ptts_mimi;
 
+/* Activation layout of the CPU ptts_mimi_decode path. */
+typedef enum {
+    PTTS_MIMI_LAYOUT_CHANNELS_FIRST = 0, /* [C, T] */
+    PTTS_MIMI_LAYOUT_CHANNELS_LAST = 1   /* [T, C] */
+} ptts_mimi_layout;
+
 ptts_mimi *ptts_mimi_load(ptts_ctx *ctx);
 void ptts_mimi_free(ptts_mimi *mm);
 
+/* Map the converted weights read-only; layout packs and quantized copies
+ * made later stay ordinary heap memory. */
+int ptts_mimi_protect_weights(ptts_mimi *mm);
+
+/* Select the decode layout (initially from PTTS_MIMI_LAYOUT=chw|thw).
+ * Channels-last repacks the conv weights on first use; returns -1 on OOM. */
+int ptts_mimi_set_layout(ptts_mimi *mm, ptts_mimi_layout layout);
+ptts_mimi_layout ptts_mimi_get_layout(const ptts_mimi *mm);
+
+/* Hand each conv's channels-last weight packing to emit() as
+ * "<weight tensor>.tc" (n floats), for ptts_pack_model. A packed model that
+ * carries them skips the repack at load. Returns 0, the first nonzero
+ * emit() result, or -1 on OOM. */
+typedef int (*ptts_mimi_emit_fn)(void *user, const char *name, const float *data, size_t n);
+int ptts_mimi_export_packed(ptts_mimi *mm, ptts_mimi_emit_fn emit, void *user);
+
+/* Time each k=3/k=7 conv1d of the channels-last decoder at its rate for
+ * `frames` latent frames, specialized kernel vs the generic one, and print
+ * the speedup and max abs difference to stdout. */
+int ptts_mimi_conv_report(ptts_mimi *mm, int frames);
+
+/* Numeric precision of the decoder. Below F32 the transformer projections
+ * use BF16 or per-row INT8 weights (f32 accumulation) and the channels-last
+ * upsampling stages keep their activations in BF16. Conv weights, norms,
+ * attention and the transformer residual stream stay f32. */
+typedef enum {
+    PTTS_MIMI_PRECISION_F32 = 0,
+    PTTS_MIMI_PRECISION_BF16 = 1,
+    PTTS_MIMI_PRECISION_INT8 = 2
+} ptts_mimi_precision;
+
+/* Select the precision (initially from PTTS_MIMI_PRECISION=f32|bf16|int8).
+ * Quantized weight copies are built on first use; returns -1 on OOM. */
+int ptts_mimi_set_precision(ptts_mimi *mm, ptts_mimi_precision precision);
+ptts_mimi_precision ptts_mimi_get_precision(const ptts_mimi *mm);
+
+/* Decode `frames` random latents on the channels-last path at each
+ * precision and print per-stage times, speedups over f32, and audio SNR /
+ * max abs diff against the f32 output to stdout. */
+int ptts_mimi_precision_report(ptts_mimi *mm, int frames);
+
 /*
  * Run a minimal Mimi decode stage: quantizer output projection + decoder transformer.
  * latent: length 32, output: length 512.
@@ -22,10 +73,66 @@ int ptts_mimi_forward_one(ptts_mimi *mm, const float *latent, float *out_embed);
 /* Decode a single FlowLM latent frame into raw audio (80 ms @ 24kHz). */
 int ptts_mimi_decode_one(ptts_mimi *mm, const float *latent, float *out_audio, int *out_len);
 
-/* Decode a sequence of FlowLM latents into raw audio. */
+/*
+ * Decode a sequence of FlowLM latents into raw audio. Long sequences are cut
+ * into PTTS_MIMI_CHUNK-frame chunks (default 64, 0 = one pass) decoded on
+ * PTTS_MIMI_THREADS threads, each with enough earlier frames to cover the
+ * decoder's receptive field; the stitched output is sample-identical to a
+ * one-pass decode and working memory is bounded by the chunk size.
+ */
 int ptts_mimi_decode(ptts_mimi *mm, const float *latents, int frames,
                      float *out_audio, int *out_len);
 
+/* Decode-side counters behind ptts_stats. Upsampling counts as conv time;
+ * a chunked decode adds up its threads' times and working sets. On the
+ * channel-major and streaming paths scratch_bytes is worked out from the
+ * buffer sizes (streams include their carried state). */
+typedef struct {
+    double transformer_ms;
+    double conv_ms;
+    size_t scratch_bytes; /* peak activation working set */
+} ptts_mimi_run_stats;
+
+/* ptts_mimi_decode, filling rs (may be NULL). */
+int ptts_mimi_decode_stats(ptts_mimi *mm, const float *latents, int frames,
+                           float *out_audio, int *out_len, ptts_mimi_run_stats *rs);
+
+/*
+ * Decode n independent latent sequences in one call. The transformer's
+ * norms, projections and MLP run once over all sequences' rows stacked
+ * together; attention windows and conv stacks stay per sequence, so each
+ * output matches ptts_mimi_decode on that sequence alone. Sequences longer
+ * than the chunk size (and every sequence on a channels-first decoder) fall
+ * back to ptts_mimi_decode. out_len[i] receives frames[i] * 1920.
+ */
+int ptts_mimi_decode_batch(ptts_mimi *mm, int n, const float *const *latents,
+                           const int *frames, float *const *out_audio, int *out_len);
+
+/*
+ * Incremental decoder. Latent frames are fed in order, in chunks of any size;
+ * each call emits frames * 1920 samples. Convolution and attention state is
+ * carried across calls, so the concatenated output matches ptts_mimi_decode
+ * over all frames (up to float rounding). Runs on the CPU path, in the
+ * decoder's layout and precision at creation (decode fails if the precision
+ * has changed since).
+ */
+typedef struct ptts_mimi_stream ptts_mimi_stream;
+
+ptts_mimi_stream *ptts_mimi_stream_create(ptts_mimi *mm);
+void ptts_mimi_stream_free(ptts_mimi_stream *st);
+int ptts_mimi_stream_decode(ptts_mimi_stream *st, const float *latents, int frames,
+                            float *out_audio, int *out_len);
+
+/* Totals over this stream's ptts_mimi_stream_decode calls. */
+void ptts_mimi_stream_get_stats(const ptts_mimi_stream *st, ptts_mimi_run_stats *out);
+
+/* Advance n streams of the same decoder together, sharing the transformer
+ * GEMMs as in ptts_mimi_decode_batch. Each stream keeps its own attention
+ * history and conv state; results match n separate stream_decode calls. */
+int ptts_mimi_stream_decode_batch(ptts_mimi_stream *const *st, int n,
+                                  const float *const *latents, const int *frames,
+                                  float *const *out_audio, int *out_len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,367 @@
+/*
+ * ptts_prefix_cache.c - Radix-tree KV prefix cache
+ */
+
+#include "ptts_prefix_cache.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct prefix_node {
+    struct prefix_node *parent;
+    struct prefix_node **children;
+    int num_children;
+    int cap_children;
+    uint64_t voice_key; /* depth-1 (voice) nodes only */
+    int *tokens;        /* edge label, NULL for voice nodes */
+    int num_tokens;
+    int num_pos;        /* positions covered by this edge */
+    float *kv;          /* [num_layers][2][num_pos][row_dim] */
+    uint64_t last_used;
+} prefix_node;
+
+struct ptts_prefix_cache {
+    pthread_mutex_t lock;
+    int num_layers;
+    int row_dim;
+    prefix_node root;
+    uint64_t clock;
+    ptts_prefix_cache_stats stats;
+};
+
+/* ========================================================================
+ * Node helpers
+ * ======================================================================== */
+
+static size_t node_bytes(const ptts_prefix_cache *pc, int num_pos) {
+    return (size_t)num_pos * pc->row_dim * 2 * pc->num_layers * sizeof(float);
+}
+
+static float *node_rows(const ptts_prefix_cache *pc, const prefix_node *n, int layer, int is_v) {
+    return n->kv + ((size_t)(layer * 2 + is_v) * n->num_pos) * pc->row_dim;
+}
+
+/* Copy the caller's rows [src_pos, src_pos + num_pos) into the node. */
+static void node_fill(const ptts_prefix_cache *pc, prefix_node *n,
+                      ptts_kv_row_fn row, void *user, int src_pos) {
+    size_t row_bytes = (size_t)pc->row_dim * sizeof(float);
+    for (int l = 0; l < pc->num_layers; l++) {
+        for (int is_v = 0; is_v < 2; is_v++) {
+            float *dst = node_rows(pc, n, l, is_v);
+            for (int p = 0; p < n->num_pos; p++) {
+                memcpy(dst + (size_t)p * pc->row_dim, row(user, l, is_v, src_pos + p), row_bytes);
+            }
+        }
+    }
+}
+
+static void node_copy_out(const ptts_prefix_cache *pc, const prefix_node *n, int count,
+                          ptts_kv_row_fn row, void *user, int dst_pos) {
+    size_t row_bytes = (size_t)pc->row_dim * sizeof(float);
+    for (int l = 0; l < pc->num_layers; l++) {
+        for (int is_v = 0; is_v < 2; is_v++) {
+            const float *src = node_rows(pc, n, l, is_v);
+            for (int p = 0; p < count; p++) {
+                memcpy(row(user, l, is_v, dst_pos + p), src + (size_t)p * pc->row_dim, row_bytes);
+            }
+        }
+    }
+}
+
+static prefix_node *node_new(ptts_prefix_cache *pc, prefix_node *parent, int num_pos) {
+    prefix_node *n = (prefix_node *)calloc(1, sizeof(prefix_node));
+    if (!n) return NULL;
+    n->num_pos = num_pos;
+    if (num_pos > 0) {
+        n->kv = (float *)malloc(node_bytes(pc, num_pos));
+        if (!n->kv) {
+            free(n);
+            return NULL;
+        }
+    }
+    if (parent->num_children >= parent->cap_children) {
+        int new_cap = parent->cap_children ? parent->cap_children * 2 : 4;
+        prefix_node **nc = (prefix_node **)realloc(parent->children,
+                                                   (size_t)new_cap * sizeof(prefix_node *));
+        if (!nc) {
+            free(n->kv);
+            free(n);
+            return NULL;
+        }
+        parent->children = nc;
+        parent->cap_children = new_cap;
+    }
+    parent->children[parent->num_children++] = n;
+    n->parent = parent;
+    pc->stats.bytes += node_bytes(pc, num_pos);
+    pc->stats.nodes++;
+    return n;
+}
+
+static void node_unlink(prefix_node *n) {
+    prefix_node *p = n->parent;
+    for (int i = 0; i < p->num_children; i++) {
+        if (p->children[i] == n) {
+            p->children[i] = p->children[--p->num_children];
+            break;
+        }
+    }
+}
+
+/* Free n and its subtree (n must already be unlinked unless it is the root). */
+static void node_free_tree(ptts_prefix_cache *pc, prefix_node *n) {
+    for (int i = 0; i < n->num_children; i++) node_free_tree(pc, n->children[i]);
+    free(n->children);
+    n->children = NULL;
+    n->num_children = 0;
+    if (n != &pc->root) {
+        pc->stats.bytes -= node_bytes(pc, n->num_pos);
+        pc->stats.nodes--;
+        free(n->tokens);
+        free(n->kv);
+        free(n);
+    }
+}
+
+static prefix_node *find_voice(const ptts_prefix_cache *pc, uint64_t key, int voice_len) {
+    for (int i = 0; i < pc->root.num_children; i++) {
+        prefix_node *c = pc->root.children[i];
+        if (c->voice_key == key && c->num_pos == voice_len) return c;
+    }
+    return NULL;
+}
+
+static prefix_node *find_child(const prefix_node *n, int token) {
+    for (int i = 0; i < n->num_children; i++) {
+        if (n->children[i]->tokens[0] == token) return n->children[i];
+    }
+    return NULL;
+}
+
+static int common_len(const int *a, int na, const int *b, int nb) {
+    int m = 0;
+    while (m < na && m < nb && a[m] == b[m]) m++;
+    return m;
+}
+
+static void touch_path(ptts_prefix_cache *pc, prefix_node *n) {
+    uint64_t now = ++pc->clock;
+    for (; n && n != &pc->root; n = n->parent) n->last_used = now;
+}
+
+/* Split child's edge after m tokens; returns the new upper node. */
+static prefix_node *node_split(ptts_prefix_cache *pc, prefix_node *child, int m) {
+    prefix_node *parent = child->parent;
+    int rest = child->num_tokens - m;
+    int *lower_tokens = (int *)malloc((size_t)rest * sizeof(int));
+    float *lower_kv = (float *)malloc(node_bytes(pc, rest));
+    int *upper_tokens = (int *)malloc((size_t)m * sizeof(int));
+    if (!lower_tokens || !lower_kv || !upper_tokens) {
+        free(lower_tokens); free(lower_kv); free(upper_tokens);
+        return NULL;
+    }
+    node_unlink(child);
+    prefix_node *upper = node_new(pc, parent, m);
+    if (!upper) {
+        parent->children[parent->num_children++] = child;
+        free(lower_tokens); free(lower_kv); free(upper_tokens);
+        return NULL;
+    }
+    size_t row = (size_t)pc->row_dim;
+    for (int l = 0; l < pc->num_layers; l++) {
+        for (int is_v = 0; is_v < 2; is_v++) {
+            const float *src = node_rows(pc, child, l, is_v);
+            memcpy(node_rows(pc, upper, l, is_v), src, (size_t)m * row * sizeof(float));
+            memcpy(lower_kv + ((size_t)(l * 2 + is_v) * rest) * row, src + (size_t)m * row,
+                   (size_t)rest * row * sizeof(float));
+        }
+    }
+    memcpy(upper_tokens, child->tokens, (size_t)m * sizeof(int));
+    memcpy(lower_tokens, child->tokens + m, (size_t)rest * sizeof(int));
+    upper->tokens = upper_tokens;
+    upper->num_tokens = m;
+    upper->last_used = child->last_used;
+
+    pc->stats.bytes -= node_bytes(pc, child->num_pos);
+    free(child->tokens);
+    free(child->kv);
+    child->tokens = lower_tokens;
+    child->num_tokens = rest;
+    child->num_pos = rest;
+    child->kv = lower_kv;
+    pc->stats.bytes += node_bytes(pc, rest);
+
+    upper->children = (prefix_node **)malloc(4 * sizeof(prefix_node *));
+    if (upper->children) {
+        upper->cap_children = 4;
+        upper->children[upper->num_children++] = child;
+        child->parent = upper;
+    } else {
+        /* keep the tree consistent: drop the lower half */
+        node_free_tree(pc, child);
+    }
+    return upper;
+}
+
+static prefix_node *lru_leaf(prefix_node *n, prefix_node *best) {
+    for (int i = 0; i < n->num_children; i++) {
+        prefix_node *c = n->children[i];
+        if (c->num_children == 0) {
+            if (!best || c->last_used < best->last_used) best = c;
+        } else {
+            best = lru_leaf(c, best);
+        }
+    }
+    return best;
+}
+
+static void evict_to_budget(ptts_prefix_cache *pc) {
+    while (pc->stats.bytes > pc->stats.max_bytes) {
+        prefix_node *victim = lru_leaf(&pc->root, NULL);
+        if (!victim) break;
+        node_unlink(victim);
+        pc->stats.evictions++;
+        node_free_tree(pc, victim);
+    }
+}
+
+/* ========================================================================
+ * Public API
+ * ======================================================================== */
+
+ptts_prefix_cache *ptts_prefix_cache_create(int num_layers, int row_dim, size_t max_bytes) {
+    if (num_layers <= 0 || row_dim <= 0 || max_bytes == 0) return NULL;
+    ptts_prefix_cache *pc = (ptts_prefix_cache *)calloc(1, sizeof(ptts_prefix_cache));
+    if (!pc) return NULL;
+    if (pthread_mutex_init(&pc->lock, NULL) != 0) {
+        free(pc);
+        return NULL;
+    }
+    pc->num_layers = num_layers;
+    pc->row_dim = row_dim;
+    pc->stats.max_bytes = max_bytes;
+    return pc;
+}
+
+void ptts_prefix_cache_free(ptts_prefix_cache *pc) {
+    if (!pc) return;
+    node_free_tree(pc, &pc->root);
+    pthread_mutex_destroy(&pc->lock);
+    free(pc);
+}
+
+uint64_t ptts_prefix_cache_voice_key(const float *cond, size_t n) {
+    /* FNV-1a over the raw bytes */
+    uint64_t h = 1469598103934665603ULL;
+    const unsigned char *p = (const unsigned char *)cond;
+    size_t bytes = cond ? n * sizeof(float) : 0;
+    for (size_t i = 0; i < bytes; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    h ^= (uint64_t)n;
+    h *= 1099511628211ULL;
+    return h;
+}
+
+int ptts_prefix_cache_lookup(ptts_prefix_cache *pc, uint64_t voice_key, int voice_len,
+                             const int *tokens, int num_tokens,
+                             ptts_kv_row_fn row, void *user) {
+    if (!pc || voice_len < 0 || num_tokens < 0 || !row) return 0;
+    pthread_mutex_lock(&pc->lock);
+    pc->stats.lookups++;
+
+    int pos = 0;
+    prefix_node *node = find_voice(pc, voice_key, voice_len);
+    if (node) {
+        node_copy_out(pc, node, voice_len, row, user, 0);
+        touch_path(pc, node);
+        pos = voice_len;
+        int i = 0;
+        while (i < num_tokens) {
+            prefix_node *child = find_child(node, tokens[i]);
+            if (!child) break;
+            int m = common_len(child->tokens, child->num_tokens, tokens + i, num_tokens - i);
+            node_copy_out(pc, child, m, row, user, pos);
+            touch_path(pc, child);
+            pos += m;
+            i += m;
+            if (m < child->num_tokens) break;
+            node = child;
+        }
+    }
+
+    if (pos > 0) pc->stats.hits++;
+    pc->stats.reused_positions += (uint64_t)pos;
+    pthread_mutex_unlock(&pc->lock);
+    return pos;
+}
+
+void ptts_prefix_cache_insert(ptts_prefix_cache *pc, uint64_t voice_key, int voice_len,
+                              const int *tokens, int num_tokens,
+                              ptts_kv_row_fn row, void *user, int computed) {
+    if (!pc || voice_len < 0 || num_tokens < 0 || !row) return;
+    pthread_mutex_lock(&pc->lock);
+    if (computed > 0) pc->stats.computed_positions += (uint64_t)computed;
+
+    /* A prefix larger than the whole budget would only evict everything. */
+    if (node_bytes(pc, voice_len + num_tokens) > pc->stats.max_bytes) {
+        pthread_mutex_unlock(&pc->lock);
+        return;
+    }
+
+    prefix_node *node = find_voice(pc, voice_key, voice_len);
+    if (!node) {
+        node = node_new(pc, &pc->root, voice_len);
+        if (!node) {
+            pthread_mutex_unlock(&pc->lock);
+            return;
+        }
+        node->voice_key = voice_key;
+        node_fill(pc, node, row, user, 0);
+    }
+    touch_path(pc, node);
+
+    int pos = voice_len;
+    int i = 0;
+    while (i < num_tokens) {
+        prefix_node *child = find_child(node, tokens[i]);
+        if (!child) {
+            int rest = num_tokens - i;
+            prefix_node *leaf = node_new(pc, node, rest);
+            if (!leaf) break;
+            leaf->tokens = (int *)malloc((size_t)rest * sizeof(int));
+            if (!leaf->tokens) {
+                node_unlink(leaf);
+                node_free_tree(pc, leaf);
+                break;
+            }
+            memcpy(leaf->tokens, tokens + i, (size_t)rest * sizeof(int));
+            leaf->num_tokens = rest;
+            node_fill(pc, leaf, row, user, pos);
+            touch_path(pc, leaf);
+            break;
+        }
+        int m = common_len(child->tokens, child->num_tokens, tokens + i, num_tokens - i);
+        if (m < child->num_tokens) {
+            child = node_split(pc, child, m);
+            if (!child) break;
+        }
+        touch_path(pc, child);
+        pos += m;
+        i += m;
+        node = child;
+    }
+
+    evict_to_budget(pc);
+    pthread_mutex_unlock(&pc->lock);
+}
+
+void ptts_prefix_cache_get_stats(ptts_prefix_cache *pc, ptts_prefix_cache_stats *out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!pc) return;
+    pthread_mutex_lock(&pc->lock);
+    *out = pc->stats;
+    pthread_mutex_unlock(&pc->lock);
+}
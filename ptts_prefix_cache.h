@@ -0,0 +1,62 @@
+#ifndef PTTS_PREFIX_CACHE_H
+#define PTTS_PREFIX_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Radix-tree cache of transformer KV rows for shared prompt prefixes.
+ *
+ * A prefix is (voice, token ids): the voice covers voice_len positions and
+ * each token one position. Nodes store per-layer K/V rows for the positions
+ * on their edge. Lookups copy the longest cached prefix into a caller's
+ * cache; inserts add what was computed. Memory is bounded by max_bytes with
+ * LRU eviction of leaves. All calls are thread-safe.
+ */
+
+typedef struct ptts_prefix_cache ptts_prefix_cache;
+
+/* Returns the row_dim floats of K (is_v = 0) or V (is_v = 1) at one position
+ * of the caller's cache. */
+typedef float *(*ptts_kv_row_fn)(void *user, int layer, int is_v, int pos);
+
+typedef struct {
+    uint64_t lookups;
+    uint64_t hits;             /* lookups that reused at least one position */
+    uint64_t reused_positions;
+    uint64_t computed_positions;
+    uint64_t evictions;
+    size_t bytes;
+    size_t max_bytes;
+    int nodes;
+} ptts_prefix_cache_stats;
+
+ptts_prefix_cache *ptts_prefix_cache_create(int num_layers, int row_dim, size_t max_bytes);
+void ptts_prefix_cache_free(ptts_prefix_cache *pc);
+
+/* Content hash identifying a voice conditioning prefix. */
+uint64_t ptts_prefix_cache_voice_key(const float *cond, size_t n);
+
+/* Copy the longest cached prefix into the caller's rows from position 0.
+ * Returns the number of positions filled (0 on miss). */
+int ptts_prefix_cache_lookup(ptts_prefix_cache *pc, uint64_t voice_key, int voice_len,
+                             const int *tokens, int num_tokens,
+                             ptts_kv_row_fn row, void *user);
+
+/* Record KV rows for positions [0, voice_len + num_tokens) read through row.
+ * computed is the number of positions the caller had to compute (for stats). */
+void ptts_prefix_cache_insert(ptts_prefix_cache *pc, uint64_t voice_key, int voice_len,
+                              const int *tokens, int num_tokens,
+                              ptts_kv_row_fn row, void *user, int computed);
+
+void ptts_prefix_cache_get_stats(ptts_prefix_cache *pc, ptts_prefix_cache_stats *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTTS_PREFIX_CACHE_H */
@@ -0,0 +1,303 @@
+/*
+ * ptts_prefork.c - Copy-on-write prefork workers behind a Unix socket
+ */
+
+#define _GNU_SOURCE
+#include "ptts_prefork.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#define PREFORK_MAX_REQUEST (1 << 16)
+
+typedef struct {
+    pid_t pid;
+    int restarts;
+    time_t started;
+} prefork_worker;
+
+static volatile sig_atomic_t stop_requested = 0;
+static volatile sig_atomic_t report_requested = 0;
+
+static void on_stop(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static void on_report(int sig) {
+    (void)sig;
+    report_requested = 1;
+}
+
+/* ========================================================================
+ * Memory accounting
+ * ======================================================================== */
+
+int ptts_proc_mem_read(int pid, ptts_proc_mem *mem) {
+    if (!mem) return -1;
+    char path[64];
+    if (pid > 0) {
+        snprintf(path, sizeof(path), "/proc/%d/smaps_rollup", pid);
+    } else {
+        snprintf(path, sizeof(path), "/proc/self/smaps_rollup");
+    }
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    memset(mem, 0, sizeof(*mem));
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        long kb = 0;
+        if (sscanf(line, "Rss: %ld kB", &kb) == 1) mem->rss_kb = kb;
+        else if (sscanf(line, "Pss: %ld kB", &kb) == 1) mem->pss_kb = kb;
+        else if (sscanf(line, "Private_Clean: %ld kB", &kb) == 1) mem->unique_kb += kb;
+        else if (sscanf(line, "Private_Dirty: %ld kB", &kb) == 1) mem->unique_kb += kb;
+    }
+    fclose(f);
+    return 0;
+}
+
+static void print_report(const prefork_worker *workers, int n) {
+    ptts_proc_mem m;
+    if (ptts_proc_mem_read(0, &m) == 0) {
+        fprintf(stderr, "[ptts] prefork parent  pid %d: unique %.1f MB, pss %.1f MB, rss %.1f MB\n",
+                (int)getpid(), m.unique_kb / 1024.0, m.pss_kb / 1024.0, m.rss_kb / 1024.0);
+    }
+    for (int i = 0; i < n; i++) {
+        if (workers[i].pid <= 0) continue;
+        if (ptts_proc_mem_read(workers[i].pid, &m) != 0) continue;
+        fprintf(stderr, "[ptts] prefork worker %d pid %d: unique %.1f MB, pss %.1f MB, "
+                "rss %.1f MB, restarts %d\n", i, (int)workers[i].pid, m.unique_kb / 1024.0,
+                m.pss_kb / 1024.0, m.rss_kb / 1024.0, workers[i].restarts);
+    }
+}
+
+/* ========================================================================
+ * Worker
+ * ======================================================================== */
+
+static void reply(int fd, const char *msg) {
+    size_t len = strlen(msg);
+    while (len > 0) {
+        ssize_t w = write(fd, msg, len);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        msg += w;
+        len -= (size_t)w;
+    }
+}
+
+static void handle_job(ptts_ctx *ctx, int fd, const char *voice, const ptts_params *params) {
+    char *req = (char *)malloc(PREFORK_MAX_REQUEST);
+    if (!req) {
+        reply(fd, "error out of memory\n");
+        return;
+    }
+    size_t len = 0;
+    while (len < PREFORK_MAX_REQUEST - 1) {
+        ssize_t r = read(fd, req + len, PREFORK_MAX_REQUEST - 1 - len);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) break;
+        len += (size_t)r;
+        if (memchr(req + len - r, '\n', (size_t)r)) break;
+    }
+    req[len] = '\0';
+    char *nl = strchr(req, '\n');
+    if (nl) *nl = '\0';
+
+    char *out_path = req;
+    char *text = strchr(req, '\t');
+    if (!text || text == req || !text[1]) {
+        reply(fd, "error expected OUT_PATH<TAB>TEXT[<TAB>SEED]\n");
+        free(req);
+        return;
+    }
+    *text++ = '\0';
+    ptts_params p = *params;
+    char *seed = strchr(text, '\t');
+    if (seed) {
+        *seed++ = '\0';
+        p.seed = atoll(seed);
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    ptts_audio *audio = ptts_generate(ctx, text, voice, &p);
+    char msg[512];
+    if (!audio) {
+        snprintf(msg, sizeof(msg), "error %s\n", ptts_get_error());
+    } else if (ptts_audio_save_wav(audio, out_path) != 0) {
+        snprintf(msg, sizeof(msg), "error cannot write %s\n", out_path);
+    } else {
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double ms = (t1.tv_sec - t0.tv_sec) * 1000.0 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+        ptts_proc_mem m = {0, 0, 0};
+        ptts_proc_mem_read(0, &m);
+        snprintf(msg, sizeof(msg), "ok samples=%d ms=%.1f uss_kb=%ld\n",
+                 audio->num_samples, ms, m.unique_kb);
+    }
+    ptts_audio_free(audio);
+    reply(fd, msg);
+    free(req);
+}
+
+static void worker_main(ptts_ctx *ctx, int listen_fd, const char *voice,
+                        const ptts_params *params) {
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGINT, SIG_IGN); /* the parent turns ^C into SIGTERM */
+    signal(SIGUSR1, SIG_IGN);
+    signal(SIGPIPE, SIG_IGN);
+#ifdef __linux__
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+#endif
+    if (getppid() == 1) _exit(0);
+    for (;;) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            _exit(1);
+        }
+        handle_job(ctx, fd, voice, params);
+        close(fd);
+    }
+}
+
+/* ========================================================================
+ * Supervisor
+ * ======================================================================== */
+
+static int spawn_worker(prefork_worker *w, ptts_ctx *ctx, int listen_fd, const char *voice,
+                        const ptts_params *params) {
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        worker_main(ctx, listen_fd, voice, params);
+        _exit(0);
+    }
+    w->pid = pid;
+    w->started = time(NULL);
+    return 0;
+}
+
+static int open_socket(const char *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int ptts_prefork_serve(ptts_ctx *ctx, const char *socket_path, int num_workers,
+                       const char *voice, const ptts_params *params) {
+    if (!ctx || !socket_path || num_workers < 1) return -1;
+    ptts_params defaults = PTTS_PARAMS_DEFAULT;
+    if (params) defaults = *params;
+
+    /* Threads do not survive fork(): keep the flow net single-threaded. */
+    unsetenv("PTTS_FLOW_THREADS");
+    if (ptts_preload(ctx, 1) != 0) return -1;
+
+    int listen_fd = open_socket(socket_path);
+    if (listen_fd < 0) {
+        fprintf(stderr, "[ptts] prefork: cannot listen on %s: %s\n", socket_path, strerror(errno));
+        return -1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sigemptyset(&sa.sa_mask);
+    sa.sa_handler = on_stop; /* no SA_RESTART: waitpid returns EINTR */
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sa.sa_handler = on_report;
+    sigaction(SIGUSR1, &sa, NULL);
+
+    prefork_worker *workers = (prefork_worker *)calloc((size_t)num_workers, sizeof(prefork_worker));
+    if (!workers) {
+        close(listen_fd);
+        unlink(socket_path);
+        return -1;
+    }
+    int rc = 0;
+    for (int i = 0; i < num_workers; i++) {
+        if (spawn_worker(&workers[i], ctx, listen_fd, voice, &defaults) != 0) {
+            fprintf(stderr, "[ptts] prefork: fork failed: %s\n", strerror(errno));
+            stop_requested = 1;
+            rc = -1;
+            break;
+        }
+    }
+    if (rc == 0) {
+        fprintf(stderr, "[ptts] prefork: %d workers on %s (parent pid %d, kill -USR1 for memory)\n",
+                num_workers, socket_path, (int)getpid());
+    }
+
+    while (!stop_requested) {
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno != EINTR) break;
+            if (report_requested) {
+                report_requested = 0;
+                print_report(workers, num_workers);
+            }
+            continue;
+        }
+        int slot = -1;
+        for (int i = 0; i < num_workers; i++) {
+            if (workers[i].pid == pid) slot = i;
+        }
+        if (slot < 0) continue;
+        prefork_worker *w = &workers[slot];
+        if (WIFSIGNALED(status)) {
+            fprintf(stderr, "[ptts] prefork worker %d pid %d killed by signal %d\n", slot, (int)pid,
+                    WTERMSIG(status));
+        } else {
+            fprintf(stderr, "[ptts] prefork worker %d pid %d exited with status %d\n", slot,
+                    (int)pid, WEXITSTATUS(status));
+        }
+        w->pid = 0;
+        if (stop_requested) break;
+        /* A worker that dies right after starting would otherwise respawn in
+         * a tight loop. */
+        if (time(NULL) - w->started < 1) sleep(1);
+        w->restarts++;
+        if (spawn_worker(w, ctx, listen_fd, voice, &defaults) != 0) {
+            fprintf(stderr, "[ptts] prefork: fork failed: %s\n", strerror(errno));
+        }
+    }
+
+    print_report(workers, num_workers);
+    for (int i = 0; i < num_workers; i++) {
+        if (workers[i].pid > 0) kill(workers[i].pid, SIGTERM);
+    }
+    for (int i = 0; i < num_workers; i++) {
+        if (workers[i].pid > 0) waitpid(workers[i].pid, NULL, 0);
+    }
+    free(workers);
+    close(listen_fd);
+    unlink(socket_path);
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGUSR1, SIG_DFL);
+    return rc;
+}
@@ -0,0 +1,41 @@
+#ifndef PTTS_PREFORK_H
+#define PTTS_PREFORK_H
+
+#include "ptts.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Prefork worker pool. The parent loads the model once (ptts_preload with
+ * read-only weights) and forks num_workers processes that share those pages
+ * copy-on-write. Every worker blocks in accept() on one Unix socket, so
+ * each connection is one job, taken by whichever worker is idle:
+ *
+ *   request: OUT_PATH '\t' TEXT [ '\t' SEED ] '\n'
+ *   reply:   "ok samples=N ms=X uss_kb=K\n" or "error MESSAGE\n"
+ *
+ * The parent supervises: workers that die are restarted, SIGUSR1 prints
+ * per-worker memory (unique/proportional/resident), SIGINT/SIGTERM stop the
+ * pool and remove the socket. Returns 0 after a clean shutdown.
+ */
+int ptts_prefork_serve(ptts_ctx *ctx, const char *socket_path, int num_workers,
+                       const char *voice, const ptts_params *params);
+
+/* Memory of a process from /proc/<pid>/smaps_rollup, in KB. unique is
+ * Private_Clean + Private_Dirty: what the process would free on exit. */
+typedef struct {
+    long rss_kb;
+    long pss_kb;
+    long unique_kb;
+} ptts_proc_mem;
+
+/* pid 0 = this process. Returns 0 on success, -1 if unavailable. */
+int ptts_proc_mem_read(int pid, ptts_proc_mem *mem);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTTS_PREFORK_H */
@@ -0,0 +1,223 @@
+/*
+ * ptts_request.c - Synthesis requests as flat JSON objects
+ */
+
+#include "ptts_request.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *json_ws(const char *p) {
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+    return p;
+}
+
+static int json_hex4(const char *p, unsigned *out) {
+    unsigned v = 0;
+    for (int i = 0; i < 4; i++) {
+        int c = (unsigned char)p[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= (unsigned)(c - '0');
+        else if (c >= 'a' && c <= 'f') v |= (unsigned)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') v |= (unsigned)(c - 'A' + 10);
+        else return -1;
+    }
+    *out = v;
+    return 0;
+}
+
+static size_t utf8_put(char *out, unsigned cp) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/* p points at the opening quote. Decodes into out (at least cap bytes; the
+ * decoded string is never longer than its encoding). Returns the position
+ * after the closing quote, or NULL. */
+static const char *json_string(const char *p, char *out, size_t cap) {
+    size_t n = 0;
+    p++;
+    while (*p && *p != '"') {
+        char tmp[4];
+        size_t len = 1;
+        unsigned char c = (unsigned char)*p++;
+        if (c == '\\') {
+            if (!*p) return NULL;
+            c = (unsigned char)*p++;
+            switch (c) {
+                case '"': case '\\': case '/': tmp[0] = (char)c; break;
+                case 'b': tmp[0] = '\b'; break;
+                case 'f': tmp[0] = '\f'; break;
+                case 'n': tmp[0] = '\n'; break;
+                case 'r': tmp[0] = '\r'; break;
+                case 't': tmp[0] = '\t'; break;
+                case 'u': {
+                    unsigned cp, lo;
+                    if (json_hex4(p, &cp) != 0) return NULL;
+                    p += 4;
+                    if (cp >= 0xD800 && cp < 0xDC00 && p[0] == '\\' && p[1] == 'u' &&
+                        json_hex4(p + 2, &lo) == 0 && lo >= 0xDC00 && lo < 0xE000) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                        p += 6;
+                    }
+                    len = utf8_put(tmp, cp);
+                    break;
+                }
+                default: return NULL;
+            }
+        } else if (c < 0x20) {
+            return NULL;
+        } else {
+            tmp[0] = (char)c;
+        }
+        if (n + len >= cap) return NULL;
+        memcpy(out + n, tmp, len);
+        n += len;
+    }
+    if (*p != '"') return NULL;
+    out[n] = '\0';
+    return p + 1;
+}
+
+const char *ptts_request_parse(const char *body, size_t body_len, const ptts_params *defaults,
+                               ptts_request *req) {
+    ptts_params base = PTTS_PARAMS_DEFAULT;
+    memset(req, 0, sizeof(*req));
+    req->params = defaults ? *defaults : base;
+    char key[64];
+    char *sval = (char *)malloc(body_len + 1);
+    if (!sval) return "out of memory";
+    const char *err = NULL;
+    const char *p = json_ws(body);
+    if (*p++ != '{') {
+        free(sval);
+        return "body must be a JSON object";
+    }
+    for (;;) {
+        p = json_ws(p);
+        if (*p == '}') break;
+        if (*p != '"' || !(p = json_string(p, key, sizeof(key)))) {
+            err = "bad object key";
+            break;
+        }
+        p = json_ws(p);
+        if (*p++ != ':') {
+            err = "expected ':'";
+            break;
+        }
+        p = json_ws(p);
+
+        int is_str = 0;
+        int bval = -1;
+        double num = 0.0;
+        if (*p == '"') {
+            if (!(p = json_string(p, sval, body_len + 1))) {
+                err = "bad string value";
+                break;
+            }
+            is_str = 1;
+        } else if (strncmp(p, "true", 4) == 0) {
+            bval = 1;
+            p += 4;
+        } else if (strncmp(p, "false", 5) == 0) {
+            bval = 0;
+            p += 5;
+        } else if (strncmp(p, "null", 4) == 0) {
+            p += 4;
+            goto next; /* null leaves the default */
+        } else {
+            char *end = NULL;
+            num = strtod(p, &end);
+            if (end == p) {
+                err = "unsupported value (flat object of strings, numbers and booleans only)";
+                break;
+            }
+            p = end;
+        }
+
+        ptts_params *prm = &req->params;
+        if (strcmp(key, "text") == 0) {
+            if (!is_str) { err = "\"text\" must be a string"; break; }
+            free(req->text);
+            req->text = strdup(sval);
+        } else if (strcmp(key, "voice") == 0 || strcmp(key, "out") == 0) {
+            if (!is_str || !sval[0]) { err = "\"voice\" and \"out\" must be non-empty strings"; break; }
+            char **dst = key[0] == 'v' ? &req->voice : &req->out;
+            free(*dst);
+            *dst = strdup(sval);
+        } else if (strcmp(key, "format") == 0) {
+            if (!is_str || (strcmp(sval, "wav") != 0 && strcmp(sval, "pcm") != 0)) {
+                err = "\"format\" must be \"wav\" or \"pcm\"";
+                break;
+            }
+            req->pcm = strcmp(sval, "pcm") == 0;
+        } else if (strcmp(key, "eos") == 0) {
+            if (bval < 0) { err = "\"eos\" must be a boolean"; break; }
+            prm->eos_enabled = bval;
+        } else if (is_str || bval >= 0) {
+            err = "numeric field expected";
+            break;
+        } else if (strcmp(key, "seed") == 0) {
+            prm->seed = (int64_t)num;
+        } else if (strcmp(key, "request_id") == 0) {
+            prm->request_id = (uint64_t)num;
+        } else if (strcmp(key, "temp") == 0) {
+            prm->temp = (float)num;
+        } else if (strcmp(key, "noise_clamp") == 0) {
+            prm->noise_clamp = (float)num;
+        } else if (strcmp(key, "steps") == 0) {
+            if (!(num <= PTTS_MAX_STEPS)) { err = "\"steps\" is too large"; break; }
+            prm->num_steps = num < 1 ? 1 : (int)num;
+        } else if (strcmp(key, "frames") == 0) {
+            if (!(num <= 4096)) { err = "\"frames\" is too large"; break; }
+            prm->num_frames = num < 0 ? -1 : (int)num;
+        } else if (strcmp(key, "eos_threshold") == 0) {
+            prm->eos_enabled = 1;
+            prm->eos_threshold = (float)num;
+        } else if (strcmp(key, "eos_min_frames") == 0) {
+            prm->eos_min_frames = (int)num;
+        } else if (strcmp(key, "eos_after") == 0) {
+            prm->eos_after = (int)num;
+        }
+        /* other keys are ignored */
+next:
+        p = json_ws(p);
+        if (*p == ',') {
+            p++;
+            continue;
+        }
+        if (*p != '}') err = "expected ',' or '}'";
+        break;
+    }
+    free(sval);
+    if (!err && (!req->text || !req->text[0])) err = "\"text\" is required";
+    if (!err && req->params.num_frames < 0) err = "\"frames\" must not be negative";
+    return err;
+}
+
+void ptts_request_clear(ptts_request *req) {
+    if (!req) return;
+    free(req->text);
+    free(req->voice);
+    free(req->out);
+    req->text = NULL;
+    req->voice = NULL;
+    req->out = NULL;
+}
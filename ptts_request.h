@@ -0,0 +1,41 @@
+#ifndef PTTS_REQUEST_H
+#define PTTS_REQUEST_H
+
+#include <stddef.h>
+#include "ptts.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * One synthesis request as used by `ptts serve` bodies and `--batch` lines:
+ * a flat JSON object of strings, numbers and booleans.
+ *
+ *   text (required), voice, out, format ("wav" | "pcm"), seed, request_id,
+ *   temp, noise_clamp, steps, frames, eos, eos_threshold, eos_min_frames,
+ *   eos_after
+ *
+ * Numeric fields override the matching ptts_params field; unknown keys and
+ * null values are ignored.
+ */
+typedef struct {
+    char *text;
+    char *voice;        /* NULL: caller's default */
+    char *out;          /* output name, NULL if absent */
+    int pcm;            /* "format": "pcm" */
+    ptts_params params; /* defaults with the request's overrides */
+} ptts_request;
+
+/* Parses body (body_len bytes, NUL-terminated) into req, starting from
+ * defaults (NULL: PTTS_PARAMS_DEFAULT). Returns NULL on success or a static
+ * error message. Call ptts_request_clear either way. */
+const char *ptts_request_parse(const char *body, size_t body_len, const ptts_params *defaults,
+                               ptts_request *req);
+void ptts_request_clear(ptts_request *req);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTTS_REQUEST_H */
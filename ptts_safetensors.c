@@ -3,9 +3,11 @@
  */
 
 #include "ptts_safetensors.h"
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/mman.h>
@@ -151,6 +153,82 @@ static int parse_tensor_entry(const char **p, safetensor_t *t) {
     return 0;
 }
 
+/* ========================================================================
+ * Name and suffix indexes
+ * ======================================================================== */
+
+struct safetensors_suffix {
+    const char *key; /* points into sf->names */
+    int first;       /* first tensor with this suffix, -1 = empty slot */
+    int count;
+};
+
+/* FNV-1a */
+static uint32_t hash_name(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int index_capacity(int n) {
+    int cap = 16;
+    while (cap < 2 * n) cap *= 2;
+    return cap;
+}
+
+static int build_indexes(safetensors_file_t *sf) {
+    int n = sf->num_tensors;
+    int num_suffixes = 0;
+    for (int i = 0; i < n; i++) {
+        num_suffixes++;
+        for (const char *c = sf->tensors[i].name; *c; c++) {
+            if (*c == '.') num_suffixes++;
+        }
+    }
+
+    sf->name_index_cap = index_capacity(n);
+    sf->name_index = (int *)malloc((size_t)sf->name_index_cap * sizeof(int));
+    sf->suffix_index_cap = index_capacity(num_suffixes);
+    sf->suffix_index = (struct safetensors_suffix *)malloc(
+        (size_t)sf->suffix_index_cap * sizeof(struct safetensors_suffix));
+    if (!sf->name_index || !sf->suffix_index) return -1;
+    for (int i = 0; i < sf->name_index_cap; i++) sf->name_index[i] = -1;
+    for (int i = 0; i < sf->suffix_index_cap; i++) sf->suffix_index[i].first = -1;
+
+    uint32_t name_mask = (uint32_t)sf->name_index_cap - 1;
+    uint32_t suffix_mask = (uint32_t)sf->suffix_index_cap - 1;
+    for (int i = 0; i < n; i++) {
+        const char *name = sf->tensors[i].name;
+        /* Duplicate names keep the first entry, as the linear scan did. */
+        uint32_t h = hash_name(name) & name_mask;
+        while (sf->name_index[h] >= 0 && strcmp(sf->tensors[sf->name_index[h]].name, name) != 0) {
+            h = (h + 1) & name_mask;
+        }
+        if (sf->name_index[h] < 0) sf->name_index[h] = i;
+
+        for (const char *suf = name; suf; ) {
+            h = hash_name(suf) & suffix_mask;
+            struct safetensors_suffix *e = &sf->suffix_index[h];
+            while (e->first >= 0 && strcmp(e->key, suf) != 0) {
+                h = (h + 1) & suffix_mask;
+                e = &sf->suffix_index[h];
+            }
+            if (e->first < 0) {
+                e->key = suf;
+                e->first = i;
+                e->count = 0;
+            }
+            e->count++;
+            suf = strchr(suf, '.');
+            if (suf) suf++;
+        }
+    }
+    return 0;
+}
+
 /* Parse the entire JSON header */
 static int parse_header(safetensors_file_t *sf) {
     const char *p = sf->header_json;
@@ -159,16 +237,27 @@ static int parse_header(safetensors_file_t *sf) {
     if (*p != '{') return -1;
     p++;
 
+    /* Size the table from the number of data_offsets keys (one per tensor);
+     * names are no longer than the header they come from. */
+    int max_tensors = 0;
+    for (const char *q = strstr(p, "\"data_offsets\""); q; q = strstr(q + 1, "\"data_offsets\"")) {
+        max_tensors++;
+    }
     sf->num_tensors = 0;
+    sf->tensors = (safetensor_t *)calloc((size_t)(max_tensors > 0 ? max_tensors : 1),
+                                         sizeof(safetensor_t));
+    sf->names = (char *)malloc(sf->header_size + 1);
+    if (!sf->tensors || !sf->names) return -1;
+    size_t names_used = 0;
 
-    while (*p && *p != '}' && sf->num_tensors < SAFETENSORS_MAX_TENSORS) {
+    while (*p && *p != '}') {
         skip_whitespace(&p);
         if (*p == ',') { p++; continue; }
         if (*p == '}') break;
 
         /* Parse tensor name */
-        char name[256];
-        if (parse_string(&p, name, sizeof(name)) != 0) return -1;
+        char *name = sf->names + names_used;
+        if (parse_string(&p, name, sf->header_size + 1 - names_used) != 0) return -1;
 
         skip_whitespace(&p);
         if (*p != ':') return -1;
@@ -190,16 +279,168 @@ static int parse_header(safetensors_file_t *sf) {
         }
 
         /* Parse tensor entry */
+        if (sf->num_tensors >= max_tensors) {
+            /* Only if an entry lacks data_offsets; grow rather than fail. */
+            int new_max = max_tensors ? 2 * max_tensors : 16;
+            safetensor_t *nt = (safetensor_t *)realloc(sf->tensors,
+                                                       (size_t)new_max * sizeof(safetensor_t));
+            if (!nt) return -1;
+            sf->tensors = nt;
+            max_tensors = new_max;
+        }
         safetensor_t *t = &sf->tensors[sf->num_tensors];
-        snprintf(t->name, sizeof(t->name), "%s", name);
+        t->name = name;
+        names_used += strlen(name) + 1;
 
         if (parse_tensor_entry(&p, t) != 0) return -1;
         sf->num_tensors++;
     }
 
+    return build_indexes(sf);
+}
+
+/* ========================================================================
+ * Packed model files
+ * ======================================================================== */
+
+#define PACK_HEADER_SIZE 64
+#define PACK_ENTRY_SIZE 96
+
+static uint32_t read_u32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint64_t read_u64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/* Fill the tensor table from a packed directory; no JSON involved. */
+static int parse_pack(safetensors_file_t *sf) {
+    const unsigned char *base = (const unsigned char *)sf->data;
+    if (sf->file_size < PACK_HEADER_SIZE) return -1;
+    if (read_u32(base + 8) != SAFETENSORS_PACK_VERSION) return -1;
+    uint32_t n = read_u32(base + 12);
+    uint64_t names_off = read_u64(base + 16);
+    uint64_t names_size = read_u64(base + 24);
+    uint64_t data_off = read_u64(base + 32);
+    uint64_t dir_end = PACK_HEADER_SIZE + (uint64_t)n * PACK_ENTRY_SIZE;
+    if (dir_end > sf->file_size || names_off < dir_end || names_size > sf->file_size ||
+        names_off + names_size > sf->file_size || data_off < names_off + names_size ||
+        data_off > sf->file_size) {
+        return -1;
+    }
+
+    sf->packed = 1;
+    sf->header_size = (size_t)data_off - 8; /* safetensors_data adds 8 + header_size */
+    sf->tensors = (safetensor_t *)calloc(n > 0 ? n : 1, sizeof(safetensor_t));
+    sf->names = (char *)malloc((size_t)names_size + 1);
+    if (!sf->tensors || !sf->names) return -1;
+    memcpy(sf->names, base + names_off, (size_t)names_size);
+    sf->names[names_size] = '\0';
+
+    uint64_t data_size = sf->file_size - data_off;
+    for (uint32_t i = 0; i < n; i++) {
+        const unsigned char *e = base + PACK_HEADER_SIZE + (size_t)i * PACK_ENTRY_SIZE;
+        safetensor_t *t = &sf->tensors[i];
+        uint64_t name_off = read_u64(e);
+        if (name_off >= names_size) return -1;
+        t->name = sf->names + name_off;
+        t->dtype = (safetensor_dtype_t)(int32_t)read_u32(e + 8);
+        t->ndim = (int)read_u32(e + 12);
+        if (t->ndim < 0 || t->ndim > 8) return -1;
+        for (int d = 0; d < 8; d++) t->shape[d] = (int64_t)read_u64(e + 16 + 8 * d);
+        t->data_offset = (size_t)read_u64(e + 80);
+        t->data_size = (size_t)read_u64(e + 88);
+        if (t->data_offset > data_size || t->data_size > data_size - t->data_offset) return -1;
+    }
+    sf->num_tensors = (int)n;
+    return build_indexes(sf);
+}
+
+static size_t align_up(size_t v, size_t a) {
+    return (v + a - 1) / a * a;
+}
+
+static int write_zeros(FILE *f, size_t n) {
+    static const unsigned char zeros[SAFETENSORS_PACK_ALIGN];
+    while (n > 0) {
+        size_t c = n < sizeof(zeros) ? n : sizeof(zeros);
+        if (fwrite(zeros, 1, c, f) != c) return -1;
+        n -= c;
+    }
     return 0;
 }
 
+int safetensors_write_pack(const char *path, const safetensors_pack_entry *entries, int n) {
+    if (!path || n < 0 || (n > 0 && !entries)) return -1;
+
+    size_t names_off = PACK_HEADER_SIZE + (size_t)n * PACK_ENTRY_SIZE;
+    size_t names_size = 0;
+    for (int i = 0; i < n; i++) names_size += strlen(entries[i].name) + 1;
+    size_t data_off = align_up(names_off + names_size, SAFETENSORS_PACK_ALIGN);
+
+    unsigned char *dir = (unsigned char *)calloc(1, names_off);
+    if (!dir) return -1;
+    memcpy(dir, SAFETENSORS_PACK_MAGIC, 8);
+    uint32_t u32 = SAFETENSORS_PACK_VERSION;
+    memcpy(dir + 8, &u32, 4);
+    u32 = (uint32_t)n;
+    memcpy(dir + 12, &u32, 4);
+    uint64_t u64 = names_off;
+    memcpy(dir + 16, &u64, 8);
+    u64 = names_size;
+    memcpy(dir + 24, &u64, 8);
+    u64 = data_off;
+    memcpy(dir + 32, &u64, 8);
+
+    size_t name_pos = 0, data_pos = 0;
+    for (int i = 0; i < n; i++) {
+        const safetensors_pack_entry *en = &entries[i];
+        unsigned char *e = dir + PACK_HEADER_SIZE + (size_t)i * PACK_ENTRY_SIZE;
+        u64 = name_pos;
+        memcpy(e, &u64, 8);
+        int32_t dtype = (int32_t)en->dtype;
+        memcpy(e + 8, &dtype, 4);
+        u32 = (uint32_t)en->ndim;
+        memcpy(e + 12, &u32, 4);
+        for (int d = 0; d < 8; d++) {
+            int64_t dim = d < en->ndim ? en->shape[d] : 0;
+            memcpy(e + 16 + 8 * d, &dim, 8);
+        }
+        u64 = data_pos;
+        memcpy(e + 80, &u64, 8);
+        u64 = en->data_size;
+        memcpy(e + 88, &u64, 8);
+        name_pos += strlen(en->name) + 1;
+        data_pos = align_up(data_pos + en->data_size, SAFETENSORS_PACK_ALIGN);
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        free(dir);
+        return -1;
+    }
+    int rc = fwrite(dir, 1, names_off, f) == names_off ? 0 : -1;
+    free(dir);
+    for (int i = 0; rc == 0 && i < n; i++) {
+        size_t len = strlen(entries[i].name) + 1;
+        if (fwrite(entries[i].name, 1, len, f) != len) rc = -1;
+    }
+    if (rc == 0) rc = write_zeros(f, data_off - names_off - names_size);
+    for (int i = 0; rc == 0 && i < n; i++) {
+        size_t size = entries[i].data_size;
+        if (size > 0 && fwrite(entries[i].data, 1, size, f) != size) rc = -1;
+        if (rc == 0) rc = write_zeros(f, align_up(size, SAFETENSORS_PACK_ALIGN) - size);
+    }
+    if (fclose(f) != 0) rc = -1;
+    if (rc != 0) remove(path);
+    return rc;
+}
+
 safetensors_file_t *safetensors_open(const char *path) {
     int fd = open(path, O_RDONLY);
     if (fd < 0) return NULL;
@@ -224,6 +465,14 @@ safetensors_file_t *safetensors_open(const char *path) {
     sf->data = data;
     sf->file_size = st.st_size;
 
+    if (sf->file_size >= PACK_HEADER_SIZE && memcmp(data, SAFETENSORS_PACK_MAGIC, 8) == 0) {
+        if (parse_pack(sf) != 0) {
+            safetensors_close(sf);
+            return NULL;
+        }
+        return sf;
+    }
+
     /* Read header size */
     if (sf->file_size < 8) {
         safetensors_close(sf);
@@ -259,14 +508,36 @@ void safetensors_close(safetensors_file_t *sf) {
     if (!sf) return;
     if (sf->data) munmap(sf->data, sf->file_size);
     free(sf->header_json);
+    free(sf->tensors);
+    free(sf->names);
+    free(sf->name_index);
+    free(sf->suffix_index);
     free(sf->path);
     free(sf);
 }
 
 const safetensor_t *safetensors_find(const safetensors_file_t *sf, const char *name) {
-    if (!sf || !name) return NULL;
-    for (int i = 0; i < sf->num_tensors; i++) {
-        if (strcmp(sf->tensors[i].name, name) == 0) return &sf->tensors[i];
+    if (!sf || !name || !sf->name_index) return NULL;
+    uint32_t mask = (uint32_t)sf->name_index_cap - 1;
+    for (uint32_t h = hash_name(name) & mask; sf->name_index[h] >= 0; h = (h + 1) & mask) {
+        const safetensor_t *t = &sf->tensors[sf->name_index[h]];
+        if (strcmp(t->name, name) == 0) return t;
+    }
+    return NULL;
+}
+
+const safetensor_t *safetensors_find_suffix(const safetensors_file_t *sf, const char *suffix,
+                                            int *count) {
+    if (count) *count = 0;
+    if (!sf || !suffix || !sf->suffix_index) return NULL;
+    uint32_t mask = (uint32_t)sf->suffix_index_cap - 1;
+    for (uint32_t h = hash_name(suffix) & mask; sf->suffix_index[h].first >= 0;
+         h = (h + 1) & mask) {
+        const struct safetensors_suffix *e = &sf->suffix_index[h];
+        if (strcmp(e->key, suffix) == 0) {
+            if (count) *count = e->count;
+            return &sf->tensors[e->first];
+        }
     }
     return NULL;
 }
@@ -276,6 +547,30 @@ const void *safetensors_data(const safetensors_file_t *sf, const safetensor_t *t
     return (const char *)sf->data + 8 + sf->header_size + t->data_offset;
 }
 
+/* Widening loops, written branch-free on integers so the compiler
+ * vectorizes them (no float ops on the bits, so FTZ/DAZ cannot flush F16
+ * subnormals). */
+static void f16_to_f32_row(float *dst, const uint16_t *src, size_t n) {
+    uint32_t *out = (uint32_t *)dst;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t h = src[i];
+        uint32_t sign = (h & 0x8000u) << 16;
+        uint32_t em = h & 0x7fffu;
+        uint32_t normal = (em << 13) + ((127u - 15u) << 23);
+        uint32_t inf_nan = 0x7f800000u | ((em & 0x3ffu) << 13);
+        float sub = (float)em * 0x1p-24f; /* exact for em < 0x400 */
+        uint32_t sub_bits;
+        memcpy(&sub_bits, &sub, sizeof(sub_bits));
+        uint32_t bits = em >= 0x7c00u ? inf_nan : (em >= 0x400u ? normal : sub_bits);
+        out[i] = sign | bits;
+    }
+}
+
+static void bf16_to_f32_row(float *dst, const uint16_t *src, size_t n) {
+    uint32_t *out = (uint32_t *)dst;
+    for (size_t i = 0; i < n; i++) out[i] = (uint32_t)src[i] << 16;
+}
+
 float *safetensors_get_f32(const safetensors_file_t *sf, const safetensor_t *t) {
     if (!sf || !t) return NULL;
 
@@ -294,40 +589,9 @@ float *safetensors_get_f32(const safetensors_file_t *sf, const safetensor_t *t)
     if (t->dtype == DTYPE_F32) {
         memcpy(out, src, numel * sizeof(float));
     } else if (t->dtype == DTYPE_F16) {
-        const uint16_t *in = (const uint16_t *)src;
-        for (int64_t i = 0; i < numel; i++) {
-            uint16_t h = in[i];
-            uint16_t sign = (h >> 15) & 1;
-            uint16_t exp = (h >> 10) & 0x1f;
-            uint16_t mant = h & 0x3ff;
-            uint32_t f;
-            if (exp == 0) {
-                if (mant == 0) {
-                    f = (uint32_t)sign << 31;
-                } else {
-                    exp = 1;
-                    while ((mant & 0x400) == 0) {
-                        mant <<= 1;
-                        exp--;
-                    }
-                    mant &= 0x3ff;
-                    exp += 127 - 15;
-                    f = ((uint32_t)sign << 31) | ((uint32_t)exp << 23) | ((uint32_t)mant << 13);
-                }
-            } else if (exp == 31) {
-                f = ((uint32_t)sign << 31) | 0x7f800000 | ((uint32_t)mant << 13);
-            } else {
-                exp += 127 - 15;
-                f = ((uint32_t)sign << 31) | ((uint32_t)exp << 23) | ((uint32_t)mant << 13);
-            }
-            memcpy(&out[i], &f, sizeof(float));
-        }
+        f16_to_f32_row(out, (const uint16_t *)src, (size_t)numel);
     } else if (t->dtype == DTYPE_BF16) {
-        const uint16_t *in = (const uint16_t *)src;
-        for (int64_t i = 0; i < numel; i++) {
-            uint32_t f = ((uint32_t)in[i]) << 16;
-            memcpy(&out[i], &f, sizeof(float));
-        }
+        bf16_to_f32_row(out, (const uint16_t *)src, (size_t)numel);
     } else {
         free(out);
         return NULL;
@@ -359,6 +623,222 @@ uint16_t *safetensors_get_bf16_direct(const safetensors_file_t *sf, const safete
     return (uint16_t *)safetensors_data(sf, t);
 }
 
+const float *safetensors_get_f32_direct(const safetensors_file_t *sf, const safetensor_t *t) {
+    if (!sf || !t || t->dtype != DTYPE_F32) return NULL;
+    const void *p = safetensors_data(sf, t);
+    if (((uintptr_t)p & (sizeof(float) - 1)) != 0) return NULL;
+    return (const float *)p;
+}
+
+int safetensors_contains(const safetensors_file_t *sf, const void *p) {
+    if (!sf || !sf->data || !p) return 0;
+    const char *c = (const char *)p;
+    const char *base = (const char *)sf->data;
+    return c >= base && c < base + sf->file_size;
+}
+
+/* ========================================================================
+ * Batched loader
+ * ======================================================================== */
+
+#define LOADER_CHUNK ((size_t)1 << 18) /* elements per conversion job */
+#define LOADER_DEFAULT_THREADS 8
+#define LOADER_MAX_THREADS 64
+
+typedef struct {
+    const safetensor_t *t;
+    float *dst;
+    size_t start;
+    size_t count;
+} load_job;
+
+struct safetensors_loader {
+    const safetensors_file_t *sf;
+    char *arena;        /* reserved, bump-allocated, tail trimmed by run */
+    size_t arena_cap;
+    size_t arena_used;
+    load_job *jobs;
+    int num_jobs;
+    int cap_jobs;
+    int tensors;
+    int converted;
+    int failed;
+    size_t bytes;
+    int next_job; /* shared cursor while running */
+};
+
+static int loader_threads(void) {
+    static int inited = 0;
+    static int threads = 1;
+    if (!inited) {
+        const char *v = getenv("PTTS_LOAD_THREADS");
+        if (v && v[0]) {
+            threads = atoi(v);
+        } else {
+            long n = sysconf(_SC_NPROCESSORS_ONLN);
+            threads = n > LOADER_DEFAULT_THREADS ? LOADER_DEFAULT_THREADS : (int)n;
+        }
+        if (threads < 1) threads = 1;
+        if (threads > LOADER_MAX_THREADS) threads = LOADER_MAX_THREADS;
+        inited = 1;
+    }
+    return threads;
+}
+
+/* Start readahead of a tensor's bytes so page faults overlap the rest of
+ * the load instead of stalling the conversion one page at a time. */
+static void advise_willneed(const safetensors_file_t *sf, const safetensor_t *t) {
+    long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0 || t->data_size == 0) return;
+    uintptr_t begin = (uintptr_t)safetensors_data(sf, t);
+    uintptr_t end = begin + t->data_size;
+    begin &= ~((uintptr_t)page - 1);
+    madvise((void *)begin, end - begin, MADV_WILLNEED);
+}
+
+safetensors_loader *safetensors_loader_create(const safetensors_file_t *sf) {
+    if (!sf) return NULL;
+    safetensors_loader *ld = (safetensors_loader *)calloc(1, sizeof(safetensors_loader));
+    if (!ld) return NULL;
+    ld->sf = sf;
+    /* Widening at most doubles a tensor; reserve address space for that and
+     * let pages materialize as chunks are written. */
+    ld->arena_cap = 2 * sf->file_size + (size_t)sf->num_tensors * SAFETENSORS_PACK_ALIGN;
+    void *arena = mmap(NULL, ld->arena_cap, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (arena == MAP_FAILED) {
+        free(ld);
+        return NULL;
+    }
+    ld->arena = (char *)arena;
+    return ld;
+}
+
+float *safetensors_loader_f32(safetensors_loader *ld, const safetensor_t *t) {
+    if (!ld || !t) return NULL;
+    ld->tensors++;
+    advise_willneed(ld->sf, t);
+    const float *direct = safetensors_get_f32_direct(ld->sf, t);
+    if (direct) return (float *)direct;
+
+    int64_t numel = safetensor_numel(t);
+    size_t bytes = (size_t)numel * sizeof(float);
+    size_t offset = align_up(ld->arena_used, SAFETENSORS_PACK_ALIGN);
+    if (numel <= 0 || (t->dtype != DTYPE_F32 && t->dtype != DTYPE_F16 &&
+                       t->dtype != DTYPE_BF16) || offset + bytes > ld->arena_cap) {
+        ld->failed = 1;
+        return NULL;
+    }
+    float *dst = (float *)(ld->arena + offset);
+    for (size_t start = 0; start < (size_t)numel; start += LOADER_CHUNK) {
+        if (ld->num_jobs == ld->cap_jobs) {
+            int cap = ld->cap_jobs ? 2 * ld->cap_jobs : 256;
+            load_job *nj = (load_job *)realloc(ld->jobs, (size_t)cap * sizeof(load_job));
+            if (!nj) {
+                /* Drop this tensor's queued chunks; the buffer is unusable. */
+                while (ld->num_jobs > 0 && ld->jobs[ld->num_jobs - 1].dst == dst) ld->num_jobs--;
+                ld->failed = 1;
+                return NULL;
+            }
+            ld->jobs = nj;
+            ld->cap_jobs = cap;
+        }
+        load_job *j = &ld->jobs[ld->num_jobs++];
+        j->t = t;
+        j->dst = dst;
+        j->start = start;
+        j->count = (size_t)numel - start < LOADER_CHUNK ? (size_t)numel - start : LOADER_CHUNK;
+    }
+    ld->arena_used = offset + bytes;
+    ld->converted++;
+    ld->bytes += bytes;
+    return dst;
+}
+
+static void *loader_worker(void *arg) {
+    safetensors_loader *ld = (safetensors_loader *)arg;
+    for (;;) {
+        int i = __atomic_fetch_add(&ld->next_job, 1, __ATOMIC_RELAXED);
+        if (i >= ld->num_jobs) break;
+        const load_job *j = &ld->jobs[i];
+        const char *src = (const char *)safetensors_data(ld->sf, j->t);
+        float *dst = j->dst + j->start;
+        if (j->t->dtype == DTYPE_F32) {
+            memcpy(dst, src + j->start * sizeof(float), j->count * sizeof(float));
+        } else if (j->t->dtype == DTYPE_F16) {
+            f16_to_f32_row(dst, (const uint16_t *)src + j->start, j->count);
+        } else {
+            bf16_to_f32_row(dst, (const uint16_t *)src + j->start, j->count);
+        }
+    }
+    return NULL;
+}
+
+static double loader_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+int safetensors_loader_run(safetensors_loader *ld, safetensors_load_stats *stats,
+                           safetensors_arena *arena) {
+    if (!ld) return -1;
+    double t0 = loader_now_ms();
+    int threads = loader_threads();
+    if (threads > ld->num_jobs) threads = ld->num_jobs > 0 ? ld->num_jobs : 1;
+
+    pthread_t tids[LOADER_MAX_THREADS];
+    int spawned = 0;
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&tids[spawned], NULL, loader_worker, ld) != 0) break;
+        spawned++;
+    }
+    loader_worker(ld);
+    for (int i = 0; i < spawned; i++) pthread_join(tids[i], NULL);
+
+    if (stats) {
+        stats->tensors = ld->tensors;
+        stats->converted = ld->converted;
+        stats->bytes = ld->bytes;
+        stats->threads = spawned + 1;
+        stats->ms = loader_now_ms() - t0;
+    }
+    int rc = ld->failed ? -1 : 0;
+
+    /* Give back the unused reservation */
+    long page = sysconf(_SC_PAGESIZE);
+    size_t keep = align_up(ld->arena_used, page > 0 ? (size_t)page : 4096);
+    if (keep < ld->arena_cap) munmap(ld->arena + keep, ld->arena_cap - keep);
+    safetensors_arena a = {keep ? ld->arena : NULL, keep};
+    if (arena) {
+        *arena = a;
+    } else {
+        safetensors_arena_free(&a);
+    }
+    free(ld->jobs);
+    free(ld);
+    return rc;
+}
+
+void safetensors_arena_free(safetensors_arena *arena) {
+    if (!arena) return;
+    if (arena->base) munmap(arena->base, arena->size);
+    arena->base = NULL;
+    arena->size = 0;
+}
+
+int safetensors_arena_contains(const safetensors_arena *arena, const void *p) {
+    if (!arena || !arena->base || !p) return 0;
+    const char *c = (const char *)p;
+    const char *base = (const char *)arena->base;
+    return c >= base && c < base + arena->size;
+}
+
+int safetensors_arena_protect(const safetensors_arena *arena) {
+    if (!arena || !arena->base) return 0;
+    return mprotect(arena->base, arena->size, PROT_READ) == 0 ? 0 : -1;
+}
+
 int safetensor_is_bf16(const safetensor_t *t) {
     return t && t->dtype == DTYPE_BF16;
 }
@@ -5,6 +5,15 @@
  *   - 8 bytes: uint64 little-endian header size
  *   - N bytes: JSON header with tensor metadata
  *   - Remaining: raw tensor data
+ *
+ * Packed model format (written by ptts --pack, little-endian):
+ *   - 64-byte header: "PTTSPACK", u32 version, u32 num_tensors,
+ *     u64 names offset, u64 names size, u64 data offset, zero padding
+ *   - num_tensors fixed 96-byte directory entries: u64 name offset,
+ *     u32 dtype, u32 ndim, i64 shape[8], u64 data offset, u64 data size
+ *   - NUL-terminated names, then tensor data, each tensor 64-byte aligned
+ * Tensors are stored in the dtype and layout the runtime uses, so loaders
+ * can point straight into the mapping instead of converting.
  */
 
 #ifndef PTTS_SAFETENSORS_H
@@ -13,9 +22,6 @@
 #include <stddef.h>
 #include <stdint.h>
 
-/* Maximum number of tensors per file */
-#define SAFETENSORS_MAX_TENSORS 512
-
 /* Tensor data types */
 typedef enum {
     DTYPE_F32 = 0,
@@ -29,7 +35,7 @@ typedef enum {
 
 /* Tensor descriptor */
 typedef struct {
-    char name[256];
+    const char *name;        /* owned by the file handle */
     safetensor_dtype_t dtype;
     int ndim;
     int64_t shape[8];
@@ -45,10 +51,33 @@ typedef struct {
     size_t header_size;
     char *header_json;
     int num_tensors;
-    safetensor_t tensors[SAFETENSORS_MAX_TENSORS];
+    safetensor_t *tensors;   /* num_tensors entries, in header order */
+    char *names;             /* storage for tensor names */
+    /* Open-addressing indexes (power-of-two capacity, -1 = empty slot):
+     * name_index maps a full name to its tensor; suffix_index maps every
+     * dot-separated suffix to its first tensor, with the match count. */
+    int *name_index;
+    int name_index_cap;
+    struct safetensors_suffix *suffix_index;
+    int suffix_index_cap;
+    int packed;              /* 1 for a PTTSPACK file */
 } safetensors_file_t;
 
-/* Open a safetensors file (memory-mapped) */
+#define SAFETENSORS_PACK_MAGIC "PTTSPACK"
+#define SAFETENSORS_PACK_VERSION 1
+#define SAFETENSORS_PACK_ALIGN 64
+
+/* One tensor to write into a packed model */
+typedef struct {
+    const char *name;
+    safetensor_dtype_t dtype;
+    int ndim;
+    int64_t shape[8];
+    const void *data;
+    size_t data_size;
+} safetensors_pack_entry;
+
+/* Open a safetensors or packed model file (memory-mapped) */
 safetensors_file_t *safetensors_open(const char *path);
 
 /* Close and free resources */
@@ -57,6 +86,12 @@ void safetensors_close(safetensors_file_t *sf);
 /* Find a tensor by name, returns NULL if not found */
 const safetensor_t *safetensors_find(const safetensors_file_t *sf, const char *name);
 
+/* Find the first tensor (in header order) whose name is `suffix` or ends
+ * with "." + suffix. *count, if given, receives the number of such
+ * tensors. Returns NULL if none. */
+const safetensor_t *safetensors_find_suffix(const safetensors_file_t *sf, const char *suffix,
+                                            int *count);
+
 /* Get raw pointer to tensor data (within mmap'd region) */
 const void *safetensors_data(const safetensors_file_t *sf, const safetensor_t *t);
 
@@ -72,6 +107,52 @@ uint16_t *safetensors_get_bf16(const safetensors_file_t *sf, const safetensor_t
  * Only works for BF16 tensors. Returns NULL for other dtypes. */
 uint16_t *safetensors_get_bf16_direct(const safetensors_file_t *sf, const safetensor_t *t);
 
+/* Get direct pointer to f32 data in mmap'd region (no copy, caller must NOT free)
+ * Only works for 4-byte aligned F32 tensors. Returns NULL otherwise. */
+const float *safetensors_get_f32_direct(const safetensors_file_t *sf, const safetensor_t *t);
+
+/* 1 if p points into the file's mapping (i.e. came from a _direct getter) */
+int safetensors_contains(const safetensors_file_t *sf, const void *p);
+
+/* Batched F32 materialization for model loaders. safetensors_loader_f32
+ * returns the tensor's final pointer at once (into the mapping for F32
+ * tensors, else into the loader's weight arena) but fills arena buffers
+ * only in safetensors_loader_run, which spreads the widening over
+ * PTTS_LOAD_THREADS threads (default: online CPUs, at most 8). */
+typedef struct safetensors_loader safetensors_loader;
+
+typedef struct {
+    int tensors;      /* tensors requested */
+    int converted;    /* of those, widened into the arena */
+    size_t bytes;     /* f32 bytes written */
+    int threads;
+    double ms;        /* wall time of safetensors_loader_run */
+} safetensors_load_stats;
+
+/* One anonymous mapping holding every converted tensor of a model, so the
+ * weights can be freed at once and mapped read-only as a unit. */
+typedef struct {
+    void *base;
+    size_t size;
+} safetensors_arena;
+
+safetensors_loader *safetensors_loader_create(const safetensors_file_t *sf);
+float *safetensors_loader_f32(safetensors_loader *ld, const safetensor_t *t);
+/* Convert everything queued, hand the arena to *arena, free the loader.
+ * Returns 0, or -1 if any request failed (its pointer was NULL); the arena
+ * is handed over either way. stats may be NULL. */
+int safetensors_loader_run(safetensors_loader *ld, safetensors_load_stats *stats,
+                           safetensors_arena *arena);
+
+void safetensors_arena_free(safetensors_arena *arena);
+int safetensors_arena_contains(const safetensors_arena *arena, const void *p);
+/* Map the arena read-only: forked processes then share it copy-on-write
+ * with no chance of a stray write un-sharing a page. Returns 0 or -1. */
+int safetensors_arena_protect(const safetensors_arena *arena);
+
+/* Write a packed model file. Returns 0 on success, -1 on error. */
+int safetensors_write_pack(const char *path, const safetensors_pack_entry *entries, int n);
+
 /* Check if tensor is stored in bf16 format */
 int safetensor_is_bf16(const safetensor_t *t);
 
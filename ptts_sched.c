@@ -0,0 +1,420 @@
+/*
+ * ptts_sched.c - Continuous batching of FlowLM sessions at frame boundaries
+ */
+
+#include "ptts_sched.h"
+#include "ptts_flowlm.h"
+#include "ptts_internal.h"
+#include "ptts_mimi.h"
+#include "ptts_spsc.h"
+#include "ptts_trace.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SCHED_FRAME_MS 80.0
+#define SCHED_MAX_DECODE_CHUNK 8
+
+typedef struct sched_job {
+    /* set by the caller before submit */
+    const int *ids;
+    int n;
+    const float *voice_cond;
+    int voice_len;
+    ptts_params p;
+    ptts_spsc *ring; /* scaled latents; holds every frame, so pushes never wait */
+    double submit_ms;
+    int cancel; /* caller stopped listening; atomic */
+    /* owned by the scheduler thread until it closes ring */
+    ptts_flowlm_session *session;
+    double admit_ms;
+    int status; /* 0 finished, -1 failed */
+    struct sched_job *next;
+} sched_job;
+
+struct ptts_sched {
+    ptts_ctx *ctx;
+    ptts_sched_opts opts;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    sched_job *head; /* waiting FIFO */
+    sched_job *tail;
+    int kv_full; /* head job found no KV pages; retry after a retirement */
+    int stopping;
+    ptts_sched_stats stats;
+};
+
+/* Last touch of a job by the scheduler: the caller may free it once its pops
+ * see the ring closed. */
+static void job_retire(sched_job *job, int status) {
+    ptts_flowlm_session_free(job->session);
+    job->session = NULL;
+    job->status = status;
+    ptts_spsc_close(job->ring);
+}
+
+static sched_job *sched_pop(ptts_sched *s) {
+    pthread_mutex_lock(&s->lock);
+    sched_job *job = s->head;
+    if (job) {
+        s->head = job->next;
+        if (!s->head) s->tail = NULL;
+        job->next = NULL;
+        s->stats.waiting--;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return job;
+}
+
+static void sched_push_front(ptts_sched *s, sched_job *job) {
+    pthread_mutex_lock(&s->lock);
+    job->next = s->head;
+    s->head = job;
+    if (!s->tail) s->tail = job;
+    s->stats.waiting++;
+    pthread_mutex_unlock(&s->lock);
+}
+
+/* Moves waiting jobs into free batch slots, oldest first; returns the new
+ * batch size. A job is admitted once the KV pool has pages for its prefix
+ * and first frame; until then it stays at the head of the queue and is
+ * retried after a session retires. With nothing running to free pages it
+ * fails instead. */
+static int sched_admit(ptts_sched *s, sched_job **active, int n_active) {
+    ptts_flowlm *fm = s->ctx->flowlm;
+    while (n_active < s->opts.max_batch && !s->kv_full) {
+        sched_job *job = sched_pop(s);
+        if (!job) break;
+        const ptts_params *p = &job->p;
+        job->session = ptts_flowlm_session_create(fm, job->ids, job->n, job->voice_cond,
+                                                  job->voice_len, p->num_frames, p->num_steps,
+                                                  p->temp, p->noise_clamp, p->seed,
+                                                  p->request_id, p->eos_enabled,
+                                                  p->eos_threshold, p->eos_min_frames,
+                                                  p->eos_after);
+        int rc = job->session ? ptts_flowlm_session_reserve(job->session, 1) : -1;
+        if (rc == 1 && n_active > 0) {
+            ptts_flowlm_session_free(job->session);
+            job->session = NULL;
+            sched_push_front(s, job);
+            s->kv_full = 1;
+            break;
+        }
+        if (rc != 0) {
+            job_retire(job, -1);
+            continue;
+        }
+        job->admit_ms = ptts_time_ms();
+        active[n_active++] = job;
+    }
+    return n_active;
+}
+
+static void *sched_main(void *arg) {
+    ptts_sched *s = (ptts_sched *)arg;
+    int max_batch = s->opts.max_batch;
+    ptts_trace_thread_name("scheduler", 0);
+    sched_job **active = (sched_job **)calloc((size_t)max_batch, sizeof(sched_job *));
+    sched_job **stepping = (sched_job **)calloc((size_t)max_batch, sizeof(sched_job *));
+    ptts_flowlm_session **batch =
+        (ptts_flowlm_session **)calloc((size_t)max_batch, sizeof(ptts_flowlm_session *));
+    float *latents = (float *)malloc(sizeof(float) * PTTS_FLOWLM_LATENT_DIM * (size_t)max_batch);
+    int n_active = 0;
+    int oom = !active || !stepping || !batch || !latents;
+
+    for (;;) {
+        /* retire */
+        int kept = 0;
+        for (int i = 0; i < n_active; i++) {
+            sched_job *job = active[i];
+            int state = ptts_flowlm_session_state(job->session);
+            if (__atomic_load_n(&job->cancel, __ATOMIC_ACQUIRE) || state != 1) {
+                job_retire(job, state == 0 ? 0 : -1);
+                s->kv_full = 0;
+            } else {
+                active[kept++] = job;
+            }
+        }
+        n_active = kept;
+
+        pthread_mutex_lock(&s->lock);
+        /* the gauge drops to 0 before an idle wait, not at the next step */
+        s->stats.active = n_active;
+        while (!s->stopping && n_active == 0 && !s->head) pthread_cond_wait(&s->cond, &s->lock);
+        int done = s->stopping && n_active == 0 && !s->head;
+        if (oom) {
+            /* fail everything queued rather than leave callers waiting */
+            while (s->head) {
+                sched_job *job = s->head;
+                s->head = job->next;
+                s->stats.waiting--;
+                job_retire(job, -1);
+            }
+            s->tail = NULL;
+        }
+        pthread_mutex_unlock(&s->lock);
+        if (done) break;
+        if (oom) continue;
+
+        /* admit */
+        n_active = sched_admit(s, active, n_active);
+        pthread_mutex_lock(&s->lock);
+        s->stats.active = n_active;
+        pthread_mutex_unlock(&s->lock);
+
+        /* prefill, oldest first, within this boundary's budget */
+        int budget = s->opts.prefill_chunk;
+        for (int i = 0; i < n_active && budget > 0; i++) {
+            ptts_flowlm_session *sess = active[i]->session;
+            int left = ptts_flowlm_session_prefill_left(sess);
+            if (left == 0) continue;
+            int run = left < budget ? left : budget;
+            if (ptts_flowlm_session_prefill(sess, run) < 0) continue; /* retired next round */
+            budget -= run;
+        }
+
+        /* step every decoding session that has a KV page for its next
+         * position by one frame; the rest wait for pages to be released */
+        int m = 0;
+        int stuck = -1; /* newest session waiting for a page */
+        for (int i = 0; i < n_active; i++) {
+            ptts_flowlm_session *sess = active[i]->session;
+            if (ptts_flowlm_session_state(sess) != 1 || ptts_flowlm_session_prefill_left(sess) > 0) {
+                continue;
+            }
+            int rc = ptts_flowlm_session_reserve(sess, 1);
+            if (rc == 1) stuck = i;
+            if (rc != 0) continue;
+            stepping[m] = active[i];
+            batch[m++] = sess;
+        }
+        if (m == 0) {
+            /* Every decoding session waits on pages only another one could
+             * free, and no prefill is running toward a retirement: fail the
+             * newest so the others go on. */
+            if (stuck >= 0 && budget == s->opts.prefill_chunk) {
+                job_retire(active[stuck], -1);
+                memmove(active + stuck, active + stuck + 1,
+                        sizeof(*active) * (size_t)(n_active - stuck - 1));
+                n_active--;
+                s->kv_full = 0;
+            }
+            continue;
+        }
+        ptts_flowlm_session_step(batch, m, latents);
+        int pushed = 0;
+        for (int j = 0; j < m; j++) {
+            if (ptts_flowlm_session_state(batch[j]) < 0) continue;
+            float scaled[PTTS_FLOWLM_LATENT_DIM];
+            ptts_flowlm_scale_latents(s->ctx->flowlm, latents + (size_t)j * PTTS_FLOWLM_LATENT_DIM,
+                                      1, scaled);
+            ptts_spsc_push(stepping[j]->ring, scaled);
+            pushed++;
+        }
+        pthread_mutex_lock(&s->lock);
+        s->stats.steps++;
+        s->stats.frames += (unsigned long)pushed;
+        pthread_mutex_unlock(&s->lock);
+    }
+
+    free(active);
+    free(stepping);
+    free(batch);
+    free(latents);
+    return NULL;
+}
+
+ptts_sched *ptts_sched_create(ptts_ctx *ctx, const ptts_sched_opts *opts) {
+    if (!ctx) return NULL;
+    ptts_sched_opts o = PTTS_SCHED_OPTS_DEFAULT;
+    if (opts) o = *opts;
+    if (o.max_batch < 1) o.max_batch = 8;
+    if (o.prefill_chunk < 1) o.prefill_chunk = 64;
+#ifdef PTTS_USE_CUDA
+    /* the resident CUDA KV cache holds one session */
+    o.max_batch = 1;
+#endif
+    if (ptts_preload(ctx, 0) != 0) return NULL;
+
+    ptts_sched *s = (ptts_sched *)calloc(1, sizeof(*s));
+    if (!s) {
+        ptts_set_error("Out of memory");
+        return NULL;
+    }
+    s->ctx = ctx;
+    s->opts = o;
+    s->stats.max_batch = o.max_batch;
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    if (pthread_create(&s->thread, NULL, sched_main, s) != 0) {
+        pthread_cond_destroy(&s->cond);
+        pthread_mutex_destroy(&s->lock);
+        free(s);
+        ptts_set_error("Failed to start scheduler thread");
+        return NULL;
+    }
+    return s;
+}
+
+void ptts_sched_free(ptts_sched *s) {
+    if (!s) return;
+    pthread_mutex_lock(&s->lock);
+    s->stopping = 1;
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->thread, NULL);
+    pthread_cond_destroy(&s->cond);
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+}
+
+void ptts_sched_get_stats(ptts_sched *s, ptts_sched_stats *out) {
+    if (!s || !out) return;
+    pthread_mutex_lock(&s->lock);
+    *out = s->stats;
+    pthread_mutex_unlock(&s->lock);
+}
+
+static void sched_submit(ptts_sched *s, sched_job *job) {
+    pthread_mutex_lock(&s->lock);
+    job->submit_ms = ptts_time_ms();
+    if (s->tail) {
+        s->tail->next = job;
+    } else {
+        s->head = job;
+    }
+    s->tail = job;
+    s->stats.waiting++;
+    s->stats.submitted++;
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+}
+
+ptts_audio *ptts_sched_generate(ptts_sched *s, const char *text, const char *voice_path,
+                                const ptts_params *params, ptts_audio_fn on_audio, void *user,
+                                ptts_sched_result *result) {
+    if (!s) {
+        ptts_set_error("Scheduler required");
+        return NULL;
+    }
+    ptts_ctx *ctx = s->ctx;
+    sched_job job;
+    memset(&job, 0, sizeof(job));
+    int *ids = NULL;
+    if (ptts_prepare_request(ctx, text, params, &job.p, &ids, &job.n) != 0) return NULL;
+    job.ids = ids;
+
+    float *voice_cond = NULL;
+    if (ptts_load_voice_conditioning(ctx, voice_path, &voice_cond, &job.voice_len) != 0) {
+        free(ids);
+        return NULL;
+    }
+    job.voice_cond = voice_cond;
+
+    job.ring = ptts_spsc_create(job.p.num_frames + 1, PTTS_FLOWLM_LATENT_DIM);
+    ptts_mimi_stream *st = ptts_mimi_stream_create(ctx->mimi);
+    ptts_audio *audio = ptts_audio_create(job.p.sample_rate, 1,
+                                          PTTS_MIMI_FRAME_SAMPLES * job.p.num_frames);
+    if (!job.ring || !st || !audio) {
+        ptts_spsc_free(job.ring);
+        ptts_mimi_stream_free(st);
+        ptts_audio_free(audio);
+        free(voice_cond);
+        free(ids);
+        ptts_set_error("Out of memory");
+        return NULL;
+    }
+
+    sched_submit(s, &job);
+
+    ptts_sched_result r;
+    memset(&r, 0, sizeof(r));
+    float chunk[SCHED_MAX_DECODE_CHUNK * PTTS_FLOWLM_LATENT_DIM];
+    double first_ms = -1.0;
+    int decoded = 0;
+    int failed = 0;
+    int stopped = 0;
+    while (ptts_spsc_pop_wait(job.ring, chunk) == 0) {
+        int m = 1;
+        while (m < SCHED_MAX_DECODE_CHUNK &&
+               ptts_spsc_pop(job.ring, chunk + (size_t)m * PTTS_FLOWLM_LATENT_DIM) == 0) {
+            m++;
+        }
+        int len = 0;
+        float *out = audio->samples + (size_t)decoded * PTTS_MIMI_FRAME_SAMPLES;
+        if (decoded + m > job.p.num_frames ||
+            ptts_mimi_stream_decode(st, chunk, m, out, &len) != 0 ||
+            len != m * PTTS_MIMI_FRAME_SAMPLES) {
+            failed = 1;
+            break;
+        }
+        if (on_audio && on_audio(user, out, len) != 0) {
+            stopped = 1;
+            break;
+        }
+        double now = ptts_time_ms();
+        if (first_ms < 0.0) {
+            first_ms = now;
+            r.ttfa_ms = now - job.submit_ms;
+        }
+        for (int f = decoded; f < decoded + m; f++) {
+            double late = now - (first_ms + f * SCHED_FRAME_MS);
+            if (late > 0.0) {
+                r.late_frames++;
+                if (late > r.max_late_ms) r.max_late_ms = late;
+            }
+        }
+        decoded += m;
+    }
+    if (failed || stopped) {
+        /* let the scheduler drop the session, then wait for it to let go */
+        __atomic_store_n(&job.cancel, 1, __ATOMIC_RELEASE);
+        while (ptts_spsc_pop_wait(job.ring, chunk) == 0) {
+        }
+    }
+    r.frames = decoded;
+    r.queue_ms = job.admit_ms > 0.0 ? job.admit_ms - job.submit_ms : 0.0;
+    int ok = !failed && !stopped && job.status == 0;
+
+    ptts_spsc_free(job.ring);
+    ptts_mimi_stream_free(st);
+    free(voice_cond);
+    free(ids);
+
+    pthread_mutex_lock(&s->lock);
+    if (ok) {
+        s->stats.completed++;
+        s->stats.late_frames += (unsigned long)r.late_frames;
+        if (first_ms >= 0.0) {
+            s->stats.ttfa_ms_sum += r.ttfa_ms;
+            s->stats.ttfa_n++;
+            if (r.ttfa_ms > s->stats.ttfa_ms_max) s->stats.ttfa_ms_max = r.ttfa_ms;
+        }
+    } else {
+        s->stats.failed++;
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    if (ptts_timing_enabled()) {
+        fprintf(stderr, "[ptts] Scheduler: %d frames, first audio %.2f ms (queued %.2f ms), "
+                "%d late (max %.2f ms)\n", r.frames, r.ttfa_ms, r.queue_ms, r.late_frames,
+                r.max_late_ms);
+    }
+    if (result) *result = r;
+
+    if (!ok) {
+        ptts_audio_free(audio);
+        if (stopped) {
+            ptts_set_error("Stopped by audio callback");
+        } else if (failed) {
+            ptts_set_error("Mimi decode failed");
+        } else {
+            ptts_set_error("FlowLM forward failed");
+        }
+        return NULL;
+    }
+    audio->num_samples = PTTS_MIMI_FRAME_SAMPLES * decoded;
+    return audio;
+}
@@ -0,0 +1,75 @@
+#ifndef PTTS_SCHED_H
+#define PTTS_SCHED_H
+
+#include "ptts.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Continuous batching. One scheduler thread owns FlowLM for every request:
+ * at each frame boundary it retires sessions that finished (EOS tail, frame
+ * limit, error or a cancelled caller), admits queued requests up to
+ * max_batch, spends at most prefill_chunk prefix positions on admitted
+ * requests that are still prefilling (oldest first, so decoding sessions
+ * are not starved by a long prompt), then steps every decoding session by
+ * one frame in a single batched transformer step.
+ *
+ * Callers block in ptts_sched_generate on their own thread, which decodes
+ * Mimi for its request as frames arrive and calls on_audio. The latents are
+ * the ones ptts_generate_stream would produce for the same request; the
+ * audio can differ by Mimi chunking rounding, as in the pipelined path.
+ */
+typedef struct ptts_sched ptts_sched;
+
+typedef struct {
+    int max_batch;     /* sessions stepped together (default 8) */
+    int prefill_chunk; /* prefix positions run per frame boundary (default 64) */
+} ptts_sched_opts;
+
+#define PTTS_SCHED_OPTS_DEFAULT { 8, 64 }
+
+/* Per request. Frame k of the audio is due k * 80 ms after the first audio
+ * reached on_audio (real-time playback); later frames count as late. */
+typedef struct {
+    double queue_ms;    /* submitted until admitted to the batch */
+    double ttfa_ms;     /* submitted until the first audio reached on_audio */
+    int frames;
+    int late_frames;
+    double max_late_ms;
+} ptts_sched_result;
+
+typedef struct {
+    unsigned long submitted;
+    unsigned long completed;
+    unsigned long failed;
+    unsigned long steps;       /* batched frame steps */
+    unsigned long frames;      /* frames over all sessions (frames / steps = mean batch) */
+    unsigned long late_frames;
+    double ttfa_ms_sum;
+    double ttfa_ms_max;
+    unsigned long ttfa_n;
+    int active;  /* sessions in the batch */
+    int waiting; /* submitted, not yet admitted */
+    int max_batch;
+} ptts_sched_stats;
+
+/* Preloads the models and starts the scheduler thread. */
+ptts_sched *ptts_sched_create(ptts_ctx *ctx, const ptts_sched_opts *opts);
+
+/* Finishes admitted and queued requests, then stops the thread. */
+void ptts_sched_free(ptts_sched *s);
+
+/* Same contract as ptts_generate_stream; result may be NULL. */
+ptts_audio *ptts_sched_generate(ptts_sched *s, const char *text, const char *voice_path,
+                                const ptts_params *params, ptts_audio_fn on_audio, void *user,
+                                ptts_sched_result *result);
+
+void ptts_sched_get_stats(ptts_sched *s, ptts_sched_stats *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTTS_SCHED_H */
@@ -0,0 +1,597 @@
+/*
+ * ptts_serve.c - HTTP/1.1 synthesis daemon with chunked audio streaming
+ */
+
+#define _GNU_SOURCE
+#include "ptts_serve.h"
+#include "ptts_prefork.h"
+#include "ptts_request.h"
+#include "ptts_sched.h"
+#include <errno.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#define SERVE_MAX_HEADER 16384
+#define SERVE_MAX_BODY (1 << 20)
+#define SERVE_IO_TIMEOUT_S 30
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int *fds; /* ring of accepted connections */
+    int cap;
+    int head;
+    int count;
+    int closing;
+} conn_queue;
+
+typedef struct {
+    pthread_mutex_t lock;
+    unsigned long requests;
+    unsigned long failed;
+    unsigned long rejected;
+    int active;
+    double audio_s;
+    double synth_s;
+    double first_audio_s;
+    unsigned long first_audio_n;
+    double started_ms;
+} serve_metrics;
+
+typedef struct {
+    ptts_ctx *ctx;
+    const ptts_serve_opts *opts;
+    ptts_sched *sched; /* NULL without max_batch */
+    conn_queue q;
+    serve_metrics m;
+} serve_state;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void on_stop(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+/* ========================================================================
+ * Socket I/O
+ * ======================================================================== */
+
+static int send_all(int fd, const void *buf, size_t len) {
+    const char *p = (const char *)buf;
+    while (len > 0) {
+        ssize_t w = send(fd, p, len, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+static int send_chunk(int fd, const void *data, size_t len) {
+    char hdr[32];
+    int n = snprintf(hdr, sizeof(hdr), "%zx\r\n", len);
+    if (send_all(fd, hdr, (size_t)n) != 0) return -1;
+    if (len > 0 && send_all(fd, data, len) != 0) return -1;
+    return send_all(fd, "\r\n", 2);
+}
+
+static void send_response(int fd, int status, const char *reason, const char *type,
+                          const char *body) {
+    char hdr[256];
+    size_t len = strlen(body);
+    int n = snprintf(hdr, sizeof(hdr),
+                     "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n"
+                     "Connection: close\r\n\r\n", status, reason, type, len);
+    if (send_all(fd, hdr, (size_t)n) == 0) send_all(fd, body, len);
+}
+
+static void send_error(int fd, int status, const char *reason, const char *msg) {
+    char body[384];
+    char esc[256];
+    size_t j = 0;
+    for (size_t i = 0; msg[i] && j + 2 < sizeof(esc); i++) {
+        unsigned char c = (unsigned char)msg[i];
+        if (c == '"' || c == '\\') esc[j++] = '\\';
+        esc[j++] = c < 0x20 ? ' ' : (char)c;
+    }
+    esc[j] = '\0';
+    snprintf(body, sizeof(body), "{\"error\": \"%s\"}\n", esc);
+    send_response(fd, status, reason, "application/json", body);
+}
+
+/* ========================================================================
+ * Handlers
+ * ======================================================================== */
+
+typedef struct {
+    int fd;
+    int pcm;
+    int sample_rate;
+    int started;
+    uint8_t *buf;
+    size_t buf_cap;
+    double t0;
+    double first_ms;
+} audio_stream;
+
+/* Headers go out with the first block, so failures before any audio still
+ * get a proper error status. */
+static int stream_start(audio_stream *as) {
+    char hdr[256];
+    int n = snprintf(hdr, sizeof(hdr),
+                     "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nX-Sample-Rate: %d\r\n"
+                     "Transfer-Encoding: chunked\r\nConnection: close\r\n\r\n",
+                     as->pcm ? "application/octet-stream" : "audio/wav", as->sample_rate);
+    as->started = 1;
+    as->first_ms = now_ms() - as->t0;
+    if (send_all(as->fd, hdr, (size_t)n) != 0) return -1;
+    if (!as->pcm) {
+        uint8_t wav[PTTS_WAV_HEADER_SIZE];
+        ptts_audio_wav_header(wav, as->sample_rate, 1, PTTS_WAV_SIZE_UNKNOWN);
+        if (send_chunk(as->fd, wav, sizeof(wav)) != 0) return -1;
+    }
+    return 0;
+}
+
+static int stream_on_audio(void *user, const float *samples, int num_samples) {
+    audio_stream *as = (audio_stream *)user;
+    if (!as->started && stream_start(as) != 0) return -1;
+    if (num_samples <= 0) return 0;
+    size_t bytes = (size_t)num_samples * 2;
+    if (bytes > as->buf_cap) {
+        uint8_t *nb = (uint8_t *)realloc(as->buf, bytes);
+        if (!nb) return -1;
+        as->buf = nb;
+        as->buf_cap = bytes;
+    }
+    ptts_audio_to_s16le(samples, (size_t)num_samples, as->buf);
+    /* a client that went away stops generation */
+    return send_chunk(as->fd, as->buf, bytes);
+}
+
+static void handle_synthesize(serve_state *st, int fd, const char *body, size_t body_len) {
+    ptts_request req;
+    const char *err = ptts_request_parse(body, body_len, &st->opts->params, &req);
+    if (err) {
+        send_error(fd, 400, "Bad Request", err);
+        ptts_request_clear(&req);
+        pthread_mutex_lock(&st->m.lock);
+        st->m.failed++;
+        pthread_mutex_unlock(&st->m.lock);
+        return;
+    }
+
+    const char *voice = req.voice ? req.voice : st->opts->voice;
+    audio_stream as;
+    memset(&as, 0, sizeof(as));
+    as.fd = fd;
+    as.pcm = req.pcm;
+    as.sample_rate = req.params.sample_rate > 0 ? req.params.sample_rate : PTTS_DEFAULT_SAMPLE_RATE;
+    as.t0 = now_ms();
+
+    pthread_mutex_lock(&st->m.lock);
+    st->m.active++;
+    pthread_mutex_unlock(&st->m.lock);
+
+    ptts_audio *audio = st->sched
+        ? ptts_sched_generate(st->sched, req.text, voice, &req.params, stream_on_audio, &as, NULL)
+        : ptts_generate_stream(st->ctx, req.text, voice, &req.params, stream_on_audio, &as);
+    double ms = now_ms() - as.t0;
+    int ok = audio != NULL && (as.started || stream_start(&as) == 0) &&
+             send_chunk(fd, NULL, 0) == 0;
+    if (!audio && !as.started) {
+        send_error(fd, 500, "Internal Server Error", ptts_get_error());
+    }
+    /* after the 200 went out, a failure can only cut the stream short */
+
+    double audio_s = audio ? (double)audio->num_samples / as.sample_rate : 0.0;
+    pthread_mutex_lock(&st->m.lock);
+    st->m.active--;
+    if (ok) {
+        st->m.audio_s += audio_s;
+        st->m.synth_s += ms / 1000.0;
+        st->m.first_audio_s += as.first_ms / 1000.0;
+        st->m.first_audio_n++;
+    } else {
+        st->m.failed++;
+    }
+    pthread_mutex_unlock(&st->m.lock);
+
+    if (ok) {
+        fprintf(stderr, "[ptts] serve: %.2f s audio in %.1f ms (first audio %.1f ms, %s)\n",
+                audio_s, ms, as.first_ms, req.pcm ? "pcm" : "wav");
+    } else {
+        fprintf(stderr, "[ptts] serve: synthesis failed after %.1f ms: %s\n", ms,
+                audio ? "client disconnected" : ptts_get_error());
+    }
+    ptts_audio_free(audio);
+    free(as.buf);
+    ptts_request_clear(&req);
+}
+
+static void handle_metrics(serve_state *st, int fd) {
+    serve_metrics m;
+    pthread_mutex_lock(&st->m.lock);
+    m = st->m;
+    pthread_mutex_unlock(&st->m.lock);
+    pthread_mutex_lock(&st->q.lock);
+    int queued = st->q.count;
+    pthread_mutex_unlock(&st->q.lock);
+    ptts_proc_mem mem = {0, 0, 0};
+    ptts_proc_mem_read(0, &mem);
+
+    char body[4096];
+    int len = snprintf(body, sizeof(body),
+             "# TYPE ptts_requests_total counter\nptts_requests_total %lu\n"
+             "# TYPE ptts_requests_failed_total counter\nptts_requests_failed_total %lu\n"
+             "# TYPE ptts_requests_rejected_total counter\nptts_requests_rejected_total %lu\n"
+             "# TYPE ptts_requests_active gauge\nptts_requests_active %d\n"
+             "# TYPE ptts_queue_depth gauge\nptts_queue_depth %d\n"
+             "# TYPE ptts_workers gauge\nptts_workers %d\n"
+             "# TYPE ptts_audio_seconds_total counter\nptts_audio_seconds_total %.3f\n"
+             "# TYPE ptts_synthesis_seconds_total counter\nptts_synthesis_seconds_total %.3f\n"
+             "# TYPE ptts_first_audio_seconds summary\n"
+             "ptts_first_audio_seconds_sum %.3f\nptts_first_audio_seconds_count %lu\n"
+             "# TYPE ptts_resident_memory_bytes gauge\nptts_resident_memory_bytes %ld\n"
+             "# TYPE ptts_uptime_seconds gauge\nptts_uptime_seconds %.0f\n",
+             m.requests, m.failed, m.rejected, m.active, queued, st->opts->workers,
+             m.audio_s, m.synth_s, m.first_audio_s, m.first_audio_n, mem.rss_kb * 1024L,
+             (now_ms() - m.started_ms) / 1000.0);
+    if (st->sched && len > 0 && (size_t)len < sizeof(body)) {
+        ptts_sched_stats ss;
+        ptts_sched_get_stats(st->sched, &ss);
+        snprintf(body + len, sizeof(body) - (size_t)len,
+                 "# TYPE ptts_batch_sessions gauge\nptts_batch_sessions %d\n"
+                 "# TYPE ptts_batch_waiting gauge\nptts_batch_waiting %d\n"
+                 "# TYPE ptts_batch_max gauge\nptts_batch_max %d\n"
+                 "# TYPE ptts_batch_steps_total counter\nptts_batch_steps_total %lu\n"
+                 "# TYPE ptts_batch_frames_total counter\nptts_batch_frames_total %lu\n"
+                 "# TYPE ptts_batch_late_frames_total counter\nptts_batch_late_frames_total %lu\n"
+                 "# TYPE ptts_batch_ttfa_seconds summary\n"
+                 "ptts_batch_ttfa_seconds_sum %.3f\nptts_batch_ttfa_seconds_count %lu\n"
+                 "# TYPE ptts_batch_ttfa_max_seconds gauge\nptts_batch_ttfa_max_seconds %.3f\n",
+                 ss.active, ss.waiting, ss.max_batch, ss.steps, ss.frames, ss.late_frames,
+                 ss.ttfa_ms_sum / 1000.0, ss.ttfa_n, ss.ttfa_ms_max / 1000.0);
+    }
+    ptts_governor_stats gs;
+    ptts_governor_get_stats(st->ctx, &gs);
+    if (gs.enabled && len > 0 && (size_t)len < sizeof(body)) {
+        len = (int)strlen(body);
+        snprintf(body + len, sizeof(body) - (size_t)len,
+                 "# TYPE ptts_governor_frames_total counter\nptts_governor_frames_total %lu\n"
+                 "# TYPE ptts_governor_underruns_total counter\nptts_governor_underruns_total %lu\n"
+                 "# TYPE ptts_governor_steps_lowered_total counter\n"
+                 "ptts_governor_steps_lowered_total %lu\n"
+                 "# TYPE ptts_governor_steps_raised_total counter\n"
+                 "ptts_governor_steps_raised_total %lu\n",
+                 gs.frames, gs.underruns, gs.lowered, gs.raised);
+    }
+    send_response(fd, 200, "OK", "text/plain; version=0.0.4", body);
+}
+
+/* Reads one request (headers, then Content-Length bytes of body) and
+ * dispatches it. Every response closes the connection. */
+static void handle_connection(serve_state *st, int fd) {
+    struct timeval tv = {SERVE_IO_TIMEOUT_S, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    char *buf = (char *)malloc(SERVE_MAX_HEADER + 1);
+    if (!buf) return;
+    size_t len = 0;
+    char *end = NULL;
+    while (!end && len < SERVE_MAX_HEADER) {
+        ssize_t r = recv(fd, buf + len, SERVE_MAX_HEADER - len, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) break;
+        len += (size_t)r;
+        buf[len] = '\0';
+        end = strstr(buf, "\r\n\r\n");
+    }
+    if (!end) {
+        if (len > 0) send_error(fd, 400, "Bad Request", "incomplete request header");
+        free(buf);
+        return;
+    }
+    *end = '\0';
+    size_t head_len = (size_t)(end - buf) + 4;
+
+    char method[16], path[256];
+    if (sscanf(buf, "%15s %255s", method, path) != 2) {
+        send_error(fd, 400, "Bad Request", "bad request line");
+        free(buf);
+        return;
+    }
+    char *q = strchr(path, '?');
+    if (q) *q = '\0';
+
+    long content_len = -1;
+    int expect_continue = 0;
+    int chunked = 0;
+    for (char *line = strstr(buf, "\r\n"); line; line = strstr(line, "\r\n")) {
+        line += 2;
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            content_len = strtol(line + 15, NULL, 10);
+        } else if (strncasecmp(line, "Expect:", 7) == 0) {
+            expect_continue = strstr(line, "100-continue") != NULL;
+        } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+            chunked = 1;
+        }
+    }
+
+    pthread_mutex_lock(&st->m.lock);
+    st->m.requests++;
+    pthread_mutex_unlock(&st->m.lock);
+
+    if (strcmp(path, "/metrics") == 0 || strcmp(path, "/health") == 0) {
+        if (strcmp(method, "GET") != 0) {
+            send_error(fd, 405, "Method Not Allowed", "use GET");
+        } else if (path[1] == 'm') {
+            handle_metrics(st, fd);
+        } else {
+            send_response(fd, 200, "OK", "text/plain", "ok\n");
+        }
+    } else if (strcmp(path, "/synthesize") == 0) {
+        if (strcmp(method, "POST") != 0) {
+            send_error(fd, 405, "Method Not Allowed", "use POST with a JSON body");
+        } else if (chunked || content_len < 0) {
+            send_error(fd, 411, "Length Required", "Content-Length required");
+        } else if (content_len > SERVE_MAX_BODY) {
+            send_error(fd, 413, "Payload Too Large", "request body too large");
+        } else {
+            char *body = (char *)malloc((size_t)content_len + 1);
+            size_t have = len - head_len;
+            if (have > (size_t)content_len) have = (size_t)content_len;
+            if (body) memcpy(body, buf + head_len, have);
+            if (body && have < (size_t)content_len && expect_continue) {
+                send_all(fd, "HTTP/1.1 100 Continue\r\n\r\n", 25);
+            }
+            while (body && have < (size_t)content_len) {
+                ssize_t r = recv(fd, body + have, (size_t)content_len - have, 0);
+                if (r < 0 && errno == EINTR) continue;
+                if (r <= 0) break;
+                have += (size_t)r;
+            }
+            if (!body) {
+                send_error(fd, 500, "Internal Server Error", "out of memory");
+            } else if (have < (size_t)content_len) {
+                send_error(fd, 400, "Bad Request", "truncated body");
+            } else {
+                body[have] = '\0';
+                handle_synthesize(st, fd, body, have);
+            }
+            free(body);
+        }
+    } else {
+        send_error(fd, 404, "Not Found", "unknown path");
+    }
+    free(buf);
+}
+
+/* ========================================================================
+ * Worker pool
+ * ======================================================================== */
+
+static void *worker_main(void *arg) {
+    serve_state *st = (serve_state *)arg;
+    conn_queue *q = &st->q;
+    for (;;) {
+        pthread_mutex_lock(&q->lock);
+        while (q->count == 0 && !q->closing) pthread_cond_wait(&q->cond, &q->lock);
+        if (q->count == 0) {
+            pthread_mutex_unlock(&q->lock);
+            return NULL;
+        }
+        int fd = q->fds[q->head];
+        q->head = (q->head + 1) % q->cap;
+        q->count--;
+        pthread_mutex_unlock(&q->lock);
+        handle_connection(st, fd);
+        close(fd);
+    }
+}
+
+/* Returns 0 when queued, -1 when the queue is full. */
+static int queue_push(conn_queue *q, int fd) {
+    pthread_mutex_lock(&q->lock);
+    if (q->count == q->cap) {
+        pthread_mutex_unlock(&q->lock);
+        return -1;
+    }
+    q->fds[(q->head + q->count) % q->cap] = fd;
+    q->count++;
+    pthread_cond_signal(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+    return 0;
+}
+
+/* ========================================================================
+ * Listener
+ * ======================================================================== */
+
+static int open_listener(const char *spec, int *is_unix) {
+    *is_unix = strchr(spec, '/') != NULL;
+    if (*is_unix) {
+        struct sockaddr_un addr;
+        if (strlen(spec) >= sizeof(addr.sun_path)) return -1;
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, spec);
+        unlink(spec);
+        if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    char host[256] = "127.0.0.1";
+    const char *port = spec;
+    const char *colon = strrchr(spec, ':');
+    if (colon) {
+        size_t hl = (size_t)(colon - spec);
+        if (hl >= sizeof(host)) return -1;
+        if (hl > 0) {
+            memcpy(host, spec, hl);
+            host[hl] = '\0';
+        }
+        port = colon + 1;
+    }
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo(host, port, &hints, &res) != 0) return -1;
+    int fd = -1;
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, 64) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+int ptts_serve(ptts_ctx *ctx, const ptts_serve_opts *opts) {
+    if (!ctx || !opts || !opts->listen) return -1;
+    ptts_serve_opts o = *opts;
+    if (o.workers < 1) o.workers = 1;
+    if (o.queue < 1) o.queue = 16;
+
+    /* Concurrent requests would queue for the model's one flow-net team;
+     * each runs its flow net on its own thread instead. The scheduler is the
+     * only FlowLM user, so it keeps the team. */
+    if (o.workers > 1 && o.max_batch <= 0) unsetenv("PTTS_FLOW_THREADS");
+    /* Without the scheduler every worker runs its own FlowLM session. */
+    if (o.workers > 1 && o.max_batch <= 0 && ptts_session_limit(ctx) == 1) {
+        fprintf(stderr, "[ptts] serve: CUDA KV cache holds one session, using 1 worker\n");
+        o.workers = 1;
+    }
+    if (ptts_preload(ctx, 0) != 0) return -1;
+    ptts_sched *sched = NULL;
+    if (o.max_batch > 0) {
+        ptts_sched_opts so = PTTS_SCHED_OPTS_DEFAULT;
+        so.max_batch = o.max_batch;
+        sched = ptts_sched_create(ctx, &so);
+        if (!sched) return -1;
+    }
+
+    int is_unix = 0;
+    int listen_fd = open_listener(o.listen, &is_unix);
+    if (listen_fd < 0) {
+        fprintf(stderr, "[ptts] serve: cannot listen on %s: %s\n", o.listen, strerror(errno));
+        ptts_sched_free(sched);
+        return -1;
+    }
+
+    serve_state st;
+    memset(&st, 0, sizeof(st));
+    st.ctx = ctx;
+    st.opts = &o;
+    st.sched = sched;
+    st.q.cap = o.queue;
+    st.q.fds = (int *)malloc(sizeof(int) * (size_t)o.queue);
+    pthread_t *threads = (pthread_t *)calloc((size_t)o.workers, sizeof(pthread_t));
+    if (!st.q.fds || !threads) {
+        free(st.q.fds);
+        free(threads);
+        close(listen_fd);
+        ptts_sched_free(sched);
+        return -1;
+    }
+    pthread_mutex_init(&st.q.lock, NULL);
+    pthread_cond_init(&st.q.cond, NULL);
+    pthread_mutex_init(&st.m.lock, NULL);
+    st.m.started_ms = now_ms();
+
+    /* Workers inherit a mask with the stop signals blocked, so they always
+     * interrupt accept() in this thread. */
+    sigset_t stop_set, old_set;
+    sigemptyset(&stop_set);
+    sigaddset(&stop_set, SIGINT);
+    sigaddset(&stop_set, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_set, &old_set);
+    int started = 0;
+    for (; started < o.workers; started++) {
+        if (pthread_create(&threads[started], NULL, worker_main, &st) != 0) break;
+    }
+    pthread_sigmask(SIG_SETMASK, &old_set, NULL);
+
+    struct sigaction sa, old_int, old_term;
+    memset(&sa, 0, sizeof(sa));
+    sigemptyset(&sa.sa_mask);
+    sa.sa_handler = on_stop; /* no SA_RESTART: accept returns EINTR */
+    sigaction(SIGINT, &sa, &old_int);
+    sigaction(SIGTERM, &sa, &old_term);
+    signal(SIGPIPE, SIG_IGN);
+
+    int rc = started == o.workers ? 0 : -1;
+    if (rc == 0) {
+        fprintf(stderr, "[ptts] serve: listening on %s (%d workers, queue %d", o.listen,
+                o.workers, o.queue);
+        if (sched) fprintf(stderr, ", batch %d", o.max_batch);
+        fprintf(stderr, ")\n");
+    }
+    while (rc == 0 && !stop_requested) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            fprintf(stderr, "[ptts] serve: accept failed: %s\n", strerror(errno));
+            rc = -1;
+            break;
+        }
+        if (queue_push(&st.q, fd) != 0) {
+            send_error(fd, 503, "Service Unavailable", "server busy");
+            close(fd);
+            pthread_mutex_lock(&st.m.lock);
+            st.m.rejected++;
+            pthread_mutex_unlock(&st.m.lock);
+        }
+    }
+
+    close(listen_fd);
+    if (is_unix) unlink(o.listen);
+    pthread_mutex_lock(&st.q.lock);
+    st.q.closing = 1;
+    pthread_cond_broadcast(&st.q.cond);
+    pthread_mutex_unlock(&st.q.lock);
+    for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    ptts_sched_free(sched);
+    fprintf(stderr, "[ptts] serve: stopped after %lu requests\n", st.m.requests);
+
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+    pthread_cond_destroy(&st.q.cond);
+    pthread_mutex_destroy(&st.q.lock);
+    pthread_mutex_destroy(&st.m.lock);
+    free(st.q.fds);
+    free(threads);
+    return rc;
+}
@@ -0,0 +1,42 @@
+#ifndef PTTS_SERVE_H
+#define PTTS_SERVE_H
+
+#include "ptts.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * HTTP/1.1 synthesis daemon. The model stays loaded; a fixed pool of worker
+ * threads serves connections from a bounded queue (full queue: 503).
+ *
+ *   POST /synthesize  JSON request (ptts_request.h); the audio is streamed back
+ *                     with chunked transfer encoding as frames are decoded
+ *                     (16-bit mono; "pcm" is raw little-endian samples)
+ *   GET  /metrics     Prometheus text format counters
+ *   GET  /health      "ok"
+ *
+ * With max_batch, the workers hand FlowLM to one scheduler thread that steps
+ * up to max_batch requests per frame together; workers should then be at
+ * least max_batch, as each still decodes Mimi for its own request.
+ *
+ * Fields a request omits take their values from opts->params / opts->voice.
+ * Runs until SIGINT or SIGTERM, then finishes queued requests and returns 0.
+ */
+typedef struct {
+    const char *listen;  /* "HOST:PORT", "PORT", or a Unix socket path (has '/') */
+    int workers;         /* concurrent syntheses (default 1) */
+    int queue;           /* accepted connections waiting for a worker (default 16) */
+    int max_batch;       /* > 0: workers share a continuous-batching scheduler (ptts_sched.h) */
+    const char *voice;   /* default voice, NULL for the built-in default */
+    ptts_params params;  /* default generation parameters */
+} ptts_serve_opts;
+
+int ptts_serve(ptts_ctx *ctx, const ptts_serve_opts *opts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTTS_SERVE_H */
@@ -40,6 +40,13 @@ struct ptts_spm {
     int *user_pieces_len;
     int num_user_pieces;
     int cap_user_pieces;
+    /* Double-array trie over piece bytes: child of s on byte c is
+     * t = da_base[s] + c + 1 when da_check[t] == s; da_id[t] is the piece
+     * ending at t (-1 if none). The root is index 0. */
+    int32_t *da_base;
+    int32_t *da_check;
+    int32_t *da_id;
+    int da_size;
 };
 
 /* ========================================================================
@@ -226,16 +233,159 @@ static int is_utf8_lead(unsigned char c) {
     return (c & 0xC0) != 0x80;
 }
 
-static int boundary_index_for_offset(const int *pos, int n, int offset) {
-    int lo = 0, hi = n;
-    while (lo <= hi) {
-        int mid = (lo + hi) / 2;
-        int v = pos[mid];
-        if (v == offset) return mid;
-        if (v < offset) lo = mid + 1;
-        else hi = mid - 1;
+/* ========================================================================
+ * Piece trie
+ *
+ * Built once at load: a pointer trie over the piece bytes is laid out
+ * breadth-first into a double array, so matching every piece that starts
+ * at a text offset is one array lookup per byte. Pieces with identical
+ * bytes keep the best score (lowest id on ties), which is the piece the
+ * Viterbi pass would have chosen among them.
+ * ======================================================================== */
+
+typedef struct {
+    int first_child;
+    int next_sibling;
+    int id;
+    int da_index;
+    unsigned char label;
+} spm_trie_node;
+
+static int spm_trie_insert(spm_trie_node **nodes, int *n, int *cap,
+                           const struct ptts_spm_piece *pieces, int id) {
+    const struct ptts_spm_piece *piece = &pieces[id];
+    int s = 0;
+    for (int k = 0; k < piece->len; k++) {
+        unsigned char c = (unsigned char)piece->bytes[k];
+        int child = (*nodes)[s].first_child;
+        while (child >= 0 && (*nodes)[child].label != c) child = (*nodes)[child].next_sibling;
+        if (child < 0) {
+            if (*n >= *cap) {
+                int new_cap = *cap * 2;
+                spm_trie_node *nn = (spm_trie_node *)realloc(*nodes,
+                                                             (size_t)new_cap * sizeof(spm_trie_node));
+                if (!nn) return -1;
+                *nodes = nn;
+                *cap = new_cap;
+            }
+            child = (*n)++;
+            (*nodes)[child].first_child = -1;
+            (*nodes)[child].next_sibling = (*nodes)[s].first_child;
+            (*nodes)[child].id = -1;
+            (*nodes)[child].da_index = -1;
+            (*nodes)[child].label = c;
+            (*nodes)[s].first_child = child;
+        }
+        s = child;
     }
-    return -1;
+    int old = (*nodes)[s].id;
+    if (old < 0 || piece->score > pieces[old].score) (*nodes)[s].id = id;
+    return 0;
+}
+
+/* Grow the double array to at least need slots; new slots are free. free_up
+ * (n slots, resized alongside) maps a slot to itself when free, otherwise
+ * toward the next candidate (see spm_da_find_free). */
+static int spm_da_reserve(ptts_spm *spm, int need, int **free_up) {
+    if (need <= spm->da_size) return 0;
+    int new_size = spm->da_size ? spm->da_size : 1024;
+    while (new_size < need) new_size *= 2;
+    int32_t *nb = (int32_t *)realloc(spm->da_base, (size_t)new_size * sizeof(int32_t));
+    if (nb) spm->da_base = nb;
+    int32_t *nc = (int32_t *)realloc(spm->da_check, (size_t)new_size * sizeof(int32_t));
+    if (nc) spm->da_check = nc;
+    int32_t *ni = (int32_t *)realloc(spm->da_id, (size_t)new_size * sizeof(int32_t));
+    if (ni) spm->da_id = ni;
+    int *nf = (int *)realloc(*free_up, (size_t)(new_size + 1) * sizeof(int));
+    if (nf) *free_up = nf;
+    if (!nb || !nc || !ni || !nf) return -1;
+    for (int i = spm->da_size; i < new_size; i++) {
+        spm->da_base[i] = 0;
+        spm->da_check[i] = -1;
+        spm->da_id[i] = -1;
+        nf[i] = i;
+    }
+    nf[new_size] = new_size; /* sentinel: "free" past the end, grown on use */
+    spm->da_size = new_size;
+    return 0;
+}
+
+/* Lowest free slot >= i (union-find with path halving over used slots). */
+static int spm_da_find_free(int *free_up, int i) {
+    while (free_up[i] != i) {
+        free_up[i] = free_up[free_up[i]];
+        i = free_up[i];
+    }
+    return i;
+}
+
+static int spm_build_trie(ptts_spm *spm) {
+    int cap = 1024;
+    int n = 1;
+    spm_trie_node *nodes = (spm_trie_node *)malloc((size_t)cap * sizeof(spm_trie_node));
+    if (!nodes) return -1;
+    nodes[0].first_child = -1;
+    nodes[0].next_sibling = -1;
+    nodes[0].id = -1;
+    nodes[0].da_index = 0;
+    nodes[0].label = 0;
+    for (int j = 0; j < spm->num_pieces; j++) {
+        if (!spm->pieces[j].bytes || spm->pieces[j].len <= 0) continue;
+        if (spm_trie_insert(&nodes, &n, &cap, spm->pieces, j) != 0) {
+            free(nodes);
+            return -1;
+        }
+    }
+
+    int *free_up = NULL;
+    int *queue = (int *)malloc((size_t)n * sizeof(int));
+    int rc = -1;
+    if (!queue || spm_da_reserve(spm, 1024, &free_up) != 0) goto done;
+    spm->da_check[0] = -2; /* root: never a child slot */
+    free_up[0] = 1;
+    int head = 0, tail = 0;
+    queue[tail++] = 0;
+    while (head < tail) {
+        int node = queue[head++];
+        int s = nodes[node].da_index;
+        int lo = 256, hi = 0;
+        for (int c = nodes[node].first_child; c >= 0; c = nodes[c].next_sibling) {
+            if (nodes[c].label < lo) lo = nodes[c].label;
+            if (nodes[c].label > hi) hi = nodes[c].label;
+        }
+        if (lo > hi) continue;
+
+        /* Put the lowest label on the first free slot that leaves room for
+         * the other children; only free slots are visited. */
+        int base;
+        int f = spm_da_find_free(free_up, lo + 1);
+        for (;;) {
+            base = f - lo - 1;
+            if (spm_da_reserve(spm, base + hi + 2, &free_up) != 0) goto done;
+            int ok = 1;
+            for (int c = nodes[node].first_child; c >= 0 && ok; c = nodes[c].next_sibling) {
+                ok = spm->da_check[base + nodes[c].label + 1] == -1;
+            }
+            if (ok) break;
+            f = spm_da_find_free(free_up, f + 1);
+        }
+        spm->da_base[s] = base;
+        for (int c = nodes[node].first_child; c >= 0; c = nodes[c].next_sibling) {
+            int t = base + nodes[c].label + 1;
+            spm->da_check[t] = s;
+            spm->da_id[t] = nodes[c].id;
+            free_up[t] = t + 1;
+            nodes[c].da_index = t;
+            queue[tail++] = c;
+        }
+    }
+    rc = 0;
+
+done:
+    free(free_up);
+    free(queue);
+    free(nodes);
+    return rc;
 }
 
 /* ========================================================================
@@ -583,7 +733,7 @@ ptts_spm *ptts_spm_load(const char *path) {
     }
 
     free(buf);
-    if (spm->num_pieces == 0) {
+    if (spm->num_pieces == 0 || spm_build_trie(spm) != 0) {
         ptts_spm_free(spm);
         return NULL;
     }
@@ -600,6 +750,9 @@ void ptts_spm_free(ptts_spm *spm) {
     free(spm->charsmap);
     free(spm->user_pieces);
     free(spm->user_pieces_len);
+    free(spm->da_base);
+    free(spm->da_check);
+    free(spm->da_id);
     free(spm);
 }
 
@@ -628,18 +781,27 @@ int ptts_spm_encode(const ptts_spm *spm, const char *text, int **out_ids, int *o
         return 0;
     }
 
+    /* pos: byte offset of each character boundary; bidx: the inverse,
+     * boundary index of each byte offset (-1 inside a character). */
     int *pos = (int *)malloc((size_t)(norm_len + 2) * sizeof(int));
-    if (!pos) {
+    int *bidx = (int *)malloc((size_t)(norm_len + 1) * sizeof(int));
+    if (!pos || !bidx) {
         free(norm);
+        free(pos);
+        free(bidx);
         return -1;
     }
 
     int n_pos = 0;
     for (int i = 0; i < norm_len; i++) {
         if (is_utf8_lead((unsigned char)norm[i])) {
+            bidx[i] = n_pos;
             pos[n_pos++] = i;
+        } else {
+            bidx[i] = -1;
         }
     }
+    bidx[norm_len] = n_pos;
     pos[n_pos++] = norm_len;
 
     const float NEG = -1e30f;
@@ -649,6 +811,7 @@ int ptts_spm_encode(const ptts_spm *spm, const char *text, int **out_ids, int *o
     if (!dp || !prev || !best_id) {
         free(norm);
         free(pos);
+        free(bidx);
         free(dp);
         free(prev);
         free(best_id);
@@ -667,17 +830,20 @@ int ptts_spm_encode(const ptts_spm *spm, const char *text, int **out_ids, int *o
         int matched = 0;
         int start = pos[i];
 
-        for (int j = 0; j < spm->num_pieces; j++) {
-            struct ptts_spm_piece *piece = &spm->pieces[j];
-            if (!piece->bytes || piece->len <= 0) continue;
-            int end = start + piece->len;
-            if (end > norm_len) continue;
-            if (memcmp(norm + start, piece->bytes, (size_t)piece->len) != 0) continue;
-
-            int end_idx = boundary_index_for_offset(pos, n_pos - 1, end);
+        /* Walk the trie along the text; every node with a piece is a match. */
+        int s = 0;
+        for (int end = start; end < norm_len; ) {
+            int t = spm->da_base[s] + (unsigned char)norm[end] + 1;
+            if (t >= spm->da_size || spm->da_check[t] != s) break;
+            s = t;
+            end++;
+            int j = spm->da_id[s];
+            if (j < 0) continue;
+
+            int end_idx = bidx[end];
             if (end_idx < 0) continue;
 
-            float score = dp[i] + piece->score;
+            float score = dp[i] + spm->pieces[j].score;
             if (score > dp[end_idx]) {
                 dp[end_idx] = score;
                 prev[end_idx] = i;
@@ -701,6 +867,7 @@ int ptts_spm_encode(const ptts_spm *spm, const char *text, int **out_ids, int *o
     if (prev[end_idx] < 0) {
         free(norm);
         free(pos);
+        free(bidx);
         free(dp);
         free(prev);
         free(best_id);
@@ -714,6 +881,7 @@ int ptts_spm_encode(const ptts_spm *spm, const char *text, int **out_ids, int *o
     if (!ids) {
         free(norm);
         free(pos);
+        free(bidx);
         free(dp);
         free(prev);
         free(best_id);
@@ -731,6 +899,7 @@ int ptts_spm_encode(const ptts_spm *spm, const char *text, int **out_ids, int *o
 
     free(norm);
     free(pos);
+    free(bidx);
     free(dp);
     free(prev);
     free(best_id);
@@ -0,0 +1,148 @@
+/*
+ * ptts_spsc.c - Lock-free SPSC ring buffer
+ */
+
+#include "ptts_spsc.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Spins, then yields, for this many polls before sleeping. */
+#define SPSC_SPIN_POLLS 64
+#define SPSC_YIELD_POLLS 256
+
+struct ptts_spsc {
+    int mask;
+    int slot_floats;
+    float *slots;
+    /* head/tail on separate cache lines so the two threads do not contend */
+    _Alignas(64) atomic_uint head; /* next slot to pop (consumer) */
+    _Alignas(64) atomic_uint tail; /* next slot to push (producer) */
+    _Alignas(64) atomic_int closed;
+    atomic_int waiters; /* threads asleep in park */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+ptts_spsc *ptts_spsc_create(int capacity, int slot_floats) {
+    if (capacity < 1 || slot_floats < 1) return NULL;
+    int cap = 1;
+    while (cap < capacity) cap <<= 1;
+    ptts_spsc *q = (ptts_spsc *)aligned_alloc(64, (sizeof(ptts_spsc) + 63) & ~(size_t)63);
+    if (!q) return NULL;
+    memset(q, 0, sizeof(*q));
+    q->slots = (float *)malloc((size_t)cap * slot_floats * sizeof(float));
+    if (!q->slots) {
+        free(q);
+        return NULL;
+    }
+    q->mask = cap - 1;
+    q->slot_floats = slot_floats;
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->closed, 0);
+    atomic_init(&q->waiters, 0);
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->cond, NULL);
+    return q;
+}
+
+void ptts_spsc_free(ptts_spsc *q) {
+    if (!q) return;
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->lock);
+    free(q->slots);
+    free(q);
+}
+
+/* Wakes a sleeper after head, tail or closed changed. The fence pairs with
+ * the one in park: either the sleeper sees the change before it waits, or
+ * this sees it waiting and signals under the lock. */
+static void wake(ptts_spsc *q) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&q->waiters, memory_order_relaxed) > 0) {
+        pthread_mutex_lock(&q->lock);
+        pthread_cond_broadcast(&q->cond);
+        pthread_mutex_unlock(&q->lock);
+    }
+}
+
+int ptts_spsc_push(ptts_spsc *q, const float *slot) {
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&q->head, memory_order_acquire);
+    if (tail - head > (unsigned)q->mask) return -1;
+    memcpy(q->slots + (size_t)(tail & (unsigned)q->mask) * q->slot_floats, slot,
+           (size_t)q->slot_floats * sizeof(float));
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    wake(q);
+    return 0;
+}
+
+int ptts_spsc_pop(ptts_spsc *q, float *slot) {
+    unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    if (head == tail) return -1;
+    memcpy(slot, q->slots + (size_t)(head & (unsigned)q->mask) * q->slot_floats,
+           (size_t)q->slot_floats * sizeof(float));
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    wake(q);
+    return 0;
+}
+
+/* Spin briefly, then yield; past the budget callers park instead. */
+static void backoff(int *spins) {
+    if ((*spins)++ >= SPSC_SPIN_POLLS) sched_yield();
+}
+
+/* Sleeps until the ring is closed or, for a consumer, not empty (for a
+ * producer, not full). */
+static void park(ptts_spsc *q, int consumer) {
+    pthread_mutex_lock(&q->lock);
+    atomic_fetch_add_explicit(&q->waiters, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    for (;;) {
+        if (atomic_load_explicit(&q->closed, memory_order_acquire)) break;
+        unsigned head = atomic_load_explicit(&q->head, memory_order_acquire);
+        unsigned tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+        if (consumer ? head != tail : tail - head <= (unsigned)q->mask) break;
+        pthread_cond_wait(&q->cond, &q->lock);
+    }
+    atomic_fetch_sub_explicit(&q->waiters, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&q->lock);
+}
+
+int ptts_spsc_push_wait(ptts_spsc *q, const float *slot) {
+    int spins = 0;
+    for (;;) {
+        if (atomic_load_explicit(&q->closed, memory_order_acquire)) return -1;
+        if (ptts_spsc_push(q, slot) == 0) return 0;
+        if (spins < SPSC_YIELD_POLLS) backoff(&spins);
+        else park(q, 0);
+    }
+}
+
+int ptts_spsc_pop_wait(ptts_spsc *q, float *slot) {
+    int spins = 0;
+    for (;;) {
+        if (ptts_spsc_pop(q, slot) == 0) return 0;
+        if (atomic_load_explicit(&q->closed, memory_order_acquire)) {
+            /* a push may have landed between the pop and the close check */
+            return ptts_spsc_pop(q, slot);
+        }
+        if (spins < SPSC_YIELD_POLLS) backoff(&spins);
+        else park(q, 1);
+    }
+}
+
+void ptts_spsc_close(ptts_spsc *q) {
+    atomic_store_explicit(&q->closed, 1, memory_order_release);
+    wake(q);
+}
+
+int ptts_spsc_size(const ptts_spsc *q) {
+    unsigned head = atomic_load_explicit(&((ptts_spsc *)q)->head, memory_order_acquire);
+    unsigned tail = atomic_load_explicit(&((ptts_spsc *)q)->tail, memory_order_acquire);
+    return (int)(tail - head);
+}
@@ -0,0 +1,38 @@
+#ifndef PTTS_SPSC_H
+#define PTTS_SPSC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Lock-free single-producer/single-consumer ring of fixed-size float slots.
+ * One thread pushes, one thread pops; either side may close the ring, after
+ * which pushes fail and pops drain what is left. The *_wait variants spin,
+ * then yield, then sleep on a condition variable that the other side
+ * signals on push, pop and close; the non-blocking calls only take its lock
+ * when someone is asleep.
+ */
+
+typedef struct ptts_spsc ptts_spsc;
+
+/* capacity is rounded up to a power of two. */
+ptts_spsc *ptts_spsc_create(int capacity, int slot_floats);
+void ptts_spsc_free(ptts_spsc *q);
+
+/* Non-blocking: 0 on success, -1 when full/empty. */
+int ptts_spsc_push(ptts_spsc *q, const float *slot);
+int ptts_spsc_pop(ptts_spsc *q, float *slot);
+
+/* Blocking: 0 on success, -1 once the ring is closed (and, for pop, drained). */
+int ptts_spsc_push_wait(ptts_spsc *q, const float *slot);
+int ptts_spsc_pop_wait(ptts_spsc *q, float *slot);
+
+void ptts_spsc_close(ptts_spsc *q);
+int ptts_spsc_size(const ptts_spsc *q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTTS_SPSC_H */
@@ -0,0 +1,204 @@
+/*
+ * ptts_team.c - Pinned SPMD thread team
+ */
+
+#define _GNU_SOURCE
+#include "ptts_team.h"
+#include "ptts_trace.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Spins, then yields, for this many polls before sleeping. */
+#define TEAM_SPIN_POLLS 2048
+#define TEAM_YIELD_POLLS 4096
+
+typedef struct {
+    ptts_team *team;
+    int index;
+    pthread_t thread;
+} team_worker;
+
+struct ptts_team {
+    int num_workers;
+    int pin;
+    int own0;                         /* worker 0 is a team thread, not the caller */
+    team_worker *workers;
+    ptts_team_fn fn;
+    void *arg;
+    _Alignas(64) atomic_uint job;     /* bumped once per ptts_team_run */
+    atomic_int parked;                /* idle workers in park_wait */
+    pthread_mutex_t park_lock;
+    pthread_cond_t park_cond;
+    _Alignas(64) atomic_uint done;    /* job whose run worker 0 saw finish */
+    _Alignas(64) atomic_int quit;
+    _Alignas(64) atomic_int arrived;  /* barrier */
+    _Alignas(64) atomic_uint phase;
+};
+
+static void backoff(int *spins) {
+    int n = (*spins)++;
+    if (n < TEAM_SPIN_POLLS) return;
+    if (n < TEAM_YIELD_POLLS) {
+        sched_yield();
+        return;
+    }
+    struct timespec ts = {0, 20000};
+    nanosleep(&ts, NULL);
+}
+
+void ptts_team_barrier(ptts_team *team) {
+    if (team->num_workers <= 1) return;
+    unsigned phase = atomic_load_explicit(&team->phase, memory_order_acquire);
+    if (atomic_fetch_add_explicit(&team->arrived, 1, memory_order_acq_rel) ==
+        team->num_workers - 1) {
+        atomic_store_explicit(&team->arrived, 0, memory_order_relaxed);
+        atomic_store_explicit(&team->phase, phase + 1, memory_order_release);
+        return;
+    }
+    int spins = 0;
+    while (atomic_load_explicit(&team->phase, memory_order_acquire) == phase) backoff(&spins);
+}
+
+/* An idle worker sleeps here until ptts_team_run or ptts_team_free bumps
+ * job. parked is raised under the lock before job is checked again, and the
+ * waker bumps job before it reads parked, so one of them sees the other. */
+static void park_wait(ptts_team *team, unsigned seen) {
+    pthread_mutex_lock(&team->park_lock);
+    atomic_fetch_add(&team->parked, 1);
+    while (atomic_load(&team->job) == seen) pthread_cond_wait(&team->park_cond, &team->park_lock);
+    atomic_fetch_sub(&team->parked, 1);
+    pthread_mutex_unlock(&team->park_lock);
+}
+
+static unsigned start_job(ptts_team *team) {
+    unsigned job = atomic_fetch_add(&team->job, 1) + 1;
+    if (atomic_load(&team->parked) > 0) {
+        pthread_mutex_lock(&team->park_lock);
+        pthread_cond_broadcast(&team->park_cond);
+        pthread_mutex_unlock(&team->park_lock);
+    }
+    return job;
+}
+
+#ifdef __linux__
+/* Pins the calling thread to the index-th CPU it may run on. Returns 0 if
+ * pinned. */
+static int pin_to_cpu(int index) {
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return -1;
+    int n = CPU_COUNT(&allowed);
+    if (n <= 0) return -1;
+    int target = index % n;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        if (target-- == 0) {
+            cpu_set_t one;
+            CPU_ZERO(&one);
+            CPU_SET(cpu, &one);
+            return pthread_setaffinity_np(pthread_self(), sizeof(one), &one) != 0 ? -1 : 0;
+        }
+    }
+    return -1;
+}
+#endif
+
+static void *worker_main(void *p) {
+    team_worker *w = (team_worker *)p;
+    ptts_team *team = w->team;
+#ifdef __linux__
+    if (team->pin) pin_to_cpu(w->index);
+#endif
+    ptts_trace_thread_name("team worker %d", w->index);
+    unsigned seen = 0;
+    for (;;) {
+        int spins = 0;
+        unsigned job;
+        while ((job = atomic_load_explicit(&team->job, memory_order_acquire)) == seen) {
+            if (spins < TEAM_YIELD_POLLS) backoff(&spins);
+            else park_wait(team, seen);
+        }
+        seen = job;
+        if (atomic_load_explicit(&team->quit, memory_order_acquire)) break;
+        PTTS_TRACE_BEGIN(t_trace);
+        team->fn(team->arg, w->index, team->num_workers);
+        PTTS_TRACE_END(t_trace, "team.job", w->index);
+        ptts_team_barrier(team);
+        /* past the barrier every worker is done; release the caller */
+        if (w->index == 0) atomic_store_explicit(&team->done, job, memory_order_release);
+    }
+    return NULL;
+}
+
+ptts_team *ptts_team_create(int num_workers, int pin) {
+    if (num_workers < 1) return NULL;
+    ptts_team *team = (ptts_team *)aligned_alloc(64, (sizeof(ptts_team) + 63) & ~(size_t)63);
+    if (!team) return NULL;
+    team->num_workers = num_workers;
+    team->pin = pin;
+    team->own0 = pin && num_workers > 1;
+    team->fn = NULL;
+    team->arg = NULL;
+    atomic_init(&team->job, 0);
+    atomic_init(&team->parked, 0);
+    pthread_mutex_init(&team->park_lock, NULL);
+    pthread_cond_init(&team->park_cond, NULL);
+    atomic_init(&team->done, 0);
+    atomic_init(&team->quit, 0);
+    atomic_init(&team->arrived, 0);
+    atomic_init(&team->phase, 0);
+    team->workers = (team_worker *)calloc((size_t)num_workers, sizeof(team_worker));
+    if (!team->workers) {
+        pthread_cond_destroy(&team->park_cond);
+        pthread_mutex_destroy(&team->park_lock);
+        free(team);
+        return NULL;
+    }
+    for (int i = team->own0 ? 0 : 1; i < num_workers; i++) {
+        team->workers[i].team = team;
+        team->workers[i].index = i;
+        if (pthread_create(&team->workers[i].thread, NULL, worker_main, &team->workers[i]) != 0) {
+            /* without a worker 0 thread the caller runs its share, unpinned;
+             * otherwise shrink to the workers that did start */
+            if (i == 0) {
+                team->own0 = 0;
+                continue;
+            }
+            team->num_workers = i;
+            break;
+        }
+    }
+    return team;
+}
+
+void ptts_team_free(ptts_team *team) {
+    if (!team) return;
+    atomic_store_explicit(&team->quit, 1, memory_order_release);
+    start_job(team);
+    for (int i = team->own0 ? 0 : 1; i < team->num_workers; i++) {
+        pthread_join(team->workers[i].thread, NULL);
+    }
+    pthread_cond_destroy(&team->park_cond);
+    pthread_mutex_destroy(&team->park_lock);
+    free(team->workers);
+    free(team);
+}
+
+int ptts_team_size(const ptts_team *team) {
+    return team ? team->num_workers : 0;
+}
+
+void ptts_team_run(ptts_team *team, ptts_team_fn fn, void *arg) {
+    team->fn = fn;
+    team->arg = arg;
+    unsigned job = start_job(team);
+    if (team->own0) {
+        int spins = 0;
+        while (atomic_load_explicit(&team->done, memory_order_acquire) != job) backoff(&spins);
+        return;
+    }
+    fn(arg, 0, team->num_workers);
+    ptts_team_barrier(team);
+}
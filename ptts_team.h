@@ -0,0 +1,34 @@
+#ifndef PTTS_TEAM_H
+#define PTTS_TEAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Persistent thread team for SPMD kernels. Without pin, worker 0 is the
+ * calling thread and workers 1..N-1 are long-lived threads. With pin, all N
+ * workers are long-lived threads pinned to one CPU each, so that data they
+ * own stays in that core's cache, and the caller only waits for the run; its
+ * own affinity is never touched. ptts_team_run executes fn on every worker
+ * and returns once all have finished; inside fn, workers synchronise with
+ * ptts_team_barrier. Barrier and completion waits spin, then yield, then
+ * sleep; idle workers spin and yield, then block until the next run.
+ */
+
+typedef struct ptts_team ptts_team;
+
+typedef void (*ptts_team_fn)(void *arg, int worker, int num_workers);
+
+ptts_team *ptts_team_create(int num_workers, int pin);
+void ptts_team_free(ptts_team *team);
+
+int ptts_team_size(const ptts_team *team);
+void ptts_team_run(ptts_team *team, ptts_team_fn fn, void *arg);
+void ptts_team_barrier(ptts_team *team);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTTS_TEAM_H */
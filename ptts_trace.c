@@ -0,0 +1,148 @@
+/*
+ * ptts_trace.c - Chrome trace event spans
+ */
+
+#include "ptts_trace.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Per thread; beyond this spans are counted and dropped (32 MB each). */
+#define PTTS_TRACE_MAX_EVENTS (1 << 20)
+
+typedef struct {
+    const char *name;
+    uint64_t t0;
+    uint64_t t1;
+    int arg;
+} trace_event;
+
+typedef struct trace_buf {
+    struct trace_buf *next;
+    int tid;
+    char name[32];
+    trace_event *ev;
+    size_t n; /* written by the owner, read by ptts_trace_write */
+    size_t cap;
+    size_t dropped;
+} trace_buf;
+
+int ptts_trace_active = 0;
+
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static trace_buf *trace_bufs = NULL; /* buffers live until exit */
+static int trace_next_tid = 1;
+static uint64_t trace_origin = 0;
+
+static __thread trace_buf *tls_buf = NULL;
+static __thread char tls_name[32];
+
+uint64_t ptts_trace_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void ptts_trace_thread_name(const char *fmt, int index) {
+    snprintf(tls_name, sizeof(tls_name), fmt, index);
+    if (tls_buf) memcpy(tls_buf->name, tls_name, sizeof(tls_name));
+}
+
+static trace_buf *trace_buf_get(void) {
+    if (tls_buf) return tls_buf;
+    trace_buf *b = (trace_buf *)calloc(1, sizeof(trace_buf));
+    if (!b) return NULL;
+    memcpy(b->name, tls_name, sizeof(tls_name));
+    pthread_mutex_lock(&trace_lock);
+    b->tid = trace_next_tid++;
+    if (!b->name[0]) snprintf(b->name, sizeof(b->name), "thread %d", b->tid);
+    b->next = trace_bufs;
+    trace_bufs = b;
+    pthread_mutex_unlock(&trace_lock);
+    tls_buf = b;
+    return b;
+}
+
+void ptts_trace_span(const char *name, uint64_t t0, int arg) {
+    uint64_t t1 = ptts_trace_now();
+    if (!__atomic_load_n(&ptts_trace_active, __ATOMIC_RELAXED)) return;
+    trace_buf *b = trace_buf_get();
+    if (!b) return;
+    size_t n = b->n;
+    if (n == b->cap) {
+        /* ptts_trace_write may be walking b->ev: move it under the lock. */
+        pthread_mutex_lock(&trace_lock);
+        size_t cap = b->cap ? b->cap * 2 : 4096;
+        trace_event *ev = cap <= PTTS_TRACE_MAX_EVENTS
+                              ? (trace_event *)realloc(b->ev, cap * sizeof(trace_event))
+                              : NULL;
+        if (ev) {
+            b->ev = ev;
+            b->cap = cap;
+        } else {
+            b->dropped++;
+        }
+        pthread_mutex_unlock(&trace_lock);
+        if (!ev) return;
+    }
+    b->ev[n].name = name;
+    b->ev[n].t0 = t0;
+    b->ev[n].t1 = t1;
+    b->ev[n].arg = arg;
+    __atomic_store_n(&b->n, n + 1, __ATOMIC_RELEASE);
+}
+
+void ptts_trace_start(void) {
+    pthread_mutex_lock(&trace_lock);
+    for (trace_buf *b = trace_bufs; b; b = b->next) {
+        __atomic_store_n(&b->n, 0, __ATOMIC_RELAXED);
+        b->dropped = 0;
+    }
+    trace_origin = ptts_trace_now();
+    pthread_mutex_unlock(&trace_lock);
+    __atomic_store_n(&ptts_trace_active, 1, __ATOMIC_RELEASE);
+}
+
+int ptts_trace_write(const char *path) {
+    __atomic_store_n(&ptts_trace_active, 0, __ATOMIC_RELEASE);
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+    int pid = (int)getpid();
+    size_t events = 0;
+    size_t dropped = 0;
+    const char *sep = "";
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    pthread_mutex_lock(&trace_lock);
+    for (trace_buf *b = trace_bufs; b; b = b->next) {
+        size_t n = __atomic_load_n(&b->n, __ATOMIC_ACQUIRE);
+        dropped += b->dropped;
+        if (n == 0) continue;
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                "\"args\":{\"name\":\"%s\"}}", sep, pid, b->tid, b->name);
+        fprintf(f, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                "\"args\":{\"sort_index\":%d}}", pid, b->tid, b->tid);
+        sep = ",\n";
+        for (size_t i = 0; i < n; i++) {
+            const trace_event *e = &b->ev[i];
+            uint64_t t0 = e->t0 > trace_origin ? e->t0 - trace_origin : 0;
+            fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"ptts\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                    "\"ts\":%.3f,\"dur\":%.3f", e->name, pid, b->tid, t0 / 1000.0,
+                    (e->t1 - e->t0) / 1000.0);
+            if (e->arg >= 0) fprintf(f, ",\"args\":{\"n\":%d}", e->arg);
+            fputc('}', f);
+        }
+        events += n;
+    }
+    pthread_mutex_unlock(&trace_lock);
+    fprintf(f, "\n]}\n");
+    int rc = fclose(f) == 0 ? 0 : -1;
+    if (dropped > 0) {
+        fprintf(stderr, "[ptts] Trace: %zu spans dropped (over %d per thread)\n",
+                dropped, PTTS_TRACE_MAX_EVENTS);
+    }
+    if (rc == 0) fprintf(stderr, "[ptts] Trace: %zu spans written to %s\n", events, path);
+    return rc;
+}
@@ -0,0 +1,59 @@
+#ifndef PTTS_TRACE_H
+#define PTTS_TRACE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Span tracing in the Chrome trace event format (chrome://tracing, Perfetto).
+ * Spans are recorded between ptts_trace_start and ptts_trace_write; the rest
+ * of the time a PTTS_TRACE_BEGIN / PTTS_TRACE_END pair is one relaxed load
+ * and an untaken branch, and -DPTTS_NO_TRACE compiles the pairs out.
+ *
+ * Every thread appends to its own buffer without locking; a thread's buffer
+ * is registered on its first span and becomes one track in the timeline,
+ * labelled with ptts_trace_thread_name (e.g. "team worker 2").
+ *
+ *     PTTS_TRACE_BEGIN(t);
+ *     ...
+ *     PTTS_TRACE_END(t, "mimi.transformer", frames);
+ *
+ * name must be a string literal (only the pointer is kept); arg is shown as
+ * args.n in the viewer, or left out when negative.
+ */
+
+extern int ptts_trace_active;
+
+/* Starts recording (clears spans from an earlier run). */
+void ptts_trace_start(void);
+
+/* Stops recording and writes every thread's spans to path. Returns 0 on
+ * success. Safe while other threads are still inside a span (a buffer only
+ * moves under the same lock); spans they finish after the stop are left out. */
+int ptts_trace_write(const char *path);
+
+/* Labels the calling thread's track; takes effect for spans recorded later,
+ * whether or not tracing is active yet. */
+void ptts_trace_thread_name(const char *fmt, int index);
+
+uint64_t ptts_trace_now(void);
+void ptts_trace_span(const char *name, uint64_t t0, int arg);
+
+#ifdef PTTS_NO_TRACE
+#define PTTS_TRACE_BEGIN(var) do { } while (0)
+#define PTTS_TRACE_END(var, name, arg) do { (void)(arg); } while (0)
+#else
+#define PTTS_TRACE_BEGIN(var) \
+    uint64_t var = __atomic_load_n(&ptts_trace_active, __ATOMIC_RELAXED) ? ptts_trace_now() : 0
+#define PTTS_TRACE_END(var, name, arg) \
+    do { if (var) ptts_trace_span((name), (var), (arg)); } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PTTS_TRACE_H */
@@ -0,0 +1,39 @@
+/*
+ * test.h - minimal checks for the model-free unit tests (make check)
+ */
+
+#ifndef PTTS_TEST_H
+#define PTTS_TEST_H
+
+#include <stdio.h>
+
+static int test_failures = 0;
+
+#define CHECK(cond)                                                               \
+    do {                                                                          \
+        if (!(cond)) {                                                            \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            test_failures++;                                                      \
+        }                                                                         \
+    } while (0)
+
+/* Prints the verdict for this test binary; returns its exit status. */
+static inline int test_finish(const char *name) {
+    if (test_failures) {
+        fprintf(stderr, "FAIL %s (%d checks)\n", name, test_failures);
+        return 1;
+    }
+    printf("ok   %s\n", name);
+    return 0;
+}
+
+/* xorshift32 for test inputs; never 0 for a non-zero seed. */
+static inline unsigned test_rand(unsigned *state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+#endif /* PTTS_TEST_H */
@@ -0,0 +1,176 @@
+/*
+ * test_kernels.c - channels-last conv1d: fixed k = 3 / 7 kernels
+ *
+ * Runs every conv1d shape of the Mimi decoder under each flag combination
+ * the conv stack can pass (ELU, ACCUM, bf16 storage, HIST) with time
+ * lengths that end on and off the 64-row tile. ptts_conv1d_tc_forward (the
+ * register-blocked kernel where it applies) must match the generic tile
+ * kernel exactly, and both must match a scalar reference.
+ */
+
+#include "../ptts_kernels.h"
+#include "test.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    int k, in_ch, out_ch;
+} conv_shape;
+
+/* Mimi decoder conv1d layers (the k = 1 and mono output convs take the
+ * generic path and are covered against the reference only). */
+static const conv_shape shapes[] = {
+    {"dec_in", 7, 512, 512},  {"res0.conv1", 3, 256, 128}, {"res1.conv1", 3, 128, 64},
+    {"res2.conv1", 3, 64, 32}, {"res0.conv2", 1, 128, 256}, {"res2.conv2", 1, 32, 64},
+    {"dec_out", 7, 64, 1},
+};
+
+/* in: f32 storage, bf16 in and out (resblocks), bf16 in only (dec_out) */
+static const int storage_modes[] = {0, PTTS_CONV_IN_BF16 | PTTS_CONV_OUT_BF16,
+                                    PTTS_CONV_IN_BF16};
+
+static float bf16_value(uint16_t h) {
+    uint32_t u = (uint32_t)h << 16;
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+static uint16_t bf16_round(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return (uint16_t)((u + 0x7fffu + ((u >> 16) & 1u)) >> 16);
+}
+
+static float rand_unit(unsigned *seed) {
+    return (float)(test_rand(seed) >> 8) / 8388608.0f - 1.0f;
+}
+
+/* Element i of a buffer in f32 or bf16 storage. */
+static float load(const void *p, ptrdiff_t i, int bf16) {
+    return bf16 ? bf16_value(((const uint16_t *)p)[i]) : ((const float *)p)[i];
+}
+
+static void store(void *p, size_t i, float v, int bf16) {
+    if (bf16) {
+        ((uint16_t *)p)[i] = bf16_round(v);
+    } else {
+        ((float *)p)[i] = v;
+    }
+}
+
+/* y[t][o] (+)= b[o] + sum over taps and inputs, in double. */
+static void reference(void *y, const void *x, const float *w, const float *b, int in_ch,
+                      int out_ch, int T, int k, int flags) {
+    int in_bf16 = (flags & PTTS_CONV_IN_BF16) != 0;
+    int out_bf16 = (flags & PTTS_CONV_OUT_BF16) != 0;
+    for (int t = 0; t < T; t++) {
+        for (int o = 0; o < out_ch; o++) {
+            double sum = b[o];
+            for (int kk = 0; kk < k; kk++) {
+                int r = t - (k - 1) + kk;
+                if (r < 0 && !(flags & PTTS_CONV_IN_HIST)) continue;
+                for (int ic = 0; ic < in_ch; ic++) {
+                    double v = load(x, (ptrdiff_t)r * in_ch + ic, in_bf16);
+                    if ((flags & PTTS_CONV_IN_ELU) && v < 0.0) v = exp(v) - 1.0;
+                    sum += v * w[((size_t)o * in_ch + ic) * k + kk];
+                }
+            }
+            size_t i = (size_t)t * out_ch + o;
+            if (flags & PTTS_CONV_ACCUM) sum += load(y, (ptrdiff_t)i, out_bf16);
+            store(y, i, (float)sum, out_bf16);
+        }
+    }
+}
+
+/* One shape, T and flag set; returns 0 when all three outputs agree. */
+static int check_case(const conv_shape *s, int T, int flags, unsigned *seed) {
+    int k = s->k, in_ch = s->in_ch, out_ch = s->out_ch;
+    int in_bytes = (flags & PTTS_CONV_IN_BF16) ? 2 : 4;
+    int out_bytes = (flags & PTTS_CONV_OUT_BF16) ? 2 : 4;
+    size_t lead = (size_t)(k - 1) * in_ch; /* history rows before x */
+    size_t nx = lead + (size_t)T * in_ch;
+    size_t ny = (size_t)T * out_ch;
+    size_t nw = (size_t)out_ch * in_ch * k;
+    size_t scratch_n = (size_t)ptts_kernel_threads() * ptts_conv1d_tc_scratch(in_ch, k, 1);
+
+    char *xbuf = (char *)malloc(nx * in_bytes);
+    float *w = (float *)malloc(nw * sizeof(float));
+    float *b = (float *)malloc((size_t)out_ch * sizeof(float));
+    char *y[3];
+    for (int i = 0; i < 3; i++) y[i] = (char *)malloc(ny * out_bytes);
+    float *scratch = (float *)malloc(scratch_n * sizeof(float));
+    if (!xbuf || !w || !b || !y[0] || !y[1] || !y[2] || !scratch) return -1;
+
+    float wscale = 1.0f / sqrtf((float)(in_ch * k));
+    for (size_t i = 0; i < nx; i++) store(xbuf, i, 2.0f * rand_unit(seed), in_bytes == 2);
+    for (size_t i = 0; i < nw; i++) w[i] = wscale * rand_unit(seed);
+    for (int o = 0; o < out_ch; o++) b[o] = 0.1f * rand_unit(seed);
+    for (size_t i = 0; i < ny; i++) store(y[0], i, rand_unit(seed), out_bytes == 2);
+    memcpy(y[1], y[0], ny * out_bytes);
+    memcpy(y[2], y[0], ny * out_bytes);
+    const void *x = xbuf + lead * in_bytes;
+
+    float *wt = ptts_conv1d_pack_tc(w, in_ch, out_ch, k, 1);
+    if (!wt) return -1;
+    ptts_conv1d_tc_forward((float *)y[0], (const float *)x, wt, b, in_ch, out_ch, T, k, 1,
+                           flags, scratch);
+    ptts_conv1d_tc_generic_forward((float *)y[1], (const float *)x, wt, b, in_ch, out_ch, T, k,
+                                   1, flags, scratch);
+    reference(y[2], x, w, b, in_ch, out_ch, T, k, flags);
+
+    int bad = memcmp(y[0], y[1], ny * out_bytes) != 0;
+    double max_err = 0.0;
+    for (size_t i = 0; i < ny; i++) {
+        double r = load(y[2], (ptrdiff_t)i, out_bytes == 2);
+        double d = fabs(load(y[1], (ptrdiff_t)i, out_bytes == 2) - r);
+        /* f32: summation order; bf16: one rounding step either way */
+        double tol = out_bytes == 2 ? fabs(r) / 64.0 + 1e-3 : 1e-4 * (1.0 + fabs(r));
+        if (d > tol) bad = 1;
+        if (d > max_err) max_err = d;
+    }
+    if (bad) {
+        fprintf(stderr, "%s k=%d %d->%d T=%d flags=%d: fixed %s generic, max|ref diff| %.3g\n",
+                s->name, k, in_ch, out_ch, T, flags,
+                memcmp(y[0], y[1], ny * out_bytes) ? "!=" : "==", max_err);
+    }
+    free(wt);
+    free(xbuf);
+    free(w);
+    free(b);
+    for (int i = 0; i < 3; i++) free(y[i]);
+    free(scratch);
+    return bad ? 1 : 0;
+}
+
+static void test_decoder_shapes(void) {
+    /* one or two full 64-row tiles, 4- and 60-row tails, shorter than a
+     * tile, and one T that is not a multiple of 4 (generic only) */
+    static const int small_T[] = {4, 12, 64, 68, 124, 128, 30};
+    static const int large_T[] = {68};
+    unsigned seed = 36;
+    for (size_t si = 0; si < sizeof(shapes) / sizeof(shapes[0]); si++) {
+        const conv_shape *s = &shapes[si];
+        int large = s->in_ch * s->out_ch * s->k > 1 << 20;
+        const int *Ts = large ? large_T : small_T;
+        int nT = large ? (int)(sizeof(large_T) / sizeof(int)) : (int)(sizeof(small_T) / sizeof(int));
+        for (int ti = 0; ti < nT; ti++) {
+            for (size_t m = 0; m < sizeof(storage_modes) / sizeof(int); m++) {
+                for (int f = 0; f < 8; f++) {
+                    int flags = storage_modes[m] | ((f & 1) ? PTTS_CONV_IN_ELU : 0) |
+                                ((f & 2) ? PTTS_CONV_ACCUM : 0) |
+                                ((f & 4) ? PTTS_CONV_IN_HIST : 0);
+                    CHECK(check_case(s, Ts[ti], flags, &seed) == 0);
+                }
+            }
+        }
+    }
+}
+
+int main(void) {
+    test_decoder_shapes();
+    return test_finish("kernels");
+}
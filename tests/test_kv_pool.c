@@ -0,0 +1,195 @@
+/*
+ * test_kv_pool.c - paged KV pool: budget, reuse, waiting for releases
+ */
+
+#define _GNU_SOURCE
+#include "../ptts_kv_pool.h"
+#include "test.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LAYERS 2
+#define DIM 4
+#define PAGE_FLOATS (LAYERS * 2 * PTTS_KV_PAGE_POS * DIM)
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static void test_budget_and_reuse(void) {
+    size_t page_bytes = PAGE_FLOATS * sizeof(float);
+    ptts_kv_pool *pool = ptts_kv_pool_create(LAYERS, DIM, 3 * page_bytes + page_bytes / 2);
+    CHECK(pool != NULL);
+    if (!pool) return;
+    ptts_kv_pool_set_wait_ms(pool, 0.0);
+
+    float *p[4];
+    for (int i = 0; i < 3; i++) {
+        p[i] = ptts_kv_pool_alloc(pool);
+        CHECK(p[i] != NULL);
+        if (p[i]) for (int j = 0; j < PAGE_FLOATS; j++) p[i][j] = (float)i;
+    }
+    CHECK(p[0] != p[1] && p[1] != p[2] && p[0] != p[2]);
+    p[3] = ptts_kv_pool_alloc(pool);
+    CHECK(p[3] == NULL);
+    CHECK(ptts_kv_pool_wait(pool, 3) == -1); /* nobody else to release */
+
+    ptts_kv_pool_release(pool, p[1]);
+    CHECK(ptts_kv_pool_wait(pool, 2) == 0); /* a free page is there */
+    p[3] = ptts_kv_pool_alloc(pool);
+    CHECK(p[3] == p[1]);
+
+    ptts_kv_pool_stats st;
+    ptts_kv_pool_get_stats(pool, &st);
+    CHECK(st.page_bytes == page_bytes);
+    CHECK(st.pages_total == 3);
+    CHECK(st.pages_in_use == 3);
+    CHECK(st.pages_peak == 3);
+    CHECK(st.alloc_failures == 1);
+    CHECK(st.waits == 0);
+
+    ptts_kv_pool_release(pool, p[0]);
+    ptts_kv_pool_release(pool, p[2]);
+    ptts_kv_pool_release(pool, p[3]);
+    ptts_kv_pool_get_stats(pool, &st);
+    CHECK(st.pages_in_use == 0);
+    CHECK(st.pages_peak == 3);
+    ptts_kv_pool_free(pool);
+}
+
+static void test_unbounded(void) {
+    ptts_kv_pool *pool = ptts_kv_pool_create(LAYERS, DIM, 0);
+    CHECK(pool != NULL);
+    if (!pool) return;
+    float *p[100];
+    for (int i = 0; i < 100; i++) {
+        p[i] = ptts_kv_pool_alloc(pool);
+        CHECK(p[i] != NULL);
+    }
+    for (int i = 0; i < 100; i++) ptts_kv_pool_release(pool, p[i]);
+    ptts_kv_pool_stats st;
+    ptts_kv_pool_get_stats(pool, &st);
+    CHECK(st.pages_total == 100);
+    CHECK(st.alloc_failures == 0);
+    ptts_kv_pool_free(pool);
+    CHECK(ptts_kv_pool_create(0, DIM, 0) == NULL);
+}
+
+typedef struct {
+    ptts_kv_pool *pool;
+    float *page;
+    int delay_ms;
+} releaser_arg;
+
+static void *release_later(void *p) {
+    releaser_arg *r = (releaser_arg *)p;
+    usleep((useconds_t)r->delay_ms * 1000);
+    ptts_kv_pool_release(r->pool, r->page);
+    return NULL;
+}
+
+static void test_wait(void) {
+    ptts_kv_pool *pool = ptts_kv_pool_create(LAYERS, DIM, 2 * PAGE_FLOATS * sizeof(float));
+    CHECK(pool != NULL);
+    if (!pool) return;
+    float *mine = ptts_kv_pool_alloc(pool);
+    float *other = ptts_kv_pool_alloc(pool);
+    CHECK(mine && other);
+
+    /* the other holder never releases: time out */
+    ptts_kv_pool_set_wait_ms(pool, 50.0);
+    double t0 = now_ms();
+    CHECK(ptts_kv_pool_wait(pool, 1) == -1);
+    CHECK(now_ms() - t0 >= 45.0);
+
+    /* the other holder releases after 20 ms: woken well before the wait time */
+    ptts_kv_pool_set_wait_ms(pool, 5000.0);
+    releaser_arg r = {pool, other, 20};
+    pthread_t th;
+    pthread_create(&th, NULL, release_later, &r);
+    t0 = now_ms();
+    CHECK(ptts_kv_pool_wait(pool, 1) == 0);
+    CHECK(now_ms() - t0 < 2000.0);
+    pthread_join(th, NULL);
+    float *again = ptts_kv_pool_alloc(pool);
+    CHECK(again == other);
+
+    ptts_kv_pool_stats st;
+    ptts_kv_pool_get_stats(pool, &st);
+    CHECK(st.waits == 2);
+    CHECK(st.wait_timeouts == 1);
+    ptts_kv_pool_release(pool, mine);
+    ptts_kv_pool_release(pool, again);
+    ptts_kv_pool_free(pool);
+}
+
+typedef struct {
+    ptts_kv_pool *pool;
+    int id;
+    int ok;
+} session_arg;
+
+/* A session grows to a few pages (waiting when the pool is dry), stamps
+ * them with its id, checks nobody else wrote them, then gives them back. */
+static void *session(void *p) {
+    session_arg *s = (session_arg *)p;
+    unsigned seed = 99u + (unsigned)s->id;
+    s->ok = 1;
+    for (int it = 0; it < 200; it++) {
+        float *pages[3];
+        int held = 0;
+        int want = 1 + (int)(test_rand(&seed) % 3);
+        while (held < want) {
+            float *pg = ptts_kv_pool_alloc(s->pool);
+            if (pg) {
+                for (int j = 0; j < PAGE_FLOATS; j++) pg[j] = (float)s->id;
+                pages[held++] = pg;
+            } else if (ptts_kv_pool_wait(s->pool, held) != 0) {
+                break;
+            }
+        }
+        for (int i = 0; i < held; i++) {
+            for (int j = 0; j < PAGE_FLOATS; j++) {
+                if (pages[i][j] != (float)s->id) s->ok = 0;
+            }
+            ptts_kv_pool_release(s->pool, pages[i]);
+        }
+    }
+    return NULL;
+}
+
+static void test_threads(void) {
+    ptts_kv_pool *pool = ptts_kv_pool_create(LAYERS, DIM, 5 * PAGE_FLOATS * sizeof(float));
+    CHECK(pool != NULL);
+    if (!pool) return;
+    ptts_kv_pool_set_wait_ms(pool, 100.0);
+    pthread_t th[4];
+    session_arg args[4];
+    for (int i = 0; i < 4; i++) {
+        args[i] = (session_arg){pool, i + 1, 0};
+        pthread_create(&th[i], NULL, session, &args[i]);
+    }
+    for (int i = 0; i < 4; i++) {
+        pthread_join(th[i], NULL);
+        CHECK(args[i].ok);
+    }
+    ptts_kv_pool_stats st;
+    ptts_kv_pool_get_stats(pool, &st);
+    CHECK(st.pages_in_use == 0);
+    CHECK(st.pages_total <= 5);
+    CHECK(st.pages_peak <= 5);
+    ptts_kv_pool_free(pool);
+}
+
+int main(void) {
+    test_budget_and_reuse();
+    test_unbounded();
+    test_wait();
+    test_threads();
+    return test_finish("kv_pool");
+}
@@ -0,0 +1,114 @@
+/*
+ * test_longform.c - sentence splitting for long-form synthesis
+ */
+
+#include "../ptts_longform.h"
+#include "test.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Splits text and compares with the NULL-terminated list want. */
+static int split_equals(const char *text, int max_words, const char *const *want) {
+    char **chunks = NULL;
+    int n = -1;
+    if (ptts_split_sentences(text, max_words, &chunks, &n) != 0) return 0;
+    int n_want = 0;
+    while (want[n_want]) n_want++;
+    int same = n == n_want;
+    for (int i = 0; same && i < n; i++) same = strcmp(chunks[i], want[i]) == 0;
+    if (!same) {
+        fprintf(stderr, "split(\"%s\", %d):", text, max_words);
+        for (int i = 0; i < n; i++) fprintf(stderr, " [%s]", chunks[i]);
+        fprintf(stderr, "\n");
+    }
+    ptts_chunks_free(chunks, n);
+    return same;
+}
+
+#define SPLIT(text, max, ...)                                       \
+    do {                                                            \
+        const char *const want_[] = {__VA_ARGS__, NULL};             \
+        CHECK(split_equals(text, max, want_));                      \
+    } while (0)
+
+static void test_boundaries(void) {
+    SPLIT("Hello there. How are you? Fine!", 4, "Hello there.", "How are you? Fine!");
+    SPLIT("Dr. Smith met J. R. Tolkien. They talked.", 3, "Dr. Smith met", "J. R. Tolkien.",
+          "They talked.");
+    SPLIT("Go \"now.\" Then stop.", 3, "Go \"now.\"", "Then stop.");
+    SPLIT("Go \xE2\x80\x9Cnow.\xE2\x80\x9D Then stop.", 3, "Go \xE2\x80\x9Cnow.\xE2\x80\x9D",
+          "Then stop.");
+    SPLIT("Wait... What?! Yes.", 1, "Wait...", "What?!", "Yes.");
+    SPLIT("Pi is 3.14 today. Ok.", 4, "Pi is 3.14 today.", "Ok.");
+    SPLIT("Title line\n \nBody text here.", 3, "Title line", "Body text here.");
+    SPLIT("  No end here  ", 5, "No end here");
+    SPLIT("one two three, four five six seven eight nine.", 6, "one two three,",
+          "four five six seven eight nine.");
+    SPLIT("a b c d e", 0, "a", "b", "c", "d", "e");
+    SPLIT("Short. Also short. Still short.", 40, "Short. Also short. Still short.");
+}
+
+static void test_empty(void) {
+    char **chunks = NULL;
+    int n = -1;
+    CHECK(ptts_split_sentences("", 10, &chunks, &n) == 0 && n == 0);
+    ptts_chunks_free(chunks, n);
+    CHECK(ptts_split_sentences(" \n\n  ", 10, &chunks, &n) == 0 && n == 0);
+    ptts_chunks_free(chunks, n);
+    CHECK(ptts_split_sentences(NULL, 10, &chunks, &n) == -1);
+}
+
+/* Appends the whitespace-separated words of s to out, one space apart. */
+static void words_of(const char *s, char *out) {
+    size_t o = strlen(out);
+    for (const char *p = s; *p;) {
+        while (isspace((unsigned char)*p)) p++;
+        if (!*p) break;
+        if (o) out[o++] = ' ';
+        while (*p && !isspace((unsigned char)*p)) out[o++] = *p++;
+    }
+    out[o] = '\0';
+}
+
+/* Random documents: every chunk stays within max_words and the chunks hold
+ * exactly the document's words, in order. */
+static void test_random(void) {
+    static const char *const vocab[] = {"the", "cat", "sat,", "on", "mats.", "Dr.", "why?",
+                                        "no!", "\"yes.\"", "3.5", "end;", "\n\n", "J.",
+                                        "ok", "so:", "wow...", "(aside.)"};
+    unsigned seed = 4242;
+    for (int iter = 0; iter < 300; iter++) {
+        char text[2048] = "";
+        int len = 1 + (int)(test_rand(&seed) % 120);
+        for (int i = 0; i < len; i++) {
+            if (i) strcat(text, " ");
+            strcat(text, vocab[test_rand(&seed) % (sizeof(vocab) / sizeof(vocab[0]))]);
+        }
+        int max_words = 1 + (int)(test_rand(&seed) % 12);
+        char **chunks = NULL;
+        int n = 0;
+        CHECK(ptts_split_sentences(text, max_words, &chunks, &n) == 0);
+        char want[2048] = "", got[2048] = "";
+        words_of(text, want);
+        int within = 1;
+        for (int i = 0; i < n; i++) {
+            char w[2048] = "";
+            words_of(chunks[i], w);
+            int words = w[0] ? 1 : 0;
+            for (char *p = w; *p; p++) words += *p == ' ';
+            if (words < 1 || words > max_words) within = 0;
+            words_of(chunks[i], got);
+        }
+        CHECK(within);
+        CHECK(strcmp(want, got) == 0);
+        ptts_chunks_free(chunks, n);
+    }
+}
+
+int main(void) {
+    test_boundaries();
+    test_empty();
+    test_random();
+    return test_finish("longform");
+}
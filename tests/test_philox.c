@@ -0,0 +1,144 @@
+/*
+ * test_philox.c - counter-based latent noise
+ *
+ * Checks ptts_flowlm_noise against a scalar Philox4x32-10 (itself checked
+ * on the Random123 known-answer vector) and the properties the batched and
+ * sentence-parallel paths rely on: any (seed, stream, frame) can be drawn
+ * in any order, streams are independent, and the result is N(0, temp).
+ */
+
+#include "../ptts_flowlm.h"
+#include "test.h"
+#include <math.h>
+#include <string.h>
+
+#define DIM PTTS_FLOWLM_LATENT_DIM
+
+/* Random123 philox4x32_10, one block. */
+static void philox4x32_10(const uint32_t ctr_in[4], const uint32_t key_in[2], uint32_t out[4]) {
+    uint32_t c[4] = {ctr_in[0], ctr_in[1], ctr_in[2], ctr_in[3]};
+    uint32_t k[2] = {key_in[0], key_in[1]};
+    for (int r = 0; r < 10; r++) {
+        uint64_t p0 = (uint64_t)0xD2511F53u * c[0];
+        uint64_t p1 = (uint64_t)0xCD9E8D57u * c[2];
+        uint32_t n[4] = {(uint32_t)(p1 >> 32) ^ c[1] ^ k[0], (uint32_t)p1,
+                         (uint32_t)(p0 >> 32) ^ c[3] ^ k[1], (uint32_t)p0};
+        memcpy(c, n, sizeof(c));
+        k[0] += 0x9E3779B9u;
+        k[1] += 0xBB67AE85u;
+    }
+    memcpy(out, c, sizeof(c));
+}
+
+/* Dims 4b..4b+3 come from counter (b, frame, stream), key = seed. */
+static void reference_noise(uint64_t seed, uint64_t stream, uint32_t frame, float temp,
+                            double *out) {
+    uint32_t key[2] = {(uint32_t)seed, (uint32_t)(seed >> 32)};
+    uint32_t bits[DIM];
+    for (int b = 0; b < DIM / 4; b++) {
+        uint32_t ctr[4] = {(uint32_t)b, frame, (uint32_t)stream, (uint32_t)(stream >> 32)};
+        philox4x32_10(ctr, key, bits + 4 * b);
+    }
+    for (int i = 0; i < DIM / 2; i++) {
+        double u1 = ((double)(bits[2 * i] >> 8) + 0.5) / 16777216.0;
+        double u2 = ((double)(bits[2 * i + 1] >> 8) + 0.5) / 16777216.0;
+        double r = sqrt(-2.0 * log(u1)) * sqrt((double)temp);
+        out[2 * i] = r * cos(2.0 * M_PI * u2);
+        out[2 * i + 1] = r * sin(2.0 * M_PI * u2);
+    }
+}
+
+static void test_known_answer(void) {
+    const uint32_t zero_ctr[4] = {0, 0, 0, 0};
+    const uint32_t zero_key[2] = {0, 0};
+    const uint32_t want[4] = {0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u};
+    uint32_t got[4];
+    philox4x32_10(zero_ctr, zero_key, got);
+    CHECK(memcmp(got, want, sizeof(want)) == 0);
+}
+
+static void test_matches_reference(void) {
+    static const uint64_t seeds[] = {0, 42, 0x123456789abcdefull, ~0ull};
+    static const uint64_t streams[] = {0, 1, 7, 0xffffffff00000001ull};
+    static const int frames[] = {0, 1, 2, 255, 4096};
+    double max_diff = 0.0;
+    for (size_t s = 0; s < sizeof(seeds) / sizeof(seeds[0]); s++) {
+        for (size_t t = 0; t < sizeof(streams) / sizeof(streams[0]); t++) {
+            for (size_t f = 0; f < sizeof(frames) / sizeof(frames[0]); f++) {
+                float got[DIM];
+                double want[DIM];
+                ptts_flowlm_noise(seeds[s], streams[t], frames[f], 0.7f, 0.0f, got);
+                reference_noise(seeds[s], streams[t], (uint32_t)frames[f], 0.7f, want);
+                for (int i = 0; i < DIM; i++) {
+                    double d = fabs(got[i] - want[i]);
+                    if (d > max_diff) max_diff = d;
+                }
+            }
+        }
+    }
+    CHECK(max_diff < 1e-4);
+}
+
+static void test_order_and_streams(void) {
+    float a[DIM], b[DIM], c[DIM];
+    /* frame 9 is the same whether or not frames 0-8 were drawn first */
+    ptts_flowlm_noise(42, 3, 9, 1.0f, 0.0f, a);
+    for (int f = 0; f < 9; f++) ptts_flowlm_noise(42, 3, f, 1.0f, 0.0f, c);
+    ptts_flowlm_noise(42, 3, 9, 1.0f, 0.0f, b);
+    CHECK(memcmp(a, b, sizeof(a)) == 0);
+
+    ptts_flowlm_noise(42, 4, 9, 1.0f, 0.0f, b);
+    ptts_flowlm_noise(43, 3, 9, 1.0f, 0.0f, c);
+    CHECK(memcmp(a, b, sizeof(a)) != 0);
+    CHECK(memcmp(a, c, sizeof(a)) != 0);
+}
+
+static void test_temp_and_clamp(void) {
+    float z[DIM];
+    ptts_flowlm_noise(1, 0, 0, 0.0f, 0.0f, z);
+    for (int i = 0; i < DIM; i++) CHECK(z[i] == 0.0f);
+
+    float maxabs = 0.0f;
+    for (int f = 0; f < 256; f++) {
+        ptts_flowlm_noise(5, 0, f, 4.0f, 1.5f, z);
+        for (int i = 0; i < DIM; i++) {
+            if (fabsf(z[i]) > maxabs) maxabs = fabsf(z[i]);
+        }
+    }
+    CHECK(maxabs == 1.5f);
+}
+
+/* 4096 frames x 32 dims: mean and variance within a few standard errors,
+ * and no correlation between neighbouring dims or streams. */
+static void test_distribution(void) {
+    const int frames = 4096;
+    const float temp = 0.5f;
+    double sum = 0.0, sum2 = 0.0, cross_dim = 0.0, cross_stream = 0.0;
+    for (int f = 0; f < frames; f++) {
+        float a[DIM], b[DIM];
+        ptts_flowlm_noise(2024, 0, f, temp, 0.0f, a);
+        ptts_flowlm_noise(2024, 1, f, temp, 0.0f, b);
+        for (int i = 0; i < DIM; i++) {
+            sum += a[i];
+            sum2 += (double)a[i] * a[i];
+            cross_dim += (double)a[i] * a[(i + 1) % DIM];
+            cross_stream += (double)a[i] * b[i];
+        }
+    }
+    double n = (double)frames * DIM;
+    double mean = sum / n;
+    double var = sum2 / n - mean * mean;
+    CHECK(fabs(mean) < 4.0 * sqrt(temp / n));
+    CHECK(fabs(var - temp) < 0.02);
+    CHECK(fabs(cross_dim / n) < 0.02);
+    CHECK(fabs(cross_stream / n) < 0.02);
+}
+
+int main(void) {
+    test_known_answer();
+    test_matches_reference();
+    test_order_and_streams();
+    test_temp_and_clamp();
+    test_distribution();
+    return test_finish("philox");
+}
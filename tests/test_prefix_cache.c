@@ -0,0 +1,195 @@
+/*
+ * test_prefix_cache.c - radix-tree KV prefix cache
+ *
+ * Each test "computes" KV rows whose values depend on the whole prefix up
+ * to their position, so a row copied from the wrong branch or offset shows
+ * up as a mismatch.
+ */
+
+#include "../ptts_prefix_cache.h"
+#include "test.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LAYERS 3
+#define DIM 8
+#define MAX_POS 64
+
+typedef struct {
+    float kv[LAYERS][2][MAX_POS][DIM];
+} fake_cache;
+
+static float *fake_row(void *user, int layer, int is_v, int pos) {
+    return ((fake_cache *)user)->kv[layer][is_v][pos];
+}
+
+/* Row value for the prefix (voice, tokens[0 .. pos - voice_len]). */
+static float expected(uint64_t voice, int voice_len, const int *tokens, int layer, int is_v,
+                      int pos, int d) {
+    uint64_t h = voice * 0x9E3779B97F4A7C15ull + (uint64_t)pos;
+    for (int i = 0; i < pos - voice_len + 1 && pos >= voice_len; i++) {
+        h = (h ^ (uint64_t)tokens[i]) * 0x100000001B3ull;
+    }
+    h = (h ^ (uint64_t)(layer * 2 + is_v) * 131u ^ (uint64_t)d) * 0x100000001B3ull;
+    return (float)(h >> 40);
+}
+
+static void compute(fake_cache *c, uint64_t voice, int voice_len, const int *tokens, int n) {
+    for (int l = 0; l < LAYERS; l++) {
+        for (int v = 0; v < 2; v++) {
+            for (int p = 0; p < voice_len + n; p++) {
+                for (int d = 0; d < DIM; d++) {
+                    c->kv[l][v][p][d] = expected(voice, voice_len, tokens, l, v, p, d);
+                }
+            }
+        }
+    }
+}
+
+/* 1 when rows [0, count) hold the values of (voice, tokens). */
+static int rows_match(const fake_cache *c, uint64_t voice, int voice_len, const int *tokens,
+                      int count) {
+    for (int l = 0; l < LAYERS; l++) {
+        for (int v = 0; v < 2; v++) {
+            for (int p = 0; p < count; p++) {
+                for (int d = 0; d < DIM; d++) {
+                    if (c->kv[l][v][p][d] != expected(voice, voice_len, tokens, l, v, p, d)) {
+                        return 0;
+                    }
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+static size_t pos_bytes(int n) {
+    return (size_t)n * LAYERS * 2 * DIM * sizeof(float);
+}
+
+static void insert(ptts_prefix_cache *pc, uint64_t voice, int voice_len, const int *tokens,
+                   int n) {
+    fake_cache c;
+    compute(&c, voice, voice_len, tokens, n);
+    ptts_prefix_cache_insert(pc, voice, voice_len, tokens, n, fake_row, &c, voice_len + n);
+}
+
+/* Lookup into a cache poisoned with -1; returns the positions reused and
+ * fails the check when a reused row is wrong or a row past it was written. */
+static int lookup(ptts_prefix_cache *pc, uint64_t voice, int voice_len, const int *tokens,
+                  int n) {
+    fake_cache *c = (fake_cache *)malloc(sizeof(fake_cache));
+    if (!c) return -1;
+    for (size_t i = 0; i < sizeof(c->kv) / sizeof(float); i++) ((float *)c->kv)[i] = -1.0f;
+    int got = ptts_prefix_cache_lookup(pc, voice, voice_len, tokens, n, fake_row, c);
+    CHECK(rows_match(c, voice, voice_len, tokens, got));
+    if (got < MAX_POS) CHECK(c->kv[LAYERS - 1][1][got][DIM - 1] == -1.0f);
+    free(c);
+    return got;
+}
+
+static void test_radix(void) {
+    ptts_prefix_cache *pc = ptts_prefix_cache_create(LAYERS, DIM, pos_bytes(1000));
+    CHECK(pc != NULL);
+    if (!pc) return;
+    const int a[] = {1, 2, 3, 4};
+    const int b[] = {1, 2, 9};
+    const int c[] = {5};
+
+    CHECK(lookup(pc, 7, 2, a, 4) == 0);
+    insert(pc, 7, 2, a, 4);
+    CHECK(lookup(pc, 7, 2, a, 4) == 6);
+    CHECK(lookup(pc, 7, 2, a, 2) == 4);  /* query shorter than the edge */
+    CHECK(lookup(pc, 7, 2, b, 3) == 4);  /* diverges inside the edge */
+    CHECK(lookup(pc, 7, 2, c, 1) == 2);  /* voice only */
+    CHECK(lookup(pc, 8, 2, a, 4) == 0);  /* other voice */
+    CHECK(lookup(pc, 7, 3, a, 4) == 0);  /* same key, other length */
+
+    insert(pc, 7, 2, b, 3); /* splits a's edge after {1, 2} */
+    CHECK(lookup(pc, 7, 2, b, 3) == 5);
+    CHECK(lookup(pc, 7, 2, a, 4) == 6);
+
+    ptts_prefix_cache_stats st;
+    ptts_prefix_cache_get_stats(pc, &st);
+    CHECK(st.nodes == 4); /* voice, {1, 2}, {3, 4}, {9} */
+    CHECK(st.bytes == pos_bytes(2 + 2 + 2 + 1));
+    CHECK(st.lookups == 9);
+    CHECK(st.hits == 6);
+    CHECK(st.reused_positions == 6 + 4 + 4 + 2 + 5 + 6);
+    CHECK(st.computed_positions == 6 + 5);
+    CHECK(st.evictions == 0);
+    ptts_prefix_cache_free(pc);
+}
+
+static void test_eviction(void) {
+    /* room for the voice and three 4-token leaves */
+    ptts_prefix_cache *pc = ptts_prefix_cache_create(LAYERS, DIM, pos_bytes(2 + 12));
+    CHECK(pc != NULL);
+    if (!pc) return;
+    int t[8][4];
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 4; j++) t[i][j] = 100 * i + j;
+        insert(pc, 7, 2, t[i], 4);
+        if (i == 3) CHECK(lookup(pc, 7, 2, t[1], 4) == 6); /* keep t[1] recent */
+    }
+    ptts_prefix_cache_stats st;
+    ptts_prefix_cache_get_stats(pc, &st);
+    CHECK(st.bytes <= st.max_bytes);
+    CHECK(st.evictions == 5);
+    CHECK(lookup(pc, 7, 2, t[7], 4) == 6);
+    CHECK(lookup(pc, 7, 2, t[0], 4) == 2);
+
+    /* larger than the whole budget: ignored */
+    int big[MAX_POS];
+    for (int i = 0; i < MAX_POS - 2; i++) big[i] = 5000 + i;
+    insert(pc, 9, 2, big, MAX_POS - 2);
+    CHECK(lookup(pc, 9, 2, big, MAX_POS - 2) == 0);
+    ptts_prefix_cache_free(pc);
+}
+
+typedef struct {
+    ptts_prefix_cache *pc;
+    unsigned seed;
+} worker_arg;
+
+/* Threads share a few voices and short token alphabets so their prefixes
+ * overlap, split and evict each other's nodes. */
+static void *worker(void *p) {
+    worker_arg *w = (worker_arg *)p;
+    for (int it = 0; it < 400; it++) {
+        uint64_t voice = 1 + test_rand(&w->seed) % 3;
+        int n = 1 + (int)(test_rand(&w->seed) % 12);
+        int tokens[12];
+        for (int i = 0; i < n; i++) tokens[i] = (int)(test_rand(&w->seed) % 3);
+        int got = lookup(w->pc, voice, 4, tokens, n);
+        CHECK(got == 0 || (got >= 4 && got <= 4 + n));
+        if (got < 4 + n) insert(w->pc, voice, 4, tokens, n);
+    }
+    return NULL;
+}
+
+static void test_threads(void) {
+    ptts_prefix_cache *pc = ptts_prefix_cache_create(LAYERS, DIM, pos_bytes(120));
+    CHECK(pc != NULL);
+    if (!pc) return;
+    pthread_t th[4];
+    worker_arg args[4];
+    for (int i = 0; i < 4; i++) {
+        args[i] = (worker_arg){pc, 77u + (unsigned)i};
+        pthread_create(&th[i], NULL, worker, &args[i]);
+    }
+    for (int i = 0; i < 4; i++) pthread_join(th[i], NULL);
+    ptts_prefix_cache_stats st;
+    ptts_prefix_cache_get_stats(pc, &st);
+    CHECK(st.lookups == 1600);
+    CHECK(st.bytes <= st.max_bytes);
+    ptts_prefix_cache_free(pc);
+}
+
+int main(void) {
+    test_radix();
+    test_eviction();
+    test_threads();
+    return test_finish("prefix_cache");
+}
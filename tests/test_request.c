@@ -0,0 +1,127 @@
+/*
+ * test_request.c - JSON request bodies for serve and --batch
+ */
+
+#include "../ptts_request.h"
+#include "test.h"
+#include <string.h>
+
+static const char *parse(const char *body, const ptts_params *defaults, ptts_request *req) {
+    return ptts_request_parse(body, strlen(body), defaults, req);
+}
+
+static void test_fields(void) {
+    ptts_request r;
+    const char *err = parse(" {\"text\": \"Hello world.\", \"voice\":\"alba\", \"out\":\"a.wav\","
+                            "\"format\":\"pcm\", \"seed\": 42, \"request_id\": 7, \"temp\": 0.5,"
+                            "\"noise_clamp\": 3, \"steps\": 4, \"frames\": 12, \"eos\": false,"
+                            "\"eos_min_frames\": 5, \"eos_after\": 2, \"future\": 1 }\n",
+                            NULL, &r);
+    CHECK(err == NULL);
+    CHECK(r.text && strcmp(r.text, "Hello world.") == 0);
+    CHECK(r.voice && strcmp(r.voice, "alba") == 0);
+    CHECK(r.out && strcmp(r.out, "a.wav") == 0);
+    CHECK(r.pcm == 1);
+    CHECK(r.params.seed == 42);
+    CHECK(r.params.request_id == 7);
+    CHECK(r.params.temp == 0.5f);
+    CHECK(r.params.noise_clamp == 3.0f);
+    CHECK(r.params.num_steps == 4);
+    CHECK(r.params.num_frames == 12);
+    CHECK(r.params.eos_enabled == 0);
+    CHECK(r.params.eos_min_frames == 5);
+    CHECK(r.params.eos_after == 2);
+    ptts_request_clear(&r);
+    CHECK(r.text == NULL && r.voice == NULL && r.out == NULL);
+
+    /* eos_threshold turns EOS back on; null keeps the default */
+    err = parse("{\"eos\":false,\"eos_threshold\":-1.5,\"text\":\"x\",\"voice\":null}", NULL, &r);
+    CHECK(err == NULL);
+    CHECK(r.params.eos_enabled == 1 && r.params.eos_threshold == -1.5f);
+    CHECK(r.voice == NULL && r.pcm == 0);
+    ptts_request_clear(&r);
+
+    /* later keys win; steps below 1 clamp */
+    err = parse("{\"text\":\"a\",\"text\":\"b\",\"steps\":0}", NULL, &r);
+    CHECK(err == NULL && strcmp(r.text, "b") == 0 && r.params.num_steps == 1);
+    ptts_request_clear(&r);
+}
+
+static void test_defaults(void) {
+    ptts_params d = PTTS_PARAMS_DEFAULT;
+    d.temp = 0.25f;
+    d.num_steps = 3;
+    d.seed = 9;
+    ptts_request r;
+    CHECK(parse("{\"text\":\"x\",\"seed\":10}", &d, &r) == NULL);
+    CHECK(r.params.temp == 0.25f && r.params.num_steps == 3 && r.params.seed == 10);
+    ptts_request_clear(&r);
+
+    ptts_params base = PTTS_PARAMS_DEFAULT;
+    CHECK(parse("{\"text\":\"x\"}", NULL, &r) == NULL);
+    CHECK(r.params.temp == base.temp && r.params.num_steps == base.num_steps &&
+          r.params.seed == base.seed && r.params.num_frames == base.num_frames &&
+          r.params.eos_enabled == base.eos_enabled && r.params.sample_rate == base.sample_rate);
+    ptts_request_clear(&r);
+}
+
+static void test_strings(void) {
+    ptts_request r;
+    const char *err = parse("{\"text\":\"q\\\"b\\\\s\\/ n\\n t\\t \\u00e9 \\u20ac \\ud83d\\ude00\"}",
+                            NULL, &r);
+    CHECK(err == NULL);
+    CHECK(r.text && strcmp(r.text, "q\"b\\s/ n\n t\t \xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80") == 0);
+    ptts_request_clear(&r);
+
+    /* raw UTF-8 passes through */
+    CHECK(parse("{\"text\":\"caf\xC3\xA9\"}", NULL, &r) == NULL);
+    CHECK(r.text && strcmp(r.text, "caf\xC3\xA9") == 0);
+    ptts_request_clear(&r);
+}
+
+static void test_errors(void) {
+    static const char *const bad[] = {
+        "",
+        "[]",
+        "\"text\"",
+        "{\"text\":\"a\"",
+        "{\"text\" \"a\"}",
+        "{\"text\":\"a\" \"voice\":\"b\"}",
+        "{text:\"a\"}",
+        "{\"text\":\"unterminated}",
+        "{\"text\":\"bad \\x escape\"}",
+        "{\"text\":\"bad \\u12g4\"}",
+        "{\"text\":\"ctl \x01 char\"}",
+        "{\"text\":1}",
+        "{\"text\":\"\"}",
+        "{}",
+        "{\"voice\":\"alba\"}",
+        "{\"text\":\"a\",\"voice\":\"\"}",
+        "{\"text\":\"a\",\"out\":2}",
+        "{\"text\":\"a\",\"format\":\"mp3\"}",
+        "{\"text\":\"a\",\"eos\":1}",
+        "{\"text\":\"a\",\"seed\":\"1\"}",
+        "{\"text\":\"a\",\"temp\":true}",
+        "{\"text\":\"a\",\"steps\":1000}",
+        "{\"text\":\"a\",\"frames\":5000}",
+        "{\"text\":\"a\",\"frames\":-3}",
+        "{\"text\":\"a\",\"meta\":{\"x\":1}}",
+        "{\"text\":\"a\",\"list\":[1]}",
+        "{\"this key is far too long for the sixty-four byte key buffer ....\":1,\"text\":\"a\"}",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        ptts_request r;
+        const char *err = parse(bad[i], NULL, &r);
+        if (!err) fprintf(stderr, "accepted: %s\n", bad[i]);
+        CHECK(err != NULL);
+        ptts_request_clear(&r);
+    }
+}
+
+int main(void) {
+    test_fields();
+    test_defaults();
+    test_strings();
+    test_errors();
+    return test_finish("request");
+}
@@ -0,0 +1,308 @@
+/*
+ * test_safetensors.c - tensor lookup on safetensors files
+ *
+ * Writes safetensors files with a few hundred transformer-style names and
+ * checks the hash indexes against a linear scan over the same names, then
+ * round-trips tensors of every dtype through a packed model file and
+ * checks F16/BF16 widening on every 16-bit input.
+ */
+
+#include "../ptts_safetensors.h"
+#include "test.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define LAYERS 40
+#define MAX_TENSORS 256
+
+static const char *const layer_parts[] = {
+    "self_attn.in_proj.weight", "self_attn.out_proj.weight", "norm1.weight", "norm1.bias",
+    "linear1.weight",
+};
+#define NUM_PARTS ((int)(sizeof(layer_parts) / sizeof(layer_parts[0])))
+
+typedef struct {
+    char names[MAX_TENSORS][96];
+    int n;
+} name_set;
+
+static void make_names(name_set *s) {
+    s->n = 0;
+    snprintf(s->names[s->n++], 96, "flow_lm.emb.weight");
+    for (int l = 0; l < LAYERS; l++) {
+        for (int p = 0; p < NUM_PARTS; p++) {
+            snprintf(s->names[s->n++], 96, "flow_lm.transformer.layers.%d.%s", l, layer_parts[p]);
+        }
+    }
+    snprintf(s->names[s->n++], 96, "mimi.decoder.norm1.weight");
+    snprintf(s->names[s->n++], 96, "weight");
+}
+
+/* Tensor i: F32 vector of (i % 5) + 1 elements valued i. */
+static char *write_safetensors(const name_set *s) {
+    static char path[64];
+    snprintf(path, sizeof(path), "/tmp/ptts_test_st_XXXXXX");
+    int fd = mkstemp(path);
+    if (fd < 0) return NULL;
+    close(fd);
+
+    size_t cap = 64 * 1024;
+    char *json = (char *)malloc(cap);
+    size_t len = (size_t)snprintf(json, cap, "{\"__metadata__\":{\"format\":\"pt\"}");
+    size_t off = 0;
+    for (int i = 0; i < s->n; i++) {
+        size_t numel = (size_t)(i % 5) + 1;
+        len += (size_t)snprintf(json + len, cap - len,
+                                ",\"%s\":{\"dtype\":\"F32\",\"shape\":[%zu],"
+                                "\"data_offsets\":[%zu,%zu]}",
+                                s->names[i], numel, off, off + numel * 4);
+        off += numel * 4;
+    }
+    len += (size_t)snprintf(json + len, cap - len, "}");
+    while (len % 8) json[len++] = ' ';
+
+    FILE *f = fopen(path, "wb");
+    uint64_t hlen = len;
+    fwrite(&hlen, 8, 1, f);
+    fwrite(json, 1, len, f);
+    for (int i = 0; i < s->n; i++) {
+        float v = (float)i;
+        for (int k = 0; k <= i % 5; k++) fwrite(&v, 4, 1, f);
+    }
+    fclose(f);
+    free(json);
+    return path;
+}
+
+/* Linear reference: first name equal to suffix or ending in "." + suffix. */
+static int scan_suffix(const name_set *s, const char *suffix, int *count) {
+    size_t sl = strlen(suffix);
+    int first = -1;
+    *count = 0;
+    for (int i = 0; i < s->n; i++) {
+        size_t nl = strlen(s->names[i]);
+        if (nl < sl || strcmp(s->names[i] + nl - sl, suffix) != 0) continue;
+        if (nl > sl && s->names[i][nl - sl - 1] != '.') continue;
+        if (first < 0) first = i;
+        (*count)++;
+    }
+    return first;
+}
+
+/* extra: tensors appended after the name set (none of them matches a
+ * checked suffix). */
+static void check_lookups(const safetensors_file_t *sf, const name_set *s, int extra) {
+    CHECK(sf->num_tensors == s->n + extra);
+    int found = 0;
+    for (int i = 0; i < s->n; i++) {
+        const safetensor_t *t = safetensors_find(sf, s->names[i]);
+        if (t && t == &sf->tensors[i] && strcmp(t->name, s->names[i]) == 0) found++;
+    }
+    CHECK(found == s->n);
+    CHECK(safetensors_find(sf, "flow_lm.transformer.layers.40.norm1.weight") == NULL);
+    CHECK(safetensors_find(sf, "flow_lm.emb") == NULL);
+    CHECK(safetensors_find(sf, "") == NULL);
+
+    static const char *const suffixes[] = {
+        "weight", "bias", "norm1.weight", "self_attn.in_proj.weight",
+        "layers.7.norm1.bias", "emb.weight", "flow_lm.emb.weight", "decoder.norm1.weight",
+        "eight", "1.weight", "missing", "transformer.layers.39.linear1.weight",
+    };
+    for (size_t k = 0; k < sizeof(suffixes) / sizeof(suffixes[0]); k++) {
+        int want_count = 0;
+        int want = scan_suffix(s, suffixes[k], &want_count);
+        int count = -1;
+        const safetensor_t *t = safetensors_find_suffix(sf, suffixes[k], &count);
+        CHECK(count == want_count);
+        CHECK(want < 0 ? t == NULL : t == &sf->tensors[want]);
+    }
+}
+
+static void test_index(void) {
+    static name_set s;
+    make_names(&s);
+    char *path = write_safetensors(&s);
+    CHECK(path != NULL);
+    if (!path) return;
+    safetensors_file_t *sf = safetensors_open(path);
+    unlink(path);
+    CHECK(sf != NULL);
+    if (!sf) return;
+    CHECK(!sf->packed);
+    check_lookups(sf, &s, 0);
+
+    const safetensor_t *t = safetensors_find(sf, s.names[13]);
+    CHECK(t && t->dtype == DTYPE_F32 && t->ndim == 1 && t->shape[0] == 13 % 5 + 1);
+    float *v = t ? safetensors_get_f32(sf, t) : NULL;
+    CHECK(v && v[0] == 13.0f && v[t->shape[0] - 1] == 13.0f);
+    free(v);
+    safetensors_close(sf);
+}
+
+/* Every tensor of the safetensors file, plus odd sizes and dtypes, through
+ * safetensors_write_pack and back: same names, order, metadata and bytes,
+ * data 64-byte aligned in the mapping, same lookups. */
+static void test_pack(void) {
+    static name_set s;
+    make_names(&s);
+    char *st_path = write_safetensors(&s);
+    CHECK(st_path != NULL);
+    if (!st_path) return;
+    safetensors_file_t *src = safetensors_open(st_path);
+    unlink(st_path);
+    CHECK(src != NULL);
+    if (!src) return;
+
+    static safetensors_pack_entry e[MAX_TENSORS + 3];
+    int n = 0;
+    for (int i = 0; i < src->num_tensors; i++) {
+        const safetensor_t *t = &src->tensors[i];
+        e[n] = (safetensors_pack_entry){t->name, t->dtype, t->ndim, {0},
+                                        safetensors_data(src, t), t->data_size};
+        memcpy(e[n].shape, t->shape, sizeof(e[n].shape));
+        n++;
+    }
+    uint16_t half[3 * 7];
+    for (int i = 0; i < 3 * 7; i++) half[i] = (uint16_t)(0x3c00 + 37 * i);
+    int64_t ids[5] = {-1, 0, 1, 1ll << 40, 7};
+    e[n++] = (safetensors_pack_entry){"extra.bf16", DTYPE_BF16, 2, {3, 7}, half, sizeof(half)};
+    e[n++] = (safetensors_pack_entry){"extra.f16", DTYPE_F16, 3, {1, 3, 7}, half, sizeof(half)};
+    e[n++] = (safetensors_pack_entry){"extra.ids", DTYPE_I64, 1, {5}, ids, sizeof(ids)};
+
+    char path[] = "/tmp/ptts_test_pack_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    if (fd >= 0) close(fd);
+    CHECK(safetensors_write_pack(path, e, n) == 0);
+    safetensors_file_t *pk = safetensors_open(path);
+    unlink(path);
+    CHECK(pk != NULL);
+    if (pk) {
+        CHECK(pk->packed);
+        CHECK(pk->num_tensors == n);
+        int same = 0;
+        for (int i = 0; i < n && i < pk->num_tensors; i++) {
+            const safetensor_t *t = &pk->tensors[i];
+            const void *data = safetensors_data(pk, t);
+            if (strcmp(t->name, e[i].name) == 0 && t->dtype == e[i].dtype &&
+                t->ndim == e[i].ndim && memcmp(t->shape, e[i].shape, sizeof(t->shape)) == 0 &&
+                t->data_size == e[i].data_size && memcmp(data, e[i].data, t->data_size) == 0 &&
+                (uintptr_t)data % SAFETENSORS_PACK_ALIGN == 0) {
+                same++;
+            }
+        }
+        CHECK(same == n);
+        check_lookups(pk, &s, 3);
+
+        const safetensor_t *t = safetensors_find(pk, "flow_lm.emb.weight");
+        const float *direct = t ? safetensors_get_f32_direct(pk, t) : NULL;
+        CHECK(direct && safetensors_contains(pk, direct) && direct[0] == 0.0f);
+        t = safetensors_find(pk, "extra.bf16");
+        float *wide = t ? safetensors_get_f32(pk, t) : NULL;
+        CHECK(wide && wide[0] == 0x1p-7f);
+        free(wide);
+        t = safetensors_find(pk, "extra.f16");
+        wide = t ? safetensors_get_f32(pk, t) : NULL;
+        CHECK(wide && wide[0] == 1.0f);
+        free(wide);
+        safetensors_close(pk);
+    }
+    safetensors_close(src);
+
+    CHECK(safetensors_write_pack("/nonexistent-dir/x.pack", e, n) == -1);
+}
+
+static uint32_t float_bits(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+/* IEEE half -> float computed in double, independent of the bit tricks. */
+static int f16_matches(uint16_t h, float got) {
+    int sign = h >> 15;
+    int exp = (h >> 10) & 0x1f;
+    int mant = h & 0x3ff;
+    uint32_t bits = float_bits(got);
+    if (exp == 0x1f && mant) { /* NaN; bit tests, since -ffast-math folds isnan */
+        return (bits & 0x7f800000u) == 0x7f800000u && (bits & 0x7fffffu) &&
+               (int)(bits >> 31) == sign;
+    }
+    double v = exp == 0x1f ? INFINITY
+                           : exp ? ldexp(1024 + mant, exp - 25) : ldexp(mant, -24);
+    return bits == float_bits((float)(sign ? -v : v));
+}
+
+/* Widen every F16 and BF16 bit pattern through safetensors_get_f32 and
+ * through the threaded loader. The F16 tensor repeats the 65536 patterns
+ * five times so the loader splits it across several chunks. */
+static void test_widening(void) {
+    enum { PATTERNS = 65536, REPEAT = 5 };
+    uint16_t *h = (uint16_t *)malloc((size_t)PATTERNS * REPEAT * sizeof(uint16_t));
+    CHECK(h != NULL);
+    if (!h) return;
+    for (int i = 0; i < PATTERNS * REPEAT; i++) h[i] = (uint16_t)i;
+    safetensors_pack_entry e[2] = {
+        {"f16", DTYPE_F16, 2, {REPEAT, PATTERNS}, h, (size_t)PATTERNS * REPEAT * 2},
+        {"bf16", DTYPE_BF16, 1, {PATTERNS}, h, (size_t)PATTERNS * 2},
+    };
+    char path[] = "/tmp/ptts_test_wide_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) close(fd);
+    CHECK(fd >= 0 && safetensors_write_pack(path, e, 2) == 0);
+    safetensors_file_t *sf = safetensors_open(path);
+    unlink(path);
+    free(h);
+    CHECK(sf != NULL);
+    if (!sf) return;
+    const safetensor_t *tf = safetensors_find(sf, "f16");
+    const safetensor_t *tb = safetensors_find(sf, "bf16");
+    CHECK(tf && tb);
+    if (!tf || !tb) {
+        safetensors_close(sf);
+        return;
+    }
+
+    float *f = safetensors_get_f32(sf, tf);
+    float *b = safetensors_get_f32(sf, tb);
+    CHECK(f && b);
+    int bad_f16 = 0, bad_bf16 = 0;
+    for (int i = 0; f && b && i < PATTERNS; i++) {
+        if (!f16_matches((uint16_t)i, f[i])) bad_f16++;
+        if (float_bits(b[i]) != (uint32_t)i << 16) bad_bf16++;
+    }
+    CHECK(bad_f16 == 0);
+    CHECK(bad_bf16 == 0);
+
+    setenv("PTTS_LOAD_THREADS", "3", 1);
+    safetensors_loader *ld = safetensors_loader_create(sf);
+    CHECK(ld != NULL);
+    if (ld) {
+        float *lf = safetensors_loader_f32(ld, tf);
+        float *lb = safetensors_loader_f32(ld, tb);
+        safetensors_load_stats st;
+        safetensors_arena arena = {NULL, 0};
+        CHECK(safetensors_loader_run(ld, &st, &arena) == 0);
+        CHECK(st.tensors == 2 && st.converted == 2 && st.threads == 3);
+        CHECK(safetensors_arena_contains(&arena, lf) && safetensors_arena_contains(&arena, lb));
+        int same = 1;
+        for (int r = 0; f && lf && r < REPEAT; r++) {
+            if (memcmp(lf + (size_t)r * PATTERNS, f, PATTERNS * sizeof(float)) != 0) same = 0;
+        }
+        CHECK(same);
+        CHECK(b && lb && memcmp(lb, b, PATTERNS * sizeof(float)) == 0);
+        safetensors_arena_free(&arena);
+    }
+    free(f);
+    free(b);
+    safetensors_close(sf);
+}
+
+int main(void) {
+    test_index();
+    test_pack();
+    test_widening();
+    return test_finish("safetensors");
+}
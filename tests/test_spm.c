@@ -0,0 +1,209 @@
+/*
+ * test_spm.c - SentencePiece trie encode against a brute-force Viterbi
+ *
+ * Writes small ModelProto files, encodes with ptts_spm_encode (double-array
+ * trie walk) and compares with the original scan of every piece at every
+ * character boundary, plus a few hand-checked segmentations.
+ */
+
+#include "../ptts_spm.h"
+#include "test.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SPACE "\xE2\x96\x81"
+
+typedef struct {
+    const char *piece;
+    float score;
+    int type; /* 1 normal, 2 unknown */
+} vocab_entry;
+
+static void put_varint(FILE *f, uint64_t v) {
+    while (v >= 0x80) {
+        fputc((int)(v & 0x7f) | 0x80, f);
+        v >>= 7;
+    }
+    fputc((int)v, f);
+}
+
+/* ModelProto with one SentencePiece (field 1) per entry. */
+static int write_model(const char *path, const vocab_entry *v, int n) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    for (int i = 0; i < n; i++) {
+        size_t len = strlen(v[i].piece);
+        size_t msg = 1 + (len < 128 ? 1 : 2) + len + 1 + 4 + 1 + 1;
+        put_varint(f, (1 << 3) | 2);
+        put_varint(f, msg);
+        put_varint(f, (1 << 3) | 2);
+        put_varint(f, len);
+        fwrite(v[i].piece, 1, len, f);
+        put_varint(f, (2 << 3) | 5);
+        fwrite(&v[i].score, 4, 1, f);
+        put_varint(f, (3 << 3) | 0);
+        put_varint(f, (uint64_t)v[i].type);
+    }
+    return fclose(f);
+}
+
+static ptts_spm *load_vocab(const vocab_entry *v, int n) {
+    char path[] = "/tmp/ptts_test_spm_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return NULL;
+    close(fd);
+    ptts_spm *spm = write_model(path, v, n) == 0 ? ptts_spm_load(path) : NULL;
+    unlink(path);
+    return spm;
+}
+
+/* What the default normalizer makes of single-spaced ASCII words. */
+static void normalize_words(const char *text, char *out) {
+    size_t o = 0;
+    for (const char *p = text; *p; p++) {
+        if (p == text || *p == ' ') {
+            memcpy(out + o, SPACE, 3);
+            o += 3;
+        }
+        if (*p != ' ') out[o++] = *p;
+    }
+    out[o] = '\0';
+}
+
+/* Scan every piece at every boundary, as ptts_spm_encode did before the trie. */
+static int reference_encode(const vocab_entry *v, int n, const char *norm, int *ids) {
+    int len = (int)strlen(norm);
+    float dp[256];
+    int prev[256];
+    int best[256];
+    for (int i = 0; i <= len; i++) {
+        dp[i] = -1e30f;
+        prev[i] = -1;
+        best[i] = -1;
+    }
+    dp[0] = 0.0f;
+    for (int i = 0; i < len; i++) {
+        if (dp[i] <= -1e29f || (norm[i] & 0xC0) == 0x80) continue;
+        int matched = 0;
+        for (int j = 0; j < n; j++) {
+            int pl = (int)strlen(v[j].piece);
+            if (v[j].type != 1 || i + pl > len || memcmp(norm + i, v[j].piece, pl) != 0) continue;
+            if (i + pl < len && (norm[i + pl] & 0xC0) == 0x80) continue;
+            matched = 1;
+            if (dp[i] + v[j].score > dp[i + pl]) {
+                dp[i + pl] = dp[i] + v[j].score;
+                prev[i + pl] = i;
+                best[i + pl] = j;
+            }
+        }
+        if (!matched) {
+            int e = i + 1;
+            while (e < len && (norm[e] & 0xC0) == 0x80) e++;
+            if (dp[i] + v[0].score > dp[e]) {
+                dp[e] = dp[i] + v[0].score;
+                prev[e] = i;
+                best[e] = 0;
+            }
+        }
+    }
+    int count = 0;
+    for (int i = len; i > 0; i = prev[i]) count++;
+    for (int i = len, k = count - 1; i > 0; i = prev[i], k--) ids[k] = best[i];
+    return count;
+}
+
+static int encode_equals(const ptts_spm *spm, const char *text, const int *want, int n_want) {
+    int *ids = NULL;
+    int n = 0;
+    if (ptts_spm_encode(spm, text, &ids, &n) != 0) return 0;
+    int same = n == n_want && (n == 0 || memcmp(ids, want, (size_t)n * sizeof(int)) == 0);
+    if (!same) {
+        fprintf(stderr, "encode(\"%s\"):", text);
+        for (int i = 0; i < n; i++) fprintf(stderr, " %d", ids[i]);
+        fprintf(stderr, "  want:");
+        for (int i = 0; i < n_want; i++) fprintf(stderr, " %d", want[i]);
+        fprintf(stderr, "\n");
+    }
+    free(ids);
+    return same;
+}
+
+static void test_fixed(void) {
+    static const vocab_entry v[] = {
+        {"<unk>", -10.0f, 2}, {SPACE, -1.0f, 1},      {"a", -2.0f, 1},
+        {"b", -2.0f, 1},      {"ab", -1.5f, 1},       {SPACE "a", -1.2f, 1},
+        {"\xC3\xA9", -2.5f, 1},
+    };
+    ptts_spm *spm = load_vocab(v, (int)(sizeof(v) / sizeof(v[0])));
+    CHECK(spm != NULL);
+    if (!spm) return;
+    CHECK(ptts_spm_vocab_size(spm) == 7);
+
+    const int ab_ab[] = {1, 4, 1, 4}; /* "▁" "ab" beats "▁a" "b" */
+    const int ba[] = {1, 3, 2};
+    const int unk[] = {1, 0};
+    const int accent[] = {5, 6, 3};
+    CHECK(encode_equals(spm, "ab ab", ab_ab, 4));
+    CHECK(encode_equals(spm, "  ab   ab ", ab_ab, 4));
+    CHECK(encode_equals(spm, "ba", ba, 3));
+    CHECK(encode_equals(spm, "d", unk, 2));
+    CHECK(encode_equals(spm, "a\xC3\xA9" "b", accent, 3));
+    CHECK(encode_equals(spm, "", NULL, 0));
+    ptts_spm_free(spm);
+}
+
+/* Every string over {a,b,c} of length 1-3, with and without the word
+ * marker, under scrambled scores; random texts must segment like the scan. */
+static void test_random(void) {
+    static char storage[128][8];
+    vocab_entry v[128];
+    unsigned seed = 12345;
+    int n = 0;
+    v[n++] = (vocab_entry){"<unk>", -12.0f, 2};
+    for (int len = 1; len <= 3; len++) {
+        int combos = len == 1 ? 3 : len == 2 ? 9 : 27;
+        for (int c = 0; c < combos; c++) {
+            for (int marker = 0; marker < 2 && (!marker || len < 3); marker++) {
+                char *s = storage[n];
+                int o = 0;
+                if (marker) o += sprintf(s, SPACE);
+                for (int k = 0, x = c; k < len; k++, x /= 3) s[o++] = (char)('a' + x % 3);
+                s[o] = '\0';
+                float score = -1.0f - (float)(test_rand(&seed) % 7000) / 1000.0f;
+                v[n++] = (vocab_entry){s, score, 1};
+            }
+        }
+    }
+    v[n++] = (vocab_entry){SPACE, -3.0f, 1};
+    ptts_spm *spm = load_vocab(v, n);
+    CHECK(spm != NULL);
+    if (!spm) return;
+    CHECK(ptts_spm_vocab_size(spm) == n);
+
+    for (int iter = 0; iter < 500; iter++) {
+        char text[64];
+        int len = 1 + (int)(test_rand(&seed) % 40);
+        for (int i = 0; i < len; i++) {
+            unsigned r = test_rand(&seed) % 10;
+            text[i] = r < 7 ? (char)('a' + r % 3) : r < 9 ? ' ' : 'd';
+            if (text[i] == ' ' && (i == 0 || text[i - 1] == ' ')) text[i] = 'a';
+        }
+        while (len > 1 && text[len - 1] == ' ') len--;
+        text[len] = '\0';
+
+        char norm[256];
+        int want[256];
+        normalize_words(text, norm);
+        int n_want = reference_encode(v, n, norm, want);
+        CHECK(encode_equals(spm, text, want, n_want));
+    }
+    ptts_spm_free(spm);
+}
+
+int main(void) {
+    test_fixed();
+    test_random();
+    return test_finish("spm");
+}
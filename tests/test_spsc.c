@@ -0,0 +1,156 @@
+/*
+ * test_spsc.c - FlowLM -> Mimi latent ring
+ */
+
+#include "../ptts_spsc.h"
+#include "test.h"
+#include <pthread.h>
+#include <time.h>
+
+#define SLOT 32
+#define ITEMS 200000
+
+static void fill(float *slot, int seq) {
+    for (int i = 0; i < SLOT; i++) slot[i] = (float)seq + (float)i / 64.0f;
+}
+
+static int holds(const float *slot, int seq) {
+    for (int i = 0; i < SLOT; i++) {
+        if (slot[i] != (float)seq + (float)i / 64.0f) return 0;
+    }
+    return 1;
+}
+
+static void test_single_thread(void) {
+    ptts_spsc *q = ptts_spsc_create(5, SLOT); /* rounds up to 8 */
+    CHECK(q != NULL);
+    if (!q) return;
+    float s[SLOT];
+    CHECK(ptts_spsc_pop(q, s) == -1);
+    for (int i = 0; i < 8; i++) {
+        fill(s, i);
+        CHECK(ptts_spsc_push(q, s) == 0);
+    }
+    CHECK(ptts_spsc_push(q, s) == -1);
+    CHECK(ptts_spsc_size(q) == 8);
+
+    /* wrap around the end of the ring a few times */
+    for (int i = 8; i < 30; i++) {
+        CHECK(ptts_spsc_pop(q, s) == 0);
+        CHECK(holds(s, i - 8));
+        fill(s, i);
+        CHECK(ptts_spsc_push(q, s) == 0);
+    }
+
+    ptts_spsc_close(q);
+    CHECK(ptts_spsc_push(q, s) == -1);
+    CHECK(ptts_spsc_push_wait(q, s) == -1);
+    for (int i = 22; i < 30; i++) {
+        CHECK(ptts_spsc_pop_wait(q, s) == 0); /* closed rings still drain */
+        CHECK(holds(s, i));
+    }
+    CHECK(ptts_spsc_pop_wait(q, s) == -1);
+    CHECK(ptts_spsc_size(q) == 0);
+    ptts_spsc_free(q);
+}
+
+typedef struct {
+    ptts_spsc *q;
+    int pushed;
+} producer_arg;
+
+static void *producer(void *p) {
+    producer_arg *a = (producer_arg *)p;
+    float s[SLOT];
+    for (a->pushed = 0; a->pushed < ITEMS; a->pushed++) {
+        fill(s, a->pushed);
+        if (ptts_spsc_push_wait(a->q, s) != 0) break;
+    }
+    ptts_spsc_close(a->q);
+    return NULL;
+}
+
+/* A small ring forces both sides through their full and empty waits. */
+static void test_threads(void) {
+    ptts_spsc *q = ptts_spsc_create(4, SLOT);
+    CHECK(q != NULL);
+    if (!q) return;
+    producer_arg a = {q, 0};
+    pthread_t th;
+    pthread_create(&th, NULL, producer, &a);
+    float s[SLOT];
+    int popped = 0;
+    int in_order = 1;
+    while (ptts_spsc_pop_wait(q, s) == 0) {
+        if (!holds(s, popped)) in_order = 0;
+        popped++;
+    }
+    pthread_join(th, NULL);
+    CHECK(in_order);
+    CHECK(popped == ITEMS);
+    ptts_spsc_free(q);
+}
+
+/* The consumer closing first (a failed decode) releases a blocked producer. */
+static void test_consumer_close(void) {
+    ptts_spsc *q = ptts_spsc_create(2, SLOT);
+    CHECK(q != NULL);
+    if (!q) return;
+    producer_arg a = {q, 0};
+    pthread_t th;
+    pthread_create(&th, NULL, producer, &a);
+    float s[SLOT];
+    for (int i = 0; i < 10; i++) {
+        CHECK(ptts_spsc_pop_wait(q, s) == 0);
+        CHECK(holds(s, i));
+    }
+    ptts_spsc_close(q);
+    pthread_join(th, NULL);
+    CHECK(a.pushed < ITEMS);
+    ptts_spsc_free(q);
+}
+
+static void *slow_producer(void *p) {
+    producer_arg *a = (producer_arg *)p;
+    struct timespec ts = {0, 5000000};
+    float s[SLOT];
+    for (a->pushed = 0; a->pushed < 20; a->pushed++) {
+        nanosleep(&ts, NULL);
+        fill(s, a->pushed);
+        if (ptts_spsc_push_wait(a->q, s) != 0) break;
+    }
+    nanosleep(&ts, NULL);
+    ptts_spsc_close(a->q);
+    return NULL;
+}
+
+/* Frames arrive far apart (a real producer takes tens of ms per frame):
+ * the consumer goes to sleep between them and each push, and finally the
+ * close, must wake it. */
+static void test_slow_producer(void) {
+    ptts_spsc *q = ptts_spsc_create(4, SLOT);
+    CHECK(q != NULL);
+    if (!q) return;
+    producer_arg a = {q, 0};
+    pthread_t th;
+    pthread_create(&th, NULL, slow_producer, &a);
+    float s[SLOT];
+    int popped = 0;
+    int in_order = 1;
+    while (ptts_spsc_pop_wait(q, s) == 0) {
+        if (!holds(s, popped)) in_order = 0;
+        popped++;
+    }
+    pthread_join(th, NULL);
+    CHECK(in_order);
+    CHECK(popped == 20);
+    ptts_spsc_free(q);
+}
+
+int main(void) {
+    test_single_thread();
+    test_threads();
+    test_consumer_close();
+    test_slow_producer();
+    return test_finish("spsc");
+}
@@ -0,0 +1,72 @@
+/*
+ * test_team.c - Pinned SPMD thread team
+ */
+
+#define _GNU_SOURCE
+#include "../ptts_team.h"
+#include "test.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#define TEAM_N 3
+#define ROUNDS 4
+
+typedef struct {
+    ptts_team *team;
+    int slots[TEAM_N];
+    int sums[TEAM_N][ROUNDS];
+    atomic_int calls;
+    pthread_t callers[TEAM_N];
+} job;
+
+/* Each round every worker writes its slot, then after the barrier reads
+ * everyone's, so a missing or early barrier shows up as a wrong sum. */
+static void job_fn(void *arg, int worker, int num_workers) {
+    job *j = (job *)arg;
+    atomic_fetch_add(&j->calls, 1);
+    j->callers[worker] = pthread_self();
+    for (int r = 0; r < ROUNDS; r++) {
+        j->slots[worker] = (worker + 1) * (r + 1);
+        ptts_team_barrier(j->team);
+        int sum = 0;
+        for (int w = 0; w < num_workers; w++) sum += j->slots[w];
+        j->sums[worker][r] = sum;
+        ptts_team_barrier(j->team);
+    }
+}
+
+static void run_team(int pin) {
+    ptts_team *team = ptts_team_create(TEAM_N, pin);
+    CHECK(team != NULL);
+    if (!team) return;
+    int n = ptts_team_size(team);
+    CHECK(n == TEAM_N);
+#ifdef __linux__
+    cpu_set_t before, after;
+    CHECK(sched_getaffinity(0, sizeof(before), &before) == 0);
+#endif
+    for (int run = 0; run < 50; run++) {
+        job j = {.team = team};
+        atomic_init(&j.calls, 0);
+        ptts_team_run(team, job_fn, &j);
+        CHECK(atomic_load(&j.calls) == n);
+        for (int w = 0; w < n; w++) {
+            for (int r = 0; r < ROUNDS; r++) CHECK(j.sums[w][r] == n * (n + 1) / 2 * (r + 1));
+        }
+        /* with pin every share runs on a team thread, else worker 0 is us */
+        CHECK(pthread_equal(j.callers[0], pthread_self()) == !pin);
+    }
+#ifdef __linux__
+    /* the caller is never moved */
+    CHECK(sched_getaffinity(0, sizeof(after), &after) == 0);
+    CHECK(CPU_EQUAL(&before, &after));
+#endif
+    ptts_team_free(team);
+}
+
+int main(void) {
+    run_team(0);
+    run_team(1);
+    return test_finish("team");
+}